@@ -0,0 +1,588 @@
+// Micro-benchmarks of the kernels which dominate the cost of the solver.
+// Each kernel is timed on a few sizes of structured grid, with real and
+// dual numbers, and reported as the time and memory traffic per element
+// (a face, cell or vector entry, depending on the kernel). The results
+// can be checked against a baseline, so that kernel level optimisations
+// can be measured, and regressions caught. The construction of the grid,
+// which dominates the start up of a run, is timed the same way, on the
+// structured grids and on any grid files given with --grids.
+
+#define DOCTEST_CONFIG_IMPLEMENT
+#include <doctest/doctest.h>
+#include <finite_volume/conserved_quantities.h>
+#include <finite_volume/convective_flux.h>
+#include <finite_volume/finite_volume.h>
+#include <finite_volume/flux_calc.h>
+#include <finite_volume/limiter.h>
+#include <finite_volume/primative_conserved_conversion.h>
+#include <gas/flow_state.h>
+#include <gas/gas_model.h>
+#include <grid/grid.h>
+#include <grid/structured_grid.h>
+#include <linear_algebra/dense_linear_algebra.h>
+#include <spdlog/spdlog.h>
+#include <spdlog/stopwatch.h>
+#include <unistd.h>
+#include <util/field.h>
+#include <util/numeric_types.h>
+
+#include <CLI/CLI.hpp>
+#include <Kokkos_Core.hpp>
+#include <algorithm>
+#include <filesystem>
+#include <fstream>
+#include <limits>
+#include <nlohmann/json.hpp>
+#include <stdexcept>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+using json = nlohmann::json;
+
+// the number of batches of calls timed for each kernel
+constexpr size_t num_batches = 5;
+
+// the columns of the Krylov basis used for gemv, about the number of
+// iterations in a typical linear solve
+constexpr size_t krylov_size = 16;
+
+// the exit code when there's nothing in the baseline to compare with, which
+// ctest reports as the test being skipped rather than passing
+constexpr int no_baseline_code = 77;
+
+struct MicroBenchOptions {
+    // if not given, sizes which take similar times in 2D and 3D are used
+    std::vector<size_t> sizes;
+    int dim = 2;
+    double min_time = 0.05;
+    std::string filter;
+
+    // su2 files (e.g. the grid.su2 written by the grid.py of each example)
+    // to time reading and building the grid of
+    std::vector<std::string> grids;
+
+    std::string baseline;
+    double threshold = -1.0;
+    std::string write_baseline;
+    std::string output;
+};
+
+struct KernelResult {
+    std::string kernel;
+    std::string number_type;
+    int dim;
+    size_t size;
+    size_t elements;
+    double ns_per_element;
+    double bytes_per_element;
+
+    // the name the result is stored under in the baseline
+    std::string key() const {
+        return kernel + "/" + number_type + "/" + std::to_string(dim) + "d/" +
+               std::to_string(size);
+    }
+};
+
+template <typename T>
+std::string number_type() {
+    return std::is_same<T, Ibis::dual>::value ? "dual" : "real";
+}
+
+// The seconds per call of kernel. The number of calls in a batch is doubled
+// until a batch takes at least min_time, and then the fastest of a few
+// batches is used, since noise only ever makes a kernel slower.
+template <class Kernel>
+double time_kernel(Kernel& kernel, double min_time) {
+    kernel();
+    Kokkos::fence();
+    size_t calls = 1;
+    while (true) {
+        spdlog::stopwatch sw;
+        for (size_t i = 0; i < calls; i++) {
+            kernel();
+        }
+        Kokkos::fence();
+        if (sw.elapsed().count() >= min_time) break;
+        calls *= 2;
+    }
+
+    double best = std::numeric_limits<double>::max();
+    for (size_t batch = 0; batch < num_batches; batch++) {
+        spdlog::stopwatch sw;
+        for (size_t i = 0; i < calls; i++) {
+            kernel();
+        }
+        Kokkos::fence();
+        best = std::min(best, sw.elapsed().count() / calls);
+    }
+    return best;
+}
+
+class MicroBench {
+public:
+    MicroBench(const MicroBenchOptions& options) : options_(options) {}
+
+    // Time kernel, which processes the given number of elements, moving
+    // (at least) bytes_per_element bytes of memory for each one
+    template <class Kernel>
+    void run(std::string kernel_name, std::string number_type, size_t size,
+             size_t elements, double bytes_per_element, Kernel kernel) {
+        run(kernel_name, number_type, options_.dim, size, elements, bytes_per_element,
+            kernel);
+    }
+
+    // The same, for a kernel on a grid with a different number of dimensions
+    // to the structured grids (e.g. a grid read from a file)
+    template <class Kernel>
+    void run(std::string kernel_name, std::string number_type, int dim, size_t size,
+             size_t elements, double bytes_per_element, Kernel kernel) {
+        if (kernel_name.find(options_.filter) == std::string::npos) return;
+
+        double time = time_kernel(kernel, options_.min_time);
+        KernelResult result{kernel_name, number_type, dim,
+                            size,        elements,    1e9 * time / elements,
+                            bytes_per_element};
+        spdlog::info("{:<40} {:>10} elements {:>10.3f} ns/element {:>8.1f} B/element "
+                     "{:>8.1f} GB/s",
+                     result.key(), elements, result.ns_per_element, bytes_per_element,
+                     bytes_per_element / result.ns_per_element);
+        results_.push_back(result);
+    }
+
+    const std::vector<KernelResult>& results() const { return results_; }
+
+private:
+    MicroBenchOptions options_;
+    std::vector<KernelResult> results_;
+};
+
+// the settings for a grid with ghost cells on every boundary
+json grid_config(const GridIO& grid_io) {
+    json boundaries;
+    for (const auto& [tag, faces] : grid_io.markers()) {
+        boundaries[tag] = {{"ghost_cells", true}};
+    }
+    return json{{"boundaries", boundaries},
+                {"motion", {{"enabled", false}}},
+                {"renumber", "none"},
+                {"cache", false},
+                {"geometry_cache",
+                 {{"face_weights", true},
+                  {"signed_areas", true},
+                  {"inverse_volumes", true},
+                  {"centre_offsets", true}}}};
+}
+
+// the settings for a first order inviscid finite volume
+// discretisation, with nothing done at the boundaries
+json finite_volume_config(const GridIO& grid_io) {
+    json boundaries;
+    for (const auto& [tag, faces] : grid_io.markers()) {
+        boundaries[tag] = {{"pre_reconstruction", json::array()},
+                           {"post_convective_flux", json::array()},
+                           {"pre_viscous_grad", json::array()}};
+    }
+    return json{{"convective_flux",
+                 {{"flux_calculator", {{"type", "hanel"}}},
+                  {"reconstruction_order", 1},
+                  {"fused", false}}},
+                {"viscous_flux", {{"enabled", false}, {"signal_factor", 4.0}}},
+                {"grid", {{"boundaries", boundaries}}}};
+}
+
+// A smoothly varying supersonic flow of air, with the phase shifted
+// so that different sets of flow states differ
+template <typename T>
+void fill_flow_states(FlowStates<T>& fs, const IdealGas<T>& gas_model,
+                      Ibis::real phase) {
+    Kokkos::parallel_for(
+        "microbench::fill_flow_states", fs.number_flow_states(),
+        KOKKOS_LAMBDA(const size_t i) {
+            Ibis::real wave = Kokkos::sin(0.01 * i + phase);
+            fs.gas.rho(i) = T(1.0 + 0.1 * wave);
+            fs.gas.temp(i) = T(300.0 - 20.0 * wave);
+            fs.vel.x(i) = T(600.0 + 50.0 * wave);
+            fs.vel.y(i) = T(30.0 * wave);
+            fs.vel.z(i) = T(0.0);
+        });
+    gas_model.update_thermo_from_rhoT(fs.gas);
+}
+
+// The kernels which run with the number type of the simulation. The bytes
+// per element are a lower bound on the memory traffic: each value is
+// counted once, however many times it is actually read, and the values of
+// the neighbouring cells are assumed to already be in cache.
+template <typename T>
+void bench_kernels(MicroBench& bench, int dim, size_t size) {
+    GridIO grid_io = structured_grid(size, size, (dim == 3) ? size : 0);
+    json grid_json = grid_config(grid_io);
+    GridBlock<T> grid(grid_io, grid_json);
+    grid.allocate_gradient_weights();
+    size_t n_cells = grid.num_cells();
+    size_t n_faces = grid.num_interfaces();
+    size_t n_total_cells = grid.num_total_cells();
+    std::string type = number_type<T>();
+
+    IdealGas<T> gas_model(287.0);
+    FlowStates<T> fs(n_total_cells);
+    fill_flow_states(fs, gas_model, 0.0);
+    ConservedQuantities<T> cq(n_total_cells, dim);
+    primatives_to_conserved(cq, fs, gas_model);
+
+    const double value_bytes = sizeof(T);
+    const double index_bytes = sizeof(size_t);
+    const double flow_values = 7;  // rho, p, T, energy and the velocity
+    const double n_cons = cq.n_conserved();
+    const double faces_per_cell = 2 * dim;
+
+    // the flux calculators, on the states either side of each face
+    FlowStates<T> left(n_faces);
+    FlowStates<T> right(n_faces);
+    fill_flow_states(left, gas_model, 0.0);
+    fill_flow_states(right, gas_model, 0.5);
+    ConservedQuantities<T> flux(n_faces, dim);
+    for (std::string flux_name : {"hanel", "ausmdv", "ldfss2", "rusanov"}) {
+        json flux_config{{"type", flux_name}, {"delta", 2.0}};
+        FluxCalculator<T> flux_calculator = make_flux_calculator<T>(flux_config);
+        bench.run(flux_name + "_flux", type, size, n_faces,
+                  value_bytes * (2 * flow_values + n_cons), [&]() {
+                      flux_calculator.compute_flux(left, right, flux, gas_model,
+                                                   dim == 3);
+                  });
+    }
+
+    // gradients and limiters of one variable
+    Vector3s<T> grad("microbench::grad", n_cells);
+    double r_values = (dim == 2) ? 3 : 6;
+    bench.run("wls_gradient", type, size, n_cells,
+              value_bytes * (1 + r_values + 3 + 3) + index_bytes * faces_per_cell,
+              [&]() {
+                  grid.grad_calc().compute_gradients(grid, fs.gas.pressure(), grad);
+              });
+
+    BarthJespersen<T> limiter(1e-25);
+    Field<T> limits("microbench::limits", n_cells);
+    bench.run("barth_jespersen", type, size, n_cells,
+              value_bytes * (1 + 3 + 3 * faces_per_cell + 1) +
+                  index_bytes * 2 * faces_per_cell,
+              [&]() {
+                  limiter.calculate_limiters(fs.gas.pressure(), limits, grid, grad);
+              });
+
+    bench.run("conserved_to_primatives", type, size, n_total_cells,
+              value_bytes * (n_cons + flow_values),
+              [&]() { conserved_to_primatives(cq, fs, gas_model); });
+
+    // the whole convective flux calculation, with and without the fused
+    // kernel. The unfused kernels write the reconstructed states either
+    // side of each face and read them back, which the fused kernel doesn't.
+    // Second order includes the gradients and limiters, which are the same.
+    for (size_t order : {1, 2}) {
+        for (bool fused : {false, true}) {
+            json convective_config{
+                {"flux_calculator", {{"type", "hanel"}}},
+                {"reconstruction_order", order},
+                {"limiter", {{"type", "barth_jespersen"}, {"epsilon", 1e-25}}},
+                {"thermo_interpolator", "rho_u"},
+                {"fused", fused}};
+            ConvectiveFlux<T> convective_flux(grid, convective_config);
+            const RequiredGradients grads = convective_flux.required_gradients();
+            Gradients<T> cell_grad(n_cells, grads.pressure, grads.temp, grads.u,
+                                   grads.rho, false);
+            double state_values = (fused ? 2 : 6) * flow_values;
+            std::string name = std::string(fused ? "fused_" : "") + "convective_flux_o" +
+                               std::to_string(order);
+            bench.run(name, type, size, n_faces,
+                      value_bytes * (state_values + n_cons + 10) + index_bytes * 2,
+                      [&]() {
+                          convective_flux.compute_convective_flux(
+                              fs, grid, gas_model, cell_grad, grid.grad_calc(), flux,
+                              true);
+                      });
+        }
+    }
+
+    // the surface integral of the fluxes
+    FiniteVolume<T> fv(grid, finite_volume_config(grid_io));
+    ConservedQuantities<T> dudt(n_total_cells, dim);
+    double faces_per_cell_flux = double(n_faces) / n_cells;
+    bench.run("flux_surface_integral", type, size, n_cells,
+              value_bytes *
+                      (faces_per_cell + 1 + faces_per_cell_flux * n_cons + n_cons) +
+                  index_bytes * faces_per_cell,
+              [&]() { fv.flux_surface_integral(grid, dudt); });
+
+    // the cost of the arithmetic itself, which is most of
+    // the difference between real and dual numbers
+    Field<T> x("microbench::x", n_cells);
+    Field<T> y("microbench::y", n_cells);
+    Field<T> z("microbench::z", n_cells);
+    Kokkos::parallel_for(
+        "microbench::fill_arithmetic", n_cells, KOKKOS_LAMBDA(const size_t i) {
+            x(i) = T(1.5 + Kokkos::sin(0.01 * i));
+            y(i) = T(1.5 + Kokkos::cos(0.01 * i));
+            if constexpr (std::is_same<T, Ibis::dual>::value) {
+                x(i).dual() = 1.0;
+            }
+        });
+    bench.run("arithmetic", type, size, n_cells, 3 * value_bytes, [&]() {
+        Kokkos::parallel_for(
+            "microbench::arithmetic", n_cells, KOKKOS_LAMBDA(const size_t i) {
+                z(i) = Ibis::sqrt(x(i) * y(i) + x(i) / y(i));
+            });
+    });
+}
+
+// The dense linear algebra of GMRES, which is only done with real numbers,
+// on vectors as long as the number of unknowns of the grid
+void bench_linear_algebra(MicroBench& bench, int dim, size_t size) {
+    size_t n_cells = size * size * ((dim == 3) ? size : 1);
+    size_t n_vars = n_cells * (dim + 2);
+    Ibis::Vector<Ibis::real> a("microbench::a", n_vars);
+    Ibis::Vector<Ibis::real> b("microbench::b", n_vars);
+    Ibis::Vector<Ibis::real> w("microbench::w", n_vars);
+    Ibis::Vector<Ibis::real> ym("microbench::ym", krylov_size);
+    Ibis::Matrix<Ibis::real> krylov("microbench::krylov", n_vars, krylov_size);
+    Kokkos::parallel_for(
+        "microbench::fill_vectors", n_vars, KOKKOS_LAMBDA(const size_t i) {
+            a(i) = Kokkos::sin(0.01 * i);
+            b(i) = Kokkos::cos(0.01 * i);
+            for (size_t j = 0; j < krylov_size; j++) {
+                krylov(i, j) = Kokkos::sin(0.01 * i + j);
+            }
+            if (i < krylov_size) ym(i) = 1.0 / (i + 1);
+        });
+
+    // keep the results, so the reductions can't be optimised away
+    Ibis::real sink = 0.0;
+    const double value_bytes = sizeof(Ibis::real);
+    bench.run("dot", "real", size, n_vars, 2 * value_bytes,
+              [&]() { sink += Ibis::dot(a, b); });
+    bench.run("norm2", "real", size, n_vars, value_bytes,
+              [&]() { sink += Ibis::norm2(a); });
+    bench.run("gemv", "real", size, n_vars * krylov_size,
+              value_bytes * (1.0 + 1.0 / krylov_size),
+              [&]() { Ibis::gemv(krylov, ym, w); });
+    spdlog::debug("microbench: checksum {}", sink);
+}
+
+// Building the grid on the device from the grid read from a file: finding
+// the faces (mostly the interface lookup), the geometry and the ghost
+// cells. Most of this is serial host code, so no memory traffic is
+// reported.
+void bench_grid_construction(MicroBench& bench, int dim, size_t size) {
+    GridIO grid_io = structured_grid(size, size, (dim == 3) ? size : 0);
+    json grid_json = grid_config(grid_io);
+    bench.run("grid_construction", "real", size, grid_io.num_cells(), 0.0,
+              [&]() { GridBlock<Ibis::real> grid(grid_io, grid_json); });
+}
+
+// Reading and building a grid from a file, as at the start of a run. The
+// result is named after the file's name without its directory, so that the
+// same grid gives the same key in the baseline wherever it is run from. The
+// key includes the number of cells, so grids from different examples with
+// the same file name (e.g. grid.su2) only clash if they are the same size.
+void bench_grid_file(MicroBench& bench, const std::string& file_name) {
+    if (!std::filesystem::exists(file_name)) {
+        spdlog::error("Grid file {} doesn't exist", file_name);
+        throw std::runtime_error("Grid file doesn't exist");
+    }
+    GridIO grid_io(file_name);
+    json grid_json = grid_config(grid_io);
+    std::string kernel_name =
+        "grid_startup:" + std::filesystem::path(file_name).filename().string();
+    KernelResult same_grid{kernel_name, "real", static_cast<int>(grid_io.dim()),
+                           grid_io.num_cells(), 0, 0.0, 0.0};
+    for (const KernelResult& result : bench.results()) {
+        if (result.key() == same_grid.key()) {
+            spdlog::error("{} has the same name and number of cells as another grid "
+                          "file, so their results can't be told apart",
+                          file_name);
+            throw std::runtime_error("Grid files with the same name and size");
+        }
+    }
+    bench.run(kernel_name, "real", grid_io.dim(), grid_io.num_cells(),
+              grid_io.num_cells(), 0.0, [&]() {
+                  GridIO file_grid_io(file_name);
+                  GridBlock<Ibis::real> grid(file_grid_io, grid_json);
+              });
+}
+
+std::string host_name() {
+    char name[256] = "";
+    gethostname(name, sizeof(name) - 1);
+    return name;
+}
+
+json results_json(const std::vector<KernelResult>& results) {
+    json results_data;
+    for (const KernelResult& result : results) {
+        results_data[result.key()] = {{"elements", result.elements},
+                                      {"ns_per_element", result.ns_per_element},
+                                      {"bytes_per_element", result.bytes_per_element}};
+    }
+    return results_data;
+}
+
+// The speed up of each fused kernel over the unfused kernels it replaces,
+// which are timed with the same name without the "fused_" prefix
+void report_fused_speedups(const std::vector<KernelResult>& results) {
+    const std::string prefix = "fused_";
+    for (const KernelResult& fused : results) {
+        if (fused.kernel.rfind(prefix, 0) != 0) continue;
+        KernelResult unfused = fused;
+        unfused.kernel = fused.kernel.substr(prefix.size());
+        auto match = std::find_if(results.begin(), results.end(),
+                                  [&](const KernelResult& result) {
+                                      return result.key() == unfused.key();
+                                  });
+        if (match == results.end()) continue;
+        spdlog::info("{}: {:.2f}x faster than unfused", fused.key(),
+                     match->ns_per_element / fused.ns_per_element);
+    }
+}
+
+// Compare the results with the baseline, returning the number of kernels
+// more than the threshold slower than their baseline. Kernels without a
+// baseline (e.g. new kernels, or a baseline from a different set of
+// sizes) are reported, but don't count as regressions.
+size_t check_baseline(const std::vector<KernelResult>& results, const json& baseline,
+                      double threshold) {
+    json baseline_results = baseline.at("results");
+    size_t regressions = 0;
+    size_t missing = 0;
+    for (const KernelResult& result : results) {
+        if (!baseline_results.contains(result.key())) {
+            missing++;
+            continue;
+        }
+        double baseline_ns = baseline_results.at(result.key()).at("ns_per_element");
+        double change = result.ns_per_element / baseline_ns - 1.0;
+        if (change > threshold) {
+            regressions++;
+            spdlog::error("{}: {:.3f} ns/element, {:.0f}% slower than the baseline "
+                          "({:.3f} ns/element)",
+                          result.key(), result.ns_per_element, 100 * change,
+                          baseline_ns);
+        } else if (change < -threshold) {
+            spdlog::info("{}: {:.3f} ns/element, {:.0f}% faster than the baseline "
+                         "({:.3f} ns/element)",
+                         result.key(), result.ns_per_element, -100 * change,
+                         baseline_ns);
+        }
+    }
+    if (missing > 0) {
+        spdlog::warn("{} of {} kernels have no baseline", missing, results.size());
+    }
+    spdlog::info("{} regressions of more than {:.0f}% from the baseline ({})",
+                 regressions, 100 * threshold,
+                 std::string(baseline.value("machine", "")));
+    return regressions;
+}
+
+int microbench(const MicroBenchOptions& options) {
+    MicroBench bench(options);
+    for (size_t size : options.sizes) {
+        bench_kernels<Ibis::real>(bench, options.dim, size);
+        bench_kernels<Ibis::dual>(bench, options.dim, size);
+        bench_linear_algebra(bench, options.dim, size);
+        bench_grid_construction(bench, options.dim, size);
+    }
+    for (const std::string& grid_file : options.grids) {
+        bench_grid_file(bench, grid_file);
+    }
+    const std::vector<KernelResult>& results = bench.results();
+    report_fused_speedups(results);
+
+    if (!options.output.empty()) {
+        std::ofstream output_file(options.output);
+        output_file << results_json(results).dump(4);
+    }
+
+    int result = 0;
+    if (!options.baseline.empty()) {
+        std::ifstream baseline_file(options.baseline);
+        if (!baseline_file) {
+            spdlog::error("Unable to open baseline {}", options.baseline);
+            return 1;
+        }
+        json baseline = json::parse(baseline_file);
+        const json& baseline_results = baseline.at("results");
+        bool any_baseline = std::any_of(
+            results.begin(), results.end(),
+            [&](const KernelResult& r) { return baseline_results.contains(r.key()); });
+        if (!any_baseline) {
+            spdlog::error("None of the kernels have a result in the baseline {}, so "
+                          "there's nothing to compare with. Write one with "
+                          "--write-baseline on the machine the benchmarks are "
+                          "tracked on.",
+                          options.baseline);
+            return no_baseline_code;
+        }
+        double threshold = (options.threshold >= 0.0)
+                               ? options.threshold
+                               : baseline.at("threshold").get<double>();
+        if (check_baseline(results, baseline, threshold) > 0) {
+            result = 1;
+        }
+    }
+
+    if (!options.write_baseline.empty()) {
+        json baseline;
+        baseline["machine"] = host_name();
+        baseline["threads"] = Kokkos::DefaultHostExecutionSpace().concurrency();
+        baseline["threshold"] = (options.threshold >= 0.0) ? options.threshold : 0.25;
+        baseline["results"] = results_json(results);
+        std::ofstream baseline_file(options.write_baseline);
+        baseline_file << baseline.dump(4);
+        spdlog::info("written baseline to {}", options.write_baseline);
+    }
+    return result;
+}
+
+int main(int argc, char* argv[]) {
+    CLI::App app{"micro-benchmarks of the ibis kernels"};
+    MicroBenchOptions options;
+    // pass any options for kokkos (e.g. --kokkos-num-threads) through
+    app.allow_extras();
+    app.add_option("--sizes", options.sizes,
+                   "Cells along each side of the grids to benchmark "
+                   "(default: 32,128,512 in 2D, 16,32,64 in 3D)")
+        ->delimiter(',');
+    app.add_option("--dim", options.dim, "Dimensions of the grids")
+        ->check(CLI::Range(2, 3))
+        ->capture_default_str();
+    app.add_option("--min-time", options.min_time,
+                   "Minimum time (s) of each batch of calls to a kernel")
+        ->check(CLI::PositiveNumber)
+        ->capture_default_str();
+    app.add_option("--filter", options.filter,
+                   "Only run the kernels with names containing this");
+    app.add_option("--grids", options.grids,
+                   "Grid files to time reading and building, e.g. the grid.su2 of "
+                   "each example")
+        ->delimiter(',');
+    app.add_option("--baseline", options.baseline,
+                   "Fail if any kernel is slower than this baseline");
+    app.add_option("--threshold", options.threshold,
+                   "Fraction slower than the baseline which counts as a regression "
+                   "(default: the threshold in the baseline)");
+    app.add_option("--write-baseline", options.write_baseline,
+                   "Write the results as a new baseline");
+    app.add_option("--output", options.output, "Write the results to this json file");
+    CLI11_PARSE(app, argc, argv);
+    if (options.sizes.empty()) {
+        options.sizes = (options.dim == 3) ? std::vector<size_t>{16, 32, 64}
+                                           : std::vector<size_t>{32, 128, 512};
+    }
+
+    // the libraries contain doctest tests, so there has to be a doctest
+    // context, even though the tests are never run from here
+    doctest::Context ctx;
+
+    Kokkos::initialize(argc, argv);
+    int result = microbench(options);
+    Kokkos::finalize();
+    return result;
+}
@@ -46,6 +46,7 @@ void FlowStateCopy<T>::apply(FlowStates<T>& fs, const GridBlock<T>& grid,
 }
 template class FlowStateCopy<Ibis::real>;
 template class FlowStateCopy<Ibis::dual>;
+template class FlowStateCopy<Ibis::dual4>;
 
 template <typename T>
 BoundaryLayerProfile<T>::BoundaryLayerProfile(json config) {
@@ -95,6 +96,7 @@ void BoundaryLayerProfile<T>::apply(FlowStates<T>& fs, const GridBlock<T>& grid,
 }
 template class BoundaryLayerProfile<Ibis::real>;
 template class BoundaryLayerProfile<Ibis::dual>;
+template class BoundaryLayerProfile<Ibis::dual4>;
 
 template <typename T>
 void InternalCopy<T>::apply(FlowStates<T>& fs, const GridBlock<T>& grid,
@@ -137,6 +139,7 @@ void InternalCopy<T>::apply(FlowStates<T>& fs, const GridBlock<T>& grid,
 }
 template class InternalCopy<Ibis::real>;
 template class InternalCopy<Ibis::dual>;
+template class InternalCopy<Ibis::dual4>;
 
 template <typename T>
 void InternalCopyReflectNormal<T>::apply(FlowStates<T>& fs, const GridBlock<T>& grid,
@@ -343,6 +346,7 @@ void SubsonicInflow<T>::apply(FlowStates<T>& fs, const GridBlock<T>& grid,
 }
 template class SubsonicInflow<Ibis::real>;
 template class SubsonicInflow<Ibis::dual>;
+template class SubsonicInflow<Ibis::dual4>;
 
 template <typename T>
 void SubsonicOutflow<T>::apply(FlowStates<T>& fs, const GridBlock<T>& grid,
@@ -400,6 +404,7 @@ void SubsonicOutflow<T>::apply(FlowStates<T>& fs, const GridBlock<T>& grid,
 }
 template class SubsonicOutflow<Ibis::real>;
 template class SubsonicOutflow<Ibis::dual>;
+template class SubsonicOutflow<Ibis::dual4>;
 
 template <typename T>
 void ConstantFlux<T>::apply(ConservedQuantities<T>& flux,
@@ -444,6 +449,7 @@ void ConstantFlux<T>::apply(ConservedQuantities<T>& flux,
 }
 template class ConstantFlux<Ibis::real>;
 template class ConstantFlux<Ibis::dual>;
+template class ConstantFlux<Ibis::dual4>;
 
 template <typename T>
 std::shared_ptr<GhostCellAction<T>> build_boundary_action(json config) {
@@ -543,3 +549,4 @@ void BoundaryCondition<T>::apply_pre_viscous_grad(
 }
 template class BoundaryCondition<Ibis::real>;
 template class BoundaryCondition<Ibis::dual>;
+template class BoundaryCondition<Ibis::dual4>;
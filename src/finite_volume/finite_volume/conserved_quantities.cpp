@@ -1,4 +1,6 @@
 #include <finite_volume/conserved_quantities.h>
+#include <util/dimension.h>
+#include <util/numa.h>
 #include <util/numeric_types.h>
 
 template <typename T>
@@ -11,10 +13,12 @@ void ConservedQuantitiesNorm<T>::write_to_file(std::ofstream& f, Ibis::real wc,
 }
 template class ConservedQuantitiesNorm<Ibis::real>;
 template class ConservedQuantitiesNorm<Ibis::dual>;
+template class ConservedQuantitiesNorm<Ibis::dual4>;
 
 template <typename T>
 ConservedQuantities<T>::ConservedQuantities(size_t n, size_t dim)
-    : cq_(Kokkos::View<T**>("ConservedQuantities", n, dim + 2)),
+    : cq_(Ibis::first_touch_view<Kokkos::View<T**>>("ConservedQuantities", n,
+                                                     dim + 2)),
       num_values_(n),
       dim_(dim) {
     mass_idx_ = 0;
@@ -25,12 +29,21 @@ ConservedQuantities<T>::ConservedQuantities(size_t n, size_t dim)
 template <typename T>
 void ConservedQuantities<T>::apply_time_derivative(const ConservedQuantities<T>& dudt,
                                                    Ibis::real dt) {
+    Ibis::dispatch_dim(dim_, [&](auto dim) {
+        apply_time_derivative_<decltype(dim)::value>(dudt, dt);
+    });
+}
+
+template <typename T>
+template <int Dim>
+void ConservedQuantities<T>::apply_time_derivative_(const ConservedQuantities<T>& dudt,
+                                                    Ibis::real dt) {
     Kokkos::parallel_for(
         "CQ::update_cq", num_values_, KOKKOS_CLASS_LAMBDA(const size_t i) {
             mass(i) += dudt.mass(i) * dt;
             momentum_x(i) += dudt.momentum_x(i) * dt;
             momentum_y(i) += dudt.momentum_y(i) * dt;
-            if (dim_ == 3) {
+            if constexpr (Dim == 3) {
                 momentum_z(i) += dudt.momentum_z(i) * dt;
             }
             energy(i) += dudt.energy(i) * dt;
@@ -39,6 +52,15 @@ void ConservedQuantities<T>::apply_time_derivative(const ConservedQuantities<T>&
 
 template <typename T>
 ConservedQuantitiesNorm<T> ConservedQuantities<T>::L2_norms() const {
+    ConservedQuantitiesNorm<T> norms{};
+    Ibis::dispatch_dim(dim_,
+                       [&](auto dim) { norms = L2_norms_<decltype(dim)::value>(); });
+    return norms;
+}
+
+template <typename T>
+template <int Dim>
+ConservedQuantitiesNorm<T> ConservedQuantities<T>::L2_norms_() const {
     ConservedQuantitiesNorm<T> norms{};
     Kokkos::parallel_reduce(
         "L2_norm", num_values_,
@@ -46,7 +68,10 @@ ConservedQuantitiesNorm<T> ConservedQuantities<T>::L2_norms() const {
             T mass_i = mass(i);
             T momentum_xi = momentum_x(i);
             T momentum_yi = momentum_y(i);
-            T momentum_zi = (dim_ == 3) ? momentum_z(i) : T(0.0);
+            T momentum_zi = T(0.0);
+            if constexpr (Dim == 3) {
+                momentum_zi = momentum_z(i);
+            }
             T energy_i = energy(i);
             tl_cq.mass() += mass_i * mass_i;
             tl_cq.momentum_x() += momentum_xi * momentum_xi;
@@ -75,27 +100,66 @@ void ConservedQuantities<T>::deep_copy(const ConservedQuantities<T>& other) {
 
 template class ConservedQuantities<Ibis::real>;
 template class ConservedQuantities<Ibis::dual>;
+template class ConservedQuantities<Ibis::dual4>;
 
-template <typename T>
-void apply_time_derivative(const ConservedQuantities<T>& U0, ConservedQuantities<T>& U1,
-                           ConservedQuantities<T>& dUdt, Ibis::real dt) {
+template <typename T, int Dim>
+void apply_time_derivative_(const ConservedQuantities<T>& U0, ConservedQuantities<T>& U1,
+                            ConservedQuantities<T>& dUdt, Ibis::real dt) {
     size_t n_values = U0.size();
-    size_t dim = U0.dim();
     Kokkos::parallel_for(
         "apply_time_derivative", n_values, KOKKOS_LAMBDA(const size_t i) {
             U1.mass(i) = U0.mass(i) + dUdt.mass(i) * dt;
             U1.momentum_x(i) = U0.momentum_x(i) + dUdt.momentum_x(i) * dt;
             U1.momentum_y(i) = U0.momentum_y(i) + dUdt.momentum_y(i) * dt;
-            if (dim == 3) {
+            if constexpr (Dim == 3) {
                 U1.momentum_z(i) = U0.momentum_z(i) + dUdt.momentum_z(i) * dt;
             }
             U1.energy(i) = U0.energy(i) + dUdt.energy(i) * dt;
         });
 }
 
+template <typename T>
+void apply_time_derivative(const ConservedQuantities<T>& U0, ConservedQuantities<T>& U1,
+                           ConservedQuantities<T>& dUdt, Ibis::real dt) {
+    Ibis::dispatch_dim(U0.dim(), [&](auto dim) {
+        apply_time_derivative_<T, decltype(dim)::value>(U0, U1, dUdt, dt);
+    });
+}
+
 template void apply_time_derivative(const ConservedQuantities<Ibis::real>&,
                                     ConservedQuantities<Ibis::real>&,
                                     ConservedQuantities<Ibis::real>&, Ibis::real);
 template void apply_time_derivative(const ConservedQuantities<Ibis::dual>&,
                                     ConservedQuantities<Ibis::dual>&,
                                     ConservedQuantities<Ibis::dual>&, Ibis::real);
+template void apply_time_derivative(const ConservedQuantities<Ibis::dual4>&,
+                                    ConservedQuantities<Ibis::dual4>&,
+                                    ConservedQuantities<Ibis::dual4>&, Ibis::real);
+
+template <typename T>
+ConservedQuantitiesNorm<T> combine_L2_norms(
+    const std::vector<ConservedQuantitiesNorm<T>>& norms) {
+    ConservedQuantitiesNorm<T> combined{};
+    for (ConservedQuantitiesNorm<T> norm : norms) {
+        combined.global() += norm.global() * norm.global();
+        combined.mass() += norm.mass() * norm.mass();
+        combined.momentum_x() += norm.momentum_x() * norm.momentum_x();
+        combined.momentum_y() += norm.momentum_y() * norm.momentum_y();
+        combined.momentum_z() += norm.momentum_z() * norm.momentum_z();
+        combined.energy() += norm.energy() * norm.energy();
+    }
+    combined.global() = Ibis::sqrt(combined.global());
+    combined.mass() = Ibis::sqrt(combined.mass());
+    combined.momentum_x() = Ibis::sqrt(combined.momentum_x());
+    combined.momentum_y() = Ibis::sqrt(combined.momentum_y());
+    combined.momentum_z() = Ibis::sqrt(combined.momentum_z());
+    combined.energy() = Ibis::sqrt(combined.energy());
+    return combined;
+}
+
+template ConservedQuantitiesNorm<Ibis::real> combine_L2_norms(
+    const std::vector<ConservedQuantitiesNorm<Ibis::real>>&);
+template ConservedQuantitiesNorm<Ibis::dual> combine_L2_norms(
+    const std::vector<ConservedQuantitiesNorm<Ibis::dual>>&);
+template ConservedQuantitiesNorm<Ibis::dual4> combine_L2_norms(
+    const std::vector<ConservedQuantitiesNorm<Ibis::dual4>>&);
@@ -7,6 +7,7 @@
 
 #include <Kokkos_Core.hpp>
 #include <fstream>
+#include <vector>
 
 template <typename T>
 class ConservedQuantitiesNorm {
@@ -172,6 +173,13 @@ public:
 
     void deep_copy(const ConservedQuantities<T>& other);
 
+public:  // these are public to appease NVCC
+    template <int Dim>
+    void apply_time_derivative_(const ConservedQuantities<T>& dudt, Ibis::real dt);
+
+    template <int Dim>
+    ConservedQuantitiesNorm<T> L2_norms_() const;
+
 private:
     Kokkos::View<T**> cq_;
     unsigned int mass_idx_, momentum_idx_, energy_idx_;
@@ -182,4 +190,10 @@ template <typename T>
 void apply_time_derivative(const ConservedQuantities<T>& U0, ConservedQuantities<T>& U1,
                            ConservedQuantities<T>& dUdt, Ibis::real dt);
 
+// The L2 norms of the union of several sets of conserved quantities, given
+// the L2 norms of each set, e.g. the norms over a grid split into blocks
+template <typename T>
+ConservedQuantitiesNorm<T> combine_L2_norms(
+    const std::vector<ConservedQuantitiesNorm<T>>& norms);
+
 #endif
@@ -1,6 +1,12 @@
+#include <doctest/doctest.h>
+#include <finite_volume/conserved_quantities.h>
 #include <finite_volume/convective_flux.h>
+#include <finite_volume/face_flux.h>
+#include <grid/structured_grid.h>
 #include <spdlog/spdlog.h>
+#include <util/dimension.h>
 #include <util/numeric_types.h>
+#include <util/profile.h>
 
 #include <stdexcept>
 
@@ -60,23 +66,27 @@ const RequiredGradients ConvectiveFlux<T>::required_gradients() const {
 template <typename T>
 ConvectiveFlux<T>::ConvectiveFlux(const GridBlock<T>& grid, json config) {
     // allocate memory for the reconstructed states to the left and
-    // right of the interfaces
-    left_ = FlowStates<T>(grid.num_interfaces());
-    right_ = FlowStates<T>(grid.num_interfaces());
+    // right of the interfaces. The fused kernel doesn't need them.
+    fused_ = config.at("fused");
+    if (!fused_) {
+        left_ = FlowStates<T>(grid.num_interfaces());
+        right_ = FlowStates<T>(grid.num_interfaces());
+    }
 
     // set up the flux calculator
     flux_calculator_ = make_flux_calculator<T>(config.at("flux_calculator"));
 
     // set up reconstruction
     reconstruction_order_ = config.at("reconstruction_order");
+    gradient_cells_ = grid.gradient_cells();
     if (reconstruction_order_ > 1) {
         reconstruction_vars_ =
             reconstruction_vars_from_string(config.at("thermo_interpolator"));
         limiter_ = make_limiter<T>(config.at("limiter"));
         if (limiter_->enabled()) {
             const RequiredGradients grads = required_gradients();
-            limiters_ = LimiterValues<T>(grid.num_cells(), grads.pressure, grads.rho,
-                                         grads.temp, grads.u);
+            limiters_ = LimiterValues<T>(gradient_cells_.storage_size(), grads.pressure,
+                                         grads.rho, grads.temp, grads.u);
         }
     }
 }
@@ -85,20 +95,59 @@ template <typename T>
 void ConvectiveFlux<T>::compute_convective_flux(
     const FlowStates<T>& flow_states, GridBlock<T>& grid, IdealGas<T>& gas_model,
     Gradients<T>& cell_grad, WLSGradient<T>& grad_calc, ConservedQuantities<T>& flux,
-    bool allow_reconstruction) {
-    // reconstruct
+    bool allow_reconstruction, bool compute_gradients) {
     int reconstruction_order = (allow_reconstruction) ? reconstruction_order_ : 1;
-    switch (reconstruction_order) {
-        case 1:
-            copy_reconstruct(flow_states, grid);
-            break;
-        case 2:
-            linear_reconstruct(flow_states, grid, cell_grad, grad_calc, gas_model);
-            break;
-        default:
-            spdlog::error("Invalid reconstruction order {}", reconstruction_order_);
-            throw new std::runtime_error("Invalid reconstruction order");
+
+    if (fused_) {
+        {
+            Ibis::ProfileRegion region("FV::reconstruction");
+            switch (reconstruction_order) {
+                case 1:
+                    break;
+                case 2:
+                    if (compute_gradients) {
+                        compute_convective_gradient(flow_states, grid, cell_grad,
+                                                    grad_calc);
+                        compute_limiters(flow_states, grid, cell_grad);
+                    }
+                    break;
+                default:
+                    spdlog::error("Invalid reconstruction order {}",
+                                  reconstruction_order_);
+                    throw new std::runtime_error("Invalid reconstruction order");
+            }
+        }
+
+        // the fused kernel reconstructs the face states as it goes, so
+        // that part of the reconstruction is counted in the flux
+        Ibis::ProfileRegion region("FV::flux_calculator");
+        flux_calculator_.visit([&](const auto& flux_function) {
+            Ibis::dispatch_dim(grid.dim(), [&](auto dim) {
+                constexpr int Dim = decltype(dim)::value;
+                fused_convective_flux_<Dim>(flow_states, grid, gas_model, cell_grad, flux,
+                                            reconstruction_order, flux_function);
+            });
+        });
+        return;
+    }
+
+    // reconstruct
+    {
+        Ibis::ProfileRegion region("FV::reconstruction");
+        switch (reconstruction_order) {
+            case 1:
+                copy_reconstruct(flow_states, grid);
+                break;
+            case 2:
+                linear_reconstruct(flow_states, grid, cell_grad, grad_calc, gas_model,
+                                   compute_gradients);
+                break;
+            default:
+                spdlog::error("Invalid reconstruction order {}", reconstruction_order_);
+                throw new std::runtime_error("Invalid reconstruction order");
+        }
     }
+    Ibis::ProfileRegion region("FV::flux_calculator");
 
     // transform the velocity at the interfaces to be in the frame of references
     // of the interface
@@ -117,7 +166,7 @@ void ConvectiveFlux<T>::compute_convective_flux(
     }
 
     // compute the flux
-    flux_calculator_->compute_flux(left_, right_, flux, gas_model, grid.dim() == 3);
+    flux_calculator_.compute_flux(left_, right_, flux, gas_model, grid.dim() == 3);
 
     // translate flux from interface reference frame to the global reference frame
     Vector3s<T> face_vel = grid.face_vel();
@@ -254,14 +303,92 @@ KOKKOS_INLINE_FUNCTION T linear_interpolate(T value, Vector3s<T> grad, T dx, T d
     return value + limiter * (grad_x * dx + grad_y * dy + grad_z * dz);
 }
 
+// The components of `a` in the frame of reference with axes norm, tan1, tan2
+template <typename T>
+KOKKOS_INLINE_FUNCTION Vector3<T> to_local_frame(const Vector3<T>& a,
+                                                 const Vector3<T>& norm,
+                                                 const Vector3<T>& tan1,
+                                                 const Vector3<T>& tan2) {
+    return Vector3<T>(a.x * norm.x + a.y * norm.y + a.z * norm.z,
+                      a.x * tan1.x + a.y * tan1.y + a.z * tan1.z,
+                      a.x * tan2.x + a.y * tan2.y + a.z * tan2.z);
+}
+
+// Linearly reconstruct the flow state at an interface, from the cell
+// `cell`. The interface centre is (dx, dy, dz) from the cell centre.
+template <typename T>
+KOKKOS_INLINE_FUNCTION FlowState<T> linear_reconstruct_state(
+    const FlowStates<T>& flow_states, const Gradients<T>& grad,
+    const LimiterValues<T>& limiters, const IdealGas<T>& gas_model,
+    ThermoReconstructionVars thermo_interpolator, size_t cell, T dx, T dy, T dz,
+    bool valid, bool limit) {
+    FlowState<T> state;
+    GasState<T>& gs = state.gas_state;
+    switch (thermo_interpolator) {
+        case ThermoReconstructionVars::rho_p: {
+            T p_limit = limit ? limiters.p(cell) : 1.0;
+            gs.pressure = linear_interpolate(flow_states.gas.pressure(cell), grad.p, dx,
+                                             dy, dz, cell, p_limit, valid);
+            T rho_limit = limit ? limiters.rho(cell) : 1.0;
+            gs.rho = linear_interpolate(flow_states.gas.rho(cell), grad.rho, dx, dy, dz,
+                                        cell, rho_limit, valid);
+            gas_model.update_thermo_from_rhop(gs);
+            break;
+        }
+        case ThermoReconstructionVars::rho_u: {
+            T rho_limit = limit ? limiters.rho(cell) : 1.0;
+            gs.rho = linear_interpolate(flow_states.gas.rho(cell), grad.rho, dx, dy, dz,
+                                        cell, rho_limit, valid);
+            T u_limit = limit ? limiters.u(cell) : 1.0;
+            gs.energy = linear_interpolate(flow_states.gas.energy(cell), grad.u, dx, dy,
+                                           dz, cell, u_limit, valid);
+            gas_model.update_thermo_from_rhou(gs);
+            break;
+        }
+        case ThermoReconstructionVars::rho_T: {
+            T rho_limit = limit ? limiters.rho(cell) : 1.0;
+            gs.rho = linear_interpolate(flow_states.gas.rho(cell), grad.rho, dx, dy, dz,
+                                        cell, rho_limit, valid);
+            T T_limit = limit ? limiters.temp(cell) : 1.0;
+            gs.temp = linear_interpolate(flow_states.gas.temp(cell), grad.temp, dx, dy,
+                                         dz, cell, T_limit, valid);
+            gas_model.update_thermo_from_rhoT(gs);
+            break;
+        }
+        case ThermoReconstructionVars::p_T: {
+            T p_limit = limit ? limiters.p(cell) : 1.0;
+            gs.pressure = linear_interpolate(flow_states.gas.pressure(cell), grad.p, dx,
+                                             dy, dz, cell, p_limit, valid);
+            T T_limit = limit ? limiters.temp(cell) : 1.0;
+            gs.temp = linear_interpolate(flow_states.gas.temp(cell), grad.temp, dx, dy,
+                                         dz, cell, T_limit, valid);
+            gas_model.update_thermo_from_pT(gs);
+            break;
+        }
+    }
+    T vx_limit = limit ? limiters.vx(cell) : 1.0;
+    state.velocity.x = linear_interpolate(flow_states.vel.x(cell), grad.vx, dx, dy, dz,
+                                          cell, vx_limit, valid);
+    T vy_limit = limit ? limiters.vy(cell) : 1.0;
+    state.velocity.y = linear_interpolate(flow_states.vel.y(cell), grad.vy, dx, dy, dz,
+                                          cell, vy_limit, valid);
+    T vz_limit = limit ? limiters.vz(cell) : 1.0;
+    state.velocity.z = linear_interpolate(flow_states.vel.z(cell), grad.vz, dx, dy, dz,
+                                          cell, vz_limit, valid);
+    return state;
+}
+
 template <typename T>
 void ConvectiveFlux<T>::linear_reconstruct(const FlowStates<T>& flow_states,
                                            const GridBlock<T>& grid,
                                            Gradients<T>& cell_grad,
                                            WLSGradient<T>& grad_calc,
-                                           IdealGas<T>& gas_model) {
-    compute_convective_gradient(flow_states, grid, cell_grad, grad_calc);
-    compute_limiters(flow_states, grid, cell_grad);
+                                           IdealGas<T>& gas_model,
+                                           bool compute_gradients) {
+    if (compute_gradients) {
+        compute_convective_gradient(flow_states, grid, cell_grad, grad_calc);
+        compute_limiters(flow_states, grid, cell_grad);
+    }
 
     auto limiters = limiters_;
     auto grad = cell_grad;
@@ -269,153 +396,141 @@ void ConvectiveFlux<T>::linear_reconstruct(const FlowStates<T>& flow_states,
     auto faces = grid.interfaces();
     auto left = left_;
     auto right = right_;
-    size_t num_cells = grid.num_cells();
+    GradientCells gradient_cells = gradient_cells_;
     bool limiter_enabled = limiter_->enabled();
     ThermoReconstructionVars thermo_interpolator = reconstruction_vars_;
     Kokkos::parallel_for(
         "FV::linear_reconstruct", grid.num_interfaces(), KOKKOS_LAMBDA(const int i_face) {
+            T x_face = faces.centre().x(i_face);
+            T y_face = faces.centre().y(i_face);
+            T z_face = faces.centre().z(i_face);
+
             // left state
             size_t left_cell = faces.left_cell(i_face);
-            bool left_valid = left_cell < num_cells;
+            bool left_valid = gradient_cells.contains(left_cell);
             bool limit_left = limiter_enabled && left_valid;
-            T dx = faces.centre().x(i_face) - cells.centroids().x(left_cell);
-            T dy = faces.centre().y(i_face) - cells.centroids().y(left_cell);
-            T dz = faces.centre().z(i_face) - cells.centroids().z(left_cell);
-
-            switch (thermo_interpolator) {
-                case ThermoReconstructionVars::rho_p: {
-                    T p_limit = limit_left ? limiters.p(left_cell) : 1.0;
-                    left.gas.pressure(i_face) =
-                        linear_interpolate(flow_states.gas.pressure(left_cell), grad.p,
-                                           dx, dy, dz, left_cell, p_limit, left_valid);
-                    T rho_limit = (limit_left) ? limiters.rho(left_cell) : 1.0;
-                    left.gas.rho(i_face) =
-                        linear_interpolate(flow_states.gas.rho(left_cell), grad.rho, dx,
-                                           dy, dz, left_cell, rho_limit, left_valid);
-                    gas_model.update_thermo_from_rhop(left.gas, i_face);
-                    break;
-                }
-                case ThermoReconstructionVars::rho_u: {
-                    T rho_limit = limit_left ? limiters.rho(left_cell) : 1.0;
-                    left.gas.rho(i_face) =
-                        linear_interpolate(flow_states.gas.rho(left_cell), grad.rho, dx,
-                                           dy, dz, left_cell, rho_limit, left_valid);
-                    T u_limit = (limit_left) ? limiters.u(left_cell) : 1.0;
-                    left.gas.energy(i_face) =
-                        linear_interpolate(flow_states.gas.energy(left_cell), grad.u, dx,
-                                           dy, dz, left_cell, u_limit, left_valid);
-                    gas_model.update_thermo_from_rhou(left.gas, i_face);
-                    break;
-                }
-                case ThermoReconstructionVars::rho_T: {
-                    T rho_limit = limit_left ? limiters.rho(left_cell) : 1.0;
-                    left.gas.rho(i_face) =
-                        linear_interpolate(flow_states.gas.rho(left_cell), grad.rho, dx,
-                                           dy, dz, left_cell, rho_limit, left_valid);
-                    T T_limit = (limit_left) ? limiters.temp(left_cell) : 1.0;
-                    left.gas.temp(i_face) =
-                        linear_interpolate(flow_states.gas.temp(left_cell), grad.temp, dx,
-                                           dy, dz, left_cell, T_limit, left_valid);
-                    gas_model.update_thermo_from_rhoT(left.gas, i_face);
-                    break;
-                }
-                case ThermoReconstructionVars::p_T: {
-                    T p_limit = limit_left ? limiters.p(left_cell) : 1.0;
-                    left.gas.pressure(i_face) =
-                        linear_interpolate(flow_states.gas.pressure(left_cell), grad.p,
-                                           dx, dy, dz, left_cell, p_limit, left_valid);
-                    T T_limit = (limit_left) ? limiters.temp(left_cell) : 1.0;
-                    left.gas.temp(i_face) =
-                        linear_interpolate(flow_states.gas.temp(left_cell), grad.temp, dx,
-                                           dy, dz, left_cell, T_limit, left_valid);
-                    gas_model.update_thermo_from_pT(left.gas, i_face);
-                    break;
-                }
-            }
-            T vx_limit = (limit_left) ? limiters.vx(left_cell) : 1.0;
-            left.vel.x(i_face) =
-                linear_interpolate(flow_states.vel.x(left_cell), grad.vx, dx, dy, dz,
-                                   left_cell, vx_limit, left_valid);
-            T vy_limit = (limit_left) ? limiters.vy(left_cell) : 1.0;
-            left.vel.y(i_face) =
-                linear_interpolate(flow_states.vel.y(left_cell), grad.vy, dx, dy, dz,
-                                   left_cell, vy_limit, left_valid);
-            T vz_limit = (limit_left) ? limiters.vz(left_cell) : 1.0;
-            left.vel.z(i_face) =
-                linear_interpolate(flow_states.vel.z(left_cell), grad.vz, dx, dy, dz,
-                                   left_cell, vz_limit, left_valid);
+            T dx = x_face - cells.centroids().x(left_cell);
+            T dy = y_face - cells.centroids().y(left_cell);
+            T dz = z_face - cells.centroids().z(left_cell);
+            left.set_flow_state(
+                linear_reconstruct_state(flow_states, grad, limiters, gas_model,
+                                         thermo_interpolator, left_cell, dx, dy, dz,
+                                         left_valid, limit_left),
+                i_face);
 
             // right state
             size_t right_cell = faces.right_cell(i_face);
-            bool right_valid = right_cell < num_cells;
+            bool right_valid = gradient_cells.contains(right_cell);
             bool limit_right = limiter_enabled && right_valid;
+            dx = x_face - cells.centroids().x(right_cell);
+            dy = y_face - cells.centroids().y(right_cell);
+            dz = z_face - cells.centroids().z(right_cell);
+            right.set_flow_state(
+                linear_reconstruct_state(flow_states, grad, limiters, gas_model,
+                                         thermo_interpolator, right_cell, dx, dy, dz,
+                                         right_valid, limit_right),
+                i_face);
+        });
+}
 
-            dx = faces.centre().x(i_face) - cells.centroids().x(right_cell);
-            dy = faces.centre().y(i_face) - cells.centroids().y(right_cell);
-            dz = faces.centre().z(i_face) - cells.centroids().z(right_cell);
-
-            switch (thermo_interpolator) {
-                case ThermoReconstructionVars::rho_p: {
-                    T p_limit = (limit_right) ? limiters.p(right_cell) : 1.0;
-                    right.gas.pressure(i_face) =
-                        linear_interpolate(flow_states.gas.pressure(right_cell), grad.p,
-                                           dx, dy, dz, right_cell, p_limit, right_valid);
-                    T rho_limit = (limit_right) ? limiters.rho(right_cell) : 1.0;
-                    right.gas.rho(i_face) =
-                        linear_interpolate(flow_states.gas.rho(right_cell), grad.rho, dx,
-                                           dy, dz, right_cell, rho_limit, right_valid);
-                    gas_model.update_thermo_from_rhop(right.gas, i_face);
-                    break;
-                }
-                case ThermoReconstructionVars::rho_u: {
-                    T u_limit = (limit_right) ? limiters.u(right_cell) : 1.0;
-                    right.gas.energy(i_face) =
-                        linear_interpolate(flow_states.gas.energy(right_cell), grad.u, dx,
-                                           dy, dz, right_cell, u_limit, right_valid);
-                    T rho_limit = (limit_right) ? limiters.rho(right_cell) : 1.0;
-                    right.gas.rho(i_face) =
-                        linear_interpolate(flow_states.gas.rho(right_cell), grad.rho, dx,
-                                           dy, dz, right_cell, rho_limit, right_valid);
-                    gas_model.update_thermo_from_rhou(right.gas, i_face);
-                    break;
-                }
-                case ThermoReconstructionVars::rho_T: {
-                    T T_limit = (limit_right) ? limiters.temp(right_cell) : 1.0;
-                    right.gas.temp(i_face) =
-                        linear_interpolate(flow_states.gas.temp(right_cell), grad.temp,
-                                           dx, dy, dz, right_cell, T_limit, right_valid);
-                    T rho_limit = (limit_right) ? limiters.rho(right_cell) : 1.0;
-                    right.gas.rho(i_face) =
-                        linear_interpolate(flow_states.gas.rho(right_cell), grad.rho, dx,
-                                           dy, dz, right_cell, rho_limit, right_valid);
-                    gas_model.update_thermo_from_rhoT(right.gas, i_face);
-                    break;
-                }
-                case ThermoReconstructionVars::p_T: {
-                    T T_limit = (limit_right) ? limiters.temp(right_cell) : 1.0;
-                    right.gas.temp(i_face) =
-                        linear_interpolate(flow_states.gas.temp(right_cell), grad.temp,
-                                           dx, dy, dz, right_cell, T_limit, right_valid);
-                    T p_limit = (limit_right) ? limiters.p(right_cell) : 1.0;
-                    right.gas.pressure(i_face) =
-                        linear_interpolate(flow_states.gas.pressure(right_cell), grad.p,
-                                           dx, dy, dz, right_cell, p_limit, right_valid);
-                    gas_model.update_thermo_from_pT(right.gas, i_face);
-                    break;
+template <typename T>
+template <int Dim, class FluxFunction>
+void ConvectiveFlux<T>::fused_convective_flux_(
+    const FlowStates<T>& flow_states, GridBlock<T>& grid, IdealGas<T>& gas_model,
+    Gradients<T>& cell_grad, ConservedQuantities<T>& flux, int reconstruction_order,
+    const FluxFunction& flux_function) {
+    auto limiters = limiters_;
+    auto grad = cell_grad;
+    auto cells = grid.cells();
+    auto faces = grid.interfaces();
+    Vector3s<T> face_vel = grid.face_vel();
+    bool moving_grid = grid.moving();
+    GradientCells gradient_cells = gradient_cells_;
+    bool linear = reconstruction_order == 2;
+    bool limiter_enabled = linear && limiter_->enabled();
+    ThermoReconstructionVars thermo_interpolator = reconstruction_vars_;
+    Kokkos::parallel_for(
+        "ConvectiveFlux::fused_flux", grid.num_interfaces(),
+        KOKKOS_LAMBDA(const size_t i_face) {
+            // reconstruct the left and right states
+            size_t left_cell = faces.left_cell(i_face);
+            size_t right_cell = faces.right_cell(i_face);
+            FlowState<T> left;
+            FlowState<T> right;
+            if (linear) {
+                T x_face = faces.centre().x(i_face);
+                T y_face = faces.centre().y(i_face);
+                T z_face = faces.centre().z(i_face);
+
+                bool left_valid = gradient_cells.contains(left_cell);
+                left = linear_reconstruct_state(
+                    flow_states, grad, limiters, gas_model, thermo_interpolator,
+                    left_cell, x_face - cells.centroids().x(left_cell),
+                    y_face - cells.centroids().y(left_cell),
+                    z_face - cells.centroids().z(left_cell), left_valid,
+                    limiter_enabled && left_valid);
+
+                bool right_valid = gradient_cells.contains(right_cell);
+                right = linear_reconstruct_state(
+                    flow_states, grad, limiters, gas_model, thermo_interpolator,
+                    right_cell, x_face - cells.centroids().x(right_cell),
+                    y_face - cells.centroids().y(right_cell),
+                    z_face - cells.centroids().z(right_cell), right_valid,
+                    limiter_enabled && right_valid);
+            } else {
+                left = flow_states.flow_state(left_cell);
+                right = flow_states.flow_state(right_cell);
+            }
+
+            // velocities relative to the interface, in the interface's
+            // frame of reference
+            Vector3<T> norm(faces.norm().x(i_face), faces.norm().y(i_face),
+                            faces.norm().z(i_face));
+            Vector3<T> tan1(faces.tan1().x(i_face), faces.tan1().y(i_face),
+                            faces.tan1().z(i_face));
+            Vector3<T> tan2(faces.tan2().x(i_face), faces.tan2().y(i_face),
+                            faces.tan2().z(i_face));
+            Vector3<T> vel_face;
+            if (moving_grid) {
+                vel_face = Vector3<T>(face_vel.x(i_face), face_vel.y(i_face),
+                                      face_vel.z(i_face));
+                left.velocity.x -= vel_face.x;
+                left.velocity.y -= vel_face.y;
+                left.velocity.z -= vel_face.z;
+                right.velocity.x -= vel_face.x;
+                right.velocity.y -= vel_face.y;
+                right.velocity.z -= vel_face.z;
+                vel_face = to_local_frame(vel_face, norm, tan1, tan2);
+            }
+            left.velocity = to_local_frame(left.velocity, norm, tan1, tan2);
+            right.velocity = to_local_frame(right.velocity, norm, tan1, tan2);
+
+            // the flux in the interface's frame of reference
+            FaceFlux<T> face_flux = flux_function(left, right, gas_model);
+
+            if (moving_grid) {
+                T v_sqr = vel_face.x * vel_face.x + vel_face.y * vel_face.y +
+                          vel_face.z * vel_face.z;
+                face_flux.energy += 0.5 * face_flux.mass * v_sqr +
+                                    face_flux.momentum_x * vel_face.x +
+                                    face_flux.momentum_y * vel_face.y;
+                if constexpr (Dim == 3) {
+                    face_flux.energy += face_flux.momentum_z * vel_face.z;
                 }
+                face_flux.momentum_x += vel_face.x * face_flux.mass;
+                face_flux.momentum_y += vel_face.y * face_flux.mass;
+                face_flux.momentum_z += vel_face.z * face_flux.mass;
             }
-            vx_limit = limit_right ? limiters.vx(right_cell) : 1.0;
-            right.vel.x(i_face) =
-                linear_interpolate(flow_states.vel.x(right_cell), grad.vx, dx, dy, dz,
-                                   right_cell, vx_limit, right_valid);
-            vy_limit = (limit_right) ? limiters.vy(right_cell) : 1.0;
-            right.vel.y(i_face) =
-                linear_interpolate(flow_states.vel.y(right_cell), grad.vy, dx, dy, dz,
-                                   right_cell, vy_limit, right_valid);
-            vz_limit = (limit_right) ? limiters.vz(right_cell) : 1.0;
-            right.vel.z(i_face) =
-                linear_interpolate(flow_states.vel.z(right_cell), grad.vz, dx, dy, dz,
-                                   right_cell, vz_limit, right_valid);
+
+            // rotate the momentum flux to the global frame
+            T px = face_flux.momentum_x;
+            T py = face_flux.momentum_y;
+            T pz = (Dim == 3) ? face_flux.momentum_z : T(0.0);
+            face_flux.momentum_x = px * norm.x + py * tan1.x + pz * tan2.x;
+            face_flux.momentum_y = px * norm.y + py * tan1.y + pz * tan2.y;
+            face_flux.momentum_z = px * norm.z + py * tan1.z + pz * tan2.z;
+
+            set_face_flux<Dim>(flux, face_flux, i_face);
         });
 }
 
@@ -424,42 +539,144 @@ void ConvectiveFlux<T>::compute_limiters(const FlowStates<T>& flow_states,
                                          const GridBlock<T>& grid,
                                          Gradients<T>& cell_grad) {
     if (limiter_->enabled()) {
-        auto cells = grid.cells();
-        auto faces = grid.interfaces();
         switch (reconstruction_vars_) {
             case ThermoReconstructionVars::rho_p:
                 limiter_->calculate_limiters(flow_states.gas.pressure(), limiters_.p,
-                                             cells, faces, cell_grad.p);
-                limiter_->calculate_limiters(flow_states.gas.rho(), limiters_.rho, cells,
-                                             faces, cell_grad.rho);
+                                             grid, cell_grad.p);
+                limiter_->calculate_limiters(flow_states.gas.rho(), limiters_.rho, grid,
+                                             cell_grad.rho);
                 break;
             case ThermoReconstructionVars::rho_u:
-                limiter_->calculate_limiters(flow_states.gas.rho(), limiters_.rho, cells,
-                                             faces, cell_grad.rho);
-                limiter_->calculate_limiters(flow_states.gas.energy(), limiters_.u, cells,
-                                             faces, cell_grad.u);
+                limiter_->calculate_limiters(flow_states.gas.rho(), limiters_.rho, grid,
+                                             cell_grad.rho);
+                limiter_->calculate_limiters(flow_states.gas.energy(), limiters_.u, grid,
+                                             cell_grad.u);
                 break;
             case ThermoReconstructionVars::rho_T:
-                limiter_->calculate_limiters(flow_states.gas.rho(), limiters_.rho, cells,
-                                             faces, cell_grad.rho);
-                limiter_->calculate_limiters(flow_states.gas.temp(), limiters_.temp,
-                                             cells, faces, cell_grad.temp);
+                limiter_->calculate_limiters(flow_states.gas.rho(), limiters_.rho, grid,
+                                             cell_grad.rho);
+                limiter_->calculate_limiters(flow_states.gas.temp(), limiters_.temp, grid,
+                                             cell_grad.temp);
                 break;
             case ThermoReconstructionVars::p_T:
                 limiter_->calculate_limiters(flow_states.gas.pressure(), limiters_.p,
-                                             cells, faces, cell_grad.p);
-                limiter_->calculate_limiters(flow_states.gas.temp(), limiters_.temp,
-                                             cells, faces, cell_grad.temp);
+                                             grid, cell_grad.p);
+                limiter_->calculate_limiters(flow_states.gas.temp(), limiters_.temp, grid,
+                                             cell_grad.temp);
                 break;
         }
-        limiter_->calculate_limiters(flow_states.vel.x(), limiters_.vx, cells, faces,
+        limiter_->calculate_limiters(flow_states.vel.x(), limiters_.vx, grid,
                                      cell_grad.vx);
-        limiter_->calculate_limiters(flow_states.vel.y(), limiters_.vy, cells, faces,
+        limiter_->calculate_limiters(flow_states.vel.y(), limiters_.vy, grid,
                                      cell_grad.vy);
-        limiter_->calculate_limiters(flow_states.vel.z(), limiters_.vz, cells, faces,
+        limiter_->calculate_limiters(flow_states.vel.z(), limiters_.vz, grid,
                                      cell_grad.vz);
     }
 }
 
 template class ConvectiveFlux<Ibis::real>;
 template class ConvectiveFlux<Ibis::dual>;
+template class ConvectiveFlux<Ibis::dual4>;
+
+#ifndef DOCTEST_CONFIG_DISABLE
+namespace {
+
+// The convective fluxes of a smooth supersonic flow on a structured grid,
+// computed with the fused or unfused kernels
+ConservedQuantities<Ibis::real> convective_fluxes_(size_t nz, size_t order, bool fused) {
+    GridIO grid_io = structured_grid(6, 5, nz);
+    json boundaries;
+    for (const auto& [tag, faces] : grid_io.markers()) {
+        boundaries[tag] = {{"ghost_cells", true}};
+    }
+    json grid_config{{"boundaries", boundaries},
+                     {"motion", {{"enabled", false}}},
+                     {"renumber", "none"},
+                     {"cache", false},
+                     {"geometry_cache",
+                      {{"face_weights", true},
+                       {"signed_areas", true},
+                       {"inverse_volumes", true},
+                       {"centre_offsets", true}}}};
+    GridBlock<Ibis::real> grid(grid_io, grid_config);
+    grid.allocate_gradient_weights();
+
+    json config{{"flux_calculator", {{"type", "hanel"}}},
+                {"reconstruction_order", order},
+                {"limiter", {{"type", "barth_jespersen"}, {"epsilon", 1e-25}}},
+                {"thermo_interpolator", "rho_u"},
+                {"fused", fused}};
+    ConvectiveFlux<Ibis::real> convective_flux(grid, config);
+
+    IdealGas<Ibis::real> gas_model(287.0);
+    FlowStates<Ibis::real> fs(grid.num_total_cells());
+    auto centroids = grid.cells().centroids();
+    size_t n_cells = grid.num_cells();
+    Kokkos::parallel_for(
+        "test::fill_flow_states", fs.number_flow_states(),
+        KOKKOS_LAMBDA(const size_t i) {
+            Ibis::real wave = Kokkos::sin(0.7 * i);
+            if (i < n_cells) {
+                wave = Kokkos::sin(6.0 * centroids.x(i)) *
+                       Kokkos::cos(4.0 * centroids.y(i)) *
+                       Kokkos::cos(3.0 * centroids.z(i));
+            }
+            fs.gas.rho(i) = 1.0 + 0.1 * wave;
+            fs.gas.temp(i) = 300.0 - 20.0 * wave;
+            fs.vel.x(i) = 600.0 + 50.0 * wave;
+            fs.vel.y(i) = 30.0 * wave;
+            fs.vel.z(i) = (nz > 0) ? -20.0 * wave : 0.0;
+        });
+    gas_model.update_thermo_from_rhoT(fs.gas);
+
+    const RequiredGradients grads = convective_flux.required_gradients();
+    Gradients<Ibis::real> cell_grad(n_cells, grads.pressure, grads.temp, grads.u,
+                                    grads.rho, false);
+    ConservedQuantities<Ibis::real> flux(grid.num_interfaces(), grid.dim());
+    convective_flux.compute_convective_flux(fs, grid, gas_model, cell_grad,
+                                            grid.grad_calc(), flux, true);
+    return flux;
+}
+
+// The largest difference between two sets of fluxes, relative to the
+// largest flux
+Ibis::real max_relative_difference_(const ConservedQuantities<Ibis::real>& a,
+                                    const ConservedQuantities<Ibis::real>& b) {
+    size_t n_conserved = a.n_conserved();
+    Ibis::real max_difference = 0.0;
+    Kokkos::parallel_reduce(
+        "test::max_difference", a.size(),
+        KOKKOS_LAMBDA(const size_t i, Ibis::real& difference) {
+            for (size_t j = 0; j < n_conserved; j++) {
+                difference = Kokkos::max(difference, Kokkos::abs(a(i, j) - b(i, j)));
+            }
+        },
+        Kokkos::Max<Ibis::real>(max_difference));
+    Ibis::real max_value = 0.0;
+    Kokkos::parallel_reduce(
+        "test::max_value", a.size(),
+        KOKKOS_LAMBDA(const size_t i, Ibis::real& value) {
+            for (size_t j = 0; j < n_conserved; j++) {
+                value = Kokkos::max(value, Kokkos::abs(a(i, j)));
+            }
+        },
+        Kokkos::Max<Ibis::real>(max_value));
+    return max_difference / max_value;
+}
+
+}  // namespace
+
+// the fused kernel should give the same fluxes as the separate
+// reconstruction, rotation and flux kernels, in 2D and 3D
+TEST_CASE("fused convective flux") {
+    for (size_t nz : {0, 4}) {
+        for (size_t order : {1, 2}) {
+            CAPTURE(nz);
+            CAPTURE(order);
+            auto unfused = convective_fluxes_(nz, order, false);
+            auto fused = convective_fluxes_(nz, order, true);
+            CHECK(max_relative_difference_(fused, unfused) < 1e-13);
+        }
+    }
+}
+#endif
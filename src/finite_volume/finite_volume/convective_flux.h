@@ -35,12 +35,17 @@ public:
 
     ConvectiveFlux(const GridBlock<T>& grid, json config);
 
-    // Compute the convective fluxes. Includes gradient calculation,
-    // but not boundary conditions
+    // Compute the convective fluxes. Includes gradient calculation
+    // (unless compute_gradients is false, when the gradients and limiters
+    // have already been computed), but not boundary conditions. In fused
+    // mode, the reconstruction, rotation into and out of the interface
+    // frame, and the flux calculation are done together for each
+    // interface, without storing the reconstructed left and right states.
     void compute_convective_flux(const FlowStates<T>& flow_states, GridBlock<T>& grid,
                                  IdealGas<T>& gas_model, Gradients<T>& cell_grad,
                                  WLSGradient<T>& grad_calc, ConservedQuantities<T>& flux,
-                                 bool allow_reconstruction);
+                                 bool allow_reconstruction,
+                                 bool compute_gradients = true);
 
     // Compute the convective gradients. This could be private,
     // except for the fact that we might want to compute
@@ -54,17 +59,29 @@ public:
 
     void linear_reconstruct(const FlowStates<T>& flow_states, const GridBlock<T>& grid,
                             Gradients<T>& cell_grad, WLSGradient<T>& grad_calc,
-                            IdealGas<T>& gas_model);
+                            IdealGas<T>& gas_model, bool compute_gradients = true);
 
     void compute_limiters(const FlowStates<T>& flow_states, const GridBlock<T>& grid,
                           Gradients<T>& cell_grad);
 
     size_t reconstruction_order() const { return reconstruction_order_; }
 
+    // the limiter values of each cell with gradients (if the limiter is enabled)
+    const LimiterValues<T>& limiters() const { return limiters_; }
+
+    bool fused() const { return fused_; }
+
     ThermoReconstructionVars thermo_interp() const { return reconstruction_vars_; }
 
     const RequiredGradients required_gradients() const;
 
+public:  // this is public to appease NVCC
+    template <int Dim, class FluxFunction>
+    void fused_convective_flux_(const FlowStates<T>& flow_states, GridBlock<T>& grid,
+                                IdealGas<T>& gas_model, Gradients<T>& cell_grad,
+                                ConservedQuantities<T>& flux, int reconstruction_order,
+                                const FluxFunction& flux_function);
+
 private:
     // The flow states to the left of the interface
     FlowStates<T> left_;
@@ -73,7 +90,10 @@ private:
     FlowStates<T> right_;
 
     // The flux calculator
-    std::unique_ptr<FluxCalculator<T>> flux_calculator_;
+    FluxCalculator<T> flux_calculator_;
+
+    // Compute the fluxes with a single kernel over the interfaces
+    bool fused_;
 
     // reconstruction order
     size_t reconstruction_order_;
@@ -85,6 +105,9 @@ private:
 
     // Storage for the limiter values
     LimiterValues<T> limiters_;
+
+    // The cells which have gradients and limiters
+    GradientCells gradient_cells_;
 };
 
 #endif
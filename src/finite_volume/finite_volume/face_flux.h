@@ -0,0 +1,364 @@
+#ifndef FACE_FLUX_H
+#define FACE_FLUX_H
+
+#include <finite_volume/conserved_quantities.h>
+#include <gas/flow_state.h>
+#include <gas/gas_model.h>
+#include <util/numeric_types.h>
+
+#include <Kokkos_Core.hpp>
+#include <string>
+
+// The flux of each conserved quantity through a single interface
+template <typename T>
+struct FaceFlux {
+    KOKKOS_INLINE_FUNCTION
+    FaceFlux() {}
+
+    T mass;
+    T momentum_x;
+    T momentum_y;
+    T momentum_z;
+    T energy;
+};
+
+template <int Dim, typename T>
+KOKKOS_INLINE_FUNCTION void set_face_flux(const ConservedQuantities<T>& flux,
+                                          const FaceFlux<T>& face_flux, const size_t i) {
+    flux.mass(i) = face_flux.mass;
+    flux.momentum_x(i) = face_flux.momentum_x;
+    flux.momentum_y(i) = face_flux.momentum_y;
+    if constexpr (Dim == 3) {
+        flux.momentum_z(i) = face_flux.momentum_z;
+    }
+    flux.energy(i) = face_flux.energy;
+}
+
+// The flux calculators for a single interface. The flow states
+// must already be in the frame of reference of the interface.
+// These are used by the flux calculators, and by the fused
+// convective flux kernel.
+
+template <typename T>
+struct HanelFlux {
+    KOKKOS_INLINE_FUNCTION
+    FaceFlux<T> operator()(const FlowState<T>& left, const FlowState<T>& right,
+                           const IdealGas<T>& gm) const {
+        // unpack left gas state
+        T rL = left.gas_state.rho;
+        T pL = left.gas_state.pressure;
+        T eL = gm.internal_energy(left.gas_state);
+        T aL = gm.speed_of_sound(left.gas_state);
+        T uL = left.velocity.x;
+        T vL = left.velocity.y;
+        T wL = left.velocity.z;
+        T keL = 0.5 * (uL * uL + vL * vL + wL * wL);
+        T pLrL = pL / rL;
+        T HL = eL + pLrL + keL;
+
+        // unpack right gas state
+        T rR = right.gas_state.rho;
+        T pR = right.gas_state.pressure;
+        T eR = gm.internal_energy(right.gas_state);
+        T aR = gm.speed_of_sound(right.gas_state);
+        T uR = right.velocity.x;
+        T vR = right.velocity.y;
+        T wR = right.velocity.z;
+        T keR = 0.5 * (uR * uR + vR * vR + wR * wR);
+        T pRrR = pR / rR;
+        T HR = eR + pRrR + keR;
+
+        // pressure and velocity splitting (eqn. 7 and 9)
+        T pLplus, uLplus;
+        if (Ibis::abs(uL) <= aL) {
+            uLplus = 1.0 / (4.0 * aL) * (uL + aL) * (uL + aL);
+            pLplus = pL * uLplus * (1.0 / aL * (2.0 - uL / aL));
+        } else {
+            uLplus = 0.5 * (uL + Ibis::abs(uL));
+            pLplus = pL * uLplus * (1.0 / uL);
+        }
+
+        T pRminus, uRminus;
+        if (Ibis::abs(uR) <= aR) {
+            uRminus = -1.0 / (4.0 * aR) * (uR - aR) * (uR - aR);
+            pRminus = pR * uRminus * (1.0 / aR * (-2.0 - uR / aR));
+        } else {
+            uRminus = 0.5 * (uR - Ibis::abs(uR));
+            pRminus = pR * uRminus * (1.0 / uR);
+        }
+
+        // the final fluxes
+        T p_half = pLplus + pRminus;
+        FaceFlux<T> flux;
+        flux.mass = uLplus * rL + uRminus * rR;
+        flux.momentum_x = uLplus * rL * uL + uRminus * rR * uR + p_half;
+        flux.momentum_y = uLplus * rL * vL + uRminus * rR * vR;
+        flux.momentum_z = uLplus * rL * wL + uRminus * rR * wR;
+        flux.energy = uLplus * rL * HL + uRminus * rR * HR;
+        return flux;
+    }
+};
+
+template <typename T>
+struct AusmdvFlux {
+    KOKKOS_INLINE_FUNCTION
+    FaceFlux<T> operator()(const FlowState<T>& left, const FlowState<T>& right,
+                           const IdealGas<T>& gm) const {
+        T rL = left.gas_state.rho;
+        T pL = left.gas_state.pressure;
+        T pLrL = pL / rL;
+        T uL = left.velocity.x;
+        T vL = left.velocity.y;
+        T wL = left.velocity.z;
+        T eL = gm.internal_energy(left.gas_state);
+        T aL = gm.speed_of_sound(left.gas_state);
+        T keL = 0.5 * (uL * uL + vL * vL + wL * wL);
+        T HL = eL + pLrL + keL;
+
+        T rR = right.gas_state.rho;
+        T pR = right.gas_state.pressure;
+        T pRrR = pR / rR;
+        T uR = right.velocity.x;
+        T vR = right.velocity.y;
+        T wR = right.velocity.z;
+        T eR = gm.internal_energy(right.gas_state);
+        T aR = gm.speed_of_sound(right.gas_state);
+        T keR = 0.5 * (uR * uR + vR * vR + wR * wR);
+        T HR = eR + pRrR + keR;
+
+        // This is the main part of the flux calculator.
+        // Weighting parameters (eqn 32) for velocity splitting.
+        T alphaL = 2.0 * pLrL / (pLrL + pRrR);
+        T alphaR = 2.0 * pRrR / (pLrL + pRrR);
+
+        // Common sound speed (eqn 33) and Mach doubles.
+        T am = Ibis::max(aL, aR);
+        T ML = uL / am;
+        T MR = uR / am;
+
+        // Left state:
+        // pressure splitting (eqn 34)
+        // and velocity splitting (eqn 30)
+        T pLplus, uLplus;
+        T duL = 0.5 * (uL + Ibis::abs(uL));
+        if (Ibis::abs(ML) <= 1.0) {
+            pLplus = pL * (ML + 1.0) * (ML + 1.0) * (2.0 - ML) * 0.25;
+            uLplus = alphaL * ((uL + am) * (uL + am) / (4.0 * am) - duL) + duL;
+        } else {
+            pLplus = pL * duL / uL;
+            uLplus = duL;
+        }
+
+        // Right state:
+        // pressure splitting (eqn 34)
+        // and velocity splitting (eqn 31)
+        T pRminus, uRminus;
+        T duR = 0.5 * (uR - Ibis::abs(uR));
+        if (Ibis::abs(MR) <= 1.0) {
+            pRminus = pR * (MR - 1.0) * (MR - 1.0) * (2.0 + MR) * 0.25;
+            uRminus = alphaR * (-(uR - am) * (uR - am) / (4.0 * am) - duR) + duR;
+        } else {
+            pRminus = pR * duR / uR;
+            uRminus = duR;
+        }
+
+        // Mass Flux (eqn 29)
+        // The mass flux is relative to the moving interface.
+        T ru_half = uLplus * rL + uRminus * rR;
+
+        // Pressure flux (eqn 34)
+        T p_half = pLplus + pRminus;
+
+        // Momentum flux: normal direction
+        // Compute blending parameter s (eqn 37),
+        // the momentum flux for AUSMV (eqn 21) and AUSMD (eqn 21)
+        // and blend (eqn 36).
+        T dp = pL - pR;
+        const T K_SWITCH = 10.0;
+        dp = K_SWITCH * Ibis::abs(dp) / Ibis::min(pL, pR);
+        T s = 0.5 * Ibis::min(1.0, dp);
+        T ru2_AUSMV = uLplus * rL * uL + uRminus * rR * uR;
+        T ru2_AUSMD = 0.5 * (ru_half * (uL + uR) - Ibis::abs(ru_half) * (uR - uL));
+        T ru2_half = (0.5 + s) * ru2_AUSMV + (0.5 - s) * ru2_AUSMD;
+
+        // Assemble components of the flux vector.
+        FaceFlux<T> flux;
+        flux.mass = ru_half;
+        if (ru_half >= 0.0) {
+            // Wind is blowing from the left.
+            flux.momentum_x = (ru2_half + p_half);
+            flux.momentum_y = (ru_half * vL);
+            flux.momentum_z = (ru_half * wL);
+            flux.energy = ru_half * HL;
+        } else {
+            // Wind is blowing from the right.
+            flux.momentum_x = (ru2_half + p_half);
+            flux.momentum_y = (ru_half * vR);
+            flux.momentum_z = (ru_half * wR);
+            flux.energy = ru_half * HR;
+        }
+
+        // Apply entropy fix (section 3.5 in Wada and Liou's paper)
+        const T C_EFIX = 0.125;
+        bool caseA = ((uL - aL) < 0.0) && ((uR - aR) > 0.0);
+        bool caseB = ((uL + aL) < 0.0) && ((uR + aR) > 0.0);
+        T d_ua = 0.0;
+        if (caseA && !caseB) {
+            d_ua = C_EFIX * ((uR - aR) - (uL - aL));
+        }
+        if (caseB && !caseA) {
+            d_ua = C_EFIX * ((uR + aR) - (uL + aL));
+        }
+        if (d_ua != 0.0) {
+            flux.mass -= d_ua * (rR - rL);
+            flux.momentum_x -= d_ua * (rR * uR - rL * uL);
+            flux.momentum_y -= d_ua * (rR * vR - rL * vL);
+            flux.momentum_z -= d_ua * (rR * wR - rL * wL);
+            flux.energy -= d_ua * (rR * HR - rL * HL);
+        }
+        return flux;
+    }
+};
+
+template <typename T>
+struct Ldfss2Flux {
+    KOKKOS_INLINE_FUNCTION
+    Ldfss2Flux(Ibis::real delta) : delta(delta) {}
+
+    KOKKOS_INLINE_FUNCTION
+    FaceFlux<T> operator()(const FlowState<T>& left, const FlowState<T>& right,
+                           const IdealGas<T>& gm) const {
+        // unpack left flow state
+        T rL = left.gas_state.rho;
+        T pL = left.gas_state.pressure;
+        T pLrL = pL / rL;
+        T uL = left.velocity.x;
+        T vL = left.velocity.y;
+        T wL = left.velocity.z;
+        T eL = gm.internal_energy(left.gas_state);
+        T aL = gm.speed_of_sound(left.gas_state);
+        T keL = 0.5 * (uL * uL + vL * vL + wL * wL);
+        T HL = eL + pLrL + keL;
+
+        // unpack right flow state
+        T rR = right.gas_state.rho;
+        T pR = right.gas_state.pressure;
+        T pRrR = pR / rR;
+        T uR = right.velocity.x;
+        T vR = right.velocity.y;
+        T wR = right.velocity.z;
+        T eR = gm.internal_energy(right.gas_state);
+        T aR = gm.speed_of_sound(right.gas_state);
+        T keR = 0.5 * (uR * uR + vR * vR + wR * wR);
+        T HR = eR + pRrR + keR;
+
+        // common sound speed, and mach numbers
+        T am = 0.5 * (aL + aR);
+        T ML = uL / am;
+        T MR = uR / am;
+
+        // split mach numbers
+        T MpL = 0.25 * (ML + 1.0) * (ML + 1.0);
+        T MmR = -0.25 * (MR - 1.0) * (MR - 1.0);
+
+        // parameters to provide correct sonic-point transition behaviour
+        T alphaL = 0.5 * (1.0 + Ibis::copysign(T(1.0), ML));
+        T alphaR = 0.5 * (1.0 - Ibis::copysign(T(1.0), MR));
+
+        // equation 17
+        T betaL = -Ibis::max(0.0, 1.0 - Ibis::floor(Ibis::abs(ML)));
+        T betaR = -Ibis::max(0.0, 1.0 - Ibis::floor(Ibis::abs(MR)));
+
+        // subsonic pressure splitting (eqn 12)
+        T PL = 0.25 * (ML + 1.0) * (ML + 1.0) * (2.0 - ML);
+        T PR = 0.25 * (MR - 1.0) * (MR - 1.0) * (2.0 + MR);
+
+        // eqn 11
+        T DL = alphaL * (1.0 + betaL) - betaL * PL;
+        T DR = alphaR * (1.0 + betaR) - betaR * PR;
+
+        T Mhalf = 0.25 * betaL * betaR *
+                  Ibis::pow((Ibis::sqrt(0.5 * (ML * ML + MR * MR)) - 1.0), T(2.0));
+
+        T MhalfL =
+            Mhalf * (1.0 - ((pL - pR) / (pL + pR) + delta * (Ibis::abs(pL - pR) / pL)));
+        T MhalfR =
+            Mhalf * (1.0 + ((pL - pR) / (pL + pR) - delta * (Ibis::abs(pL - pR) / pR)));
+
+        // C parameter for LDFSS (2) (eqn 13 & eqn 14 & eqn 26 & eqn 27)
+        T CL = alphaL * (1.0 + betaL) * ML - betaL * MpL - MhalfL;
+        T CR = alphaR * (1.0 + betaR) * MR - betaR * MmR + MhalfR;
+
+        T ru_half = am * rL * CL + am * rR * CR;
+        T ru2_half = am * rL * CL * uL + am * rR * CR * uR;
+        T p_half = DL * pL + DR * pR;
+        FaceFlux<T> flux;
+        flux.mass = ru_half;
+        flux.momentum_x = ru2_half + p_half;
+        flux.momentum_y = am * rL * CL * vL + am * rR * CR * vR;
+        flux.momentum_z = am * rL * CL * wL + am * rR * CR * wR;
+        flux.energy = am * rL * CL * HL + am * rR * CR * HR;
+        return flux;
+    }
+
+    Ibis::real delta;
+};
+
+template <typename T>
+struct RusanovFlux {
+    KOKKOS_INLINE_FUNCTION
+    FaceFlux<T> operator()(const FlowState<T>& left, const FlowState<T>& right,
+                           const IdealGas<T>& gm) const {
+        T rL = left.gas_state.rho;
+        T eL = gm.internal_energy(left.gas_state);
+        T pL = left.gas_state.pressure;
+        T uL = left.velocity.x;
+        T vL = left.velocity.y;
+        T wL = left.velocity.z;
+        T ruL = rL * uL;
+        T keL = 0.5 * (uL * uL + vL * vL + wL * wL);
+        T HL = eL + pL / rL + keL;
+        T aL = gm.speed_of_sound(left.gas_state);
+
+        T rR = right.gas_state.rho;
+        T eR = gm.internal_energy(right.gas_state);
+        T pR = right.gas_state.pressure;
+        T uR = right.velocity.x;
+        T vR = right.velocity.y;
+        T wR = right.velocity.z;
+        T ruR = rR * uR;
+        T keR = 0.5 * (uR * uR + vR * vR + wR * wR);
+        T HR = eR + pR / rR + keR;
+        T aR = gm.speed_of_sound(right.gas_state);
+
+        T S_plus = Ibis::max(Ibis::abs(uL - aL), Ibis::abs(uR - aR));
+        S_plus = Ibis::max(S_plus, Ibis::abs(uL + aL));
+        S_plus = Ibis::max(S_plus, Ibis::abs(uR + aR));
+
+        FaceFlux<T> flux;
+        flux.mass = 0.5 * (ruL + ruR) - 0.5 * S_plus * (rR - rL);
+        flux.momentum_x =
+            0.5 * (ruL * uL + pL + ruR * uR + pR) - 0.5 * S_plus * (rR * uR - rL * uL);
+        flux.momentum_y =
+            0.5 * (ruL * vL + ruR * vR) - 0.5 * S_plus * (rR * vR - rL * vL);
+        flux.momentum_z =
+            0.5 * (ruL * wL + ruR * wR) - 0.5 * S_plus * (rR * wR - rL * wL);
+        flux.energy = 0.5 * (ruL * HL + ruR * HR) - 0.5 * S_plus * (rR * HR - rL * HL);
+        return flux;
+    }
+};
+
+// Evaluate a single interface flux calculator on every interface
+template <int Dim, typename T, class FluxFunction>
+void compute_face_fluxes(const std::string& label, const FluxFunction& flux_function,
+                         const FlowStates<T>& left, const FlowStates<T>& right,
+                         ConservedQuantities<T>& flux, IdealGas<T>& gm) {
+    Kokkos::parallel_for(
+        label, flux.size(), KOKKOS_LAMBDA(const size_t i) {
+            FaceFlux<T> face_flux =
+                flux_function(left.flow_state(i), right.flow_state(i), gm);
+            set_face_flux<Dim>(flux, face_flux, i);
+        });
+}
+
+#endif
@@ -3,6 +3,7 @@
 #include <finite_volume/finite_volume.h>
 #include <finite_volume/flux_calc.h>
 #include <util/numeric_types.h>
+#include <util/profile.h>
 
 #include <stdexcept>
 
@@ -34,8 +35,9 @@ FiniteVolume<T>::FiniteVolume(GridBlock<T>& grid, json config) {
     if (viscous || reconstruction_order > 1) {
         grid.allocate_gradient_weights();
         const RequiredGradients grads = convective_flux_.required_gradients();
-        cell_grad_ = Gradients<T>(grid.num_cells(), grads.pressure, grads.temp, grads.u,
-                                  grads.rho, viscous);
+        // the ghost cells between blocks are given gradients too
+        cell_grad_ = Gradients<T>(grid.gradient_cells().storage_size(), grads.pressure,
+                                  grads.temp, grads.u, grads.rho, viscous);
     }
 
     // set up boundary conditions
@@ -59,29 +61,88 @@ size_t FiniteVolume<T>::compute_dudt(FlowStates<T>& flow_state, Vector3s<T> vert
                                      ConservedQuantities<T>& dudt, IdealGas<T>& gas_model,
                                      TransportProperties<T>& trans_prop,
                                      bool allow_reconstruction) {
-    apply_pre_reconstruction_bc(flow_state, grid, gas_model, trans_prop);
+    Ibis::ProfileRegion region("FV::compute_dudt");
+    compute_dudt_gradients(flow_state, vertex_vel, grid, gas_model, trans_prop,
+                           allow_reconstruction);
+    compute_dudt_convective(flow_state, grid, gas_model, trans_prop,
+                            allow_reconstruction);
+    compute_dudt_viscous(flow_state, cq, grid, dudt, gas_model, trans_prop);
+    return 0;
+}
+
+template <typename T>
+void FiniteVolume<T>::compute_dudt_gradients(FlowStates<T>& flow_state,
+                                             Vector3s<T> vertex_vel, GridBlock<T>& grid,
+                                             IdealGas<T>& gas_model,
+                                             TransportProperties<T>& trans_prop,
+                                             bool allow_reconstruction) {
+    Ibis::profile_count("residual evaluations");
+    {
+        Ibis::ProfileRegion bc_region("FV::boundary_conditions");
+        apply_pre_reconstruction_bc(flow_state, grid, gas_model, trans_prop);
+    }
     if (grid.moving()) {
+        Ibis::ProfileRegion motion_region("FV::grid_motion");
         grid.compute_grid_motion(flow_state, vertex_vel);
     }
 
+    if (allow_reconstruction && convective_flux_.reconstruction_order() > 1) {
+        Ibis::ProfileRegion reconstruction_region("FV::reconstruction");
+        convective_flux_.compute_convective_gradient(flow_state, grid, cell_grad_,
+                                                     grid.grad_calc());
+        convective_flux_.compute_limiters(flow_state, grid, cell_grad_);
+    }
+}
+
+template <typename T>
+void FiniteVolume<T>::compute_dudt_convective(FlowStates<T>& flow_state,
+                                              GridBlock<T>& grid, IdealGas<T>& gas_model,
+                                              TransportProperties<T>& trans_prop,
+                                              bool allow_reconstruction) {
+    // the gradients and limiters were computed by compute_dudt_gradients
     convective_flux_.compute_convective_flux(flow_state, grid, gas_model, cell_grad_,
                                              grid.grad_calc(), flux_,
-                                             allow_reconstruction);
+                                             allow_reconstruction, false);
 
-    apply_post_convective_flux_bc(flow_state, grid, gas_model, trans_prop);
+    {
+        Ibis::ProfileRegion bc_region("FV::boundary_conditions");
+        apply_post_convective_flux_bc(flow_state, grid, gas_model, trans_prop);
+    }
 
     if (viscous_flux_.enabled()) {
-        apply_pre_viscous_grad_bc(flow_state, grid, gas_model, trans_prop);
+        {
+            Ibis::ProfileRegion bc_region("FV::boundary_conditions");
+            apply_pre_viscous_grad_bc(flow_state, grid, gas_model, trans_prop);
+        }
+        Ibis::ProfileRegion viscous_region("FV::viscous_flux");
+        viscous_flux_.compute_viscous_gradient(flow_state, grid, cell_grad_,
+                                               grid.grad_calc());
+    }
+}
+
+template <typename T>
+void FiniteVolume<T>::compute_dudt_viscous(FlowStates<T>& flow_state,
+                                           const ConservedQuantities<T>& cq,
+                                           GridBlock<T>& grid,
+                                           ConservedQuantities<T>& dudt,
+                                           IdealGas<T>& gas_model,
+                                           TransportProperties<T>& trans_prop) {
+    if (viscous_flux_.enabled()) {
+        // the gradients were computed by compute_dudt_convective
+        Ibis::ProfileRegion viscous_region("FV::viscous_flux");
         viscous_flux_.compute_viscous_flux(flow_state, grid, gas_model, trans_prop,
-                                           cell_grad_, grid.grad_calc(), flux_);
+                                           cell_grad_, grid.grad_calc(), flux_, false);
     }
 
-    flux_surface_integral(grid, dudt);
+    {
+        Ibis::ProfileRegion integral_region("FV::flux_surface_integral");
+        flux_surface_integral(grid, dudt);
+    }
 
     if (grid.moving()) {
+        Ibis::ProfileRegion gcl_region("FV::GCL");
         apply_geometric_conservation_law(cq, grid, dudt);
     }
-    return 0;
 }
 
 template <typename T>
@@ -99,6 +160,16 @@ template <typename T>
 void FiniteVolume<T>::apply_geometric_conservation_law(const ConservedQuantities<T>& cq,
                                                        const GridBlock<T>& grid,
                                                        ConservedQuantities<T>& dudt) {
+    Ibis::dispatch_dim(dim_, [&](auto dim) {
+        apply_geometric_conservation_law_<decltype(dim)::value>(cq, grid, dudt);
+    });
+}
+
+template <typename T>
+template <int Dim>
+void FiniteVolume<T>::apply_geometric_conservation_law_(const ConservedQuantities<T>& cq,
+                                                        const GridBlock<T>& grid,
+                                                        ConservedQuantities<T>& dudt) {
     size_t num_cells = grid.num_cells();
     Cells<T> cells = grid.cells();
     CellFaces<T> cell_faces = grid.cells().faces();
@@ -120,7 +191,7 @@ void FiniteVolume<T>::apply_geometric_conservation_law(const ConservedQuantities
             dudt.mass(cell_i) -= cq.mass(cell_i) * dVdt / V;
             dudt.momentum_x(cell_i) -= cq.momentum_x(cell_i) * dVdt / V;
             dudt.momentum_y(cell_i) -= cq.momentum_y(cell_i) * dVdt / V;
-            if (cq.dim() == 3) {
+            if constexpr (Dim == 3) {
                 dudt.momentum_z(cell_i) -= cq.momentum_z(cell_i) * dVdt / V;
             }
             dudt.energy(cell_i) -= cq.energy(cell_i) * dVdt / V;
@@ -132,6 +203,7 @@ Ibis::real FiniteVolume<T>::estimate_dt(const FlowStates<T>& flow_state,
                                         GridBlock<T>& grid, IdealGas<T>& gas_model,
                                         TransportProperties<T>& trans_prop) {
     (void)trans_prop;
+    Ibis::ProfileRegion region("FV::estimate_dt");
     size_t num_cells = grid.num_cells();
     CellFaces<T> cell_interfaces = grid.cells().faces();
     Interfaces<T> interfaces = grid.interfaces();
@@ -220,11 +292,23 @@ void FiniteVolume<T>::apply_pre_viscous_grad_bc(
 template <typename T>
 void FiniteVolume<T>::flux_surface_integral(const GridBlock<T>& grid,
                                             ConservedQuantities<T>& dudt) {
+    Ibis::dispatch_dim(dim_, [&](auto dim) {
+        flux_surface_integral_<decltype(dim)::value>(grid, dudt);
+    });
+}
+
+template <typename T>
+template <int Dim>
+void FiniteVolume<T>::flux_surface_integral_(const GridBlock<T>& grid,
+                                             ConservedQuantities<T>& dudt) {
     Cells<T> cells = grid.cells();
     CellFaces<T> cell_faces = grid.cells().faces();
     Interfaces<T> faces = grid.interfaces();
     ConservedQuantities<T> flux = flux_;
     size_t num_cells = grid.num_cells();
+    auto geometry = grid.geometry_cache();
+    bool cached_areas = geometry.has_signed_areas();
+    bool cached_volumes = geometry.has_inverse_volumes();
     Kokkos::parallel_for(
         "flux_integral", num_cells, KOKKOS_LAMBDA(const size_t cell_i) {
             auto face_ids = cell_faces.face_ids(cell_i);
@@ -235,22 +319,26 @@ void FiniteVolume<T>::flux_surface_integral(const GridBlock<T>& grid,
             T d_energy = 0.0;
             for (size_t face_i = 0; face_i < face_ids.size(); face_i++) {
                 size_t face_id = face_ids(face_i);
-                T area = -faces.area(face_id) * cell_faces.outsigns(cell_i)(face_i);
+                T area = (cached_areas) ? -geometry.signed_area(cell_i, face_i)
+                                        : -faces.area(face_id) *
+                                              cell_faces.outsigns(cell_i)(face_i);
                 d_mass += flux.mass(face_id) * area;
                 d_momentum_x += flux.momentum_x(face_id) * area;
                 d_momentum_y += flux.momentum_y(face_id) * area;
-                if (flux.dim() == 3) {
+                if constexpr (Dim == 3) {
                     d_momentum_z += flux.momentum_z(face_id) * area;
                 }
                 d_energy += flux.energy(face_id) * area;
             }
-            dudt.mass(cell_i) = d_mass / cells.volume(cell_i);
-            dudt.momentum_x(cell_i) = d_momentum_x / cells.volume(cell_i);
-            dudt.momentum_y(cell_i) = d_momentum_y / cells.volume(cell_i);
-            if (dudt.dim() == 3) {
-                dudt.momentum_z(cell_i) = d_momentum_z / cells.volume(cell_i);
+            T inv_volume = (cached_volumes) ? geometry.inv_volume(cell_i)
+                                            : 1.0 / cells.volume(cell_i);
+            dudt.mass(cell_i) = d_mass * inv_volume;
+            dudt.momentum_x(cell_i) = d_momentum_x * inv_volume;
+            dudt.momentum_y(cell_i) = d_momentum_y * inv_volume;
+            if constexpr (Dim == 3) {
+                dudt.momentum_z(cell_i) = d_momentum_z * inv_volume;
             }
-            dudt.energy(cell_i) = d_energy / cells.volume(cell_i);
+            dudt.energy(cell_i) = d_energy * inv_volume;
         });
 }
 
@@ -289,3 +377,4 @@ void FiniteVolume<T>::compute_convective_gradient(
 
 template class FiniteVolume<Ibis::real>;
 template class FiniteVolume<Ibis::dual>;
+template class FiniteVolume<Ibis::dual4>;
@@ -14,6 +14,7 @@
 #include <grid/gradient.h>
 #include <grid/grid.h>
 #include <spdlog/spdlog.h>
+#include <util/dimension.h>
 #include <util/numeric_types.h>
 
 #include <nlohmann/json.hpp>
@@ -52,6 +53,30 @@ public:
                         TransportProperties<T>& trans_prop,
                         bool allow_reconstruction = true);
 
+    // compute_dudt in three stages, so that several blocks evaluated
+    // together can pass the gradients (and limiters) of the cells next to
+    // the faces between them to each other after the first two stages
+    // (see MultiBlock::compute_dudt).
+    //   1. compute_dudt_gradients: the pre-reconstruction boundary
+    //      conditions, and the convective gradients and limiters
+    //   2. compute_dudt_convective: the convective fluxes, and
+    //      the viscous gradients
+    //   3. compute_dudt_viscous: the viscous fluxes, and the
+    //      surface integral of the fluxes
+    void compute_dudt_gradients(FlowStates<T>& flow_state, Vector3s<T> vertex_vel,
+                                GridBlock<T>& grid, IdealGas<T>& gas_model,
+                                TransportProperties<T>& trans_prop,
+                                bool allow_reconstruction = true);
+
+    void compute_dudt_convective(FlowStates<T>& flow_state, GridBlock<T>& grid,
+                                 IdealGas<T>& gas_model,
+                                 TransportProperties<T>& trans_prop,
+                                 bool allow_reconstruction = true);
+
+    void compute_dudt_viscous(FlowStates<T>& flow_state, const ConservedQuantities<T>& cq,
+                              GridBlock<T>& grid, ConservedQuantities<T>& dudt,
+                              IdealGas<T>& gas_model, TransportProperties<T>& trans_prop);
+
     /**
      * Estimate the allowable global time step for a given flow
      * state on a given grid
@@ -97,10 +122,28 @@ public:
     // Count the number of bad cells in the domain
     size_t count_bad_cells(const FlowStates<T>& fs, const size_t num_cells);
 
+public:  // these are public to appease NVCC
+    template <int Dim>
+    void apply_geometric_conservation_law_(const ConservedQuantities<T>& cq,
+                                           const GridBlock<T>& grid,
+                                           ConservedQuantities<T>& dudt);
+
+    template <int Dim>
+    void flux_surface_integral_(const GridBlock<T>& grid, ConservedQuantities<T>& dudt);
+
 public:
     // methods for IO
     const Gradients<T>& cell_gradients() const { return cell_grad_; }
 
+    // the limiter values of each cell, if the limiter is enabled
+    const LimiterValues<T>& limiters() const { return convective_flux_.limiters(); }
+
+    size_t reconstruction_order() const {
+        return convective_flux_.reconstruction_order();
+    }
+
+    bool viscous() const { return viscous_flux_.enabled(); }
+
     // viscous gradients for post-processing
     void compute_viscous_gradient(FlowStates<T>& fs, const GridBlock<T>& grid,
                                   const IdealGas<T>& gas_model,
@@ -1,26 +1,45 @@
 #include <doctest/doctest.h>
 #include <finite_volume/flux_calc.h>
 #include <spdlog/spdlog.h>
+#include <util/dimension.h>
 #include <util/numeric_types.h>
 
 #include <stdexcept>
 
 template <typename T>
-std::unique_ptr<FluxCalculator<T>> make_flux_calculator(json config) {
+void FluxCalculator<T>::compute_flux(const FlowStates<T>& left,
+                                     const FlowStates<T>& right,
+                                     ConservedQuantities<T>& flux, IdealGas<T>& gm,
+                                     bool three_d) const {
+    std::string label = "Flux::" + name_;
+    visit([&](const auto& flux_function) {
+        Ibis::dispatch_dim(three_d ? 3 : 2, [&](auto dim) {
+            compute_face_fluxes<decltype(dim)::value>(label, flux_function, left, right,
+                                                      flux, gm);
+        });
+    });
+}
+template class FluxCalculator<Ibis::real>;
+template class FluxCalculator<Ibis::dual>;
+template class FluxCalculator<Ibis::dual4>;
+
+template <typename T>
+FluxCalculator<T> make_flux_calculator(json config) {
     std::string type = config.at("type");
     if (type == "hanel") {
-        return std::unique_ptr<FluxCalculator<T>>(new Hanel<T>());
+        return Hanel<T>();
     } else if (type == "ausmdv") {
-        return std::unique_ptr<FluxCalculator<T>>(new Ausmdv<T>());
+        return Ausmdv<T>();
     } else if (type == "ldfss2") {
-        return std::unique_ptr<FluxCalculator<T>>(new Ldfss2<T>(config));
+        return Ldfss2<T>(config);
     } else if (type == "rusanov") {
-        return std::unique_ptr<FluxCalculator<T>>(new Rusanov<T>());
+        return Rusanov<T>();
     } else {
         spdlog::error("Unknown flux calculator {}", type);
         throw std::runtime_error("Unknown flux calculator");
     }
 }
 
-template std::unique_ptr<FluxCalculator<Ibis::real>> make_flux_calculator(json);
-template std::unique_ptr<FluxCalculator<Ibis::dual>> make_flux_calculator(json);
+template FluxCalculator<Ibis::real> make_flux_calculator(json);
+template FluxCalculator<Ibis::dual> make_flux_calculator(json);
+template FluxCalculator<Ibis::dual4> make_flux_calculator(json);
@@ -2,82 +2,78 @@
 #define FLUX_H
 
 #include <finite_volume/conserved_quantities.h>
+#include <finite_volume/face_flux.h>
 #include <gas/flow_state.h>
 #include <gas/gas_model.h>
 #include <grid/interface.h>
 
 #include <nlohmann/json.hpp>
-
-// enum class FluxCalculator {
-//     Hanel,
-//     Ausmdv,
-//     Ldfss,
-// };
-
-// FluxCalculator flux_calculator_from_string(std::string name);
-// std::string string_from_flux_calculator(FluxCalculator flux_calc);
+#include <string>
+#include <utility>
+#include <variant>
 
 using json = nlohmann::json;
 
+// The single interface flux calculators (see face_flux.h). The flux
+// calculator is chosen at run time, but is resolved once per call,
+// so each kernel is compiled specifically for each flux calculator.
+template <typename T>
+using FluxPolicy =
+    std::variant<HanelFlux<T>, AusmdvFlux<T>, Ldfss2Flux<T>, RusanovFlux<T>>;
+
 template <typename T>
 class FluxCalculator {
 public:
-    FluxCalculator(std::string name) : name_(name) {}
+    FluxCalculator() {}
 
-    virtual ~FluxCalculator() {}
+    FluxCalculator(std::string name, FluxPolicy<T> policy)
+        : name_(name), policy_(policy) {}
 
-    virtual void compute_flux(const FlowStates<T>& left, const FlowStates<T>& right,
-                              ConservedQuantities<T>& flux, IdealGas<T>& gm,
-                              bool three_d) = 0;
+    void compute_flux(const FlowStates<T>& left, const FlowStates<T>& right,
+                      ConservedQuantities<T>& flux, IdealGas<T>& gm, bool three_d) const;
+
+    // Call `function` with the single interface flux calculator
+    template <class Function>
+    void visit(Function&& function) const {
+        std::visit(std::forward<Function>(function), policy_);
+    }
 
-    std::string name() { return name_; };
+    std::string name() const { return name_; };
 
 protected:
     std::string name_;
+    FluxPolicy<T> policy_;
 };
 
 template <typename T>
 class Hanel : public FluxCalculator<T> {
 public:
-    Hanel() : FluxCalculator<T>("hanel") {}
-
-    void compute_flux(const FlowStates<T>& left, const FlowStates<T>& right,
-                      ConservedQuantities<T>& flux, IdealGas<T>& gm, bool three_d);
+    Hanel() : FluxCalculator<T>("hanel", HanelFlux<T>()) {}
 };
 
 template <typename T>
 class Ausmdv : public FluxCalculator<T> {
 public:
-    Ausmdv() : FluxCalculator<T>("ausmdv") {}
-
-    void compute_flux(const FlowStates<T>& left, const FlowStates<T>& right,
-                      ConservedQuantities<T>& flux, IdealGas<T>& gm, bool three_d);
+    Ausmdv() : FluxCalculator<T>("ausmdv", AusmdvFlux<T>()) {}
 };
 
 template <typename T>
 class Ldfss2 : public FluxCalculator<T> {
 public:
-    Ldfss2() : FluxCalculator<T>("ldfss2") {}
+    Ldfss2() : FluxCalculator<T>("ldfss2", Ldfss2Flux<T>(2.0)) {}
 
-    Ldfss2(json config) : FluxCalculator<T>("ldfss2") { delta_ = config.at("delta"); }
-
-    void compute_flux(const FlowStates<T>& left, const FlowStates<T>& right,
-                      ConservedQuantities<T>& flux, IdealGas<T>& gm, bool three_d);
-
-private:
-    Ibis::real delta_;
+    Ldfss2(json config)
+        : FluxCalculator<T>("ldfss2",
+                            Ldfss2Flux<T>(config.at("delta").get<Ibis::real>())) {}
 };
 
 template <typename T>
 class Rusanov : public FluxCalculator<T> {
 public:
-    Rusanov() : FluxCalculator<T>("rusanov") {}
-
-    void compute_flux(const FlowStates<T>& left, const FlowStates<T>& right,
-                      ConservedQuantities<T>& flux, IdealGas<T>& gm, bool three_d);
+    Rusanov() : FluxCalculator<T>("rusanov", RusanovFlux<T>()) {}
 };
 
 template <typename T>
-std::unique_ptr<FluxCalculator<T>> make_flux_calculator(json config);
+FluxCalculator<T> make_flux_calculator(json config);
 
 #endif
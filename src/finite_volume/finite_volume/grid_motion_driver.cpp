@@ -28,3 +28,5 @@ template std::shared_ptr<GridMotionDriver<Ibis::real>>
 build_grid_motion_driver<Ibis::real>(const GridBlock<Ibis::real>&, json);
 template std::shared_ptr<GridMotionDriver<Ibis::dual>>
 build_grid_motion_driver<Ibis::dual>(const GridBlock<Ibis::dual>&, json config);
+template std::shared_ptr<GridMotionDriver<Ibis::dual4>>
+build_grid_motion_driver<Ibis::dual4>(const GridBlock<Ibis::dual4>&, json config);
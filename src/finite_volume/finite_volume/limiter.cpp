@@ -19,13 +19,17 @@ std::unique_ptr<Limiter<T>> make_limiter(json config) {
 }
 template std::unique_ptr<Limiter<Ibis::real>> make_limiter<Ibis::real>(json);
 template std::unique_ptr<Limiter<Ibis::dual>> make_limiter<Ibis::dual>(json);
+template std::unique_ptr<Limiter<Ibis::dual4>> make_limiter<Ibis::dual4>(json);
 
 template <typename T>
 void BarthJespersen<T>::calculate_limiters(const Ibis::SubArray2D<T> values,
-                                           Field<T>& limits, const Cells<T>& cells,
-                                           const Interfaces<T>& faces,
+                                           Field<T>& limits, const GridBlock<T>& grid,
                                            Vector3s<T>& grad) {
     Ibis::real epsilon = epsilon_;
+    Cells<T> cells = grid.cells();
+    Interfaces<T> faces = grid.interfaces();
+    auto geometry = grid.geometry_cache();
+    bool cached_offsets = geometry.has_centre_offsets();
     Kokkos::parallel_for(
         "Limiter::barth_jesperson", cells.num_valid_cells(),
         KOKKOS_LAMBDA(const size_t cell_i) {
@@ -39,17 +43,19 @@ void BarthJespersen<T>::calculate_limiters(const Ibis::SubArray2D<T> values,
             }
 
             T phi = 1.0;
-            T x = cells.centroids().x(cell_i);
-            T y = cells.centroids().y(cell_i);
-            T z = cells.centroids().z(cell_i);
             auto face_ids = cells.faces().face_ids(cell_i);
             for (size_t j = 0; j < face_ids.size(); j++) {
                 int i_face = face_ids(j);
-                T dx = faces.centre().x(i_face) - x;
-                T dy = faces.centre().y(i_face) - y;
-                T dz = faces.centre().z(i_face) - z;
-                T delta_2 =
-                    grad.x(cell_i) * dx + grad.y(cell_i) * dy + grad.z(cell_i) * dz;
+                Vector3<T> offset;
+                if (cached_offsets) {
+                    offset = geometry.centre_offset(cell_i, j);
+                } else {
+                    offset.x = faces.centre().x(i_face) - cells.centroids().x(cell_i);
+                    offset.y = faces.centre().y(i_face) - cells.centroids().y(cell_i);
+                    offset.z = faces.centre().z(i_face) - cells.centroids().z(cell_i);
+                }
+                T delta_2 = grad.x(cell_i) * offset.x + grad.y(cell_i) * offset.y +
+                            grad.z(cell_i) * offset.z;
                 int sign_delta_2 = (delta_2 > 0) - (delta_2 < 0);
                 delta_2 = sign_delta_2 * (Ibis::abs(delta_2) + epsilon);
                 if (sign_delta_2 > 0) {
@@ -63,16 +69,16 @@ void BarthJespersen<T>::calculate_limiters(const Ibis::SubArray2D<T> values,
 }
 template class BarthJespersen<Ibis::real>;
 template class BarthJespersen<Ibis::dual>;
+template class BarthJespersen<Ibis::dual4>;
 
 template <typename T>
 void Unlimited<T>::calculate_limiters(const Ibis::SubArray2D<T> values, Field<T>& limits,
-                                      const Cells<T>& cells, const Interfaces<T>& faces,
-                                      Vector3s<T>& grad) {
+                                      const GridBlock<T>& grid, Vector3s<T>& grad) {
     (void)values;
     (void)limits;
-    (void)cells;
-    (void)faces;
+    (void)grid;
     (void)grad;
 }
 template class Unlimited<Ibis::real>;
 template class Unlimited<Ibis::dual>;
+template class Unlimited<Ibis::dual4>;
@@ -53,8 +53,7 @@ public:
     Limiter(bool enabled) : enabled_(enabled) {}
 
     virtual void calculate_limiters(const Ibis::SubArray2D<T> values, Field<T>& limits,
-                                    const Cells<T>& cells, const Interfaces<T>& faces,
-                                    Vector3s<T>& grad) = 0;
+                                    const GridBlock<T>& grid, Vector3s<T>& grad) = 0;
 
     KOKKOS_INLINE_FUNCTION
     bool enabled() const { return enabled_; }
@@ -71,8 +70,7 @@ public:
     ~Unlimited() {}
 
     void calculate_limiters(const Ibis::SubArray2D<T> values, Field<T>& limits,
-                            const Cells<T>& cells, const Interfaces<T>& faces,
-                            Vector3s<T>& grad);
+                            const GridBlock<T>& grid, Vector3s<T>& grad);
 };
 
 template <typename T>
@@ -83,8 +81,7 @@ public:
     BarthJespersen(Ibis::real epsilon) : Limiter<T>(true), epsilon_(epsilon) {}
 
     void calculate_limiters(const Ibis::SubArray2D<T> values, Field<T>& limits,
-                            const Cells<T>& cells, const Interfaces<T>& faces,
-                            Vector3s<T>& grid);
+                            const GridBlock<T>& grid, Vector3s<T>& grad);
 
 private:
     Ibis::real epsilon_;
@@ -1,15 +1,19 @@
 #include <finite_volume/conserved_quantities.h>
 #include <finite_volume/primative_conserved_conversion.h>
+#include <util/dimension.h>
 
-template <typename T>
-int conserved_to_primatives(ConservedQuantities<T>& cq, FlowStates<T>& fs,
-                            const IdealGas<T>& gm) {
+template <typename T, int Dim>
+void conserved_to_primatives_(ConservedQuantities<T>& cq, FlowStates<T>& fs,
+                              const IdealGas<T>& gm) {
     Kokkos::parallel_for(
         "FS::from_conserved_quantities", fs.gas.size(), KOKKOS_LAMBDA(const int i) {
             T rho = cq.mass(i);
             T vx = cq.momentum_x(i) / rho;
             T vy = cq.momentum_y(i) / rho;
-            T vz = (cq.dim() == 3) ? cq.momentum_z(i) / rho : 0.0;
+            T vz = 0.0;
+            if constexpr (Dim == 3) {
+                vz = cq.momentum_z(i) / rho;
+            }
             T ke = 0.5 * (vx * vx + vy * vy + vz * vz);
             T u = cq.energy(i) / rho - ke;
             fs.gas.rho(i) = rho;
@@ -19,6 +23,14 @@ int conserved_to_primatives(ConservedQuantities<T>& cq, FlowStates<T>& fs,
             fs.gas.energy(i) = u;
             gm.update_thermo_from_rhou(fs.gas, i);
         });
+}
+
+template <typename T>
+int conserved_to_primatives(ConservedQuantities<T>& cq, FlowStates<T>& fs,
+                            const IdealGas<T>& gm) {
+    Ibis::dispatch_dim(cq.dim(), [&](auto dim) {
+        conserved_to_primatives_<T, decltype(dim)::value>(cq, fs, gm);
+    });
     return 0;
 }
 template int conserved_to_primatives(ConservedQuantities<Ibis::real>& cq,
@@ -27,11 +39,12 @@ template int conserved_to_primatives(ConservedQuantities<Ibis::real>& cq,
 template int conserved_to_primatives(ConservedQuantities<Ibis::dual>& cq,
                                      FlowStates<Ibis::dual>& fs,
                                      const IdealGas<Ibis::dual>& gm);
+template int conserved_to_primatives(ConservedQuantities<Ibis::dual4>& cq,
+                                     FlowStates<Ibis::dual4>& fs,
+                                     const IdealGas<Ibis::dual4>& gm);
 
-template <typename T>
-int primatives_to_conserved(ConservedQuantities<T>& cq, FlowStates<T>& fs,
-                            const IdealGas<T>& gm) {
-    (void)gm;
+template <typename T, int Dim>
+void primatives_to_conserved_(ConservedQuantities<T>& cq, FlowStates<T>& fs) {
     Kokkos::parallel_for(
         "CQ::from_flow_state", fs.gas.size(), KOKKOS_LAMBDA(const int i) {
             T vx = fs.vel.x(i);
@@ -41,12 +54,21 @@ int primatives_to_conserved(ConservedQuantities<T>& cq, FlowStates<T>& fs,
             cq.mass(i) = fs.gas.rho(i);
             cq.momentum_x(i) = rho * vx;
             cq.momentum_y(i) = rho * vy;
-            if (cq.dim() == 3) {
+            if constexpr (Dim == 3) {
                 cq.momentum_z(i) = rho * vz;
             }
             T ke = 0.5 * (vx * vx + vy * vy + vz * vz);
             cq.energy(i) = rho * (ke + fs.gas.energy(i));
         });
+}
+
+template <typename T>
+int primatives_to_conserved(ConservedQuantities<T>& cq, FlowStates<T>& fs,
+                            const IdealGas<T>& gm) {
+    (void)gm;
+    Ibis::dispatch_dim(cq.dim(), [&](auto dim) {
+        primatives_to_conserved_<T, decltype(dim)::value>(cq, fs);
+    });
     return 0;
 }
 template int primatives_to_conserved(ConservedQuantities<Ibis::real>& cq,
@@ -55,3 +77,6 @@ template int primatives_to_conserved(ConservedQuantities<Ibis::real>& cq,
 template int primatives_to_conserved(ConservedQuantities<Ibis::dual>& cq,
                                      FlowStates<Ibis::dual>& fs,
                                      const IdealGas<Ibis::dual>& gm);
+template int primatives_to_conserved(ConservedQuantities<Ibis::dual4>& cq,
+                                     FlowStates<Ibis::dual4>& fs,
+                                     const IdealGas<Ibis::dual4>& gm);
@@ -25,3 +25,4 @@ void RigidBodyTranslation<T>::compute_vertex_velocities(const FlowStates<T>& fs,
 }
 template class RigidBodyTranslation<Ibis::real>;
 template class RigidBodyTranslation<Ibis::dual>;
+template class RigidBodyTranslation<Ibis::dual4>;
@@ -65,6 +65,7 @@ void ShockFitting<T>::compute_vertex_velocities(const FlowStates<T>& fs,
 }
 template class ShockFitting<Ibis::real>;
 template class ShockFitting<Ibis::dual>;
+template class ShockFitting<Ibis::dual4>;
 
 template <typename T>
 ShockFittingBC<T>::ShockFittingBC(const GridBlock<T>& grid, std::string marker,
@@ -115,6 +116,7 @@ void ShockFittingBC<T>::apply_constraints(const GridBlock<T>& grid,
 }
 template class ShockFittingBC<Ibis::real>;
 template class ShockFittingBC<Ibis::dual>;
+template class ShockFittingBC<Ibis::dual4>;
 
 template <typename T>
 FixedVelocity<T>::FixedVelocity(json config) {
@@ -143,6 +145,7 @@ void FixedVelocity<T>::apply(const FlowStates<T>& fs, const GridBlock<T>& grid,
 }
 template class FixedVelocity<Ibis::real>;
 template class FixedVelocity<Ibis::dual>;
+template class FixedVelocity<Ibis::dual4>;
 
 template <typename T>
 WaveSpeed<T>::WaveSpeed(const GridBlock<T>& grid, std::string marker, json config) {
@@ -366,6 +369,7 @@ void WaveSpeed<T>::apply(const FlowStates<T>& fs, const GridBlock<T>& grid,
 }
 template class WaveSpeed<Ibis::real>;
 template class WaveSpeed<Ibis::dual>;
+template class WaveSpeed<Ibis::dual4>;
 
 template <typename T>
 ConstrainDirection<T>::ConstrainDirection(json config) {
@@ -396,6 +400,7 @@ void ConstrainDirection<T>::apply(const GridBlock<T>& grid, Vector3s<T> vertex_v
 }
 template class ConstrainDirection<Ibis::real>;
 template class ConstrainDirection<Ibis::dual>;
+template class ConstrainDirection<Ibis::dual4>;
 
 template <typename T>
 RadialConstraint<T>::RadialConstraint(json config) {
@@ -433,6 +438,7 @@ void RadialConstraint<T>::apply(const GridBlock<T>& grid, Vector3s<T> vertex_vel
 }
 template class RadialConstraint<Ibis::real>;
 template class RadialConstraint<Ibis::dual>;
+template class RadialConstraint<Ibis::dual4>;
 
 template <typename T>
 ShockFittingInterpolationAction<T>::ShockFittingInterpolationAction(
@@ -514,6 +520,7 @@ void ShockFittingInterpolationAction<T>::apply(const GridBlock<T>& grid,
 
 template class ShockFittingInterpolationAction<Ibis::real>;
 template class ShockFittingInterpolationAction<Ibis::dual>;
+template class ShockFittingInterpolationAction<Ibis::dual4>;
 
 template <typename T>
 std::shared_ptr<ShockFittingDirectVelocityAction<T>> make_direct_velocity_action(
@@ -534,6 +541,8 @@ template std::shared_ptr<ShockFittingDirectVelocityAction<Ibis::real>>
 make_direct_velocity_action(const GridBlock<Ibis::real>&, std::string, json);
 template std::shared_ptr<ShockFittingDirectVelocityAction<Ibis::dual>>
 make_direct_velocity_action(const GridBlock<Ibis::dual>&, std::string, json);
+template std::shared_ptr<ShockFittingDirectVelocityAction<Ibis::dual4>>
+make_direct_velocity_action(const GridBlock<Ibis::dual4>&, std::string, json);
 
 template <typename T>
 std::shared_ptr<Constraint<T>> make_constraint(json config) {
@@ -551,3 +560,4 @@ std::shared_ptr<Constraint<T>> make_constraint(json config) {
 }
 template std::shared_ptr<Constraint<Ibis::real>> make_constraint(json);
 template std::shared_ptr<Constraint<Ibis::dual>> make_constraint(json);
+template std::shared_ptr<Constraint<Ibis::dual4>> make_constraint(json);
@@ -36,59 +36,72 @@ KOKKOS_INLINE_FUNCTION void copy_gradients_to_face(ViscousProperties<T>& props,
 template <typename T>
 KOKKOS_INLINE_FUNCTION Vector3<T> hasselbacher_average_(
     const Vector3s<T>& grad, const T value_left, const T value_right, const size_t left,
-    const size_t right, const Vector3<T>& ehat, const Vector3<T>& n, const T& len_e,
-    const T& ehat_dot_n) {
+    const size_t right, const Vector3<T>& ehat, const Vector3<T>& n, const T& inv_len_e,
+    const T& inv_ehat_dot_n) {
     T avg_grad_x = 0.5 * (grad.x(left) + grad.x(right));
     T avg_grad_y = 0.5 * (grad.y(left) + grad.y(right));
     T avg_grad_z = 0.5 * (grad.z(left) + grad.z(right));
     T avg_dot_ehat = avg_grad_x * ehat.x + avg_grad_y * ehat.y + avg_grad_z * ehat.z;
-    T correction = avg_dot_ehat - (value_right - value_left) / len_e;
+    T correction = (avg_dot_ehat - (value_right - value_left) * inv_len_e) *
+                   inv_ehat_dot_n;
 
-    return Vector3<T>{avg_grad_x - correction * n.x / ehat_dot_n,
-                      avg_grad_y - correction * n.y / ehat_dot_n,
-                      avg_grad_z - correction * n.z / ehat_dot_n};
+    return Vector3<T>{avg_grad_x - correction * n.x, avg_grad_y - correction * n.y,
+                      avg_grad_z - correction * n.z};
 }
 
 template <typename T>
 KOKKOS_INLINE_FUNCTION void hasselbacher_average(
     ViscousProperties<T>& props, const Gradients<T>& cell_grad, const Cells<T>& cells,
     const FlowStates<T>& fs, const Interfaces<T>& faces, const size_t left_cell,
-    const size_t right_cell, const size_t face) {
-    // Vector from right cell centre to left cell centre
-    T ex = cells.centroids().x(right_cell) - cells.centroids().x(left_cell);
-    T ey = cells.centroids().y(right_cell) - cells.centroids().y(left_cell);
-    T ez = cells.centroids().z(right_cell) - cells.centroids().z(left_cell);
+    const size_t right_cell, const size_t face, const GeometryCache<T>& geometry,
+    const bool cached_weights) {
+    Vector3<T> n{faces.norm().x(face), faces.norm().y(face), faces.norm().z(face)};
 
     // Some properties of the grid used by Hasselbacher averaging
-    T len_e = Ibis::sqrt(ex * ex + ey * ey + ez * ez);
-    Vector3<T> ehat{ex / len_e, ey / len_e, ez / len_e};
-    Vector3<T> n{faces.norm().x(face), faces.norm().y(face), faces.norm().z(face)};
-    T ehat_dot_n = ehat.x * n.x + ehat.y * n.y + ehat.z * n.z;
+    Vector3<T> ehat;
+    T inv_len_e;
+    T inv_ehat_dot_n;
+    if (cached_weights) {
+        ehat = geometry.ehat(face);
+        inv_len_e = geometry.inv_len_e(face);
+        inv_ehat_dot_n = geometry.inv_ehat_dot_n(face);
+    } else {
+        // Vector from right cell centre to left cell centre
+        T ex = cells.centroids().x(right_cell) - cells.centroids().x(left_cell);
+        T ey = cells.centroids().y(right_cell) - cells.centroids().y(left_cell);
+        T ez = cells.centroids().z(right_cell) - cells.centroids().z(left_cell);
+        T len_e = Ibis::sqrt(ex * ex + ey * ey + ez * ez);
+        ehat = Vector3<T>{ex / len_e, ey / len_e, ez / len_e};
+        inv_len_e = 1.0 / len_e;
+        inv_ehat_dot_n = 1.0 / (ehat.x * n.x + ehat.y * n.y + ehat.z * n.z);
+    }
 
     props.grad_vx =
         hasselbacher_average_(cell_grad.vx, fs.vel.x(left_cell), fs.vel.x(right_cell),
-                              left_cell, right_cell, ehat, n, len_e, ehat_dot_n);
+                              left_cell, right_cell, ehat, n, inv_len_e, inv_ehat_dot_n);
     props.grad_vy =
         hasselbacher_average_(cell_grad.vy, fs.vel.y(left_cell), fs.vel.y(right_cell),
-                              left_cell, right_cell, ehat, n, len_e, ehat_dot_n);
+                              left_cell, right_cell, ehat, n, inv_len_e, inv_ehat_dot_n);
     props.grad_vz =
         hasselbacher_average_(cell_grad.vz, fs.vel.z(left_cell), fs.vel.z(right_cell),
-                              left_cell, right_cell, ehat, n, len_e, ehat_dot_n);
+                              left_cell, right_cell, ehat, n, inv_len_e, inv_ehat_dot_n);
     props.grad_temp = hasselbacher_average_(cell_grad.temp, fs.gas.temp(left_cell),
                                             fs.gas.temp(right_cell), left_cell,
-                                            right_cell, ehat, n, len_e, ehat_dot_n);
+                                            right_cell, ehat, n, inv_len_e,
+                                            inv_ehat_dot_n);
 }
 
 template <typename T>
 KOKKOS_FUNCTION ViscousProperties<T> compute_viscous_properties_at_faces(
     const FlowStates<T>& flow_states, const Interfaces<T>& faces, const Cells<T>& cells,
-    const IdealGas<T>& gas_model, const Gradients<T>& cell_grad, const size_t num_cells,
-    const size_t face_i) {
+    const IdealGas<T>& gas_model, const Gradients<T>& cell_grad,
+    const GradientCells& gradient_cells, const GeometryCache<T>& geometry,
+    const bool cached_weights, const size_t face_i) {
     ViscousProperties<T> props;
     size_t left_cell = faces.left_cell(face_i);
     size_t right_cell = faces.right_cell(face_i);
-    bool left_valid = left_cell < num_cells;
-    bool right_valid = right_cell < num_cells;
+    bool left_valid = gradient_cells.contains(left_cell);
+    bool right_valid = gradient_cells.contains(right_cell);
 
     // get the viscous gradients at faces
     if (!left_valid || !right_valid) {
@@ -96,7 +109,7 @@ KOKKOS_FUNCTION ViscousProperties<T> compute_viscous_properties_at_faces(
         copy_gradients_to_face(props, cell_grad, interior_cell);
     } else {
         hasselbacher_average(props, cell_grad, cells, flow_states, faces, left_cell,
-                             right_cell, face_i);
+                             right_cell, face_i, geometry, cached_weights);
     }
 
     // get the flow state at faces
@@ -111,7 +124,7 @@ ViscousFlux<T>::ViscousFlux(const GridBlock<T>& grid, FlowStates<T> face_fs,
                             json config) {
     enabled_ = config.at("enabled");
     signal_factor_ = config.at("signal_factor");
-    (void)grid;
+    gradient_cells_ = grid.gradient_cells();
 
     if (enabled_) {
         face_fs_ = face_fs;
@@ -133,20 +146,26 @@ template <typename T>
 void ViscousFlux<T>::compute_viscous_flux(
     const FlowStates<T>& flow_states, const GridBlock<T>& grid,
     const IdealGas<T>& gas_model, const TransportProperties<T>& trans_prop,
-    Gradients<T>& cell_grad, WLSGradient<T>& grad_calc, ConservedQuantities<T>& flux) {
-    compute_viscous_gradient(flow_states, grid, cell_grad, grad_calc);
+    Gradients<T>& cell_grad, WLSGradient<T>& grad_calc, ConservedQuantities<T>& flux,
+    bool compute_gradients) {
+    if (compute_gradients) {
+        compute_viscous_gradient(flow_states, grid, cell_grad, grad_calc);
+    }
 
     size_t num_faces = grid.num_interfaces();
     Interfaces<T> interfaces = grid.interfaces();
     Cells<T> cells = grid.cells();
-    const size_t num_cells = grid.num_cells();
+    const GradientCells gradient_cells = gradient_cells_;
     FlowStates<T> face_fs = face_fs_;
     // Gradients<T> grad = face_grad_;
     size_t dim = grid.dim();
+    auto geometry = grid.geometry_cache();
+    bool cached_weights = geometry.has_face_weights();
     Kokkos::parallel_for(
         "viscous_flux", num_faces, KOKKOS_LAMBDA(const size_t i) {
             auto props = compute_viscous_properties_at_faces(
-                flow_states, interfaces, cells, gas_model, cell_grad, num_cells, i);
+                flow_states, interfaces, cells, gas_model, cell_grad, gradient_cells,
+                geometry, cached_weights, i);
 
             face_fs.set_flow_state(props.flow, i);
 
@@ -185,3 +204,4 @@ void ViscousFlux<T>::compute_viscous_flux(
 
 template class ViscousFlux<Ibis::real>;
 template class ViscousFlux<Ibis::dual>;
+template class ViscousFlux<Ibis::dual4>;
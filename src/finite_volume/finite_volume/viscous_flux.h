@@ -24,11 +24,15 @@ public:
                                   const GridBlock<T>& grid, Gradients<T>& cell_grad,
                                   WLSGradient<T>& grad_calc);
 
+    // Compute the viscous fluxes, and add them to flux. The viscous
+    // gradients are computed first, unless compute_gradients is false,
+    // when they have already been computed.
     void compute_viscous_flux(const FlowStates<T>& flow_states, const GridBlock<T>& grid,
                               const IdealGas<T>& gas_model,
                               const TransportProperties<T>& trans_prop,
                               Gradients<T>& cell_grad, WLSGradient<T>& grad_calc,
-                              ConservedQuantities<T>& flux);
+                              ConservedQuantities<T>& flux,
+                              bool compute_gradients = true);
 
     // void compute_viscous_properties_at_faces(const FlowStates<T>& flow_states,
     //                                          const GridBlock<T>& grid,
@@ -43,6 +47,9 @@ private:
     bool enabled_;
     FlowStates<T> face_fs_;
     Ibis::real signal_factor_;
+
+    // The cells which have gradients
+    GradientCells gradient_cells_;
 };
 
 #endif
@@ -46,6 +46,11 @@ public:
     Vector3<T> velocity;
 };
 
+// The velocity always has three components, even in 2D, where the z
+// component is allocated, kept at zero, and copied along with the others.
+// Only the conserved quantities drop the unused momentum component in 2D;
+// dropping vz would need the boundary conditions, IO and viscous fluxes to
+// stop indexing it directly, and hasn't been done yet.
 template <typename T, class Layout = Kokkos::DefaultExecutionSpace::array_layout,
           class Space = Kokkos::DefaultExecutionSpace::memory_space>
 struct FlowStates {
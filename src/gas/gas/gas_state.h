@@ -1,6 +1,7 @@
 #ifndef GAS_H
 #define GAS_H
 
+#include <util/numa.h>
 #include <util/types.h>
 
 #include <Kokkos_Core.hpp>
@@ -42,7 +43,7 @@ public:
         pressure_idx_ = 1;
         temp_idx_ = 2;
         energy_idx_ = 3;
-        data_ = view_type("GasStates", n, 4);
+        data_ = Ibis::first_touch_view<view_type>("GasStates", n, 4);
     }
 
     GasStates(view_type gas_data)
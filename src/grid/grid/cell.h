@@ -33,9 +33,12 @@ public:
 
     CellFaces(
         const Ibis::RaggedArray<size_t, array_layout, execution_space>& interface_ids) {
-        offsets_ = view_type("CellFaces::offsets", interface_ids.offsets().size());
-        face_ids_ = view_type("CellFaces::face_ids", interface_ids.data().size());
-        outsigns_ = signed_view_type("CellFaces::outsigns", interface_ids.data().size());
+        offsets_ = Ibis::first_touch_view<view_type>("CellFaces::offsets",
+                                                     interface_ids.offsets().size());
+        face_ids_ = Ibis::first_touch_view<view_type>("CellFaces::face_ids",
+                                                      interface_ids.data().size());
+        outsigns_ = Ibis::first_touch_view<signed_view_type>("CellFaces::outsigns",
+                                                             interface_ids.data().size());
         Kokkos::deep_copy(offsets_, interface_ids.offsets());
         Kokkos::deep_copy(face_ids_, interface_ids.data());
     }
@@ -44,9 +47,12 @@ public:
         : offsets_(offsets), face_ids_(face_ids), outsigns_(outsigns) {}
 
     CellFaces(size_t number_cells, size_t number_face_ids) {
-        offsets_ = view_type("CellFaces::offsets", number_cells + 1);
-        face_ids_ = view_type("CellFaces::face_ids", number_face_ids);
-        outsigns_ = signed_view_type("CellFaces::outsigns", number_face_ids);
+        offsets_ =
+            Ibis::first_touch_view<view_type>("CellFaces::offsets", number_cells + 1);
+        face_ids_ =
+            Ibis::first_touch_view<view_type>("CellFaces::face_ids", number_face_ids);
+        outsigns_ = Ibis::first_touch_view<signed_view_type>("CellFaces::outsigns",
+                                                             number_face_ids);
     }
 
     mirror_type host_mirror() const {
@@ -0,0 +1,224 @@
+#ifndef GEOMETRY_CACHE_H
+#define GEOMETRY_CACHE_H
+
+#include <grid/cell.h>
+#include <grid/gradient_cells.h>
+#include <grid/interface.h>
+#include <util/field.h>
+#include <util/numeric_types.h>
+#include <util/vector3.h>
+
+#include <Kokkos_Core.hpp>
+#include <nlohmann/json.hpp>
+
+using json = nlohmann::json;
+
+// Geometric quantities which the face and cell kernels would otherwise
+// recompute every time the residuals are evaluated. These only change
+// when the vertices move, so for a static grid they are computed once,
+// after the rest of the geometric data.
+//
+// The face weights are the unit vector between the centroids of the
+// cells either side of each face (ehat), and the reciprocals of the
+// distance between the centroids and of ehat dotted with the face normal.
+// They are only meaningful for faces between two cells with gradients
+// (see GradientCells).
+//
+// The per cell-face values (signed areas, and the offsets from the cell
+// centroid to the face centre) are stored in the same order as the face
+// ids of the cells, so they are indexed with the offsets of CellFaces.
+// The signed areas are positive when the face normal points out of the
+// cell.
+template <typename T, class ExecSpace = Kokkos::DefaultExecutionSpace,
+          class Layout = Kokkos::DefaultExecutionSpace::array_layout>
+class GeometryCache {
+public:
+    using execution_space = ExecSpace;
+    using memory_space = typename execution_space::memory_space;
+    using array_layout = Layout;
+    using offset_view_type = Kokkos::View<size_t*, array_layout, memory_space>;
+
+public:
+    GeometryCache() {}
+
+    GeometryCache(json config) {
+        face_weights_ = config.at("face_weights");
+        signed_areas_ = config.at("signed_areas");
+        inverse_volumes_ = config.at("inverse_volumes");
+        centre_offsets_ = config.at("centre_offsets");
+    }
+
+    void compute(const Interfaces<T, execution_space, array_layout>& faces,
+                 const Cells<T, execution_space, array_layout>& cells,
+                 const GradientCells& gradient_cells) {
+        size_t num_faces = faces.size();
+        size_t num_cells = cells.num_valid_cells();
+        auto cell_faces = cells.faces();
+        offsets_ = cell_faces.offsets_;
+
+        if (face_weights_) {
+            if (inv_len_e_.size() != num_faces) {
+                ehat_ = Vector3s<T, array_layout, memory_space>("GeometryCache::ehat",
+                                                                 num_faces);
+                inv_len_e_ = Field<T, array_layout, memory_space>(
+                    "GeometryCache::inv_len_e", num_faces);
+                inv_ehat_dot_n_ = Field<T, array_layout, memory_space>(
+                    "GeometryCache::inv_ehat_dot_n", num_faces);
+            }
+            auto ehat = ehat_;
+            auto inv_len_e = inv_len_e_;
+            auto inv_ehat_dot_n = inv_ehat_dot_n_;
+            Kokkos::parallel_for(
+                "GeometryCache::face_weights",
+                Kokkos::RangePolicy<execution_space>(0, num_faces),
+                KOKKOS_LAMBDA(const size_t face_i) {
+                    size_t left_cell = faces.left_cell(face_i);
+                    size_t right_cell = faces.right_cell(face_i);
+                    if (!gradient_cells.contains(left_cell) ||
+                        !gradient_cells.contains(right_cell)) {
+                        ehat.x(face_i) = T(0.0);
+                        ehat.y(face_i) = T(0.0);
+                        ehat.z(face_i) = T(0.0);
+                        inv_len_e(face_i) = T(0.0);
+                        inv_ehat_dot_n(face_i) = T(0.0);
+                        return;
+                    }
+                    T ex = cells.centroids().x(right_cell) -
+                           cells.centroids().x(left_cell);
+                    T ey = cells.centroids().y(right_cell) -
+                           cells.centroids().y(left_cell);
+                    T ez = cells.centroids().z(right_cell) -
+                           cells.centroids().z(left_cell);
+                    T len_e = Ibis::sqrt(ex * ex + ey * ey + ez * ez);
+                    ehat.x(face_i) = ex / len_e;
+                    ehat.y(face_i) = ey / len_e;
+                    ehat.z(face_i) = ez / len_e;
+                    inv_len_e(face_i) = 1.0 / len_e;
+                    T ehat_dot_n = (ex * faces.norm().x(face_i) +
+                                    ey * faces.norm().y(face_i) +
+                                    ez * faces.norm().z(face_i)) /
+                                   len_e;
+                    inv_ehat_dot_n(face_i) = 1.0 / ehat_dot_n;
+                });
+        }
+
+        if (inverse_volumes_) {
+            if (inv_volume_.size() != num_cells) {
+                inv_volume_ = Field<T, array_layout, memory_space>(
+                    "GeometryCache::inv_volume", num_cells);
+            }
+            auto inv_volume = inv_volume_;
+            Kokkos::parallel_for(
+                "GeometryCache::inverse_volumes",
+                Kokkos::RangePolicy<execution_space>(0, num_cells),
+                KOKKOS_LAMBDA(const size_t cell_i) {
+                    inv_volume(cell_i) = 1.0 / cells.volume(cell_i);
+                });
+        }
+
+        size_t num_cell_faces = cell_faces.num_face_ids();
+        if (signed_areas_ && signed_area_.size() != num_cell_faces) {
+            signed_area_ = Field<T, array_layout, memory_space>(
+                "GeometryCache::signed_area", num_cell_faces);
+        }
+        if (centre_offsets_ && centre_offset_.size() != num_cell_faces) {
+            centre_offset_ = Vector3s<T, array_layout, memory_space>(
+                "GeometryCache::centre_offset", num_cell_faces);
+        }
+        if (signed_areas_ || centre_offsets_) {
+            bool signed_areas = signed_areas_;
+            bool centre_offsets = centre_offsets_;
+            auto signed_area = signed_area_;
+            auto centre_offset = centre_offset_;
+            Kokkos::parallel_for(
+                "GeometryCache::cell_faces",
+                Kokkos::RangePolicy<execution_space>(0, num_cells),
+                KOKKOS_LAMBDA(const size_t cell_i) {
+                    auto face_ids = cell_faces.face_ids(cell_i);
+                    auto outsigns = cell_faces.outsigns(cell_i);
+                    size_t first = cell_faces.offsets_(cell_i);
+                    for (size_t face_i = 0; face_i < face_ids.size(); face_i++) {
+                        size_t face_id = face_ids(face_i);
+                        if (signed_areas) {
+                            signed_area(first + face_i) =
+                                faces.area(face_id) * outsigns(face_i);
+                        }
+                        if (centre_offsets) {
+                            centre_offset.x(first + face_i) =
+                                faces.centre().x(face_id) - cells.centroids().x(cell_i);
+                            centre_offset.y(first + face_i) =
+                                faces.centre().y(face_id) - cells.centroids().y(cell_i);
+                            centre_offset.z(first + face_i) =
+                                faces.centre().z(face_id) - cells.centroids().z(cell_i);
+                        }
+                    }
+                });
+        }
+
+        valid_ = true;
+    }
+
+    // Mark the cached values as out of date, so the kernels go back to
+    // computing them from the grid until the cache is recomputed
+    void invalidate() { valid_ = false; }
+
+    bool enabled() const {
+        return face_weights_ || signed_areas_ || inverse_volumes_ || centre_offsets_;
+    }
+
+    bool valid() const { return valid_; }
+
+    // whether each group of values can currently be read from the cache
+    bool has_face_weights() const { return valid_ && face_weights_; }
+
+    bool has_signed_areas() const { return valid_ && signed_areas_; }
+
+    bool has_inverse_volumes() const { return valid_ && inverse_volumes_; }
+
+    bool has_centre_offsets() const { return valid_ && centre_offsets_; }
+
+    KOKKOS_INLINE_FUNCTION
+    Vector3<T> ehat(const size_t face_i) const { return ehat_.vector(face_i); }
+
+    KOKKOS_INLINE_FUNCTION
+    T inv_len_e(const size_t face_i) const { return inv_len_e_(face_i); }
+
+    KOKKOS_INLINE_FUNCTION
+    T inv_ehat_dot_n(const size_t face_i) const { return inv_ehat_dot_n_(face_i); }
+
+    KOKKOS_INLINE_FUNCTION
+    T inv_volume(const size_t cell_i) const { return inv_volume_(cell_i); }
+
+    KOKKOS_INLINE_FUNCTION
+    T signed_area(const size_t cell_i, const size_t face_i) const {
+        return signed_area_(offsets_(cell_i) + face_i);
+    }
+
+    KOKKOS_INLINE_FUNCTION
+    Vector3<T> centre_offset(const size_t cell_i, const size_t face_i) const {
+        return centre_offset_.vector(offsets_(cell_i) + face_i);
+    }
+
+public:
+    // which values to cache
+    bool face_weights_ = false;
+    bool signed_areas_ = false;
+    bool inverse_volumes_ = false;
+    bool centre_offsets_ = false;
+    bool valid_ = false;
+
+    // per face
+    Vector3s<T, array_layout, memory_space> ehat_;
+    Field<T, array_layout, memory_space> inv_len_e_;
+    Field<T, array_layout, memory_space> inv_ehat_dot_n_;
+
+    // per cell
+    Field<T, array_layout, memory_space> inv_volume_;
+
+    // per cell-face
+    offset_view_type offsets_;
+    Field<T, array_layout, memory_space> signed_area_;
+    Vector3s<T, array_layout, memory_space> centre_offset_;
+};
+
+#endif
@@ -12,6 +12,7 @@ json build_gradient_config() {
     json inflow{};
     json outflow{};
     json motion{};
+    json geometry_cache{};
     slip_wall["ghost_cells"] = true;
     inflow["ghost_cells"] = true;
     outflow["ghost_cells"] = true;
@@ -23,6 +24,13 @@ json build_gradient_config() {
 
     motion["enabled"] = false;
     config["motion"] = motion;
+    geometry_cache["face_weights"] = true;
+    geometry_cache["signed_areas"] = true;
+    geometry_cache["inverse_volumes"] = true;
+    geometry_cache["centre_offsets"] = true;
+    config["geometry_cache"] = geometry_cache;
+    config["renumber"] = "none";
+    config["cache"] = false;
     return config;
 }
 
@@ -2,6 +2,7 @@
 #define GRADIENT_H
 
 #include <grid/grid.h>
+#include <util/dimension.h>
 #include <util/ragged_array.h>
 
 #include <Kokkos_Core.hpp>
@@ -56,7 +57,7 @@ public:
     WLSGradient(const GridBlock<T, ExecSpace, Layout>& block) {
         int num_cells = block.num_cells();
         int num_rs = block.dim() == 2 ? 3 : 6;
-        r_ = Kokkos::View<T**, Layout, memory_space>("WLSGradient::r", num_cells, num_rs);
+        r_ = Ibis::first_touch_view<view_type>("WLSGradient::r", num_cells, num_rs);
         compute_weights(block);
     }
 
@@ -65,8 +66,16 @@ public:
     template <class SubView>
     void compute_gradients(const GridBlock<T, ExecSpace, Layout>& block,
                            const SubView values, Vector3s<T, Layout, memory_space> grad) {
+        Ibis::dispatch_dim(block.dim(), [&](auto dim) {
+            compute_gradients_<decltype(dim)::value>(block, values, grad);
+        });
+    }
+
+    template <int Dim, class SubView>
+    void compute_gradients_(const GridBlock<T, ExecSpace, Layout>& block,
+                            const SubView values,
+                            Vector3s<T, Layout, memory_space> grad) {
         auto cells = block.cells();
-        int dim = block.dim();
         Kokkos::parallel_for(
             "WLSGradient::compute_gradients", block.num_cells(),
             KOKKOS_CLASS_LAMBDA(const int i) {
@@ -81,7 +90,7 @@ public:
                 T r13 = 0.0;
                 T r23 = 0.0;
                 T r33 = 0.0;
-                if (dim == 3) {
+                if constexpr (Dim == 3) {
                     r13 = r_13_(i);
                     r23 = r_23_(i);
                     r33 = r_33_(i);
@@ -99,7 +108,7 @@ public:
                     T alpha_1 = dx / (r11 * r11);
                     T alpha_2 = 1.0 / (r22 * r22) * (dy - r12 / r11 * dx);
                     T alpha_3 = 0.0;
-                    if (dim == 3) {
+                    if constexpr (Dim == 3) {
                         alpha_3 = 1.0 / (r33 * r33) * (dz - r23 / r22 * dy + beta * dx);
                     }
                     T w_1 = alpha_1 - r12 / r11 * alpha_2 + beta * alpha_3;
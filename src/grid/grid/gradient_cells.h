@@ -0,0 +1,34 @@
+#ifndef GRADIENT_CELLS_H
+#define GRADIENT_CELLS_H
+
+#include <Kokkos_Core.hpp>
+#include <cstddef>
+
+// The cells which have their own gradients (and limiters): the valid
+// cells, and the ghost cells on the faces between blocks, which are given
+// the gradients of the cells they stand in for (see MultiBlock). The
+// ghost cells of each boundary are numbered together, so the latter are
+// a range of cell ids. The other ghost cells only have a flow state.
+struct GradientCells {
+    GradientCells() {}
+
+    GradientCells(size_t num_valid_cells, size_t halo_begin, size_t halo_end)
+        : num_valid_cells(num_valid_cells), halo_begin(halo_begin), halo_end(halo_end) {}
+
+    KOKKOS_INLINE_FUNCTION
+    bool contains(const size_t cell) const {
+        return cell < num_valid_cells || (cell >= halo_begin && cell < halo_end);
+    }
+
+    // the number of cells to store gradients for, so that
+    // every cell in the set can be used as an index
+    size_t storage_size() const {
+        return (halo_end > halo_begin) ? halo_end : num_valid_cells;
+    }
+
+    size_t num_valid_cells = 0;
+    size_t halo_begin = 0;
+    size_t halo_end = 0;
+};
+
+#endif
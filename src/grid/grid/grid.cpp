@@ -88,6 +88,7 @@ json build_config() {
     json inflow{};
     json outflow{};
     json motion{};
+    json geometry_cache{};
     slip_wall["ghost_cells"] = true;
     inflow["ghost_cells"] = true;
     outflow["ghost_cells"] = true;
@@ -98,6 +99,13 @@ json build_config() {
     config["boundaries"] = boundaries;
     motion["enabled"] = false;
     config["motion"] = motion;
+    geometry_cache["face_weights"] = true;
+    geometry_cache["signed_areas"] = true;
+    geometry_cache["inverse_volumes"] = true;
+    geometry_cache["centre_offsets"] = true;
+    config["geometry_cache"] = geometry_cache;
+    config["renumber"] = "none";
+    config["cache"] = false;
     return config;
 }
 
@@ -108,6 +116,7 @@ json build_3D_config() {
     json inflow{};
     json outflow{};
     json motion{};
+    json geometry_cache{};
     slip_wall["ghost_cells"] = true;
     inflow["ghost_cells"] = true;
     outflow["ghost_cells"] = true;
@@ -120,6 +129,13 @@ json build_3D_config() {
     config["boundaries"] = boundaries;
     motion["enabled"] = false;
     config["motion"] = motion;
+    geometry_cache["face_weights"] = true;
+    geometry_cache["signed_areas"] = true;
+    geometry_cache["inverse_volumes"] = true;
+    geometry_cache["centre_offsets"] = true;
+    config["geometry_cache"] = geometry_cache;
+    config["renumber"] = "none";
+    config["cache"] = false;
     return config;
 }
 
@@ -317,3 +333,165 @@ TEST_CASE("ghost cell centres") {
     CHECK(block_host.cells().centroids().y(ghost_cell) == 3.5);
     CHECK(block_host.cells().centroids().z(ghost_cell) == 0.0);
 }
+
+TEST_CASE("vertex face connectivity") {
+    json config = build_config();
+    GridBlock<Ibis::real> block_dev("../../../src/grid/test/grid.su2", config);
+    auto block_host = block_dev.host_mirror();
+    block_host.deep_copy(block_dev);
+    auto vertex_faces = block_dev.vertices().interface_ids().host_mirror_and_copy();
+    auto face_vertices = block_host.interfaces().vertex_ids();
+
+    // the faces of each vertex, found the slow way
+    std::vector<std::vector<size_t>> expected(block_host.num_vertices());
+    for (size_t face_i = 0; face_i < block_host.num_interfaces(); face_i++) {
+        for (size_t vertex_i = 0; vertex_i < face_vertices(face_i).size(); vertex_i++) {
+            expected[face_vertices(face_i)(vertex_i)].push_back(face_i);
+        }
+    }
+
+    CHECK(vertex_faces.num_rows() == block_host.num_vertices());
+    for (size_t vertex_i = 0; vertex_i < block_host.num_vertices(); vertex_i++) {
+        auto faces = vertex_faces(vertex_i);
+        CHECK(faces.size() == expected[vertex_i].size());
+        for (size_t face_i = 0; face_i < faces.size(); face_i++) {
+            CHECK(faces(face_i) == expected[vertex_i][face_i]);
+        }
+    }
+    CHECK(vertex_faces(0).size() == 2);
+    CHECK(vertex_faces(5).size() == 4);
+}
+
+TEST_CASE("marked vertices") {
+    json config = build_config();
+    GridBlock<Ibis::real> block_dev("../../../src/grid/test/grid.su2", config);
+    auto marked_vertices = block_dev.marked_vertices("outflow").host_mirror();
+    marked_vertices.deep_copy(block_dev.marked_vertices("outflow"));
+
+    std::vector<size_t> expected{3, 7, 11, 15};
+    CHECK(marked_vertices.size() == expected.size());
+    for (size_t i = 0; i < expected.size(); i++) {
+        CHECK(marked_vertices(i) == expected[i]);
+    }
+}
+
+TEST_CASE("geometry cache") {
+    json config = build_config();
+    GridBlock<Ibis::real> block_dev("../../../src/grid/test/grid.su2", config);
+    auto block = block_dev.host_mirror();
+    block.deep_copy(block_dev);
+    CHECK(block_dev.geometry_cache().valid());
+
+    auto cache = block_dev.geometry_cache();
+    auto inv_volume = cache.inv_volume_.host_mirror();
+    inv_volume.deep_copy(cache.inv_volume_);
+    auto signed_area = cache.signed_area_.host_mirror();
+    signed_area.deep_copy(cache.signed_area_);
+    auto centre_offset = cache.centre_offset_.host_mirror();
+    centre_offset.deep_copy(cache.centre_offset_);
+    auto inv_len_e = cache.inv_len_e_.host_mirror();
+    inv_len_e.deep_copy(cache.inv_len_e_);
+    auto inv_ehat_dot_n = cache.inv_ehat_dot_n_.host_mirror();
+    inv_ehat_dot_n.deep_copy(cache.inv_ehat_dot_n_);
+
+    // the grid is made of unit squares
+    auto cell_faces = block.cells().faces();
+    for (size_t i = 0; i < block.num_cells(); i++) {
+        CHECK(inv_volume(i) == doctest::Approx(1.0));
+        auto outsigns = cell_faces.outsigns(i);
+        for (size_t j = 0; j < outsigns.size(); j++) {
+            size_t index = cell_faces.offsets_(i) + j;
+            CHECK(signed_area(index) == doctest::Approx(outsigns(j)));
+            Ibis::real dx = centre_offset.x(index);
+            Ibis::real dy = centre_offset.y(index);
+            CHECK(Ibis::sqrt(dx * dx + dy * dy) == doctest::Approx(0.5));
+        }
+    }
+
+    // the face weights are only set for faces between two valid cells
+    for (size_t i = 0; i < block.num_interfaces(); i++) {
+        bool interior = block.interfaces().left_cell(i) < block.num_cells() &&
+                        block.interfaces().right_cell(i) < block.num_cells();
+        CHECK(inv_len_e(i) == doctest::Approx(interior ? 1.0 : 0.0));
+        CHECK(inv_ehat_dot_n(i) == doctest::Approx(interior ? 1.0 : 0.0));
+    }
+
+    // moving the vertices should update the cache
+    Vector3s<Ibis::real> positions("positions", block_dev.num_vertices());
+    positions.deep_copy(block_dev.vertices().positions());
+    scale_in_place(positions, 2.0);
+    block_dev.set_vertex_positions(positions);
+    CHECK(block_dev.geometry_cache().valid());
+    inv_volume.deep_copy(block_dev.geometry_cache().inv_volume_);
+    for (size_t i = 0; i < block.num_cells(); i++) {
+        CHECK(inv_volume(i) == doctest::Approx(0.25));
+    }
+}
+
+TEST_CASE("renumbered grid") {
+    GridIO grid_io("../../../src/grid/test/cube.su2");
+    json config = build_3D_config();
+    config["renumber"] = "hilbert";
+    GridBlock<Ibis::real> block_dev(grid_io, config);
+    CHECK(block_dev.renumbered());
+
+    auto block = block_dev.host_mirror();
+    block.deep_copy(block_dev);
+    size_t n_cells = block.num_cells();
+    CHECK(n_cells == 27);
+    for (size_t i = 0; i < n_cells; i++) {
+        CHECK(block.cells().volume(i) == doctest::Approx(1.0 / n_cells));
+    }
+
+    // the grid should be written back in the order of the grid file
+    GridIO written = block_dev.to_grid_io();
+    CHECK(written.vertices() == grid_io.vertices());
+    CHECK(written.cells() == grid_io.cells());
+}
+
+TEST_CASE("grid cache") {
+    std::filesystem::path directory =
+        std::filesystem::temp_directory_path() / "ibis_grid_cache";
+    std::filesystem::create_directories(directory);
+    std::string grid_file = (directory / "block_0000.su2").string();
+    std::filesystem::copy_file("../../../src/grid/test/grid.su2", grid_file,
+                               std::filesystem::copy_options::overwrite_existing);
+    std::string cache_file = grid_cache_file_name(grid_file);
+    std::filesystem::remove(cache_file);
+
+    json config = build_config();
+    config["cache"] = true;
+    config["renumber"] = "hilbert";
+
+    // the first time the grid is read, the cache is written
+    GridBlock<Ibis::real> built(grid_file, config);
+    CHECK(std::filesystem::exists(cache_file));
+
+    // and the second time it is read from the cache
+    GridBlock<Ibis::real> cached(grid_file, config);
+    auto built_host = built.host_mirror();
+    built_host.deep_copy(built);
+    auto cached_host = cached.host_mirror();
+    cached_host.deep_copy(cached);
+    CHECK(cached_host == built_host);
+    CHECK(cached.num_ghost_cells() == built.num_ghost_cells());
+    CHECK(cached.boundary_tags() == built.boundary_tags());
+    for (size_t i = 0; i < cached.num_cells(); i++) {
+        CHECK(cached_host.cells().volume(i) == doctest::Approx(1.0));
+    }
+    auto inflow_ghost_cells = cached_host.ghost_cells("inflow");
+    CHECK(cached_host.cells().centroids().x(inflow_ghost_cells(0)) == -0.5);
+    auto marked_vertices = cached.marked_vertices("outflow").host_mirror();
+    marked_vertices.deep_copy(cached.marked_vertices("outflow"));
+    CHECK(marked_vertices.size() == 4);
+    CHECK(cached.renumbered());
+    GridIO grid_io(grid_file);
+    CHECK(cached.to_grid_io().cells() == grid_io.cells());
+
+    // changing the boundaries means the cache has to be rebuilt
+    config["boundaries"]["inflow"]["ghost_cells"] = false;
+    GridBlock<Ibis::real> rebuilt(grid_file, config);
+    CHECK(rebuilt.num_ghost_cells() == built.num_ghost_cells() - 3);
+
+    std::filesystem::remove_all(directory);
+}
@@ -2,15 +2,24 @@
 #define GRID_H
 
 #include <grid/cell.h>
+#include <grid/geometry_cache.h>
+#include <grid/gradient_cells.h>
+#include <grid/grid_cache.h>
 #include <grid/grid_io.h>
 // #include <grid/gradient.h>
 // #include <finite_volume/grid_motion_driver.h>
 #include <gas/flow_state.h>
 #include <grid/interface.h>
+#include <grid/partition.h>
+#include <grid/renumber.h>
+#include <spdlog/spdlog.h>
 
 // #include <limits>
 #include <nlohmann/json.hpp>
 
+#include <algorithm>
+#include <filesystem>
+
 using json = nlohmann::json;
 
 // forward declarations
@@ -37,9 +46,7 @@ public:
 
     GridBlock(const GridIO& grid_io, json& config) { init_grid_block(grid_io, config); }
 
-    GridBlock(std::string file_name, json& config) {
-        init_grid_block(GridIO(file_name), config);
-    }
+    GridBlock(std::string file_name, json& config) { init_grid_block(file_name, config); }
 
     GridBlock(
         Vertices<T, execution_space, array_layout> vertices,
@@ -86,12 +93,68 @@ public:
         }
     }
 
+    void init_grid_block(std::string file_name, json& config) {
+        // a moving grid is re-read from a new grid file every time it is
+        // written, so caching it would only leave stale caches behind
+        bool use_cache = config.at("cache");
+        bool moving_grid = config.at("motion").at("enabled");
+        if (!use_cache || moving_grid) {
+            init_grid_block(GridIO(file_name), config);
+            return;
+        }
+
+        std::string cache_file = grid_cache_file_name(file_name);
+        uint64_t source_hash = hash_file(file_name);
+        uint64_t config_hash = hash_grid_config(config);
+        if (std::filesystem::exists(cache_file)) {
+            try {
+                GridCacheReader cache(cache_file);
+                if (cache.matches(source_hash, config_hash)) {
+                    read_cache(cache, config);
+                    spdlog::info("Read grid from cache {}", cache_file);
+                    return;
+                }
+                spdlog::info("Grid cache {} is out of date", cache_file);
+            } catch (const std::runtime_error& e) {
+                spdlog::warn("Unable to read grid cache {}: {}", cache_file, e.what());
+                *this = GridBlock();
+            }
+        }
+
+        init_grid_block(GridIO(file_name), config);
+        try {
+            write_cache(cache_file, source_hash, config_hash);
+        } catch (const std::exception& e) {
+            // the run can carry on without a cache
+            spdlog::warn("Unable to write grid cache {}: {}", cache_file, e.what());
+        }
+    }
+
     void init_grid_block(const GridIO& grid_io, json& config) {
+        RenumberMethod renumber_method =
+            string_to_renumber_method(config.at("renumber"));
+        if (renumber_method == RenumberMethod::None) {
+            build_grid_block(grid_io, config);
+            return;
+        }
+
+        // store the cells and vertices in a different order to the grid file
+        // to improve memory locality. The original order is kept so the grid
+        // and flow can be written in the same order as the grid file.
+        std::vector<size_t> cell_order = cell_ordering(grid_io, renumber_method);
+        std::vector<size_t> vertex_order;
+        build_grid_block(renumber_grid_io(grid_io, cell_order, vertex_order), config);
+        original_cell_ids_ = cell_order;
+        original_vertex_ids_ = vertex_order;
+        renumbered_cell_ids_ = invert_permutation(cell_order);
+    }
+
+    void build_grid_block(const GridIO& grid_io, json& config) {
         dim_ = grid_io.dim();
         json boundaries = config.at("boundaries");
 
         // set the positions of the vertices
-        std::vector<Vertex<Ibis::real>> vertices = grid_io.vertices();
+        const std::vector<Vertex<Ibis::real>>& vertices = grid_io.vertices();
         vertices_ = Vertices<T, execution_space, array_layout>(vertices.size());
         auto host_vertices = vertices_.host_mirror();
         for (size_t i = 0; i < vertices.size(); i++) {
@@ -99,50 +162,77 @@ public:
         }
         vertices_.deep_copy(host_vertices);
 
-        // some objects to assist in constructing the grid
-        std::vector<std::vector<size_t>> interface_vertices{};
-        std::vector<std::vector<size_t>> cell_vertices{};
-        std::vector<std::vector<size_t>> cell_interface_ids{};
+        // The connectivity is assembled directly into flat offset/data
+        // arrays, which are handed to the ragged arrays on the device.
+        // GridIO already stores the cells this way, so only the faces are
+        // built here. Faces are numbered in the order they are first found
+        // looping over the cells, so this pass over the cells is serial.
+        const std::vector<size_t>& cell_vertex_ids = grid_io.cell_vertex_ids();
+        const std::vector<ElemType>& cell_shapes = grid_io.cell_types();
+        num_valid_cells_ = grid_io.num_cells();
+        size_t num_faces_estimate = (dim_ == 3 ? 3 : 2) * num_valid_cells_;
         InterfaceLookup interfaces = InterfaceLookup();
-
-        // begin to assemble the interfaces and cells
-        std::vector<ElemIO> cells = grid_io.cells();
-        std::vector<ElemType> cell_shapes{};
-        std::vector<ElemType> interface_shapes{};
-        num_valid_cells_ = cells.size();
-        for (size_t cell_i = 0; cell_i < cells.size(); cell_i++) {
-            cell_vertices.push_back(cells[cell_i].vertex_ids());
-            cell_shapes.push_back(cells[cell_i].cell_type());
-
-            std::vector<ElemIO> cell_interfaces = cells[cell_i].interfaces();
-            std::vector<size_t> cell_face_ids{};
-            for (size_t face_i = 0; face_i < cell_interfaces.size(); face_i++) {
-                std::vector<size_t> face_vertices = cell_interfaces[face_i].vertex_ids();
+        interfaces.reserve(num_faces_estimate);
+
+        std::vector<size_t> cell_face_offsets(num_valid_cells_ + 1);
+        std::vector<size_t> cell_face_ids;
+        std::vector<size_t> face_vertex_offsets{0};
+        std::vector<size_t> face_vertex_ids;
+        std::vector<ElemType> interface_shapes;
+        cell_face_ids.reserve((dim_ == 3 ? 6 : 4) * num_valid_cells_);
+        face_vertex_offsets.reserve(num_faces_estimate + 1);
+        face_vertex_ids.reserve((dim_ == 3 ? 4 : 2) * num_faces_estimate);
+        interface_shapes.reserve(num_faces_estimate);
+        std::vector<size_t> face_vertices;
+        for (size_t cell_i = 0; cell_i < num_valid_cells_; cell_i++) {
+            const size_t* vertex_ids =
+                cell_vertex_ids.data() + grid_io.cell_vertex_offsets()[cell_i];
+            const ElemFaces& cell_interfaces = vtk_element_faces(cell_shapes[cell_i]);
+
+            cell_face_offsets[cell_i] = cell_face_ids.size();
+            for (size_t face_i = 0; face_i < cell_interfaces.num_faces; face_i++) {
+                face_vertices.resize(cell_interfaces.num_face_vertices[face_i]);
+                for (size_t vertex_i = 0; vertex_i < face_vertices.size(); vertex_i++) {
+                    face_vertices[vertex_i] =
+                        vertex_ids[cell_interfaces.vertices[face_i][vertex_i]];
+                }
 
                 // if this interface already exists, we use the existing one
                 // if the interface doesn't exist, we make a new one
-                size_t face_id = interfaces.id(face_vertices);
-                if (face_id == std::numeric_limits<size_t>::max()) {
-                    face_id = interfaces.insert(face_vertices);
-                    interface_vertices.push_back(face_vertices);
-                    interface_shapes.push_back(cell_interfaces[face_i].cell_type());
+                bool new_face;
+                size_t face_id = interfaces.insert_or_find(face_vertices, new_face);
+                if (new_face) {
+                    face_vertex_ids.insert(face_vertex_ids.end(), face_vertices.begin(),
+                                           face_vertices.end());
+                    face_vertex_offsets.push_back(face_vertex_ids.size());
+                    interface_shapes.push_back(cell_interfaces.face_types[face_i]);
                 }
                 cell_face_ids.push_back(face_id);
             }
-            cell_interface_ids.push_back(cell_face_ids);
         }
+        cell_face_offsets[num_valid_cells_] = cell_face_ids.size();
 
-        std::map<size_t, size_t> ghost_cell_map =
-            setup_boundaries(grid_io, boundaries, cell_vertices, interfaces, cell_shapes);
+        setup_boundaries(grid_io, boundaries, interfaces);
         setup_face_markers(grid_io, interfaces);
 
-        interfaces_ = Interfaces<T, execution_space, array_layout>(interface_vertices,
-                                                                   interface_shapes);
+        interfaces_ = Interfaces<T, execution_space, array_layout>(
+            Ibis::RaggedArray<size_t, array_layout, execution_space>(face_vertex_ids,
+                                                                     face_vertex_offsets),
+            interface_shapes);
 
         cells_ = Cells<T, execution_space, array_layout>(
-            cell_vertices, cell_interface_ids, cell_shapes, num_valid_cells_,
-            num_ghost_cells_);
+            Ibis::RaggedArray<size_t, array_layout, execution_space>(
+                cell_vertex_ids, grid_io.cell_vertex_offsets()),
+            Ibis::RaggedArray<size_t, array_layout, execution_space>(cell_face_ids,
+                                                                     cell_face_offsets),
+            cell_shapes, num_valid_cells_, num_ghost_cells_);
+
+        finish_grid_block(config);
+    }
 
+    // Set up everything which can be computed from the vertex positions
+    // and the connectivity
+    void finish_grid_block(json& config) {
         // compute geometric and connectivity properties of the grid
         // The order these are done in is important -- some things
         // rely on other properties already being set
@@ -150,7 +240,7 @@ public:
         interfaces_.compute_areas(vertices_);
         interfaces_.compute_orientations(vertices_);
         cells_.compute_centroids(vertices_, interfaces_);
-        compute_interface_connectivity(ghost_cell_map);
+        compute_interface_connectivity();
         cells_.compute_volumes(vertices_, interfaces_);
         compute_cell_neighbours();
         compute_ghost_cell_centres();
@@ -163,9 +253,153 @@ public:
             face_vel_ = Vector3s<T, Layout, memory_space>(num_interfaces());
         }
 
+        // cache the geometric quantities the kernels use. On a moving grid
+        // these would need recomputing every time the grid moves, so there
+        // is nothing to gain from caching them.
+        if (!moving_grid_) {
+            geometry_cache_ = GeometryCache<T, execution_space, array_layout>(
+                config.at("geometry_cache"));
+            if (geometry_cache_.enabled()) {
+                geometry_cache_.compute(interfaces_, cells_, gradient_cells());
+            }
+        }
+
         initialised_ = true;
     }
 
+    // Write the connectivity of the grid to a cache, which can be read
+    // back with `read_cache`
+    void write_cache(const std::string& file_name, uint64_t source_hash,
+                     uint64_t config_hash) const {
+        auto host_grid = host_mirror();
+        host_grid.deep_copy(*this);
+        GridCacheWriter cache(file_name, source_hash, config_hash);
+        cache.write_value<uint64_t>(dim_);
+        cache.write_value<uint64_t>(num_valid_cells_);
+        cache.write_value<uint64_t>(num_ghost_cells_);
+
+        std::vector<Ibis::real> positions(3 * num_vertices());
+        auto& host_positions = host_grid.vertices().positions();
+        for (size_t vertex_i = 0; vertex_i < num_vertices(); vertex_i++) {
+            positions[3 * vertex_i] = Ibis::real_part(host_positions.x(vertex_i));
+            positions[3 * vertex_i + 1] = Ibis::real_part(host_positions.y(vertex_i));
+            positions[3 * vertex_i + 2] = Ibis::real_part(host_positions.z(vertex_i));
+        }
+        cache.write_array(positions.data(), positions.size());
+
+        auto write_ragged_array = [&](const auto& array) {
+            cache.write_array(array.data().data(), array.num_values());
+            cache.write_array(array.offsets().data(), array.offsets().extent(0));
+        };
+        auto write_field = [&](const auto& field) {
+            auto host_field = field.host_mirror();
+            host_field.deep_copy(field);
+            cache.write_array(host_field.view_.data(), host_field.size());
+        };
+
+        write_ragged_array(host_grid.interfaces().vertex_ids());
+        write_field(interfaces_.shapes());
+        write_ragged_array(host_grid.cells().vertex_ids());
+        auto cell_faces = host_grid.cells().faces();
+        cache.write_array(cell_faces.face_ids_.data(), cell_faces.face_ids_.extent(0));
+        cache.write_array(cell_faces.offsets_.data(), cell_faces.offsets_.extent(0));
+        write_field(cells_.shapes());
+
+        cache.write_value<uint64_t>(boundary_tags_.size());
+        for (const std::string& boundary_tag : boundary_tags_) {
+            cache.write_string(boundary_tag);
+            write_field(boundary_faces_.at(boundary_tag));
+            write_field(ghost_cells_.at(boundary_tag));
+        }
+
+        cache.write_value<uint64_t>(markers_.size());
+        for (const auto& [marker_label, marker_faces] : markers_) {
+            cache.write_string(marker_label);
+            write_field(marker_faces);
+            write_field(marked_vertices_.at(marker_label));
+        }
+
+        cache.write_array(original_cell_ids_.data(), original_cell_ids_.size());
+        cache.write_array(original_vertex_ids_.data(), original_vertex_ids_.size());
+        cache.close();
+    }
+
+    // Set up the grid from a cache written by `write_cache`, copying the
+    // connectivity directly from the mapped file into the views
+    void read_cache(GridCacheReader& cache, json& config) {
+        using index_view = Kokkos::View<size_t*, array_layout, execution_space>;
+        using index_field = Field<size_t, array_layout, memory_space>;
+        dim_ = cache.read_value<uint64_t>();
+        num_valid_cells_ = cache.read_value<uint64_t>();
+        num_ghost_cells_ = cache.read_value<uint64_t>();
+
+        size_t num_positions;
+        const Ibis::real* positions = cache.read_array<Ibis::real>(num_positions);
+        vertices_ = Vertices<T, execution_space, array_layout>(num_positions / 3);
+        auto host_vertices = vertices_.host_mirror();
+        for (size_t vertex_i = 0; vertex_i < num_positions / 3; vertex_i++) {
+            host_vertices.set_vertex_position(
+                vertex_i, Vector3<Ibis::real>{positions[3 * vertex_i],
+                                              positions[3 * vertex_i + 1],
+                                              positions[3 * vertex_i + 2]});
+        }
+        vertices_.deep_copy(host_vertices);
+
+        auto read_ragged_array = [&](const std::string& label) {
+            index_view data = view_from_cache<index_view>(cache, label + "::data");
+            index_view offsets = view_from_cache<index_view>(cache, label + "::offsets");
+            using ragged_array = Ibis::RaggedArray<size_t, array_layout, execution_space>;
+            return ragged_array(data, offsets);
+        };
+        auto read_shapes = [&]() {
+            size_t num_shapes;
+            const ElemType* shapes = cache.read_array<ElemType>(num_shapes);
+            return std::vector<ElemType>(shapes, shapes + num_shapes);
+        };
+        auto read_field = [&](const std::string& label) {
+            return index_field(view_from_cache<index_view>(cache, label));
+        };
+
+        auto face_vertices = read_ragged_array("Interface::vertex_ids");
+        interfaces_ =
+            Interfaces<T, execution_space, array_layout>(face_vertices, read_shapes());
+        auto cell_vertices = read_ragged_array("Cell::vertex_ids");
+        auto cell_faces = read_ragged_array("Cell::face_ids");
+        cells_ = Cells<T, execution_space, array_layout>(
+            cell_vertices, cell_faces, read_shapes(), num_valid_cells_, num_ghost_cells_);
+
+        size_t num_boundaries = cache.read_value<uint64_t>();
+        for (size_t boundary_i = 0; boundary_i < num_boundaries; boundary_i++) {
+            std::string boundary_tag = cache.read_string();
+            boundary_tags_.push_back(boundary_tag);
+            boundary_faces_.insert({boundary_tag, read_field("bc_faces")});
+            ghost_cells_.insert({boundary_tag, read_field("bc_cells")});
+        }
+
+        size_t num_markers = cache.read_value<uint64_t>();
+        for (size_t marker_i = 0; marker_i < num_markers; marker_i++) {
+            std::string marker_label = cache.read_string();
+            index_field marker_faces = read_field("marker_faces");
+            if (boundary_faces_.find(marker_label) != boundary_faces_.end()) {
+                // boundary markers share the faces of the boundary
+                marker_faces = boundary_faces_.at(marker_label);
+            }
+            markers_.insert({marker_label, marker_faces});
+            marked_vertices_.insert({marker_label, read_field("marked_vertices")});
+        }
+
+        size_t num_ids;
+        const size_t* ids = cache.read_array<size_t>(num_ids);
+        original_cell_ids_ = std::vector<size_t>(ids, ids + num_ids);
+        ids = cache.read_array<size_t>(num_ids);
+        original_vertex_ids_ = std::vector<size_t>(ids, ids + num_ids);
+        if (renumbered()) {
+            renumbered_cell_ids_ = invert_permutation(original_cell_ids_);
+        }
+
+        finish_grid_block(config);
+    }
+
     void compute_geometric_data() {
         interfaces_.compute_centres(vertices_);
         interfaces_.compute_areas(vertices_);
@@ -175,9 +409,12 @@ public:
         if (grad_calc_) {
             compute_gradient_weights();
         }
+        if (geometry_cache_.enabled()) {
+            geometry_cache_.compute(interfaces_, cells_, gradient_cells());
+        }
     }
 
-    void compute_interface_connectivity(std::map<size_t, size_t> ghost_cells) {
+    void compute_interface_connectivity() {
         auto this_interfaces = interfaces_;
         auto this_cells = cells_;
         Kokkos::parallel_for(
@@ -213,22 +450,26 @@ public:
                 }
             });
 
-        // TODO: loop through the ghost cells and attach them to
-        // the other side of the interface.
-        // Think about how to do this on the GPU
-        auto interfaces_host = interfaces_.host_mirror();
-        interfaces_host.deep_copy(interfaces_);
-        for (auto boundary : ghost_cells) {
-            int face_id = boundary.first;
-            int ghost_cell_id = boundary.second;
-            if (interfaces_host.left_cell(face_id) ==
-                std::numeric_limits<size_t>::max()) {
-                interfaces_host.attach_cell_left(ghost_cell_id, face_id);
-            } else {
-                interfaces_host.attach_cell_right(ghost_cell_id, face_id);
-            }
+        // attach the ghost cells to the side of the boundary faces which
+        // the valid cells didn't take
+        for (const std::string& boundary_tag : boundary_tags_) {
+            auto boundary_faces = boundary_faces_.at(boundary_tag);
+            auto ghost_cells = ghost_cells_.at(boundary_tag);
+            if (ghost_cells.size() == 0) continue;
+            Kokkos::parallel_for(
+                "attach_ghost_cells",
+                Kokkos::RangePolicy<execution_space>(0, boundary_faces.size()),
+                KOKKOS_LAMBDA(const size_t boundary_i) {
+                    size_t face_id = boundary_faces(boundary_i);
+                    size_t ghost_cell_id = ghost_cells(boundary_i);
+                    if (this_interfaces.left_cell(face_id) ==
+                        std::numeric_limits<size_t>::max()) {
+                        this_interfaces.attach_cell_left(ghost_cell_id, face_id);
+                    } else {
+                        this_interfaces.attach_cell_right(ghost_cell_id, face_id);
+                    }
+                });
         }
-        interfaces_.deep_copy(interfaces_host);
     }
 
     mirror_type host_mirror() const {
@@ -333,6 +574,34 @@ public:
 
     const std::vector<std::string>& boundary_tags() const { return boundary_tags_; }
 
+    // The valid cells, and the ghost cells on the INTERBLOCK_TAG boundary
+    // (if there is one), which are given gradients from the neighbouring
+    // block rather than computing their own
+    GradientCells gradient_cells() const {
+        auto halo = ghost_cells_.find(INTERBLOCK_TAG);
+        if (halo == ghost_cells_.end() || halo->second.size() == 0) {
+            return GradientCells(num_valid_cells_, 0, 0);
+        }
+        auto halo_cells = halo->second.host_mirror();
+        halo_cells.deep_copy(halo->second);
+        size_t halo_begin = halo_cells(0);
+        size_t halo_end = halo_cells(halo_cells.size() - 1) + 1;
+        if (halo_end - halo_begin != halo_cells.size()) {
+            spdlog::error("The {} ghost cells aren't numbered contiguously",
+                          INTERBLOCK_TAG);
+            throw std::runtime_error("Interblock ghost cells aren't contiguous");
+        }
+        return GradientCells(num_valid_cells_, halo_begin, halo_end);
+    }
+
+    // Recompute the cached geometry, after the centroids of
+    // the ghost cells have been changed from outside the grid
+    void update_geometry_cache() {
+        if (geometry_cache_.enabled()) {
+            geometry_cache_.compute(interfaces_, cells_, gradient_cells());
+        }
+    }
+
     KOKKOS_INLINE_FUNCTION
     size_t dim() const { return dim_; }
 
@@ -403,32 +672,53 @@ public:
     }
 
 public:
-    std::map<size_t, size_t> setup_boundaries(
-        const GridIO& grid_io, json& boundaries,
-        std::vector<std::vector<size_t>>& cell_vertices, InterfaceLookup& interfaces,
-        std::vector<ElemType> cell_shapes) {
-        (void)cell_vertices;
-        (void)cell_shapes;
+    // The interface ids of the faces of a marker. The faces are looked up
+    // in parallel, so rather than throwing from inside the parallel region,
+    // the faces which aren't interfaces of the grid are counted, and
+    // reported afterwards.
+    static std::vector<size_t> find_marked_faces_(const std::vector<ElemIO>& faces,
+                                                  const InterfaceLookup& interfaces,
+                                                  const std::string& label) {
+        std::vector<size_t> face_ids(faces.size());
+        size_t num_missing = 0;
+        Kokkos::parallel_reduce(
+            "find_marked_faces",
+            Kokkos::RangePolicy<host_execution_space>(0, faces.size()),
+            [&](const size_t face_i, size_t& missing) {
+                face_ids[face_i] = interfaces.find(faces[face_i].vertex_ids());
+                if (face_ids[face_i] == InterfaceLookup::not_found) missing++;
+            },
+            num_missing);
+        if (num_missing > 0) {
+            spdlog::error("{} faces of marker {} are not faces of the grid", num_missing,
+                          label);
+            throw std::runtime_error("Marked faces not found in grid");
+        }
+        return face_ids;
+    }
+
+    void setup_boundaries(const GridIO& grid_io, json& boundaries,
+                          const InterfaceLookup& interfaces) {
         num_ghost_cells_ = 0;
-        std::map<size_t, size_t> ghost_cell_map;  // face_id -> ghost_cell_id
         for (auto& [bc_label, boundary_config] : boundaries.items()) {
             boundary_tags_.push_back(bc_label);
-            std::vector<ElemIO> bc_faces = grid_io.markers()[bc_label];
-
-            // loop over all the boundary faces for this boundary, keeping
-            // track of which cells and faces belong to this boundary
+            auto marker = grid_io.markers().find(bc_label);
+            size_t num_bc_faces =
+                (marker == grid_io.markers().end()) ? 0 : marker->second.size();
+
+            // look up the boundary faces, keeping track of which cells and
+            // faces belong to this boundary. The ghost cells are numbered
+            // in the same order as the boundary faces.
+            std::vector<size_t> boundary_faces;
+            if (num_bc_faces > 0) {
+                boundary_faces = find_marked_faces_(marker->second, interfaces, bc_label);
+            }
             std::vector<size_t> ghost_cells{};
-            std::vector<size_t> boundary_faces{};
-            for (size_t boundary_i = 0; boundary_i < bc_faces.size(); boundary_i++) {
-                size_t face_id = interfaces.id(bc_faces[boundary_i].vertex_ids());
-                boundary_faces.push_back(face_id);
-                if (boundary_config.at("ghost_cells") == true) {
-                    size_t ghost_cell_id = num_valid_cells_ + num_ghost_cells_;
+            if (boundary_config.at("ghost_cells") == true) {
+                ghost_cells.resize(num_bc_faces);
+                for (size_t boundary_i = 0; boundary_i < num_bc_faces; boundary_i++) {
+                    ghost_cells[boundary_i] = num_valid_cells_ + num_ghost_cells_;
                     num_ghost_cells_++;
-                    ghost_cells.push_back(ghost_cell_id);
-                    ghost_cell_map.insert({face_id, ghost_cell_id});
-                } else {
-                    ghost_cell_map.insert({face_id, -1});  // no ghost cell
                 }
             }
 
@@ -439,22 +729,17 @@ public:
             boundary_faces_.insert({bc_label, Field<size_t, array_layout, memory_space>(
                                                   "bc_faces", boundary_faces)});
         }
-        return ghost_cell_map;
     }
 
-    void setup_face_markers(const GridIO& grid_io, InterfaceLookup& interfaces) {
+    void setup_face_markers(const GridIO& grid_io, const InterfaceLookup& interfaces) {
         // setup_face_markers should be called after setup_boundaries,
         // since it checks if markers have already been assigned to boundaries
         for (auto& [marker_label, marker] : grid_io.markers()) {
             if (boundary_faces_.find(marker_label) == boundary_faces_.end()) {
                 // this marker is not a boundary, so we'll allocate
                 // some memory for these faces
-                std::vector<size_t> marker_faces;
-                marker_faces.reserve(marker.size());
-                for (size_t face_i = 0; face_i < marker.size(); face_i++) {
-                    size_t face_id = interfaces.id(marker[face_i].vertex_ids());
-                    marker_faces.push_back(face_id);
-                }
+                std::vector<size_t> marker_faces =
+                    find_marked_faces_(marker, interfaces, marker_label);
                 markers_.insert({marker_label, Field<size_t, array_layout, memory_space>(
                                                    "marker_faces", marker_faces)});
             } else {
@@ -463,37 +748,88 @@ public:
                 markers_.insert({marker_label, boundary_faces_[marker_label]});
             }
 
-            // keep track of the vertices belonging to these marked faces
+            // keep track of the vertices belonging to these marked faces,
+            // (sorted, with each vertex appearing once)
             std::vector<size_t> marked_vertices;
-            for (size_t face_i = 0; face_i < marker.size(); face_i++) {
-                std::vector<size_t> vertices = marker[face_i].vertex_ids();
-                for (const size_t& vertex_id : vertices) {
-                    if (std::find(marked_vertices.begin(), marked_vertices.end(),
-                                  vertex_id) == marked_vertices.end()) {
-                        marked_vertices.push_back(vertex_id);
-                    }
-                }
+            for (const ElemIO& face : marker) {
+                const std::vector<size_t>& vertices = face.vertex_ids();
+                marked_vertices.insert(marked_vertices.end(), vertices.begin(),
+                                       vertices.end());
             }
+            std::sort(marked_vertices.begin(), marked_vertices.end());
+            marked_vertices.erase(
+                std::unique(marked_vertices.begin(), marked_vertices.end()),
+                marked_vertices.end());
             marked_vertices_.insert(
                 {marker_label, Field<size_t, array_layout, memory_space>(
                                    "marked_vertices", marked_vertices)});
         }
     }
 
+    // The faces attached to each vertex. This is the transpose of the
+    // vertices of each face: count the faces attached to each vertex,
+    // turn the counts into offsets with a scan, then scatter the face ids
+    // into place. The faces of each vertex are sorted afterwards, since
+    // the order the scatter writes them in isn't deterministic.
     void setup_vertex_face_connectivity() {
-        std::vector<std::vector<size_t>> vertex_face_connections(num_vertices());
-        auto vertex_ids = interfaces_.vertex_ids().host_mirror();
-        vertex_ids.deep_copy(interfaces_.vertex_ids());
-        for (size_t face_i = 0; face_i < interfaces_.size(); face_i++) {
-            auto vertices_of_face = vertex_ids(face_i);
-            for (size_t vertex_i = 0; vertex_i < vertices_of_face.size(); vertex_i++) {
-                size_t vertex_id = vertices_of_face(vertex_i);
-                vertex_face_connections[vertex_id].push_back(face_i);
-            }
-        }
-        Ibis::RaggedArray<size_t, array_layout, ExecSpace> interface_ids(
-            vertex_face_connections);
-        vertices_.set_face_ids(interface_ids);
+        using index_view = Kokkos::View<size_t*, array_layout, execution_space>;
+        size_t num_vertices = this->num_vertices();
+        size_t num_faces = interfaces_.size();
+        auto face_vertices = interfaces_.vertex_ids();
+
+        index_view offsets("Vertices::face_offsets", num_vertices + 1);
+        Kokkos::parallel_for(
+            "vertex_face_count", Kokkos::RangePolicy<execution_space>(0, num_faces),
+            KOKKOS_LAMBDA(const size_t face_i) {
+                auto face = face_vertices(face_i);
+                for (size_t vertex_i = 0; vertex_i < face.size(); vertex_i++) {
+                    Kokkos::atomic_add(&offsets(face(vertex_i)), size_t(1));
+                }
+            });
+
+        size_t num_values = 0;
+        Kokkos::parallel_scan(
+            "vertex_face_offsets",
+            Kokkos::RangePolicy<execution_space>(0, num_vertices + 1),
+            KOKKOS_LAMBDA(const size_t vertex_i, size_t& offset, const bool final) {
+                size_t count = offsets(vertex_i);
+                if (final) offsets(vertex_i) = offset;
+                offset += count;
+            },
+            num_values);
+
+        index_view face_ids("Vertices::face_ids", num_values);
+        index_view filled("Vertices::filled", num_vertices);
+        Kokkos::parallel_for(
+            "vertex_face_fill", Kokkos::RangePolicy<execution_space>(0, num_faces),
+            KOKKOS_LAMBDA(const size_t face_i) {
+                auto face = face_vertices(face_i);
+                for (size_t vertex_i = 0; vertex_i < face.size(); vertex_i++) {
+                    size_t vertex_id = face(vertex_i);
+                    size_t slot = Kokkos::atomic_fetch_add(&filled(vertex_id), size_t(1));
+                    face_ids(offsets(vertex_id) + slot) = face_i;
+                }
+            });
+
+        Kokkos::parallel_for(
+            "vertex_face_sort", Kokkos::RangePolicy<execution_space>(0, num_vertices),
+            KOKKOS_LAMBDA(const size_t vertex_i) {
+                // insertion sort, since each vertex only has a few faces
+                size_t first = offsets(vertex_i);
+                size_t last = offsets(vertex_i + 1);
+                for (size_t i = first + 1; i < last; i++) {
+                    size_t face_id = face_ids(i);
+                    size_t j = i;
+                    while (j > first && face_ids(j - 1) > face_id) {
+                        face_ids(j) = face_ids(j - 1);
+                        j--;
+                    }
+                    face_ids(j) = face_id;
+                }
+            });
+
+        vertices_.set_face_ids(
+            Ibis::RaggedArray<size_t, array_layout, ExecSpace>(face_ids, offsets));
     }
 
     void allocate_gradient_weights() {
@@ -510,27 +846,27 @@ public:
         auto host_grid = host_mirror();
         host_grid.deep_copy(*this);
 
-        // get the position of the vertices
-        std::vector<Vertex<Ibis::real>> vertices;
-        vertices.reserve(host_grid.num_vertices());
+        // get the position of the vertices, in the order of the grid file
+        std::vector<Vertex<Ibis::real>> vertices(host_grid.num_vertices());
         for (size_t vertex_i = 0; vertex_i < host_grid.num_vertices(); vertex_i++) {
             Vector3<Ibis::real> pos{
                 Ibis::real_part(host_grid.vertices_.positions().x(vertex_i)),
                 Ibis::real_part(host_grid.vertices_.positions().y(vertex_i)),
                 Ibis::real_part(host_grid.vertices_.positions().z(vertex_i))};
-            vertices.push_back(Vertex<Ibis::real>(pos));
+            vertices[original_vertex_id(vertex_i)] = Vertex<Ibis::real>(pos);
         }
 
         // get the vertices of each cell
         std::vector<ElemIO> cells;
         cells.reserve(host_grid.num_cells());
-        for (size_t cell_i = 0; cell_i < host_grid.num_cells(); cell_i++) {
+        for (size_t file_cell_i = 0; file_cell_i < host_grid.num_cells(); file_cell_i++) {
+            size_t cell_i = cell_id_from_file(file_cell_i);
             ElemType cell_shape = host_grid.cells().shapes()(cell_i);
             auto cell_vertices = host_grid.cells().vertex_ids()(cell_i);
             std::vector<size_t> vertex_ids;
             vertex_ids.reserve(cell_vertices.size());
             for (size_t vertex_i = 0; vertex_i < cell_vertices.size(); vertex_i++) {
-                vertex_ids.push_back(cell_vertices(vertex_i));
+                vertex_ids.push_back(original_vertex_id(cell_vertices(vertex_i)));
             }
             cells.push_back(ElemIO(vertex_ids, cell_shape, FaceOrder::Vtk));
         }
@@ -549,7 +885,8 @@ public:
                 vertex_ids.reserve(bc_face_vertices.size());
                 for (size_t vertex_id = 0; vertex_id < bc_face_vertices.size();
                      vertex_id++) {
-                    vertex_ids.push_back(bc_face_vertices(vertex_id));
+                    size_t vertex_i = bc_face_vertices(vertex_id);
+                    vertex_ids.push_back(original_vertex_id(vertex_i));
                 }
                 bc_elems.push_back(ElemIO(vertex_ids, face_shape, FaceOrder::Vtk));
             }
@@ -592,6 +929,7 @@ public:
     }
 
     void set_vertex_positions(Vector3s<T, Layout, memory_space>& positions) {
+        geometry_cache_.invalidate();
         vertices_.set_positions(positions);
         compute_geometric_data();
     }
@@ -604,6 +942,25 @@ public:
 
     bool is_initialised() const { return initialised_; }
 
+    // whether the cells and vertices are stored in a different order to
+    // the grid file
+    bool renumbered() const { return !original_cell_ids_.empty(); }
+
+    // the index in this block of the cell at position file_cell_i
+    // in the grid file
+    size_t cell_id_from_file(const size_t file_cell_i) const {
+        return renumbered() ? renumbered_cell_ids_[file_cell_i] : file_cell_i;
+    }
+
+    // the position in the grid file of the vertex vertex_i in this block
+    size_t original_vertex_id(const size_t vertex_i) const {
+        return renumbered() ? original_vertex_ids_[vertex_i] : vertex_i;
+    }
+
+    const GeometryCache<T, execution_space, array_layout>& geometry_cache() const {
+        return geometry_cache_;
+    }
+
 public:
     // The primary grid data structures
     Vertices<T, execution_space, array_layout> vertices_;
@@ -613,6 +970,9 @@ public:
     // gradients
     std::shared_ptr<WLSGradient<T, ExecSpace, Layout>> grad_calc_;
 
+    // geometric quantities cached for the face and cell kernels
+    GeometryCache<T, execution_space, array_layout> geometry_cache_;
+
     // Some information about the grid
     size_t dim_;
     size_t num_valid_cells_;
@@ -639,6 +999,13 @@ public:
     std::shared_ptr<GridMotionDriver<T>> motion_driver_;
 
     bool initialised_ = false;
+
+    // If the grid was renumbered when it was loaded, the position in the
+    // grid file of each cell and vertex, and the index in this block of
+    // each cell in the grid file. These are empty if it wasn't renumbered.
+    std::vector<size_t> original_cell_ids_;
+    std::vector<size_t> original_vertex_ids_;
+    std::vector<size_t> renumbered_cell_ids_;
 };
 
 #endif
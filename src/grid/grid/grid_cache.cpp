@@ -0,0 +1,231 @@
+#include <doctest/doctest.h>
+#include <grid/grid_cache.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <vector>
+
+namespace {
+// identifies the file as a grid cache
+constexpr char MAGIC[8] = {'I', 'B', 'I', 'S', 'G', 'R', 'I', 'D'};
+
+size_t padded(size_t bytes) { return (bytes + 7) & ~size_t(7); }
+
+uint64_t mix(uint64_t x) {
+    x ^= x >> 30;
+    x *= 0xbf58476d1ce4e5b9ULL;
+    x ^= x >> 27;
+    x *= 0x94d049bb133111ebULL;
+    x ^= x >> 31;
+    return x;
+}
+}  // namespace
+
+std::string grid_cache_file_name(const std::string& grid_file) {
+    return grid_file + ".cache";
+}
+
+// Not cryptographic, just a quick way to notice that the grid file has
+// changed. Eight bytes are consumed at a time, so hashing even a large
+// grid file takes a small fraction of the time to parse it.
+uint64_t hash_bytes(const char* data, size_t size, uint64_t seed) {
+    uint64_t hash = mix(seed ^ size);
+    size_t i = 0;
+    for (; i + 8 <= size; i += 8) {
+        uint64_t word;
+        std::memcpy(&word, data + i, 8);
+        hash = mix(hash ^ word) + i;
+    }
+    uint64_t tail = 0;
+    if (i < size) {
+        std::memcpy(&tail, data + i, size - i);
+    }
+    return mix(hash ^ tail);
+}
+
+uint64_t hash_file(const std::string& file_name) {
+    Ibis::MappedFile file(file_name);
+    return hash_bytes(file.data(), file.size());
+}
+
+uint64_t hash_grid_config(const json& config) {
+    std::string key = "renumber=" + config.at("renumber").get<std::string>();
+    for (auto& [label, boundary] : config.at("boundaries").items()) {
+        bool ghost_cells = boundary.at("ghost_cells");
+        key += ";" + label + "=" + (ghost_cells ? "1" : "0");
+    }
+    return hash_bytes(key.data(), key.size());
+}
+
+GridCacheWriter::GridCacheWriter(const std::string& file_name, uint64_t source_hash,
+                                 uint64_t config_hash)
+    : file_name_(file_name) {
+    // a unique temporary file in the same directory, so several runs can
+    // write the cache at once, and the rename stays on one file system
+    std::string temp_file_name = file_name + ".XXXXXX";
+    int fd = mkstemp(temp_file_name.data());
+    if (fd < 0) {
+        throw std::runtime_error("Unable to create a temporary file for " + file_name);
+    }
+    fchmod(fd, 0644);
+    ::close(fd);
+    temp_file_name_ = temp_file_name;
+
+    file_.open(temp_file_name_, std::ios::binary | std::ios::trunc);
+    if (!file_) {
+        std::remove(temp_file_name_.c_str());
+        throw std::runtime_error("Unable to open " + temp_file_name_);
+    }
+    uint64_t version = GRID_CACHE_VERSION;
+    file_.write(MAGIC, sizeof(MAGIC));
+    file_.write(reinterpret_cast<const char*>(&version), sizeof(version));
+    file_.write(reinterpret_cast<const char*>(&source_hash), sizeof(source_hash));
+    file_.write(reinterpret_cast<const char*>(&config_hash), sizeof(config_hash));
+}
+
+GridCacheWriter::~GridCacheWriter() {
+    // the cache wasn't finished, so don't leave the partial file behind
+    if (file_.is_open()) {
+        file_.close();
+        std::remove(temp_file_name_.c_str());
+    }
+}
+
+void GridCacheWriter::write_string(const std::string& value) {
+    write_array(value.data(), value.size());
+}
+
+void GridCacheWriter::pad_() {
+    size_t position = file_.tellp();
+    size_t padding = padded(position) - position;
+    const char zeros[8] = {0};
+    file_.write(zeros, padding);
+}
+
+void GridCacheWriter::close() {
+    file_.close();
+    if (!file_) {
+        std::remove(temp_file_name_.c_str());
+        throw std::runtime_error("Unable to write " + file_name_);
+    }
+    std::filesystem::rename(temp_file_name_, file_name_);
+}
+
+GridCacheReader::GridCacheReader(const std::string& file_name) : file_(file_name) {
+    const char* magic = next_(sizeof(MAGIC));
+    if (std::memcmp(magic, MAGIC, sizeof(MAGIC)) != 0) {
+        throw std::runtime_error(file_name + " is not a grid cache");
+    }
+    uint64_t version;
+    std::memcpy(&version, next_(sizeof(version)), sizeof(version));
+    if (version != GRID_CACHE_VERSION) {
+        throw std::runtime_error(file_name + " is from a different version of ibis");
+    }
+    std::memcpy(&source_hash_, next_(sizeof(source_hash_)), sizeof(source_hash_));
+    std::memcpy(&config_hash_, next_(sizeof(config_hash_)), sizeof(config_hash_));
+}
+
+std::string GridCacheReader::read_string() {
+    size_t size;
+    const char* value = read_array<char>(size);
+    return std::string(value, size);
+}
+
+const char* GridCacheReader::next_(size_t bytes) {
+    if (position_ + bytes > file_.size()) {
+        throw std::runtime_error("Grid cache is truncated");
+    }
+    const char* start = file_.data() + position_;
+    position_ = std::min(padded(position_ + bytes), file_.size());
+    return start;
+}
+
+TEST_CASE("grid cache round trip") {
+    std::string file_name =
+        (std::filesystem::temp_directory_path() / "ibis_grid_cache_test").string();
+    std::vector<size_t> ids{3, 1, 4, 1, 5};
+    std::vector<double> positions{0.5, 1.5, 2.5};
+    {
+        GridCacheWriter writer(file_name, 12, 34);
+        writer.write_value<uint64_t>(2);
+        writer.write_array(ids.data(), ids.size());
+        writer.write_string("inflow");
+        writer.write_array(positions.data(), positions.size());
+        writer.close();
+    }
+
+    GridCacheReader reader(file_name);
+    CHECK(reader.matches(12, 34));
+    CHECK(!reader.matches(12, 35));
+    CHECK(reader.read_value<uint64_t>() == 2);
+    size_t size;
+    const size_t* read_ids = reader.read_array<size_t>(size);
+    CHECK(size == ids.size());
+    CHECK(std::vector<size_t>(read_ids, read_ids + size) == ids);
+    CHECK(reader.read_string() == "inflow");
+    const double* read_positions = reader.read_array<double>(size);
+    CHECK(size == 3);
+    CHECK(read_positions[2] == 2.5);
+    CHECK_THROWS(reader.read_array<double>(size));
+    std::remove(file_name.c_str());
+}
+
+TEST_CASE("grid cache writers use their own temporary files") {
+    std::filesystem::path directory =
+        std::filesystem::temp_directory_path() / "ibis_grid_cache_writers_test";
+    std::filesystem::remove_all(directory);
+    std::filesystem::create_directory(directory);
+    std::string file_name = (directory / "grid.cache").string();
+    {
+        GridCacheWriter first(file_name, 1, 2);
+        GridCacheWriter second(file_name, 3, 4);
+        first.write_value<uint64_t>(1);
+        second.write_value<uint64_t>(2);
+        first.close();
+        second.close();
+
+        // an unfinished cache is removed
+        GridCacheWriter unfinished(file_name, 5, 6);
+        unfinished.write_value<uint64_t>(3);
+    }
+
+    // the last cache to be closed wins, and no temporary files are left
+    GridCacheReader reader(file_name);
+    CHECK(reader.matches(3, 4));
+    CHECK(reader.read_value<uint64_t>() == 2);
+    size_t num_files = 0;
+    for (const auto& entry : std::filesystem::directory_iterator(directory)) {
+        (void)entry;
+        num_files++;
+    }
+    CHECK(num_files == 1);
+    std::filesystem::remove_all(directory);
+}
+
+TEST_CASE("hash grid config") {
+    json config;
+    config["renumber"] = "none";
+    config["boundaries"]["inflow"]["ghost_cells"] = true;
+    config["boundaries"]["inflow"]["pre_reconstruction"] = json::array();
+    uint64_t hash = hash_grid_config(config);
+
+    // only the parts of the config which change the connectivity matter
+    config["boundaries"]["inflow"]["pre_reconstruction"] = json::array({1});
+    CHECK(hash_grid_config(config) == hash);
+    config["boundaries"]["inflow"]["ghost_cells"] = false;
+    CHECK(hash_grid_config(config) != hash);
+    config["boundaries"]["inflow"]["ghost_cells"] = true;
+    config["renumber"] = "hilbert";
+    CHECK(hash_grid_config(config) != hash);
+}
+
+TEST_CASE("hash bytes") {
+    std::string a = "NDIME= 2\nNPOIN= 16\n";
+    std::string b = "NDIME= 2\nNPOIN= 17\n";
+    CHECK(hash_bytes(a.data(), a.size()) == hash_bytes(a.data(), a.size()));
+    CHECK(hash_bytes(a.data(), a.size()) != hash_bytes(b.data(), b.size()));
+    CHECK(hash_bytes(a.data(), a.size() - 1) != hash_bytes(a.data(), a.size()));
+}
@@ -0,0 +1,133 @@
+#ifndef GRID_CACHE_H
+#define GRID_CACHE_H
+
+#include <util/mapped_file.h>
+
+#include <Kokkos_Core.hpp>
+#include <algorithm>
+#include <cstdint>
+#include <fstream>
+#include <nlohmann/json.hpp>
+#include <stdexcept>
+#include <string>
+
+using json = nlohmann::json;
+
+// A binary copy of the connectivity of a grid block, written the first
+// time a grid file is loaded, so that later runs on the same grid can
+// skip parsing the grid file and building the connectivity. The geometry
+// is not stored, since it is quick to recompute in parallel from the
+// vertex positions.
+//
+// The file is a header, followed by a sequence of arrays. Each array is
+// stored as its length followed by its values, padded to a multiple of
+// eight bytes so the values can be read in place from the mapped file.
+// The header holds a hash of the grid file and of the parts of the grid
+// configuration which change the connectivity (the boundaries with ghost
+// cells and the renumbering), so a stale cache is detected and rebuilt.
+
+// Increment whenever the layout of the cache changes
+constexpr uint64_t GRID_CACHE_VERSION = 1;
+
+// The name of the cache for a grid file
+std::string grid_cache_file_name(const std::string& grid_file);
+
+uint64_t hash_bytes(const char* data, size_t size, uint64_t seed = 0);
+
+uint64_t hash_file(const std::string& file_name);
+
+uint64_t hash_grid_config(const json& config);
+
+class GridCacheWriter {
+public:
+    // The cache is written to a uniquely named temporary file, which is
+    // moved into place by `close`, so another run reading or writing the
+    // cache at the same time never sees a partially written file. If the
+    // writer is destroyed before `close`, the temporary file is removed.
+    GridCacheWriter(const std::string& file_name, uint64_t source_hash,
+                    uint64_t config_hash);
+
+    ~GridCacheWriter();
+
+    template <typename U>
+    void write_value(U value) {
+        write_array(&value, 1);
+    }
+
+    template <typename U>
+    void write_array(const U* values, size_t size) {
+        uint64_t length = size;
+        file_.write(reinterpret_cast<const char*>(&length), sizeof(length));
+        file_.write(reinterpret_cast<const char*>(values), size * sizeof(U));
+        pad_();
+    }
+
+    void write_string(const std::string& value);
+
+    void close();
+
+private:
+    std::string file_name_;
+    std::string temp_file_name_;
+    std::ofstream file_;
+
+    void pad_();
+};
+
+class GridCacheReader {
+public:
+    GridCacheReader(const std::string& file_name);
+
+    // whether the cache was made from this grid file and configuration
+    bool matches(uint64_t source_hash, uint64_t config_hash) const {
+        return source_hash == source_hash_ && config_hash == config_hash_;
+    }
+
+    template <typename U>
+    U read_value() {
+        size_t size;
+        const U* value = read_array<U>(size);
+        if (size != 1) {
+            throw std::runtime_error("Unexpected array in grid cache");
+        }
+        return *value;
+    }
+
+    // A pointer to the values of the next array in the mapped file
+    template <typename U>
+    const U* read_array(size_t& size) {
+        uint64_t length = *reinterpret_cast<const uint64_t*>(next_(sizeof(uint64_t)));
+        if (length > file_.size() / sizeof(U)) {
+            throw std::runtime_error("Grid cache is truncated");
+        }
+        size = length;
+        return reinterpret_cast<const U*>(next_(length * sizeof(U)));
+    }
+
+    std::string read_string();
+
+private:
+    Ibis::MappedFile file_;
+    size_t position_ = 0;
+    uint64_t source_hash_;
+    uint64_t config_hash_;
+
+    // move past the next `bytes` bytes (and the padding after them),
+    // returning a pointer to the start of them
+    const char* next_(size_t bytes);
+};
+
+// Copy the next array in the cache into a new view, which may live on
+// the device
+template <class ViewType>
+ViewType view_from_cache(GridCacheReader& cache, const std::string& label) {
+    size_t size;
+    const auto* values = cache.read_array<typename ViewType::non_const_value_type>(size);
+    ViewType view(label, size);
+    auto mirror = Kokkos::create_mirror_view(view);
+    std::copy(values, values + size, mirror.data());
+    Kokkos::deep_copy(view, mirror);
+    return view;
+}
+
+#endif
@@ -1,9 +1,18 @@
 #include <doctest/doctest.h>
 #include <grid/grid_io.h>
 #include <spdlog/spdlog.h>
-
+#include <util/mapped_file.h>
+
+#include <Kokkos_Core.hpp>
+#include <algorithm>
+#include <charconv>
+#include <cstring>
+#include <filesystem>
+#include <numeric>
+#include <sstream>
 #include <stdexcept>
 #include <string>
+#include <string_view>
 
 GridFileType file_type_from_name(std::string file_name) {
     std::size_t pos = file_name.find_last_of(".");
@@ -100,20 +109,49 @@ std::ostream &operator<<(std::ostream &file, const ElemIO &elem_io) {
 
 GridIO::GridIO(std::string file_name) {
     GridFileType type = file_type_from_name(file_name);
-    std::ifstream grid_file(file_name);
-    if (!grid_file) {
+    if (!std::filesystem::exists(file_name)) {
         spdlog::error("Could not find {}", file_name);
         throw new std::runtime_error("File not found");
     }
+    Ibis::MappedFile grid_file(file_name);
     switch (type) {
         case GridFileType::Su2:
-            read_su2_grid(grid_file);
+            read_su2_grid(grid_file.data(), grid_file.size());
             break;
         case GridFileType::Native:
-            read_su2_grid(grid_file);
+            read_su2_grid(grid_file.data(), grid_file.size());
             break;
     }
-    grid_file.close();
+}
+
+ElemIO GridIO::cell(size_t cell_i) const {
+    auto first = cell_vertex_ids_.begin() + cell_vertex_offsets_[cell_i];
+    auto last = cell_vertex_ids_.begin() + cell_vertex_offsets_[cell_i + 1];
+    return ElemIO(std::vector<size_t>(first, last), cell_types_[cell_i], FaceOrder::Vtk);
+}
+
+std::vector<ElemIO> GridIO::cells() const {
+    std::vector<ElemIO> cells;
+    cells.reserve(num_cells());
+    for (size_t cell_i = 0; cell_i < num_cells(); cell_i++) {
+        cells.push_back(cell(cell_i));
+    }
+    return cells;
+}
+
+void GridIO::set_cells_(const std::vector<ElemIO> &cells) {
+    cell_vertex_ids_.clear();
+    cell_vertex_offsets_.assign(1, 0);
+    cell_types_.clear();
+    cell_vertex_offsets_.reserve(cells.size() + 1);
+    cell_types_.reserve(cells.size());
+    for (const ElemIO &cell : cells) {
+        const std::vector<size_t> &vertex_ids = cell.vertex_ids();
+        cell_vertex_ids_.insert(cell_vertex_ids_.end(), vertex_ids.begin(),
+                                vertex_ids.end());
+        cell_vertex_offsets_.push_back(cell_vertex_ids_.size());
+        cell_types_.push_back(cell.cell_type());
+    }
 }
 
 void trim_whitespace(std::string &str) {
@@ -215,53 +253,202 @@ std::pair<std::string, std::vector<ElemIO>> read_su2_marker(std::istream &grid_f
     return {tag, elem_io};
 }
 
+// The parallel su2 reader. The sections of the file are found by reading
+// the headings one line at a time, and the lines within each section are
+// then parsed in parallel with std::from_chars, straight into flat arrays.
+namespace {
+
+bool is_space(char c) { return c == ' ' || c == '\t' || c == '\r' || c == '\n'; }
+
+std::string_view trim(std::string_view text) {
+    while (!text.empty() && is_space(text.front())) text.remove_prefix(1);
+    while (!text.empty() && is_space(text.back())) text.remove_suffix(1);
+    return text;
+}
+
+// The line starting at `pos`, without the whitespace at either end. `pos`
+// is moved to the start of the following line.
+std::string_view next_line(const char *data, size_t size, size_t &pos) {
+    const char *start = data + pos;
+    const void *newline = std::memchr(start, '\n', size - pos);
+    size_t length =
+        (newline) ? static_cast<const char *>(newline) - start : size - pos;
+    pos = std::min(pos + length + 1, size);
+    return trim(std::string_view(start, length));
+}
+
+// The positions of the starts of the next `num_lines` lines, followed by
+// the end of the last of them. `pos` is moved past the lines.
+std::vector<size_t> find_lines(const char *data, size_t size, size_t &pos,
+                               size_t num_lines, const std::string &section) {
+    std::vector<size_t> line_starts(num_lines + 1);
+    for (size_t line_i = 0; line_i < num_lines; line_i++) {
+        if (pos >= size) {
+            spdlog::error("su2 file ended after {} of the {} lines of {}", line_i,
+                          num_lines, section);
+            throw std::runtime_error("Invalid su2 file");
+        }
+        line_starts[line_i] = pos;
+        next_line(data, size, pos);
+    }
+    line_starts[num_lines] = pos;
+    return line_starts;
+}
+
+// Read a number from the start of `text`, after any whitespace, and move
+// `text` past the number. Returns false if there isn't a number there.
+template <typename Number>
+bool read_number(std::string_view &text, Number &value) {
+    size_t start = 0;
+    while (start < text.size() && is_space(text[start])) start++;
+    if (start < text.size() && text[start] == '+') start++;
+    const char *last = text.data() + text.size();
+    auto [end, error] = std::from_chars(text.data() + start, last, value);
+    if (error != std::errc()) return false;
+    text.remove_prefix(end - text.data());
+    return true;
+}
+
+// Read an element into `vertex_ids`, returning the type of the element
+template <class Output>
+bool read_element(std::string_view line, ElemType &type, Output vertex_ids) {
+    size_t vtk_type;
+    if (!read_number(line, vtk_type)) return false;
+    type = elem_type_from_vtk_type(vtk_type);
+    size_t num_vertices = number_vertices_from_elem_type(type);
+    for (size_t vertex_i = 0; vertex_i < num_vertices; vertex_i++) {
+        size_t vertex_id;
+        if (!read_number(line, vertex_id)) return false;
+        vertex_ids(vertex_i, vertex_id);
+    }
+    return true;
+}
+
+// Call `read_line(line_i, line)` on each line in parallel. `read_line`
+// returns false (or throws) if the line can't be read.
+template <class ReadLine>
+void read_lines(const char *data, const std::vector<size_t> &line_starts,
+                const std::string &section, ReadLine read_line) {
+    size_t num_lines = line_starts.size() - 1;
+    size_t first_bad_line = num_lines;
+    Kokkos::parallel_reduce(
+        "read_su2_grid::" + section,
+        Kokkos::RangePolicy<Kokkos::DefaultHostExecutionSpace>(0, num_lines),
+        [&](const size_t line_i, size_t &bad_line) {
+            size_t start = line_starts[line_i];
+            size_t length = line_starts[line_i + 1] - start;
+            std::string_view line = trim(std::string_view(data + start, length));
+            bool success;
+            try {
+                success = read_line(line_i, line);
+            } catch (...) {
+                success = false;
+            }
+            if (!success) bad_line = std::min(bad_line, line_i);
+        },
+        Kokkos::Min<size_t>(first_bad_line));
+
+    if (first_bad_line < num_lines) {
+        size_t start = line_starts[first_bad_line];
+        size_t length = line_starts[first_bad_line + 1] - start;
+        spdlog::error("Unable to read line {} of {} in su2 file: '{}'", first_bad_line,
+                      section, trim(std::string_view(data + start, length)));
+        throw std::runtime_error("Invalid su2 file");
+    }
+}
+
+}  // namespace
+
 void GridIO::read_su2_grid(std::istream &grid_file) {
+    std::stringstream buffer;
+    buffer << grid_file.rdbuf();
+    std::string contents = buffer.str();
+    read_su2_grid(contents.data(), contents.size());
+}
+
+void GridIO::read_su2_grid(const char *data, size_t size) {
     // iterate through the file line by line. If we come across
     // a section heading, we read that section. If we come across
     // a line we don't know what to do with, we just ignore it.
-    std::string line;
-    size_t n_vertices;
-    size_t n_cells;
-    size_t n_mark;
-    while (get_next_line(grid_file, line)) {
+    size_t pos = 0;
+    while (pos < size) {
+        std::string line(next_line(data, size, pos));
         if (starts_with(line, "NDIME")) {
             dim_ = read_int(line);
+            if (dim_ != 2 && dim_ != 3) {
+                spdlog::error("Invalid number of dimensions in su2 file: {}", dim_);
+                throw std::runtime_error("Invalid su2 file");
+            }
         }
 
         else if (starts_with(line, "NPOIN")) {
-            n_vertices = read_int(line);
-            for (size_t vtx_i = 0; vtx_i < n_vertices; vtx_i++) {
-                get_next_line(grid_file, line);
-                vertices_.push_back(read_vertex(line, dim_));
-            }
+            size_t n_vertices = read_int(line);
+            std::vector<size_t> lines = find_lines(data, size, pos, n_vertices, "NPOIN");
+            vertices_.resize(n_vertices);
+            size_t dim = dim_;
+            read_lines(data, lines, "NPOIN", [&](size_t vertex_i, std::string_view line) {
+                Ibis::real x, y;
+                Ibis::real z = 0.0;
+                bool success = read_number(line, x) && read_number(line, y);
+                if (dim == 3) success = success && read_number(line, z);
+                vertices_[vertex_i] = Vertex<Ibis::real>(Vector3<Ibis::real>(x, y, z));
+                return success && dim != 0;
+            });
         }
 
         else if (starts_with(line, "NELEM")) {
-            n_cells = read_int(line);
-            for (size_t cell_i = 0; cell_i < n_cells; cell_i++) {
-                get_next_line(grid_file, line);
-                cells_.push_back(read_su2_element(line));
-            }
+            size_t n_cells = read_int(line);
+            std::vector<size_t> lines = find_lines(data, size, pos, n_cells, "NELEM");
+
+            // first find the type of each cell, so we know where the
+            // vertices of each cell go
+            cell_types_.resize(n_cells);
+            cell_vertex_offsets_.assign(n_cells + 1, 0);
+            read_lines(data, lines, "NELEM", [&](size_t cell_i, std::string_view line) {
+                size_t vtk_type;
+                if (!read_number(line, vtk_type)) return false;
+                cell_types_[cell_i] = elem_type_from_vtk_type(vtk_type);
+                cell_vertex_offsets_[cell_i + 1] =
+                    number_vertices_from_elem_type(cell_types_[cell_i]);
+                return true;
+            });
+            std::partial_sum(cell_vertex_offsets_.begin(), cell_vertex_offsets_.end(),
+                             cell_vertex_offsets_.begin());
+
+            cell_vertex_ids_.resize(cell_vertex_offsets_[n_cells]);
+            read_lines(data, lines, "NELEM", [&](size_t cell_i, std::string_view line) {
+                size_t first = cell_vertex_offsets_[cell_i];
+                size_t *vertex_ids = cell_vertex_ids_.data() + first;
+                ElemType type;
+                return read_element(line, type, [&](size_t vertex_i, size_t vertex_id) {
+                    vertex_ids[vertex_i] = vertex_id;
+                });
+            });
         }
 
         else if (starts_with(line, "NMARK")) {
-            n_mark = read_int(line);
+            size_t n_mark = read_int(line);
             for (size_t mark_i = 0; mark_i < n_mark; mark_i++) {
-                get_next_line(grid_file, line);
-
-                auto marker = read_su2_marker(grid_file, line);
-
-                if (markers_.find(marker.first) == markers_.end()) {
-                    // we haven't seen a boundary with this tag before
-                    markers_.insert(marker);
-                } else {
-                    // we have seen a boundary with this tag before,
-                    // so we append the ElemIO's that we just read
-                    // to the existing ones
-                    markers_[marker.first].insert(markers_[marker.first].end(),
-                                                  marker.second.begin(),
-                                                  marker.second.end());
-                }
+                std::string tag = read_string(std::string(next_line(data, size, pos)));
+                size_t n_elems = read_int(std::string(next_line(data, size, pos)));
+                std::vector<size_t> lines = find_lines(data, size, pos, n_elems, tag);
+                std::vector<ElemIO> elems(n_elems);
+                read_lines(data, lines, tag, [&](size_t elem_i, std::string_view line) {
+                    ElemType type;
+                    std::vector<size_t> vertex_ids;
+                    bool success =
+                        read_element(line, type, [&](size_t, size_t vertex_id) {
+                            vertex_ids.push_back(vertex_id);
+                        });
+                    if (!success) return false;
+                    elems[elem_i] = ElemIO(vertex_ids, type, FaceOrder::Vtk);
+                    return true;
+                });
+
+                // if we have seen a boundary with this tag before, we
+                // append the new elements to the existing ones
+                std::vector<ElemIO> &marker = markers_[tag];
+                marker.insert(marker.end(), elems.begin(), elems.end());
             }
         }
     }
@@ -270,9 +457,9 @@ void GridIO::read_su2_grid(std::istream &grid_file) {
 void GridIO::write_su2_grid(std::ostream &grid_file) {
     grid_file << "NDIME= " << dim_ << "\n";
 
-    grid_file << "NELEM= " << cells_.size() << "\n";
-    for (size_t cell_i = 0; cell_i < cells_.size(); cell_i++) {
-        grid_file << cells_[cell_i] << " " << cell_i << "\n";
+    grid_file << "NELEM= " << num_cells() << "\n";
+    for (size_t cell_i = 0; cell_i < num_cells(); cell_i++) {
+        grid_file << cell(cell_i) << " " << cell_i << "\n";
     }
 
     grid_file << "NPOIN= " << vertices_.size() << "\n";
@@ -295,58 +482,73 @@ void GridIO::write_su2_grid(std::ostream &grid_file) {
     }
 }
 
-std::vector<ElemIO> vtk_face_order(std::vector<size_t> ids, ElemType type) {
+const ElemFaces &vtk_element_faces(ElemType type) {
+    using E = ElemType;
+    static const ElemFaces line{1, {E::Line}, {2}, {{0, 1}}};
+    static const ElemFaces tri{
+        3, {E::Line, E::Line, E::Line}, {2, 2, 2}, {{0, 1}, {1, 2}, {2, 0}}};
+    static const ElemFaces quad{4,
+                                {E::Line, E::Line, E::Line, E::Line},
+                                {2, 2, 2, 2},
+                                {{0, 1}, {1, 2}, {2, 3}, {3, 0}}};
+    static const ElemFaces tetra{4,
+                                 {E::Tri, E::Tri, E::Tri, E::Tri},
+                                 {3, 3, 3, 3},
+                                 {{0, 1, 2}, {0, 1, 3}, {1, 2, 3}, {0, 2, 3}}};
+    static const ElemFaces hex{
+        6,
+        {E::Quad, E::Quad, E::Quad, E::Quad, E::Quad, E::Quad},
+        {4, 4, 4, 4, 4, 4},
+        {{0, 1, 2, 3},
+         {0, 1, 5, 4},
+         {4, 5, 6, 7},
+         {2, 3, 7, 6},
+         {0, 4, 7, 3},
+         {1, 5, 6, 2}}};
+    static const ElemFaces wedge{
+        5,
+        {E::Tri, E::Tri, E::Quad, E::Quad, E::Quad},
+        {3, 3, 4, 4, 4},
+        {{0, 1, 2}, {3, 5, 4}, {1, 4, 5, 2}, {0, 2, 5, 3}, {0, 3, 4, 1}}};
+    static const ElemFaces pyramid{
+        5,
+        {E::Quad, E::Tri, E::Tri, E::Tri, E::Tri},
+        {4, 3, 3, 3, 3},
+        {{0, 3, 2, 1}, {2, 3, 4}, {0, 4, 3}, {0, 1, 4}, {1, 2, 4}}};
     switch (type) {
         case ElemType::Line:
-            return std::vector<ElemIO>{
-                ElemIO({ids[0], ids[1]}, ElemType::Line, FaceOrder::Vtk)};
+            return line;
         case ElemType::Tri:
-            return std::vector<ElemIO>{
-                ElemIO({ids[0], ids[1]}, ElemType::Line, FaceOrder::Vtk),
-                ElemIO({ids[1], ids[2]}, ElemType::Line, FaceOrder::Vtk),
-                ElemIO({ids[2], ids[0]}, ElemType::Line, FaceOrder::Vtk),
-            };
+            return tri;
         case ElemType::Quad:
-            return std::vector<ElemIO>{
-                ElemIO({ids[0], ids[1]}, ElemType::Line, FaceOrder::Vtk),
-                ElemIO({ids[1], ids[2]}, ElemType::Line, FaceOrder::Vtk),
-                ElemIO({ids[2], ids[3]}, ElemType::Line, FaceOrder::Vtk),
-                ElemIO({ids[3], ids[0]}, ElemType::Line, FaceOrder::Vtk),
-            };
+            return quad;
         case ElemType::Tetra:
-            return std::vector<ElemIO>{
-                ElemIO({ids[0], ids[1], ids[2]}, ElemType::Tri, FaceOrder::Vtk),
-                ElemIO({ids[0], ids[1], ids[3]}, ElemType::Tri, FaceOrder::Vtk),
-                ElemIO({ids[1], ids[2], ids[3]}, ElemType::Tri, FaceOrder::Vtk),
-                ElemIO({ids[0], ids[2], ids[3]}, ElemType::Tri, FaceOrder::Vtk),
-            };
+            return tetra;
         case ElemType::Hex:
-            return std::vector<ElemIO>{
-                ElemIO({ids[0], ids[1], ids[2], ids[3]}, ElemType::Quad, FaceOrder::Vtk),
-                ElemIO({ids[0], ids[1], ids[5], ids[4]}, ElemType::Quad, FaceOrder::Vtk),
-                ElemIO({ids[4], ids[5], ids[6], ids[7]}, ElemType::Quad, FaceOrder::Vtk),
-                ElemIO({ids[2], ids[3], ids[7], ids[6]}, ElemType::Quad, FaceOrder::Vtk),
-                ElemIO({ids[0], ids[4], ids[7], ids[3]}, ElemType::Quad, FaceOrder::Vtk),
-                ElemIO({ids[1], ids[5], ids[6], ids[2]}, ElemType::Quad, FaceOrder::Vtk)};
+            return hex;
         case ElemType::Wedge:
-            return std::vector<ElemIO>{
-                ElemIO({ids[0], ids[1], ids[2]}, ElemType::Tri, FaceOrder::Vtk),
-                ElemIO({ids[3], ids[5], ids[4]}, ElemType::Tri, FaceOrder::Vtk),
-                ElemIO({ids[1], ids[4], ids[5], ids[2]}, ElemType::Quad, FaceOrder::Vtk),
-                ElemIO({ids[0], ids[2], ids[5], ids[3]}, ElemType::Quad, FaceOrder::Vtk),
-                ElemIO({ids[0], ids[3], ids[4], ids[1]}, ElemType::Quad, FaceOrder::Vtk)};
+            return wedge;
         case ElemType::Pyramid:
-            return std::vector<ElemIO>{
-                ElemIO({ids[0], ids[3], ids[2], ids[1]}, ElemType::Quad, FaceOrder::Vtk),
-                ElemIO({ids[2], ids[3], ids[4]}, ElemType::Tri, FaceOrder::Vtk),
-                ElemIO({ids[0], ids[4], ids[3]}, ElemType::Tri, FaceOrder::Vtk),
-                ElemIO({ids[0], ids[1], ids[4]}, ElemType::Tri, FaceOrder::Vtk),
-                ElemIO({ids[1], ids[2], ids[4]}, ElemType::Tri, FaceOrder::Vtk)};
+            return pyramid;
         default:
             throw new std::runtime_error("Unreachable");
     }
 }
 
+std::vector<ElemIO> vtk_face_order(std::vector<size_t> ids, ElemType type) {
+    const ElemFaces &faces = vtk_element_faces(type);
+    std::vector<ElemIO> interfaces;
+    interfaces.reserve(faces.num_faces);
+    for (size_t face_i = 0; face_i < faces.num_faces; face_i++) {
+        std::vector<size_t> face_ids(faces.num_face_vertices[face_i]);
+        for (size_t vertex_i = 0; vertex_i < face_ids.size(); vertex_i++) {
+            face_ids[vertex_i] = ids[faces.vertices[face_i][vertex_i]];
+        }
+        interfaces.push_back(ElemIO(face_ids, faces.face_types[face_i], FaceOrder::Vtk));
+    }
+    return interfaces;
+}
+
 std::vector<ElemIO> ElemIO::interfaces() const {
     switch (face_order_) {
         case FaceOrder::Vtk:
@@ -527,3 +729,47 @@ TEST_CASE("write_su2_grid") {
     // make sure the original grid and the re-written grid are the same
     CHECK(grid_io == grid_io_expected);
 }
+
+TEST_CASE("read_su2_grid from memory") {
+    // tabs, carriage returns, explicit signs and trailing indices should
+    // all be accepted, and markers with the same tag should be merged
+    std::string su2 =
+        "NDIME= 2\r\n"
+        "NPOIN= 4\r\n"
+        "0.0\t0.0 0\r\n"
+        " +1.0  0.0 1\r\n"
+        "1.0 1e0 2\r\n"
+        "0.0 -0.0 3\r\n"
+        "NELEM= 2\n"
+        "5 0 1 2 0\n"
+        "5\t0 2 3\t1\n"
+        "NMARK= 3\n"
+        "MARKER_TAG= wall\n"
+        "MARKER_ELEMS= 1\n"
+        "3 0 1\n"
+        "MARKER_TAG= outflow\n"
+        "MARKER_ELEMS= 1\n"
+        "3 1 2\n"
+        "MARKER_TAG= wall\n"
+        "MARKER_ELEMS= 2\n"
+        "3 2 3\n"
+        "3 3 0";
+    GridIO grid_io;
+    grid_io.read_su2_grid(su2.data(), su2.size());
+
+    CHECK(grid_io.dim() == 2);
+    CHECK(grid_io.vertices().size() == 4);
+    CHECK(grid_io.vertices()[1].pos() == Vector3(1.0, 0.0, 0.0));
+    CHECK(grid_io.vertices()[2].pos() == Vector3(1.0, 1.0, 0.0));
+    CHECK(grid_io.cell_vertex_offsets() == std::vector<size_t>({0, 3, 6}));
+    CHECK(grid_io.cell_vertex_ids() == std::vector<size_t>({0, 1, 2, 0, 2, 3}));
+    CHECK(grid_io.cell(1) == ElemIO({0, 2, 3}, ElemType::Tri, FaceOrder::Vtk));
+    CHECK(grid_io.markers().at("wall").size() == 3);
+    CHECK(grid_io.markers().at("wall")[2] ==
+          ElemIO({3, 0}, ElemType::Line, FaceOrder::Vtk));
+    CHECK(grid_io.markers().at("outflow").size() == 1);
+
+    std::string bad_su2 = "NDIME= 2\nNPOIN= 2\n0.0 0.0 0\n0.0 abc 1\n";
+    GridIO bad_grid_io;
+    CHECK_THROWS(bad_grid_io.read_su2_grid(bad_su2.data(), bad_su2.size()));
+}
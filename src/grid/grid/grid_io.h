@@ -38,7 +38,7 @@ struct ElemIO {
         return (vertex_ids_ == other.vertex_ids_) && (cell_type_ == other.cell_type_);
     }
 
-    std::vector<size_t> vertex_ids() const { return vertex_ids_; }
+    const std::vector<size_t> &vertex_ids() const { return vertex_ids_; }
 
     ElemType cell_type() const { return cell_type_; }
 
@@ -52,43 +52,89 @@ private:
     FaceOrder face_order_;
 };
 
+// The faces of an element, as indices into the vertices of the element
+struct ElemFaces {
+    size_t num_faces;
+    ElemType face_types[6];
+    size_t num_face_vertices[6];
+    size_t vertices[6][4];
+};
+
+const ElemFaces &vtk_element_faces(ElemType type);
+
 struct GridIO {
 public:
     GridIO(std::vector<Vertex<Ibis::real>> vertices, std::vector<ElemIO> cells,
            std::unordered_map<std::string, std::vector<ElemIO>> markers, int dim)
-        : vertices_(vertices), cells_(cells), markers_(markers), dim_(dim) {}
+        : vertices_(vertices), markers_(markers), dim_(dim) {
+        set_cells_(cells);
+    }
 
     GridIO(std::vector<Vertex<Ibis::real>> vertices, std::vector<ElemIO> cells,
            std::unordered_map<std::string, std::vector<ElemIO>> markers)
-        : vertices_(vertices), cells_(cells), markers_(markers) {}
+        : vertices_(vertices), markers_(markers) {
+        set_cells_(cells);
+    }
+
+    GridIO(std::vector<Vertex<Ibis::real>> vertices, std::vector<size_t> cell_vertex_ids,
+           std::vector<size_t> cell_vertex_offsets, std::vector<ElemType> cell_types,
+           std::unordered_map<std::string, std::vector<ElemIO>> markers, int dim)
+        : vertices_(std::move(vertices)),
+          cell_vertex_ids_(std::move(cell_vertex_ids)),
+          cell_vertex_offsets_(std::move(cell_vertex_offsets)),
+          cell_types_(std::move(cell_types)),
+          markers_(std::move(markers)),
+          dim_(dim) {}
 
     GridIO(std::string file_name);
 
     GridIO() {}
 
     bool operator==(const GridIO &other) const {
-        return (vertices_ == other.vertices_) && (cells_ == other.cells_) &&
-               (markers_ == other.markers_);
+        return (vertices_ == other.vertices_) &&
+               (cell_vertex_ids_ == other.cell_vertex_ids_) &&
+               (cell_vertex_offsets_ == other.cell_vertex_offsets_) &&
+               (cell_types_ == other.cell_types_) && (markers_ == other.markers_);
     }
 
-    std::vector<Vertex<Ibis::real>> vertices() const { return vertices_; }
+    const std::vector<Vertex<Ibis::real>> &vertices() const { return vertices_; }
 
-    std::vector<ElemIO> cells() const { return cells_; }
+    size_t num_cells() const { return cell_types_.size(); }
 
-    std::unordered_map<std::string, std::vector<ElemIO>> markers() const {
+    // The cells are stored as flat arrays: the vertices of cell i are
+    // cell_vertex_ids()[cell_vertex_offsets()[i]] up to (but not including)
+    // cell_vertex_ids()[cell_vertex_offsets()[i+1]]
+    const std::vector<size_t> &cell_vertex_ids() const { return cell_vertex_ids_; }
+
+    const std::vector<size_t> &cell_vertex_offsets() const {
+        return cell_vertex_offsets_;
+    }
+
+    const std::vector<ElemType> &cell_types() const { return cell_types_; }
+
+    ElemIO cell(size_t cell_i) const;
+
+    std::vector<ElemIO> cells() const;
+
+    const std::unordered_map<std::string, std::vector<ElemIO>> &markers() const {
         return markers_;
     }
 
     size_t dim() const { return dim_; }
 
     void read_su2_grid(std::istream &grid_file);
+    void read_su2_grid(const char *data, size_t size);
     void write_su2_grid(std::ostream &grid_file);
 
 private:
     std::vector<Vertex<Ibis::real>> vertices_{};
-    std::vector<ElemIO> cells_{};
+    std::vector<size_t> cell_vertex_ids_{};
+    std::vector<size_t> cell_vertex_offsets_{0};
+    std::vector<ElemType> cell_types_{};
     std::unordered_map<std::string, std::vector<ElemIO>> markers_;
-    size_t dim_;
+    size_t dim_ = 0;
+
+    void set_cells_(const std::vector<ElemIO> &cells);
 };
 
 #endif
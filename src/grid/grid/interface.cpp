@@ -1,48 +1,113 @@
 #include <doctest/doctest.h>
 #include <grid/interface.h>
+#include <spdlog/spdlog.h>
 
 #include <algorithm>
-#include <functional>
+#include <cstdint>
+#include <stdexcept>
 
-InterfaceLookup::InterfaceLookup() {
-    hash_map_ = std::unordered_map<std::string, size_t>{};
+InterfaceLookup::InterfaceLookup() : size_(0) { rehash_(64); }
+
+void InterfaceLookup::reserve(size_t num_interfaces) {
+    // keep the load factor below one half
+    size_t capacity = ids_.size();
+    while (capacity < 2 * num_interfaces) {
+        capacity *= 2;
+    }
+    if (capacity != ids_.size()) {
+        rehash_(capacity);
+    }
 }
 
-size_t InterfaceLookup::insert(std::vector<size_t> vertex_ids) {
-    std::string hash = hash_vertex_ids(vertex_ids);
-    if (contains_hash(hash)) {
-        return hash_map_[hash];
+size_t InterfaceLookup::insert_or_find(const std::vector<size_t>& vertex_ids,
+                                       bool& inserted) {
+    if (2 * (size_ + 1) > ids_.size()) {
+        rehash_(2 * ids_.size());
+    }
+    Key key = make_key_(vertex_ids);
+    size_t slot = slot_(key);
+    if (ids_[slot] != empty_) {
+        inserted = false;
+        return ids_[slot];
     }
-    size_t id = hash_map_.size();
-    hash_map_.insert({hash, id});
-    return id;
+    keys_[slot] = key;
+    ids_[slot] = size_;
+    size_++;
+    inserted = true;
+    return ids_[slot];
+}
+
+size_t InterfaceLookup::insert(const std::vector<size_t>& vertex_ids) {
+    bool inserted;
+    return insert_or_find(vertex_ids, inserted);
+}
+
+bool InterfaceLookup::contains(const std::vector<size_t>& vertex_ids) const {
+    return id(vertex_ids) != empty_;
+}
+
+size_t InterfaceLookup::id(const std::vector<size_t>& vertex_ids) const {
+    return ids_[slot_(make_key_(vertex_ids))];
 }
 
-bool InterfaceLookup::contains(std::vector<size_t> vertex_ids) {
-    std::string hash = hash_vertex_ids(vertex_ids);
-    return contains_hash(hash);
+size_t InterfaceLookup::find(const std::vector<size_t>& vertex_ids) const noexcept {
+    Key key;
+    if (!try_make_key_(vertex_ids, key)) return not_found;
+    return ids_[slot_(key)];
 }
 
-size_t InterfaceLookup::id(std::vector<size_t> vertex_ids) {
-    std::string hash = hash_vertex_ids(vertex_ids);
-    if (contains_hash(hash)) {
-        return hash_map_[hash];
+InterfaceLookup::Key InterfaceLookup::make_key_(
+    const std::vector<size_t>& vertex_ids) const {
+    Key key;
+    if (!try_make_key_(vertex_ids, key)) {
+        spdlog::error("Interfaces with {} vertices are not supported", vertex_ids.size());
+        throw std::runtime_error("Too many vertices in interface");
     }
-    return std::numeric_limits<size_t>::max();
+    return key;
 }
 
-bool InterfaceLookup::contains_hash(std::string hash) {
-    return hash_map_.find(hash) != hash_map_.end();
+bool InterfaceLookup::try_make_key_(const std::vector<size_t>& vertex_ids,
+                                    Key& key) const noexcept {
+    if (vertex_ids.size() > max_vertices_) return false;
+    key.fill(empty_);
+    std::copy(vertex_ids.begin(), vertex_ids.end(), key.begin());
+    std::sort(key.begin(), key.begin() + vertex_ids.size());
+    return true;
 }
 
-std::string InterfaceLookup::hash_vertex_ids(std::vector<size_t> vertex_ids) {
-    std::sort(vertex_ids.begin(), vertex_ids.end(), std::greater<size_t>());
-    std::string hash_value = "";
-    for (size_t i = 0; i < vertex_ids.size(); i++) {
-        hash_value.append(std::to_string(vertex_ids[i]));
-        hash_value.append(",");
+// The slot holding key, or the empty slot where it would be inserted
+size_t InterfaceLookup::slot_(const Key& key) const noexcept {
+    std::uint64_t hash = 0x9e3779b97f4a7c15;
+    for (size_t vertex_id : key) {
+        hash ^= vertex_id + 0x9e3779b97f4a7c15 + (hash << 6) + (hash >> 2);
+    }
+    // final mixing from splitmix64, so nearby ids land in different slots
+    hash ^= hash >> 30;
+    hash *= 0xbf58476d1ce4e5b9;
+    hash ^= hash >> 27;
+    hash *= 0x94d049bb133111eb;
+    hash ^= hash >> 31;
+
+    size_t mask = ids_.size() - 1;
+    size_t slot = hash & mask;
+    while (ids_[slot] != empty_ && keys_[slot] != key) {
+        slot = (slot + 1) & mask;
+    }
+    return slot;
+}
+
+void InterfaceLookup::rehash_(size_t capacity) {
+    std::vector<Key> old_keys = std::move(keys_);
+    std::vector<size_t> old_ids = std::move(ids_);
+    keys_ = std::vector<Key>(capacity);
+    ids_ = std::vector<size_t>(capacity, empty_);
+    for (size_t i = 0; i < old_ids.size(); i++) {
+        if (old_ids[i] != empty_) {
+            size_t slot = slot_(old_keys[i]);
+            keys_[slot] = old_keys[i];
+            ids_[slot] = old_ids[i];
+        }
     }
-    return hash_value;
 }
 
 TEST_CASE("interface look up contains") {
@@ -104,6 +169,40 @@ TEST_CASE("interface look up") {
     CHECK(x.id(std::vector<size_t>{7, 6}) == 9);
 }
 
+TEST_CASE("interface look up insert_or_find") {
+    InterfaceLookup x;
+    bool inserted;
+    CHECK(x.insert_or_find(std::vector<size_t>{3, 0, 7, 4}, inserted) == 0);
+    CHECK(inserted);
+    CHECK(x.insert_or_find(std::vector<size_t>{1, 2, 6, 5}, inserted) == 1);
+    CHECK(inserted);
+    CHECK(x.insert_or_find(std::vector<size_t>{4, 7, 0, 3}, inserted) == 0);
+    CHECK(inserted == false);
+    CHECK(x.size() == 2);
+
+    // enough interfaces that the table has to grow
+    for (size_t i = 0; i < 1000; i++) {
+        x.insert(std::vector<size_t>{10 + i, 11 + i, 12 + i});
+    }
+    CHECK(x.size() == 1002);
+    CHECK(x.id(std::vector<size_t>{6, 5, 2, 1}) == 1);
+    CHECK(x.id(std::vector<size_t>{512, 510, 511}) == 502);
+    CHECK(x.contains(std::vector<size_t>{510, 511}) == false);
+}
+
+TEST_CASE("interface look up find") {
+    InterfaceLookup x;
+    x.insert(std::vector<size_t>{0, 1});
+    x.insert(std::vector<size_t>{1, 5});
+
+    CHECK(x.find(std::vector<size_t>{5, 1}) == 1);
+    CHECK(x.find(std::vector<size_t>{6, 1}) == InterfaceLookup::not_found);
+
+    // too many vertices is reported as missing, rather than thrown
+    CHECK(x.find(std::vector<size_t>{0, 1, 2, 3, 4}) == InterfaceLookup::not_found);
+    CHECK_THROWS(x.id(std::vector<size_t>{0, 1, 2, 3, 4}));
+}
+
 Interfaces<Ibis::real> generate_interfaces() {
     Vertices<Ibis::real> vertices(16);
     auto vertices_host = vertices.host_mirror();
@@ -9,8 +9,9 @@
 #include <util/ragged_array.h>
 #include <util/vector3.h>
 
+#include <array>
 #include <limits>
-#include <unordered_map>
+#include <vector>
 
 template <typename T, class ExecSpace = Kokkos::DefaultExecutionSpace,
           class Layout = Kokkos::DefaultExecutionSpace::array_layout>
@@ -31,8 +32,11 @@ public:
 public:
     Interfaces() {}
 
-    Interfaces(std::vector<std::vector<size_t>> ids, std::vector<ElemType> shapes) {
-        vertex_ids_ = id_type(ids);
+    Interfaces(std::vector<std::vector<size_t>> ids, std::vector<ElemType> shapes)
+        : Interfaces(id_type(ids), shapes) {}
+
+    Interfaces(id_type vertex_ids, const std::vector<ElemType>& shapes) {
+        vertex_ids_ = vertex_ids;
         size_ = vertex_ids_.num_rows();
         shape_ = Field<ElemType, array_layout, memory_space>("Interface::shape",
                                                              shapes.size());
@@ -344,22 +348,51 @@ public:
     vector_type centre_;
 };
 
-// Efficient look-up of interface ID
-// from the index of the vertices
-// forming the interface
+// Efficient look-up of interface ID from the index of the vertices
+// forming the interface. The vertex ids are sorted and packed into a
+// fixed size key, which is stored in an open addressing hash table
+// with linear probing, so no memory is allocated per interface.
 struct InterfaceLookup {
 public:
     InterfaceLookup();
 
-    size_t insert(std::vector<size_t> vertex_ids);
-    bool contains(std::vector<size_t> vertex_ids);
-    size_t id(std::vector<size_t> vertex_ids);
+    // Make room for at least num_interfaces interfaces without resizing
+    void reserve(size_t num_interfaces);
+
+    // The id of the interface formed by vertex_ids, adding it with the
+    // next id if it doesn't exist yet. inserted is set to whether the
+    // interface was added. This only looks up the interface once.
+    size_t insert_or_find(const std::vector<size_t>& vertex_ids, bool& inserted);
+
+    size_t insert(const std::vector<size_t>& vertex_ids);
+    bool contains(const std::vector<size_t>& vertex_ids) const;
+    size_t id(const std::vector<size_t>& vertex_ids) const;
+
+    // returned by find for an interface which doesn't exist
+    static constexpr size_t not_found = std::numeric_limits<size_t>::max();
+
+    // The id of the interface formed by vertex_ids, or not_found if there
+    // isn't one. Unlike id, this never throws (or logs), so it can be
+    // called from inside a parallel region.
+    size_t find(const std::vector<size_t>& vertex_ids) const noexcept;
+
+    size_t size() const { return size_; }
 
 private:
-    std::unordered_map<std::string, size_t> hash_map_;
+    // the most vertices an interface can have
+    static constexpr size_t max_vertices_ = 4;
+    using Key = std::array<size_t, max_vertices_>;
+
+    // keys_[i] is only meaningful if ids_[i] is not empty_
+    static constexpr size_t empty_ = not_found;
+    std::vector<Key> keys_;
+    std::vector<size_t> ids_;
+    size_t size_;
 
-    std::string hash_vertex_ids(std::vector<size_t> vertex_ids);
-    bool contains_hash(std::string hash);
+    Key make_key_(const std::vector<size_t>& vertex_ids) const;
+    bool try_make_key_(const std::vector<size_t>& vertex_ids, Key& key) const noexcept;
+    size_t slot_(const Key& key) const noexcept;
+    void rehash_(size_t capacity);
 };
 
 #endif
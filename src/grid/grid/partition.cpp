@@ -0,0 +1,343 @@
+#include <doctest/doctest.h>
+#include <grid/interface.h>
+#include <grid/partition.h>
+#include <grid/renumber.h>
+#include <spdlog/spdlog.h>
+
+#include <algorithm>
+#include <array>
+#include <limits>
+#include <stdexcept>
+
+namespace {
+
+const size_t unset = std::numeric_limits<size_t>::max();
+
+// The cells in `cells` ordered breadth first from `start`, only moving
+// between cells in the same group. If the group isn't connected, the
+// search carries on from the first cell in `cells` which hasn't been
+// reached. `visited` must be false for all the cells, and is left that way.
+std::vector<size_t> breadth_first_order(
+    const std::vector<std::vector<size_t>>& neighbours, const std::vector<size_t>& cells,
+    const std::vector<size_t>& groups, size_t start, std::vector<bool>& visited) {
+    size_t group = groups[start];
+    std::vector<size_t> order;
+    order.reserve(cells.size());
+    auto visit = [&](size_t cell) {
+        visited[cell] = true;
+        order.push_back(cell);
+    };
+
+    visit(start);
+    size_t head = 0;
+    size_t next_unvisited = 0;
+    while (order.size() < cells.size()) {
+        if (head == order.size()) {
+            while (visited[cells[next_unvisited]]) next_unvisited++;
+            visit(cells[next_unvisited]);
+        }
+        size_t cell = order[head++];
+        for (size_t neighbour : neighbours[cell]) {
+            if (groups[neighbour] == group && !visited[neighbour]) {
+                visit(neighbour);
+            }
+        }
+    }
+
+    for (size_t cell : order) {
+        visited[cell] = false;
+    }
+    return order;
+}
+
+// Split `cells`, which are all in the same group, into num_blocks blocks,
+// numbered from first_block
+void bisect(const std::vector<std::vector<size_t>>& neighbours,
+            const std::vector<size_t>& cells, size_t first_block, size_t num_blocks,
+            std::vector<size_t>& groups, size_t& num_groups, std::vector<bool>& visited,
+            std::vector<size_t>& cell_blocks) {
+    if (num_blocks == 1) {
+        for (size_t cell : cells) {
+            cell_blocks[cell] = first_block;
+        }
+        return;
+    }
+
+    // the last cell reached searching from any cell is close to the edge
+    // of the graph, so starting from there gives long, narrow levels
+    size_t start =
+        breadth_first_order(neighbours, cells, groups, cells[0], visited).back();
+    std::vector<size_t> order =
+        breadth_first_order(neighbours, cells, groups, start, visited);
+
+    size_t left_blocks = num_blocks / 2;
+    size_t left_size = cells.size() * left_blocks / num_blocks;
+    std::vector<size_t> left(order.begin(), order.begin() + left_size);
+    std::vector<size_t> right(order.begin() + left_size, order.end());
+    size_t left_group = num_groups++;
+    size_t right_group = num_groups++;
+    for (size_t cell : left) {
+        groups[cell] = left_group;
+    }
+    for (size_t cell : right) {
+        groups[cell] = right_group;
+    }
+
+    bisect(neighbours, left, first_block, left_blocks, groups, num_groups, visited,
+           cell_blocks);
+    bisect(neighbours, right, first_block + left_blocks, num_blocks - left_blocks, groups,
+           num_groups, visited, cell_blocks);
+}
+
+}  // namespace
+
+std::vector<size_t> partition_cells(const GridIO& grid_io, size_t num_blocks) {
+    size_t num_cells = grid_io.num_cells();
+    if (num_blocks == 0 || num_blocks > num_cells) {
+        spdlog::error("Unable to split {} cells into {} blocks", num_cells, num_blocks);
+        throw std::runtime_error("Invalid number of blocks");
+    }
+
+    std::vector<size_t> cell_blocks(num_cells, 0);
+    if (num_blocks == 1) {
+        return cell_blocks;
+    }
+
+    std::vector<std::vector<size_t>> neighbours = cell_adjacency(grid_io);
+    std::vector<size_t> cells(num_cells);
+    for (size_t cell_i = 0; cell_i < num_cells; cell_i++) {
+        cells[cell_i] = cell_i;
+    }
+    std::vector<size_t> groups(num_cells, 0);
+    size_t num_groups = 1;
+    std::vector<bool> visited(num_cells, false);
+    bisect(neighbours, cells, 0, num_blocks, groups, num_groups, visited, cell_blocks);
+    return cell_blocks;
+}
+
+std::vector<GridPartition> split_grid_io(const GridIO& grid_io,
+                                         const std::vector<size_t>& cell_blocks,
+                                         size_t num_blocks) {
+    const std::vector<size_t>& cell_vertex_ids = grid_io.cell_vertex_ids();
+    const std::vector<size_t>& cell_vertex_offsets = grid_io.cell_vertex_offsets();
+    const std::vector<ElemType>& cell_types = grid_io.cell_types();
+    size_t num_cells = grid_io.num_cells();
+    if (grid_io.markers().count(INTERBLOCK_TAG) > 0) {
+        spdlog::error("The marker tag {} is reserved for joining blocks", INTERBLOCK_TAG);
+        throw std::runtime_error("Reserved marker tag");
+    }
+
+    // the index of each cell in its block
+    std::vector<GridPartition> partitions(num_blocks);
+    std::vector<size_t> block_cell_ids(num_cells);
+    for (size_t cell_i = 0; cell_i < num_cells; cell_i++) {
+        GridPartition& partition = partitions[cell_blocks[cell_i]];
+        block_cell_ids[cell_i] = partition.global_cell_ids.size();
+        partition.global_cell_ids.push_back(cell_i);
+    }
+
+    // the cells either side of each face, and the faces with cells in
+    // different blocks
+    InterfaceLookup faces = InterfaceLookup();
+    faces.reserve((grid_io.dim() == 3 ? 3 : 2) * num_cells);
+    std::vector<std::array<size_t, 2>> face_cells;
+    std::vector<ElemIO> interblock_faces;
+    std::vector<size_t> interblock_face_ids;
+    std::vector<size_t> face_vertices;
+    for (size_t cell_i = 0; cell_i < num_cells; cell_i++) {
+        const size_t* vertex_ids = cell_vertex_ids.data() + cell_vertex_offsets[cell_i];
+        const ElemFaces& cell_faces = vtk_element_faces(cell_types[cell_i]);
+        for (size_t face_i = 0; face_i < cell_faces.num_faces; face_i++) {
+            face_vertices.resize(cell_faces.num_face_vertices[face_i]);
+            for (size_t vertex_i = 0; vertex_i < face_vertices.size(); vertex_i++) {
+                face_vertices[vertex_i] =
+                    vertex_ids[cell_faces.vertices[face_i][vertex_i]];
+            }
+            bool new_face;
+            size_t face_id = faces.insert_or_find(face_vertices, new_face);
+            if (new_face) {
+                face_cells.push_back({cell_i, unset});
+                continue;
+            }
+            face_cells[face_id][1] = cell_i;
+            if (cell_blocks[face_cells[face_id][0]] != cell_blocks[cell_i]) {
+                interblock_faces.push_back(
+                    ElemIO(face_vertices, cell_faces.face_types[face_i], FaceOrder::Vtk));
+                interblock_face_ids.push_back(face_id);
+            }
+        }
+    }
+
+    // the faces of the markers
+    std::unordered_map<std::string, std::vector<size_t>> marker_face_ids;
+    for (const auto& [tag, marker] : grid_io.markers()) {
+        std::vector<size_t>& face_ids = marker_face_ids[tag];
+        for (const ElemIO& face : marker) {
+            if (!faces.contains(face.vertex_ids())) {
+                spdlog::error("Marker {} has a face which isn't in the grid", tag);
+                throw std::runtime_error("Invalid marker");
+            }
+            face_ids.push_back(faces.id(face.vertex_ids()));
+        }
+    }
+
+    std::vector<size_t> block_vertex_ids(grid_io.vertices().size(), unset);
+    for (size_t block = 0; block < num_blocks; block++) {
+        GridPartition& partition = partitions[block];
+
+        // the vertices used by this block, in the order of grid_io
+        std::vector<size_t> vertices;
+        for (size_t cell_i : partition.global_cell_ids) {
+            vertices.insert(vertices.end(),
+                            cell_vertex_ids.begin() + cell_vertex_offsets[cell_i],
+                            cell_vertex_ids.begin() + cell_vertex_offsets[cell_i + 1]);
+        }
+        std::sort(vertices.begin(), vertices.end());
+        vertices.erase(std::unique(vertices.begin(), vertices.end()), vertices.end());
+        std::vector<Vertex<Ibis::real>> block_vertices;
+        block_vertices.reserve(vertices.size());
+        for (size_t vertex_i = 0; vertex_i < vertices.size(); vertex_i++) {
+            block_vertex_ids[vertices[vertex_i]] = vertex_i;
+            block_vertices.push_back(grid_io.vertices()[vertices[vertex_i]]);
+        }
+        auto block_face = [&](const ElemIO& face) {
+            std::vector<size_t> vertex_ids = face.vertex_ids();
+            for (size_t& vertex_id : vertex_ids) {
+                vertex_id = block_vertex_ids[vertex_id];
+            }
+            return ElemIO(vertex_ids, face.cell_type(), FaceOrder::Vtk);
+        };
+
+        // the cells
+        std::vector<size_t> block_cell_vertex_ids;
+        std::vector<size_t> block_cell_vertex_offsets{0};
+        std::vector<ElemType> block_cell_types;
+        for (size_t cell_i : partition.global_cell_ids) {
+            size_t first = cell_vertex_offsets[cell_i];
+            size_t last = cell_vertex_offsets[cell_i + 1];
+            for (size_t i = first; i < last; i++) {
+                block_cell_vertex_ids.push_back(block_vertex_ids[cell_vertex_ids[i]]);
+            }
+            block_cell_vertex_offsets.push_back(block_cell_vertex_ids.size());
+            block_cell_types.push_back(cell_types[cell_i]);
+        }
+
+        // the marked faces next to a cell in this block
+        std::unordered_map<std::string, std::vector<ElemIO>> block_markers;
+        for (const auto& [tag, marker] : grid_io.markers()) {
+            std::vector<ElemIO>& block_marker = block_markers[tag];
+            const std::vector<size_t>& face_ids = marker_face_ids.at(tag);
+            for (size_t face_i = 0; face_i < marker.size(); face_i++) {
+                const std::array<size_t, 2>& cells = face_cells[face_ids[face_i]];
+                if (cell_blocks[cells[0]] == block ||
+                    (cells[1] != unset && cell_blocks[cells[1]] == block)) {
+                    block_marker.push_back(block_face(marker[face_i]));
+                }
+            }
+        }
+
+        // the faces shared with other blocks, and the cells on the other side
+        std::vector<ElemIO>& interblock = block_markers[INTERBLOCK_TAG];
+        for (size_t face_i = 0; face_i < interblock_faces.size(); face_i++) {
+            const std::array<size_t, 2>& cells = face_cells[interblock_face_ids[face_i]];
+            size_t other_cell;
+            if (cell_blocks[cells[0]] == block) {
+                other_cell = cells[1];
+            } else if (cell_blocks[cells[1]] == block) {
+                other_cell = cells[0];
+            } else {
+                continue;
+            }
+            interblock.push_back(block_face(interblock_faces[face_i]));
+            partition.halo_blocks.push_back(cell_blocks[other_cell]);
+            partition.halo_cells.push_back(block_cell_ids[other_cell]);
+        }
+
+        for (size_t vertex_id : vertices) {
+            block_vertex_ids[vertex_id] = unset;
+        }
+        partition.grid_io =
+            GridIO(std::move(block_vertices), std::move(block_cell_vertex_ids),
+                   std::move(block_cell_vertex_offsets), std::move(block_cell_types),
+                   std::move(block_markers), grid_io.dim());
+    }
+    return partitions;
+}
+
+TEST_CASE("partition_cells") {
+    GridIO grid_io("../../../src/grid/test/cube.su2");
+    size_t num_cells = grid_io.num_cells();
+    for (size_t num_blocks = 1; num_blocks <= 5; num_blocks++) {
+        std::vector<size_t> cell_blocks = partition_cells(grid_io, num_blocks);
+        REQUIRE(cell_blocks.size() == num_cells);
+        std::vector<size_t> block_sizes(num_blocks, 0);
+        for (size_t block : cell_blocks) {
+            REQUIRE(block < num_blocks);
+            block_sizes[block]++;
+        }
+        auto [smallest, largest] =
+            std::minmax_element(block_sizes.begin(), block_sizes.end());
+        CHECK(*largest - *smallest <= 1);
+    }
+    CHECK_THROWS(partition_cells(grid_io, num_cells + 1));
+}
+
+TEST_CASE("split_grid_io") {
+    GridIO grid_io("../../../src/grid/test/grid.su2");
+    size_t num_blocks = 3;
+    std::vector<GridPartition> partitions =
+        split_grid_io(grid_io, partition_cells(grid_io, num_blocks), num_blocks);
+    REQUIRE(partitions.size() == num_blocks);
+
+    size_t num_cells = 0;
+    size_t num_interblock_faces = 0;
+    for (const GridPartition& partition : partitions) {
+        num_cells += partition.grid_io.num_cells();
+        REQUIRE(partition.global_cell_ids.size() == partition.grid_io.num_cells());
+
+        // each cell has the same vertices as in the original grid
+        for (size_t cell_i = 0; cell_i < partition.grid_io.num_cells(); cell_i++) {
+            ElemIO cell = partition.grid_io.cell(cell_i);
+            ElemIO global_cell = grid_io.cell(partition.global_cell_ids[cell_i]);
+            REQUIRE(cell.vertex_ids().size() == global_cell.vertex_ids().size());
+            for (size_t i = 0; i < cell.vertex_ids().size(); i++) {
+                CHECK(partition.grid_io.vertices()[cell.vertex_ids()[i]] ==
+                      grid_io.vertices()[global_cell.vertex_ids()[i]]);
+            }
+        }
+
+        // the cell on the other side of each interblock face has the
+        // vertices of the face
+        const std::vector<ElemIO>& interblock =
+            partition.grid_io.markers().at(INTERBLOCK_TAG);
+        REQUIRE(partition.halo_blocks.size() == interblock.size());
+        REQUIRE(partition.halo_cells.size() == interblock.size());
+        num_interblock_faces += interblock.size();
+        for (size_t face_i = 0; face_i < interblock.size(); face_i++) {
+            const GridPartition& other = partitions[partition.halo_blocks[face_i]];
+            CHECK(&other != &partition);
+            ElemIO other_cell = other.grid_io.cell(partition.halo_cells[face_i]);
+            for (size_t vertex_id : interblock[face_i].vertex_ids()) {
+                Vertex<Ibis::real> vertex = partition.grid_io.vertices()[vertex_id];
+                bool found = false;
+                for (size_t other_vertex : other_cell.vertex_ids()) {
+                    found = found || (other.grid_io.vertices()[other_vertex] == vertex);
+                }
+                CHECK(found);
+            }
+        }
+    }
+    CHECK(num_cells == grid_io.num_cells());
+
+    // each face between blocks is seen from both sides, and every
+    // boundary face ends up in exactly one block
+    CHECK(num_interblock_faces % 2 == 0);
+    CHECK(num_interblock_faces > 0);
+    for (const auto& [tag, marker] : grid_io.markers()) {
+        size_t num_faces = 0;
+        for (const GridPartition& partition : partitions) {
+            num_faces += partition.grid_io.markers().at(tag).size();
+        }
+        CHECK(num_faces == marker.size());
+    }
+}
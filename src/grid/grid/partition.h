@@ -0,0 +1,45 @@
+#ifndef PARTITION_H
+#define PARTITION_H
+
+#include <grid/grid_io.h>
+
+#include <string>
+#include <vector>
+
+// Splitting a grid into several blocks, which can be worked on separately
+// and joined back together through ghost cells. The faces between two
+// blocks are added to each block as a boundary with the tag
+// INTERBLOCK_TAG, and the ghost cells on that boundary are filled from the
+// cells on the other side of the faces.
+constexpr char INTERBLOCK_TAG[] = "interblock";
+
+// The block each cell belongs to, found by recursive bisection of the
+// graph of cells sharing a face. Each bisection orders the cells breadth
+// first from a cell on the edge of the graph, and splits the ordering in
+// proportion to the number of blocks on each side, so the blocks have
+// (nearly) the same number of cells, and are mostly connected.
+std::vector<size_t> partition_cells(const GridIO& grid_io, size_t num_blocks);
+
+// One block of a grid which has been split up
+struct GridPartition {
+    // The cells and vertices of this block, with any boundaries they touch,
+    // and the faces shared with other blocks on the INTERBLOCK_TAG boundary
+    GridIO grid_io;
+
+    // The position in the original grid of each cell in grid_io
+    std::vector<size_t> global_cell_ids;
+
+    // The cell on the other side of each face on the INTERBLOCK_TAG
+    // boundary, in the same order as the faces of the boundary. The cell
+    // is given as the block it belongs to, and its index in that block.
+    std::vector<size_t> halo_blocks;
+    std::vector<size_t> halo_cells;
+};
+
+// Split grid_io into blocks, with cell_blocks[i] the block of cell i. The
+// cells and vertices of each block keep the order they had in grid_io.
+std::vector<GridPartition> split_grid_io(const GridIO& grid_io,
+                                         const std::vector<size_t>& cell_blocks,
+                                         size_t num_blocks);
+
+#endif
@@ -0,0 +1,379 @@
+#include <doctest/doctest.h>
+#include <grid/interface.h>
+#include <grid/renumber.h>
+#include <spdlog/spdlog.h>
+
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <limits>
+#include <numeric>
+#include <stdexcept>
+
+RenumberMethod string_to_renumber_method(std::string method) {
+    if (method == "none") {
+        return RenumberMethod::None;
+    } else if (method == "hilbert") {
+        return RenumberMethod::Hilbert;
+    } else if (method == "morton") {
+        return RenumberMethod::Morton;
+    } else if (method == "rcm") {
+        return RenumberMethod::ReverseCuthillMcKee;
+    } else {
+        spdlog::error("Unknown grid renumbering method {}", method);
+        throw std::runtime_error("Unknown grid renumbering method");
+    }
+}
+
+std::vector<size_t> invert_permutation(const std::vector<size_t>& permutation) {
+    std::vector<size_t> inverse(permutation.size());
+    for (size_t i = 0; i < permutation.size(); i++) {
+        inverse[permutation[i]] = i;
+    }
+    return inverse;
+}
+
+using Coords = std::array<std::uint32_t, 3>;
+
+// The centres of the cells, scaled to integer coordinates with `bits`
+// bits in each direction. The average of the vertices of each cell is
+// close enough to the centroid for ordering the cells.
+std::vector<Coords> quantised_cell_centres(const GridIO& grid_io, size_t dim,
+                                           unsigned int bits) {
+    const std::vector<Vertex<Ibis::real>>& vertices = grid_io.vertices();
+    const std::vector<size_t>& cell_vertex_ids = grid_io.cell_vertex_ids();
+    const std::vector<size_t>& cell_vertex_offsets = grid_io.cell_vertex_offsets();
+    size_t num_cells = grid_io.num_cells();
+
+    std::vector<std::array<Ibis::real, 3>> centres(num_cells);
+    std::array<Ibis::real, 3> lo, hi;
+    lo.fill(std::numeric_limits<Ibis::real>::max());
+    hi.fill(std::numeric_limits<Ibis::real>::lowest());
+    for (size_t cell_i = 0; cell_i < num_cells; cell_i++) {
+        size_t first = cell_vertex_offsets[cell_i];
+        size_t last = cell_vertex_offsets[cell_i + 1];
+        std::array<Ibis::real, 3> centre{0.0, 0.0, 0.0};
+        for (size_t i = first; i < last; i++) {
+            const Vector3<Ibis::real>& pos = vertices[cell_vertex_ids[i]].pos();
+            centre[0] += pos.x;
+            centre[1] += pos.y;
+            centre[2] += pos.z;
+        }
+        for (size_t d = 0; d < 3; d++) {
+            centre[d] /= last - first;
+            lo[d] = std::min(lo[d], centre[d]);
+            hi[d] = std::max(hi[d], centre[d]);
+        }
+        centres[cell_i] = centre;
+    }
+
+    Ibis::real max_coord = static_cast<Ibis::real>((std::uint64_t(1) << bits) - 1);
+    std::vector<Coords> coords(num_cells);
+    for (size_t cell_i = 0; cell_i < num_cells; cell_i++) {
+        coords[cell_i].fill(0);
+        for (size_t d = 0; d < dim; d++) {
+            Ibis::real range = hi[d] - lo[d];
+            Ibis::real scaled =
+                (range > 0.0) ? (centres[cell_i][d] - lo[d]) / range : 0.0;
+            coords[cell_i][d] = static_cast<std::uint32_t>(scaled * max_coord);
+        }
+    }
+    return coords;
+}
+
+// Interleave the bits of the coordinates, most significant first
+std::uint64_t interleave_bits(const Coords& coords, size_t dim, unsigned int bits) {
+    std::uint64_t key = 0;
+    for (int bit = bits - 1; bit >= 0; bit--) {
+        for (size_t d = 0; d < dim; d++) {
+            key = (key << 1) | ((coords[d] >> bit) & 1);
+        }
+    }
+    return key;
+}
+
+std::uint64_t morton_key(const Coords& coords, size_t dim, unsigned int bits) {
+    return interleave_bits(coords, dim, bits);
+}
+
+// The distance along the Hilbert curve, using Skilling's algorithm
+// ("Programming the Hilbert curve", AIP Conf. Proc. 707, 2004) to
+// transform the coordinates so that interleaving their bits gives the
+// Hilbert index.
+std::uint64_t hilbert_key(Coords x, size_t dim, unsigned int bits) {
+    std::uint32_t m = std::uint32_t(1) << (bits - 1);
+
+    // inverse undo excess work
+    for (std::uint32_t q = m; q > 1; q >>= 1) {
+        std::uint32_t p = q - 1;
+        for (size_t i = 0; i < dim; i++) {
+            if (x[i] & q) {
+                x[0] ^= p;
+            } else {
+                std::uint32_t t = (x[0] ^ x[i]) & p;
+                x[0] ^= t;
+                x[i] ^= t;
+            }
+        }
+    }
+
+    // gray encode
+    for (size_t i = 1; i < dim; i++) {
+        x[i] ^= x[i - 1];
+    }
+    std::uint32_t t = 0;
+    for (std::uint32_t q = m; q > 1; q >>= 1) {
+        if (x[dim - 1] & q) {
+            t ^= q - 1;
+        }
+    }
+    for (size_t i = 0; i < dim; i++) {
+        x[i] ^= t;
+    }
+
+    return interleave_bits(x, dim, bits);
+}
+
+template <class KeyFunction>
+std::vector<size_t> space_filling_curve_ordering(const GridIO& grid_io,
+                                                 KeyFunction key_function) {
+    size_t dim = grid_io.dim();
+    unsigned int bits = (dim == 3) ? 21 : 31;
+    std::vector<Coords> coords = quantised_cell_centres(grid_io, dim, bits);
+
+    std::vector<std::uint64_t> keys(coords.size());
+    for (size_t cell_i = 0; cell_i < coords.size(); cell_i++) {
+        keys[cell_i] = key_function(coords[cell_i], dim, bits);
+    }
+
+    std::vector<size_t> order(coords.size());
+    std::iota(order.begin(), order.end(), 0);
+    std::stable_sort(order.begin(), order.end(),
+                     [&](size_t a, size_t b) { return keys[a] < keys[b]; });
+    return order;
+}
+
+// The cells which share a face with each cell
+std::vector<std::vector<size_t>> cell_adjacency(const GridIO& grid_io) {
+    size_t num_cells = grid_io.num_cells();
+    InterfaceLookup interfaces = InterfaceLookup();
+    interfaces.reserve((grid_io.dim() == 3 ? 3 : 2) * num_cells);
+    std::vector<size_t> first_cell_of_face;
+    std::vector<std::vector<size_t>> neighbours(num_cells);
+    std::vector<size_t> face_vertices;
+    for (size_t cell_i = 0; cell_i < num_cells; cell_i++) {
+        const size_t* vertex_ids =
+            grid_io.cell_vertex_ids().data() + grid_io.cell_vertex_offsets()[cell_i];
+        const ElemFaces& faces = vtk_element_faces(grid_io.cell_types()[cell_i]);
+        for (size_t face_i = 0; face_i < faces.num_faces; face_i++) {
+            face_vertices.resize(faces.num_face_vertices[face_i]);
+            for (size_t vertex_i = 0; vertex_i < face_vertices.size(); vertex_i++) {
+                face_vertices[vertex_i] = vertex_ids[faces.vertices[face_i][vertex_i]];
+            }
+            bool new_face;
+            size_t face_id = interfaces.insert_or_find(face_vertices, new_face);
+            if (new_face) {
+                first_cell_of_face.push_back(cell_i);
+            } else {
+                size_t other_cell = first_cell_of_face[face_id];
+                neighbours[cell_i].push_back(other_cell);
+                neighbours[other_cell].push_back(cell_i);
+            }
+        }
+    }
+    return neighbours;
+}
+
+// Reverse Cuthill-McKee ordering of the cell graph. Each connected part of
+// the grid is traversed breadth first, visiting the neighbours of each cell
+// in order of increasing degree, starting from a cell far from the others.
+std::vector<size_t> reverse_cuthill_mckee_ordering(const GridIO& grid_io) {
+    std::vector<std::vector<size_t>> neighbours = cell_adjacency(grid_io);
+    size_t num_cells = neighbours.size();
+    auto degree = [&](size_t cell) { return neighbours[cell].size(); };
+    auto by_degree = [&](size_t a, size_t b) { return degree(a) < degree(b); };
+    for (auto& cell_neighbours : neighbours) {
+        std::stable_sort(cell_neighbours.begin(), cell_neighbours.end(), by_degree);
+    }
+
+    std::vector<size_t> candidates(num_cells);
+    std::iota(candidates.begin(), candidates.end(), 0);
+    std::stable_sort(candidates.begin(), candidates.end(), by_degree);
+
+    std::vector<size_t> order;
+    order.reserve(num_cells);
+    std::vector<bool> visited(num_cells, false);
+
+    // breadth first traversal from `start`, appending the cells to `order`
+    auto traverse = [&](size_t start) {
+        size_t head = order.size();
+        order.push_back(start);
+        visited[start] = true;
+        while (head < order.size()) {
+            size_t cell = order[head++];
+            for (size_t neighbour : neighbours[cell]) {
+                if (!visited[neighbour]) {
+                    visited[neighbour] = true;
+                    order.push_back(neighbour);
+                }
+            }
+        }
+    };
+
+    for (size_t candidate : candidates) {
+        if (visited[candidate]) continue;
+
+        // find a pseudo-peripheral starting cell, by traversing from the
+        // lowest degree cell and starting again from the last cell found
+        size_t component_start = order.size();
+        traverse(candidate);
+        size_t start = order.back();
+        for (size_t i = component_start; i < order.size(); i++) {
+            visited[order[i]] = false;
+        }
+        order.resize(component_start);
+        traverse(start);
+    }
+
+    std::reverse(order.begin(), order.end());
+    return order;
+}
+
+std::vector<size_t> cell_ordering(const GridIO& grid_io, RenumberMethod method) {
+    switch (method) {
+        case RenumberMethod::None: {
+            std::vector<size_t> order(grid_io.num_cells());
+            std::iota(order.begin(), order.end(), 0);
+            return order;
+        }
+        case RenumberMethod::Hilbert:
+            return space_filling_curve_ordering(grid_io, hilbert_key);
+        case RenumberMethod::Morton:
+            return space_filling_curve_ordering(grid_io, morton_key);
+        case RenumberMethod::ReverseCuthillMcKee:
+            return reverse_cuthill_mckee_ordering(grid_io);
+        default:
+            throw std::runtime_error("Unreachable");
+    }
+}
+
+GridIO renumber_grid_io(const GridIO& grid_io, const std::vector<size_t>& cell_order,
+                        std::vector<size_t>& vertex_order) {
+    const std::vector<Vertex<Ibis::real>>& vertices = grid_io.vertices();
+    const std::vector<size_t>& cell_vertex_ids = grid_io.cell_vertex_ids();
+    const std::vector<size_t>& cell_vertex_offsets = grid_io.cell_vertex_offsets();
+    const size_t unset = std::numeric_limits<size_t>::max();
+
+    std::vector<size_t> new_vertex_ids(vertices.size(), unset);
+    vertex_order.clear();
+    vertex_order.reserve(vertices.size());
+    auto renumber_vertex = [&](size_t vertex_id) {
+        if (new_vertex_ids[vertex_id] == unset) {
+            new_vertex_ids[vertex_id] = vertex_order.size();
+            vertex_order.push_back(vertex_id);
+        }
+        return new_vertex_ids[vertex_id];
+    };
+
+    std::vector<size_t> new_cell_vertex_ids;
+    std::vector<size_t> new_cell_vertex_offsets{0};
+    std::vector<ElemType> new_cell_types;
+    new_cell_vertex_ids.reserve(cell_vertex_ids.size());
+    new_cell_vertex_offsets.reserve(cell_order.size() + 1);
+    new_cell_types.reserve(cell_order.size());
+    for (size_t cell_id : cell_order) {
+        size_t first = cell_vertex_offsets[cell_id];
+        size_t last = cell_vertex_offsets[cell_id + 1];
+        for (size_t i = first; i < last; i++) {
+            new_cell_vertex_ids.push_back(renumber_vertex(cell_vertex_ids[i]));
+        }
+        new_cell_vertex_offsets.push_back(new_cell_vertex_ids.size());
+        new_cell_types.push_back(grid_io.cell_types()[cell_id]);
+    }
+
+    // vertices which don't belong to any cell go at the end
+    for (size_t vertex_id = 0; vertex_id < vertices.size(); vertex_id++) {
+        renumber_vertex(vertex_id);
+    }
+    std::vector<Vertex<Ibis::real>> new_vertices;
+    new_vertices.reserve(vertices.size());
+    for (size_t vertex_id : vertex_order) {
+        new_vertices.push_back(vertices[vertex_id]);
+    }
+
+    std::unordered_map<std::string, std::vector<ElemIO>> new_markers;
+    for (auto& [label, marker] : grid_io.markers()) {
+        std::vector<ElemIO> new_marker;
+        new_marker.reserve(marker.size());
+        for (const ElemIO& face : marker) {
+            std::vector<size_t> vertex_ids = face.vertex_ids();
+            for (size_t& vertex_id : vertex_ids) {
+                vertex_id = new_vertex_ids[vertex_id];
+            }
+            new_marker.push_back(ElemIO(vertex_ids, face.cell_type(), FaceOrder::Vtk));
+        }
+        new_markers.insert({label, new_marker});
+    }
+
+    return GridIO(std::move(new_vertices), std::move(new_cell_vertex_ids),
+                  std::move(new_cell_vertex_offsets), std::move(new_cell_types),
+                  std::move(new_markers), grid_io.dim());
+}
+
+TEST_CASE("invert_permutation") {
+    std::vector<size_t> permutation{2, 0, 3, 1};
+    std::vector<size_t> inverse = invert_permutation(permutation);
+    CHECK(inverse == std::vector<size_t>{1, 3, 0, 2});
+}
+
+TEST_CASE("hilbert_key 2D") {
+    // the first order Hilbert curve visits the quadrants in a U shape
+    unsigned int bits = 1;
+    CHECK(hilbert_key(Coords{0, 0, 0}, 2, bits) == 0);
+    CHECK(hilbert_key(Coords{0, 1, 0}, 2, bits) == 1);
+    CHECK(hilbert_key(Coords{1, 1, 0}, 2, bits) == 2);
+    CHECK(hilbert_key(Coords{1, 0, 0}, 2, bits) == 3);
+}
+
+TEST_CASE("cell_ordering") {
+    GridIO grid_io("../../../src/grid/test/cube.su2");
+    size_t num_cells = grid_io.cells().size();
+    for (RenumberMethod method :
+         {RenumberMethod::Hilbert, RenumberMethod::Morton,
+          RenumberMethod::ReverseCuthillMcKee}) {
+        std::vector<size_t> order = cell_ordering(grid_io, method);
+        CHECK(order.size() == num_cells);
+        std::vector<size_t> sorted = order;
+        std::sort(sorted.begin(), sorted.end());
+        for (size_t i = 0; i < num_cells; i++) {
+            CHECK(sorted[i] == i);
+        }
+    }
+}
+
+TEST_CASE("renumber_grid_io") {
+    GridIO grid_io("../../../src/grid/test/grid.su2");
+    std::vector<size_t> cell_order =
+        cell_ordering(grid_io, RenumberMethod::ReverseCuthillMcKee);
+    std::vector<size_t> vertex_order;
+    GridIO renumbered = renumber_grid_io(grid_io, cell_order, vertex_order);
+
+    std::vector<Vertex<Ibis::real>> vertices = grid_io.vertices();
+    std::vector<Vertex<Ibis::real>> new_vertices = renumbered.vertices();
+    std::vector<ElemIO> cells = grid_io.cells();
+    std::vector<ElemIO> new_cells = renumbered.cells();
+    REQUIRE(new_vertices.size() == vertices.size());
+    REQUIRE(new_cells.size() == cells.size());
+    for (size_t i = 0; i < new_vertices.size(); i++) {
+        CHECK(new_vertices[i] == vertices[vertex_order[i]]);
+    }
+    for (size_t i = 0; i < new_cells.size(); i++) {
+        std::vector<size_t> new_ids = new_cells[i].vertex_ids();
+        std::vector<size_t> ids = cells[cell_order[i]].vertex_ids();
+        REQUIRE(new_ids.size() == ids.size());
+        for (size_t j = 0; j < ids.size(); j++) {
+            CHECK(vertex_order[new_ids[j]] == ids[j]);
+        }
+    }
+    CHECK(renumbered.markers().size() == grid_io.markers().size());
+}
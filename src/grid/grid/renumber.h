@@ -0,0 +1,40 @@
+#ifndef RENUMBER_H
+#define RENUMBER_H
+
+#include <grid/grid_io.h>
+
+#include <string>
+#include <vector>
+
+// How to reorder the cells of a grid when it is loaded. Storing cells
+// which are close to each other in space close to each other in memory
+// improves the locality of the gathers from neighbouring cells and faces.
+enum class RenumberMethod {
+    None,
+    Hilbert,
+    Morton,
+    ReverseCuthillMcKee,
+};
+
+RenumberMethod string_to_renumber_method(std::string method);
+
+// The order to store the cells of the grid in. Entry i is the index in
+// grid_io of the cell which becomes cell i.
+std::vector<size_t> cell_ordering(const GridIO& grid_io, RenumberMethod method);
+
+// A copy of grid_io with the cells stored in cell_order, and the vertices
+// numbered in the order the reordered cells first use them. Since the
+// faces are numbered in the order they are found by looping over the
+// cells, this also sorts the faces by the first cell they belong to.
+// Entry i of vertex_order is set to the index in grid_io of the vertex
+// which becomes vertex i.
+GridIO renumber_grid_io(const GridIO& grid_io, const std::vector<size_t>& cell_order,
+                        std::vector<size_t>& vertex_order);
+
+// The cells which share a face with each cell
+std::vector<std::vector<size_t>> cell_adjacency(const GridIO& grid_io);
+
+// The inverse of a permutation
+std::vector<size_t> invert_permutation(const std::vector<size_t>& permutation);
+
+#endif
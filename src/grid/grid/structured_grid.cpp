@@ -0,0 +1,167 @@
+#include <doctest/doctest.h>
+#include <grid/grid.h>
+#include <grid/structured_grid.h>
+#include <spdlog/spdlog.h>
+
+#include <stdexcept>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+GridIO structured_grid(size_t nx, size_t ny, size_t nz) {
+    if (nx == 0 || ny == 0) {
+        spdlog::error("A structured grid needs at least one cell in each direction");
+        throw std::runtime_error("Empty structured grid");
+    }
+    int dim = (nz == 0) ? 2 : 3;
+    size_t nk = (dim == 2) ? 1 : nz + 1;
+
+    // the vertices, numbered with i varying fastest
+    auto vertex_id = [&](size_t i, size_t j, size_t k) {
+        return (k * (ny + 1) + j) * (nx + 1) + i;
+    };
+    std::vector<Vertex<Ibis::real>> vertices;
+    vertices.reserve((nx + 1) * (ny + 1) * nk);
+    for (size_t k = 0; k < nk; k++) {
+        Ibis::real z = (dim == 2) ? 0.0 : Ibis::real(k) / nz;
+        for (size_t j = 0; j < ny + 1; j++) {
+            for (size_t i = 0; i < nx + 1; i++) {
+                vertices.push_back(Vertex<Ibis::real>(
+                    Vector3<Ibis::real>(Ibis::real(i) / nx, Ibis::real(j) / ny, z)));
+            }
+        }
+    }
+
+    // the cells, with their vertices in vtk order
+    std::vector<size_t> cell_vertex_ids;
+    std::vector<size_t> cell_vertex_offsets{0};
+    std::vector<ElemType> cell_types;
+    if (dim == 2) {
+        for (size_t j = 0; j < ny; j++) {
+            for (size_t i = 0; i < nx; i++) {
+                cell_vertex_ids.insert(
+                    cell_vertex_ids.end(),
+                    {vertex_id(i, j, 0), vertex_id(i + 1, j, 0),
+                     vertex_id(i + 1, j + 1, 0), vertex_id(i, j + 1, 0)});
+                cell_vertex_offsets.push_back(cell_vertex_ids.size());
+                cell_types.push_back(ElemType::Quad);
+            }
+        }
+    } else {
+        for (size_t k = 0; k < nz; k++) {
+            for (size_t j = 0; j < ny; j++) {
+                for (size_t i = 0; i < nx; i++) {
+                    cell_vertex_ids.insert(
+                        cell_vertex_ids.end(),
+                        {vertex_id(i, j, k), vertex_id(i + 1, j, k),
+                         vertex_id(i + 1, j + 1, k), vertex_id(i, j + 1, k),
+                         vertex_id(i, j, k + 1), vertex_id(i + 1, j, k + 1),
+                         vertex_id(i + 1, j + 1, k + 1), vertex_id(i, j + 1, k + 1)});
+                    cell_vertex_offsets.push_back(cell_vertex_ids.size());
+                    cell_types.push_back(ElemType::Hex);
+                }
+            }
+        }
+    }
+
+    // the boundary faces on each side
+    std::unordered_map<std::string, std::vector<ElemIO>> markers;
+    if (dim == 2) {
+        for (size_t j = 0; j < ny; j++) {
+            markers["west"].push_back(ElemIO({vertex_id(0, j, 0), vertex_id(0, j + 1, 0)},
+                                             ElemType::Line, FaceOrder::Vtk));
+            markers["east"].push_back(
+                ElemIO({vertex_id(nx, j, 0), vertex_id(nx, j + 1, 0)}, ElemType::Line,
+                       FaceOrder::Vtk));
+        }
+        for (size_t i = 0; i < nx; i++) {
+            markers["south"].push_back(
+                ElemIO({vertex_id(i, 0, 0), vertex_id(i + 1, 0, 0)}, ElemType::Line,
+                       FaceOrder::Vtk));
+            markers["north"].push_back(
+                ElemIO({vertex_id(i, ny, 0), vertex_id(i + 1, ny, 0)}, ElemType::Line,
+                       FaceOrder::Vtk));
+        }
+    } else {
+        for (size_t k = 0; k < nz; k++) {
+            for (size_t j = 0; j < ny; j++) {
+                for (size_t i : {size_t(0), nx}) {
+                    markers[(i == 0) ? "west" : "east"].push_back(
+                        ElemIO({vertex_id(i, j, k), vertex_id(i, j + 1, k),
+                                vertex_id(i, j + 1, k + 1), vertex_id(i, j, k + 1)},
+                               ElemType::Quad, FaceOrder::Vtk));
+                }
+            }
+            for (size_t i = 0; i < nx; i++) {
+                for (size_t j : {size_t(0), ny}) {
+                    markers[(j == 0) ? "south" : "north"].push_back(
+                        ElemIO({vertex_id(i, j, k), vertex_id(i + 1, j, k),
+                                vertex_id(i + 1, j, k + 1), vertex_id(i, j, k + 1)},
+                               ElemType::Quad, FaceOrder::Vtk));
+                }
+            }
+        }
+        for (size_t j = 0; j < ny; j++) {
+            for (size_t i = 0; i < nx; i++) {
+                for (size_t k : {size_t(0), nz}) {
+                    markers[(k == 0) ? "bottom" : "top"].push_back(
+                        ElemIO({vertex_id(i, j, k), vertex_id(i + 1, j, k),
+                                vertex_id(i + 1, j + 1, k), vertex_id(i, j + 1, k)},
+                               ElemType::Quad, FaceOrder::Vtk));
+                }
+            }
+        }
+    }
+
+    return GridIO(std::move(vertices), std::move(cell_vertex_ids),
+                  std::move(cell_vertex_offsets), std::move(cell_types),
+                  std::move(markers), dim);
+}
+
+TEST_CASE("structured_grid 2D") {
+    GridIO grid_io = structured_grid(4, 3);
+    CHECK(grid_io.dim() == 2);
+    CHECK(grid_io.num_cells() == 12);
+    CHECK(grid_io.vertices().size() == 20);
+    CHECK(grid_io.markers().size() == 4);
+    CHECK(grid_io.markers().at("west").size() == 3);
+    CHECK(grid_io.markers().at("east").size() == 3);
+    CHECK(grid_io.markers().at("south").size() == 4);
+    CHECK(grid_io.markers().at("north").size() == 4);
+
+    // the last cell is in the top right corner
+    ElemIO cell = grid_io.cell(11);
+    CHECK(cell.cell_type() == ElemType::Quad);
+    CHECK(cell.vertex_ids() == std::vector<size_t>{13, 14, 19, 18});
+
+    json config{{"boundaries",
+                 {{"west", {{"ghost_cells", true}}},
+                  {"east", {{"ghost_cells", true}}},
+                  {"south", {{"ghost_cells", true}}},
+                  {"north", {{"ghost_cells", true}}}}},
+                {"motion", {{"enabled", false}}},
+                {"renumber", "none"},
+                {"cache", false},
+                {"geometry_cache", {{"face_weights", true},
+                                    {"signed_areas", true},
+                                    {"inverse_volumes", true},
+                                    {"centre_offsets", true}}}};
+    GridBlock<Ibis::real> grid(grid_io, config);
+    CHECK(grid.num_cells() == 12);
+    CHECK(grid.num_interfaces() == 31);
+    CHECK(grid.num_ghost_cells() == 14);
+}
+
+TEST_CASE("structured_grid 3D") {
+    GridIO grid_io = structured_grid(2, 3, 4);
+    CHECK(grid_io.dim() == 3);
+    CHECK(grid_io.num_cells() == 24);
+    CHECK(grid_io.vertices().size() == 60);
+    CHECK(grid_io.markers().size() == 6);
+    CHECK(grid_io.markers().at("west").size() == 12);
+    CHECK(grid_io.markers().at("east").size() == 12);
+    CHECK(grid_io.markers().at("south").size() == 8);
+    CHECK(grid_io.markers().at("north").size() == 8);
+    CHECK(grid_io.markers().at("bottom").size() == 6);
+    CHECK(grid_io.markers().at("top").size() == 6);
+}
@@ -0,0 +1,18 @@
+#ifndef STRUCTURED_GRID_H
+#define STRUCTURED_GRID_H
+
+#include <grid/grid_io.h>
+
+#include <cstddef>
+
+// A structured grid of nx by ny quads on the unit square, or nx by ny by
+// nz hexes on the unit cube when nz > 0, built in memory. The faces on
+// each side are tagged "west", "east", "south" and "north" (x = 0, x = 1,
+// y = 0, y = 1), plus "bottom" and "top" (z = 0, z = 1) in 3D.
+//
+// The cells are numbered with x varying fastest, then y, then z, which is
+// the order a structured solver would use. This is meant for benchmarks
+// and tests which need a grid of a particular size without a grid file.
+GridIO structured_grid(size_t nx, size_t ny, size_t nz = 0);
+
+#endif
@@ -0,0 +1,569 @@
+#include <finite_volume/conserved_quantities.h>
+#include <finite_volume/primative_conserved_conversion.h>
+#include <gas/flow_state.h>
+#include <grid/grid.h>
+#include <grid/structured_grid.h>
+#include <ibis/commands/bench/bench.h>
+#include <ibis/config.h>
+#include <ibis_version.h>
+#include <linear_algebra/gmres.h>
+#include <runtime_dirs.h>
+#include <simulation/simulation.h>
+#include <solvers/cfl.h>
+#include <solvers/jfnk.h>
+#include <solvers/steady_state.h>
+#include <spdlog/spdlog.h>
+#include <spdlog/stopwatch.h>
+#include <sys/resource.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#include <util/profile.h>
+
+#include <Kokkos_Core.hpp>
+#include <algorithm>
+#include <filesystem>
+#include <fstream>
+#include <memory>
+#include <nlohmann/json.hpp>
+#include <stdexcept>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+using json = nlohmann::json;
+
+// The settings for one of the models, with its defaults if it has any
+json model_config(const std::string& type) {
+    json config{{"type", type}};
+    if (std::filesystem::exists(Ibis::RES_DIR + "/defaults/" + type + ".json")) {
+        config.update(read_defaults(type + ".json"));
+    }
+    return config;
+}
+
+// The configuration of a steady state simulation of air on the synthetic
+// grid, in the same form prep writes to config/config.json. Everything the
+// options don't set comes from the installed defaults.
+json bench_config(const BenchOptions& options, const GridIO& grid_io) {
+    json config;
+
+    json convective_flux = read_defaults("convective_flux.json");
+    convective_flux["flux_calculator"] = model_config(options.flux_calculator);
+    convective_flux["reconstruction_order"] = options.reconstruction_order;
+    convective_flux["fused"] = options.fused;
+    std::string limiter = convective_flux.at("limiter");
+    convective_flux["limiter"] = model_config(limiter);
+    config["convective_flux"] = convective_flux;
+
+    json viscous_flux = read_defaults("viscous_flux.json");
+    viscous_flux["enabled"] = options.viscous;
+    config["viscous_flux"] = viscous_flux;
+
+    std::ifstream species_file(Ibis::RES_DIR + "/species_database/air.json");
+    json air = json::parse(species_file);
+    IdealGas<Ibis::real> gas_model(Ibis::real(air.at("thermo").at("R")));
+    config["gas_model"] = {{"type", "ideal_gas"},
+                           {"R", gas_model.R()},
+                           {"Cv", gas_model.Cv()},
+                           {"Cp", gas_model.Cp()},
+                           {"gamma", gas_model.gamma()}};
+    json sutherland = air.at("transport").at("sutherland");
+    sutherland["type"] = "sutherland";
+    config["transport_properties"] = {
+        {"viscosity", sutherland},
+        {"thermal_conductivity",
+         {{"type", "constant_prandtl_number"},
+          {"Pr", air.at("transport").at("prandtl")}}}};
+
+    // every boundary copies the flow from the cell inside it, so the
+    // boundaries cost about the same as the simplest real boundary
+    json internal_copy{{"type", "internal_copy"}};
+    json boundaries;
+    for (const auto& [tag, faces] : grid_io.markers()) {
+        boundaries[tag] = {{"pre_reconstruction", json::array({internal_copy})},
+                           {"post_convective_flux", json::array()},
+                           {"pre_viscous_grad", json::array()},
+                           {"ghost_cells", true}};
+    }
+    config["grid"] = {{"boundaries", boundaries},
+                      {"motion", {{"enabled", false}}},
+                      {"geometry_cache", read_defaults("geometry_cache.json")},
+                      {"renumber", "none"},
+                      {"cache", false}};
+
+    json solver = read_defaults("steady_state.json");
+    solver["name"] = "steady_state";
+    solver["cfl"] = {{"type", "constant"}, {"value", solver.at("cfl")}};
+    json linear_solver = read_defaults("gmres.json");
+    linear_solver["type"] = "gmres";
+    solver["linear_solver"] = linear_solver;
+    solver["linearisation"] = options.dual ? "dual" : "forward_difference";
+    config["solver"] = solver;
+
+    return config;
+}
+
+// Mach 2 air at sea level conditions, with a smooth perturbation so the
+// limiters and flux calculators see gradients in every direction
+template <typename T>
+void initialise_flow(Sim<T>& sim, FlowStates<T>& fs) {
+    auto centroids = sim.grid.cells().centroids();
+    size_t n_cells = sim.grid.num_cells();
+    Ibis::real R = Ibis::real_part(sim.gas_model.R());
+    Ibis::real gamma = Ibis::real_part(sim.gas_model.gamma());
+    Ibis::real velocity = 2.0 * Kokkos::sqrt(gamma * R * 300.0);
+    Kokkos::parallel_for(
+        "bench::initialise_flow", fs.number_flow_states(),
+        KOKKOS_LAMBDA(const size_t cell_i) {
+            Ibis::real wave = 0.0;
+            if (cell_i < n_cells) {
+                Ibis::real x = Ibis::real_part(centroids.x(cell_i));
+                Ibis::real y = Ibis::real_part(centroids.y(cell_i));
+                Ibis::real z = Ibis::real_part(centroids.z(cell_i));
+                wave = Kokkos::sin(6.0 * x) * Kokkos::cos(4.0 * y) * Kokkos::cos(2.0 * z);
+            }
+            fs.gas.rho(cell_i) = T(1.225 * (1.0 + 0.05 * wave));
+            fs.gas.temp(cell_i) = T(300.0 * (1.0 - 0.05 * wave));
+            fs.vel.x(cell_i) = T(velocity * (1.0 + 0.1 * wave));
+            fs.vel.y(cell_i) = T(0.1 * velocity * wave);
+            fs.vel.z(cell_i) = T(0.0);
+        });
+    sim.gas_model.update_thermo_from_rhoT(fs.gas);
+}
+
+// A lower bound on the bytes moved by one residual evaluation: the flow
+// state of each cell read and its residual written, the left and right
+// states and flux of each face written and read back, and the face
+// geometry (area, normal and tangents) read once. The gradients, limiters
+// and the re-reads of cells shared between faces aren't counted, so the
+// bandwidth actually achieved is higher than reported.
+template <typename T>
+double residual_bytes(const GridBlock<T>& grid, size_t n_cons) {
+    constexpr double flow_values = 7;  // rho, p, T, energy, velocity
+    constexpr double face_geometry = 10;
+    double cells = grid.num_total_cells() * (flow_values + n_cons);
+    double faces =
+        grid.num_interfaces() * (2 * 2 * flow_values + 2 * n_cons + face_geometry);
+    return sizeof(T) * (cells + faces);
+}
+
+// The most memory this process has held at once, in MB. This only counts
+// host memory, so it misses the device memory of GPU builds.
+double peak_memory_MB() {
+    struct rusage usage;
+    if (getrusage(RUSAGE_SELF, &usage) != 0) return 0.0;
+    return usage.ru_maxrss / 1024.0;  // ru_maxrss is in kB
+}
+
+template <typename T>
+json bench_sim(const BenchOptions& options, json config, const GridIO& grid_io) {
+    json grid_config = config.at("grid");
+    GridBlock<T> grid(grid_io, grid_config);
+    auto sim = std::make_shared<Sim<T>>(grid, config);
+    size_t n_total_cells = sim->grid.num_total_cells();
+    size_t n_cells = sim->grid.num_cells();
+    size_t dim = sim->grid.dim();
+    auto fs = std::make_shared<FlowStates<T>>(n_total_cells);
+    auto cq = std::make_shared<ConservedQuantities<T>>(n_total_cells, dim);
+    auto residuals = std::make_shared<ConservedQuantities<T>>(n_total_cells, dim);
+    initialise_flow(*sim, *fs);
+    primatives_to_conserved(*cq, *fs, sim->gas_model);
+
+    json results;
+    results["cells"] = n_cells;
+    results["faces"] = sim->grid.num_interfaces();
+    results["threads"] = Kokkos::DefaultHostExecutionSpace().concurrency();
+    results["number_type"] = options.dual ? "dual" : "real";
+    results["fused"] = options.fused;
+
+    // residual evaluation, after one call to warm up
+    // the caches and fault in any memory
+    size_t evaluations = options.evaluations;
+    sim->fv.compute_dudt(*fs, sim->grid, *residuals, sim->gas_model, sim->trans_prop,
+                         true);
+    Kokkos::fence();
+    spdlog::stopwatch sw;
+    for (size_t i = 0; i < evaluations; i++) {
+        sim->fv.compute_dudt(*fs, sim->grid, *residuals, sim->gas_model,
+                             sim->trans_prop, true);
+    }
+    Kokkos::fence();
+    double dudt_time = sw.elapsed().count() / evaluations;
+    results["compute_dudt"] = {
+        {"ms", 1e3 * dudt_time},
+        {"cell_evaluations_per_s", n_cells / dudt_time},
+        {"effective_GB_per_s",
+         residual_bytes(sim->grid, cq->n_conserved()) / dudt_time / 1e9}};
+
+    Ibis::real dt = 0.0;
+    sw.reset();
+    for (size_t i = 0; i < evaluations; i++) {
+        dt = sim->fv.estimate_dt(*fs, sim->grid, sim->gas_model, sim->trans_prop);
+    }
+    Kokkos::fence();
+    double dt_time = sw.elapsed().count() / evaluations;
+    results["estimate_dt"] = {{"ms", 1e3 * dt_time},
+                              {"cell_evaluations_per_s", n_cells / dt_time}};
+
+    // the linearisation the steady state solver would use
+    json solver_config = config.at("solver");
+    std::shared_ptr<PseudoTransientLinearSystem> system;
+    if constexpr (std::is_same<T, Ibis::dual>::value) {
+        system = std::make_shared<SteadyStateLinearisation>(sim, residuals, cq, fs,
+                                                            nullptr);
+    } else {
+        system = std::make_shared<SteadyStateFDLinearisation>(sim, residuals, cq, fs,
+                                                              false);
+    }
+    system->eval_rhs();
+    Ibis::real cfl = solver_config.at("cfl").at("value");
+    system->set_pseudo_time_step(cfl * dt);
+
+    // with no tolerance, every solve runs to the maximum number of iterations
+    json linear_solver_config = solver_config.at("linear_solver");
+    linear_solver_config["tol"] = 0.0;
+    auto gmres = make_linear_solver(system, nullptr, linear_solver_config);
+    Ibis::Vector<Ibis::real> dU{"bench::dU", system->num_vars()};
+    size_t gmres_iters = 0;
+    sw.reset();
+    for (size_t i = 0; i < options.steps; i++) {
+        dU.zero();
+        gmres_iters += gmres->solve(dU).n_iters;
+    }
+    Kokkos::fence();
+    double gmres_time = sw.elapsed().count();
+    results["gmres"] = {{"ms", 1e3 * gmres_time / options.steps},
+                        {"iterations", gmres_iters},
+                        {"ms_per_iteration",
+                         1e3 * gmres_time / std::max(gmres_iters, size_t(1))}};
+
+    // the full non-linear step, with the tolerances of a real run
+    Jfnk<T> jfnk(system, make_cfl_schedule(solver_config.at("cfl")), residuals,
+                 solver_config);
+    jfnk.initialise();
+    size_t jfnk_iters = 0;
+    sw.reset();
+    for (size_t i = 0; i < options.steps; i++) {
+        jfnk_iters += jfnk.step(sim, *cq, *fs, i).n_iters;
+    }
+    Kokkos::fence();
+    double jfnk_time = sw.elapsed().count();
+    results["jfnk_step"] = {{"ms", 1e3 * jfnk_time / options.steps},
+                            {"gmres_iterations", jfnk_iters}};
+
+    if (options.profile_overhead) {
+        // the time per residual evaluation and per linear solve with the
+        // profiler in each state. The linear solve has regions inside each
+        // iteration, so it shows the cost of the finer grained regions.
+        auto time_profiled = [&](bool enabled, bool fence) {
+            Ibis::set_profiling(enabled);
+            Ibis::set_profile_fence(fence);
+            spdlog::stopwatch profile_sw;
+            for (size_t i = 0; i < evaluations; i++) {
+                sim->fv.compute_dudt(*fs, sim->grid, *residuals, sim->gas_model,
+                                     sim->trans_prop, true);
+            }
+            Kokkos::fence();
+            double dudt_ms = 1e3 * profile_sw.elapsed().count() / evaluations;
+            profile_sw.reset();
+            for (size_t i = 0; i < options.steps; i++) {
+                dU.zero();
+                gmres->solve(dU);
+            }
+            Kokkos::fence();
+            double gmres_ms = 1e3 * profile_sw.elapsed().count() / options.steps;
+            return json{{"compute_dudt_ms", dudt_ms}, {"gmres_ms", gmres_ms}};
+        };
+
+        // Each round times every state, starting from a different one each
+        // time, so no state always runs first (e.g. with colder caches).
+        // The fastest time of each state is kept, since noise only ever
+        // makes things slower.
+        const std::vector<std::string> states{"off", "on", "fenced"};
+        json overhead;
+        for (size_t round = 0; round < states.size(); round++) {
+            for (size_t i = 0; i < states.size(); i++) {
+                const std::string& state = states[(round + i) % states.size()];
+                json timing = time_profiled(state != "off", state == "fenced");
+                if (!overhead.contains(state)) {
+                    overhead[state] = timing;
+                    continue;
+                }
+                for (const char* name : {"compute_dudt_ms", "gmres_ms"}) {
+                    overhead[state][name] = std::min(double(overhead[state].at(name)),
+                                                     double(timing.at(name)));
+                }
+            }
+        }
+        results["profile_overhead"] = overhead;
+        Ibis::set_profiling(true);
+        Ibis::set_profile_fence(false);
+    }
+
+    // everything is still allocated, so this includes the simulation,
+    // the linear solver and the JFNK solver
+    results["peak_memory_MB"] = peak_memory_MB();
+    return results;
+}
+
+// The product of the steady state Jacobian with a vector, for the flow the
+// benchmark uses, with dual numbers (T = Ibis::dual) or finite differences
+// (T = Ibis::real). The pseudo time step is large enough that its (exact)
+// contribution is negligible, so only the Jacobian itself is compared.
+template <typename T>
+std::vector<Ibis::real> jacobian_vector_product(json config, const GridIO& grid_io,
+                                                bool central_difference) {
+    json grid_config = config.at("grid");
+    GridBlock<T> grid(grid_io, grid_config);
+    auto sim = std::make_shared<Sim<T>>(grid, config);
+    size_t n_total_cells = sim->grid.num_total_cells();
+    size_t n_cells = sim->grid.num_cells();
+    size_t dim = sim->grid.dim();
+    auto fs = std::make_shared<FlowStates<T>>(n_total_cells);
+    auto cq = std::make_shared<ConservedQuantities<T>>(n_total_cells, dim);
+    auto residuals = std::make_shared<ConservedQuantities<T>>(n_total_cells, dim);
+    initialise_flow(*sim, *fs);
+    primatives_to_conserved(*cq, *fs, sim->gas_model);
+
+    std::shared_ptr<PseudoTransientLinearSystem> system;
+    if constexpr (std::is_same<T, Ibis::dual>::value) {
+        system = std::make_shared<SteadyStateLinearisation>(sim, residuals, cq, fs,
+                                                            nullptr);
+    } else {
+        system = std::make_shared<SteadyStateFDLinearisation>(sim, residuals, cq, fs,
+                                                              central_difference);
+    }
+    system->set_pseudo_time_step(1e30);
+    system->eval_rhs();
+
+    // a vector scaled like the conserved quantities, as
+    // the updates in a Newton iteration would be
+    size_t n_cons = cq->n_conserved();
+    Ibis::Vector<Ibis::real> vec("bench::vec", system->num_vars());
+    Ibis::Vector<Ibis::real> result("bench::result", system->num_vars());
+    ConservedQuantities<T> U = *cq;
+    Kokkos::parallel_for(
+        "bench::vec", n_cells, KOKKOS_LAMBDA(const size_t i) {
+            for (size_t j = 0; j < n_cons; j++) {
+                vec(i * n_cons + j) =
+                    Ibis::real_part(U(i, j)) * Kokkos::sin(0.37 * (i * n_cons + j));
+            }
+        });
+    system->matrix_vector_product(vec, result);
+
+    auto host_result = result.host_mirror();
+    host_result.deep_copy_space(result);
+    std::vector<Ibis::real> product(host_result.size());
+    for (size_t i = 0; i < product.size(); i++) {
+        product[i] = host_result(i);
+    }
+    return product;
+}
+
+// The relative difference between the finite difference and
+// the exact (dual number) Jacobian-vector products
+json jacobian_vector_product_error(const json& config, const GridIO& grid_io) {
+    std::vector<Ibis::real> exact =
+        jacobian_vector_product<Ibis::dual>(config, grid_io, false);
+    json errors;
+    for (bool central_difference : {false, true}) {
+        std::vector<Ibis::real> product =
+            jacobian_vector_product<Ibis::real>(config, grid_io, central_difference);
+        Ibis::real difference = 0.0;
+        Ibis::real norm = 0.0;
+        for (size_t i = 0; i < product.size(); i++) {
+            difference += (product[i] - exact[i]) * (product[i] - exact[i]);
+            norm += exact[i] * exact[i];
+        }
+        std::string name =
+            central_difference ? "central_difference" : "forward_difference";
+        errors[name] = Ibis::sqrt(difference / norm);
+    }
+    return errors;
+}
+
+void print_results(const json& results) {
+    spdlog::info("{} cells, {} faces, {} numbers, {} host threads",
+                 size_t(results.at("cells")), size_t(results.at("faces")),
+                 std::string(results.at("number_type")), int(results.at("threads")));
+    json dudt = results.at("compute_dudt");
+    spdlog::info("  compute_dudt: {:.3f} ms, {:.3e} cell evaluations/s, {:.1f} GB/s",
+                 double(dudt.at("ms")), double(dudt.at("cell_evaluations_per_s")),
+                 double(dudt.at("effective_GB_per_s")));
+    json estimate_dt = results.at("estimate_dt");
+    spdlog::info("  estimate_dt:  {:.3f} ms, {:.3e} cell evaluations/s",
+                 double(estimate_dt.at("ms")),
+                 double(estimate_dt.at("cell_evaluations_per_s")));
+    json gmres = results.at("gmres");
+    spdlog::info("  gmres solve:  {:.3f} ms, {} iterations, {:.3f} ms/iteration",
+                 double(gmres.at("ms")), size_t(gmres.at("iterations")),
+                 double(gmres.at("ms_per_iteration")));
+    json jfnk = results.at("jfnk_step");
+    spdlog::info("  jfnk step:    {:.3f} ms, {} gmres iterations",
+                 double(jfnk.at("ms")), size_t(jfnk.at("gmres_iterations")));
+    spdlog::info("  peak memory:  {:.1f} MB", double(results.at("peak_memory_MB")));
+    if (results.contains("jacobian_vector_product_error")) {
+        json error = results.at("jacobian_vector_product_error");
+        spdlog::info("  Jacobian-vector product error relative to dual numbers:");
+        spdlog::info("    forward difference {:.3e}, central difference {:.3e}",
+                     double(error.at("forward_difference")),
+                     double(error.at("central_difference")));
+    }
+
+    if (results.contains("profile_overhead")) {
+        json overhead = results.at("profile_overhead");
+        json off = overhead.at("off");
+        spdlog::info("  profiling overhead, relative to the profiler being off:");
+        for (const char* state : {"on", "fenced"}) {
+            json timing = overhead.at(state);
+            double dudt_change =
+                double(timing.at("compute_dudt_ms")) / double(off.at("compute_dudt_ms"));
+            double gmres_change =
+                double(timing.at("gmres_ms")) / double(off.at("gmres_ms"));
+            spdlog::info("    {:<7} compute_dudt {:+.2f}%, gmres solve {:+.2f}%", state,
+                         100 * (dudt_change - 1), 100 * (gmres_change - 1));
+        }
+    }
+}
+
+// Run a command, with its arguments passed straight to the new process
+// rather than through a shell, and wait for it to finish
+int run_command(const std::vector<std::string>& args) {
+    std::vector<char*> child_argv;
+    for (const std::string& arg : args) {
+        child_argv.push_back(const_cast<char*>(arg.c_str()));
+    }
+    child_argv.push_back(nullptr);
+
+    pid_t pid = fork();
+    if (pid < 0) {
+        spdlog::error("Unable to start {}", args[0]);
+        return 1;
+    }
+    if (pid == 0) {
+        execvp(child_argv[0], child_argv.data());
+        _exit(127);
+    }
+    int status;
+    if (waitpid(pid, &status, 0) < 0) return 1;
+    return (WIFEXITED(status)) ? WEXITSTATUS(status) : 1;
+}
+
+// Run the benchmark once with each number of threads, each in a process of
+// its own since Kokkos can only be initialised once per process
+int bench_thread_scaling(const BenchOptions& options, char* argv[]) {
+    std::vector<json> results;
+    for (size_t threads : options.threads) {
+        // a file of our own, so benchmarks running at the
+        // same time don't overwrite each other's results
+        std::string output =
+            (std::filesystem::temp_directory_path() / "ibis_bench_XXXXXX").string();
+        int output_fd = mkstemp(output.data());
+        if (output_fd < 0) {
+            spdlog::error("Unable to create a temporary file for the results");
+            return 1;
+        }
+        close(output_fd);
+
+        std::string size;
+        for (size_t i = 0; i < options.size.size(); i++) {
+            size += (i == 0 ? "" : ",") + std::to_string(options.size[i]);
+        }
+        std::vector<std::string> args{argv[0],
+                                      "bench",
+                                      "--size",
+                                      size,
+                                      "--flux",
+                                      options.flux_calculator,
+                                      "--order",
+                                      std::to_string(options.reconstruction_order),
+                                      "--evaluations",
+                                      std::to_string(options.evaluations),
+                                      "--steps",
+                                      std::to_string(options.steps),
+                                      "--output",
+                                      output,
+                                      "--kokkos-num-threads=" + std::to_string(threads)};
+        if (options.viscous) args.push_back("--viscous");
+        if (options.fused) args.push_back("--fused");
+        if (options.dual) args.push_back("--dual");
+        if (options.profile_overhead) args.push_back("--profile-overhead");
+
+        spdlog::info("running with {} threads", threads);
+        if (run_command(args) != 0) {
+            spdlog::error("benchmark with {} threads failed", threads);
+            std::filesystem::remove(output);
+            return 1;
+        }
+        std::ifstream output_file(output);
+        results.push_back(json::parse(output_file));
+        std::filesystem::remove(output);
+    }
+
+    spdlog::info("thread scaling of compute_dudt:");
+    spdlog::info("  {:>8} {:>22} {:>8} {:>10}", "threads", "cell evaluations/s",
+                 "speedup", "efficiency");
+    double base_rate = results[0].at("compute_dudt").at("cell_evaluations_per_s");
+    int base_threads = results[0].at("threads");
+    json scaling = json::array();
+    for (const json& result : results) {
+        int threads = result.at("threads");
+        double rate = result.at("compute_dudt").at("cell_evaluations_per_s");
+        double speedup = rate / base_rate;
+        double efficiency = speedup * base_threads / threads;
+        spdlog::info("  {:>8} {:>22.3e} {:>8.2f} {:>9.0f}%", threads, rate, speedup,
+                     100 * efficiency);
+        scaling.push_back(result);
+    }
+
+    if (!options.output.empty()) {
+        json scaling_results;
+        scaling_results["thread_scaling"] = scaling;
+        std::ofstream output_file(options.output);
+        output_file << scaling_results.dump(4);
+    }
+    return 0;
+}
+
+int bench(const BenchOptions& options, int argc, char* argv[]) {
+    if (!options.threads.empty()) {
+        return bench_thread_scaling(options, argv);
+    }
+
+    if (options.size.size() != 2 && options.size.size() != 3) {
+        spdlog::error("--size needs two values for a 2D grid, or three for a 3D grid");
+        return 1;
+    }
+    size_t nz = (options.size.size() == 3) ? options.size[2] : 0;
+    GridIO grid_io = structured_grid(options.size[0], options.size[1], nz);
+    json config = bench_config(options, grid_io);
+
+    spdlog::info("ibis {} benchmark", Ibis::IBIS_VERSION);
+    spdlog::info("{}D structured grid, {} flux, reconstruction order {}{}{}",
+                 grid_io.dim(), options.flux_calculator, options.reconstruction_order,
+                 options.fused ? ", fused" : "", options.viscous ? ", viscous" : "");
+
+    Kokkos::initialize(argc, argv);
+    json results;
+    {
+        // all the Kokkos managed memory must be freed before Kokkos::finalize
+        if (options.dual) {
+            results = bench_sim<Ibis::dual>(options, config, grid_io);
+        } else {
+            results = bench_sim<Ibis::real>(options, config, grid_io);
+
+            // after the peak memory has been measured, since
+            // this builds a simulation with dual numbers too
+            results["jacobian_vector_product_error"] =
+                jacobian_vector_product_error(config, grid_io);
+        }
+    }
+    Kokkos::finalize();
+
+    print_results(results);
+    if (!options.output.empty()) {
+        std::ofstream output_file(options.output);
+        output_file << results.dump(4);
+    }
+    return 0;
+}
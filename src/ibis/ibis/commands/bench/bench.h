@@ -0,0 +1,45 @@
+#ifndef BENCH_H
+#define BENCH_H
+
+#include <cstddef>
+#include <string>
+#include <vector>
+
+// The settings for `ibis bench`
+struct BenchOptions {
+    // the number of cells in each direction. Two values
+    // make a 2D grid of quads, three a 3D grid of hexes
+    std::vector<size_t> size{128, 128};
+
+    std::string flux_calculator = "hanel";
+    size_t reconstruction_order = 2;
+    bool viscous = false;
+
+    // compute the convective fluxes with the single fused kernel
+    bool fused = false;
+
+    // use dual numbers, and thus the exact Jacobian-vector products,
+    // rather than real numbers and finite differences
+    bool dual = false;
+
+    // the number of calls to time for the residual evaluation and time
+    // step estimate, and for the linear solve and non-linear step
+    size_t evaluations = 100;
+    size_t steps = 5;
+
+    // if given, the benchmark is repeated with each number of host
+    // threads, and the scaling over the thread counts is reported
+    std::vector<size_t> threads;
+
+    // also time the residual evaluation and linear solve with the profiler
+    // off, and with it fencing at the end of each region, to measure what
+    // the profiling costs
+    bool profile_overhead = false;
+
+    // a json file to write the results to
+    std::string output;
+};
+
+int bench(const BenchOptions& options, int argc, char* argv[]);
+
+#endif
@@ -196,7 +196,7 @@ def ensure_custom_type(value, conversion_func):
 
 class ConvectiveFlux:
     _json_values = ["flux_calculator", "reconstruction_order", "limiter",
-                    "thermo_interpolator"]
+                    "thermo_interpolator", "fused"]
     _custom_types = {
         "flux_calculator": string_to_flux_calc,
         "limiter": string_to_limiter,
@@ -327,6 +327,28 @@ class RigidBodyTranslation:
         }
 
 
+class GeometryCache:
+    _json_values = ["face_weights", "signed_areas", "inverse_volumes",
+                    "centre_offsets"]
+    __slots__ = _json_values
+    _defaults_file = "geometry_cache.json"
+
+    def __init__(self, **kwargs):
+        json_data = read_defaults(DEFAULTS_DIRECTORY,
+                                  self._defaults_file)
+        for key in self._json_values:
+            setattr(self, key, json_data[key])
+
+        for key in kwargs:
+            setattr(self, key, kwargs[key])
+
+    def as_dict(self):
+        dictionary = {}
+        for key in self._json_values:
+            dictionary[key] = getattr(self, key)
+        return dictionary
+
+
 class Block:
     def __init__(self, file_name, initial_condition, boundaries, **kwargs):
         self._initial_condition = initial_condition
@@ -335,6 +357,10 @@ class Block:
         self.number_vertices = 0
         self.boundaries = boundaries
         self.motion = StaticGrid()
+        self.geometry_cache = GeometryCache()
+        self.renumber = "none"
+        self.cache = True
+        self.num_blocks = 1
         for key, value in kwargs.items():
             setattr(self, key, value)
         self._read_file(file_name)
@@ -364,6 +390,22 @@ class Block:
             validation_errors.append(
                 ValidationException("No grid blocks specified")
             )
+        if self.renumber not in ("none", "hilbert", "morton", "rcm"):
+            validation_errors.append(
+                ValidationException(f"Unknown renumbering {self.renumber}")
+            )
+        if type(self.num_blocks) is not int or self.num_blocks < 1:
+            validation_errors.append(
+                ValidationException(
+                    f"num_blocks should be a positive integer, not {self.num_blocks}"
+                )
+            )
+        if "interblock" in self.boundaries:
+            validation_errors.append(
+                ValidationException(
+                    "'interblock' is reserved for the faces between blocks"
+                )
+            )
 
     def _number(self, number, binary):
         if binary:
@@ -377,6 +419,12 @@ class Block:
         # write the grid
         shutil.copy(self._block, f"{grid_directory}/0000/block_{0:04}.su2")
 
+        # a cache kept beside the grid file saves rebuilding it for each
+        # case which uses the grid (it is only used if it still matches)
+        if self.cache and os.path.exists(f"{self._block}.cache"):
+            shutil.copy(f"{self._block}.cache",
+                        f"{grid_directory}/0000/block_{0:04}.su2.cache")
+
         # write the initial condition
         format = "wb" if binary else "w"
         ic_directory = f"{flow_directory}/{0:04}"
@@ -417,6 +465,10 @@ class Block:
         for key in self.boundaries:
             dictionary["boundaries"][key] = self.boundaries[key].as_dict()
         dictionary["motion"] = self.motion.as_dict()
+        dictionary["geometry_cache"] = self.geometry_cache.as_dict()
+        dictionary["renumber"] = self.renumber
+        dictionary["cache"] = self.cache
+        dictionary["num_blocks"] = self.num_blocks
         return dictionary
 
 
@@ -904,7 +956,7 @@ class RungeKutta:
 
 
 class Gmres:
-    _json_values = ["max_iters", "tol"]
+    _json_values = ["max_iters", "tol", "orthogonalisation", "krylov_precision"]
     _type = "gmres"
     __slots__ = _json_values
     _defaults_file = "gmres.json"
@@ -930,7 +982,8 @@ class Gmres:
 
 class FGmres:
     _json_values = ["max_iters", "max_preconditioner_iters",
-                    "preconditioner_tolerance", "tolerance"]
+                    "preconditioner_tolerance", "tolerance",
+                    "orthogonalisation", "preconditioner"]
     _type = "fgmres"
     __slots__ = _json_values
     _defaults_file = "fgmres.json"
@@ -954,9 +1007,61 @@ class FGmres:
         return
 
 
+class GcroDr:
+    _json_values = ["max_iters", "tol", "recycle_vectors", "orthogonalisation"]
+    _type = "gcrodr"
+    __slots__ = _json_values
+    _defaults_file = "gcrodr.json"
+
+    def __init__(self, **kwargs):
+        json_data = read_defaults(DEFAULTS_DIRECTORY, self._defaults_file)
+
+        for key in json_data:
+            setattr(self, key, json_data[key])
+
+        for key in kwargs:
+            setattr(self, key, kwargs[key])
+
+    def as_dict(self):
+        dictionary = {"type": self._type}
+        for key in self._json_values:
+            dictionary[key] = getattr(self, key)
+        return dictionary
+
+    def validate(self):
+        return
+
+
+class SStepGmres:
+    _json_values = ["max_iters", "tol", "s_step"]
+    _type = "sstep_gmres"
+    __slots__ = _json_values
+    _defaults_file = "sstep_gmres.json"
+
+    def __init__(self, **kwargs):
+        json_data = read_defaults(DEFAULTS_DIRECTORY, self._defaults_file)
+
+        for key in json_data:
+            setattr(self, key, json_data[key])
+
+        for key in kwargs:
+            setattr(self, key, kwargs[key])
+
+    def as_dict(self):
+        dictionary = {"type": self._type}
+        for key in self._json_values:
+            dictionary[key] = getattr(self, key)
+        return dictionary
+
+    def validate(self):
+        return
+
+
 class SteadyState:
     _json_values = ["cfl", "max_steps", "print_frequency", "plot_frequency",
-                    "diagnostics_frequency", "tolerance"]
+                    "diagnostics_frequency", "tolerance", "warm_start",
+                    "forcing_term", "max_forcing_term", "batched_dual",
+                    "linearisation"]
     _defaults_file = "steady_state.json"
     _name = Solver.SteadyState.value
     __slots__ = _json_values + ["linear_solver", "cfl"]
@@ -1204,6 +1309,7 @@ def main(file_name, res_dir):
         "Ldfss2": Ldfss2,
         "Rusanov": Rusanov,
         "Block": Block,
+        "GeometryCache": GeometryCache,
         "Solver": Solver,
         "FlowState": FlowState,
         "GasState": GasState,
@@ -1215,6 +1321,8 @@ def main(file_name, res_dir):
         "SteadyState": SteadyState,
         "Gmres": Gmres,
         "FGmres": FGmres,
+        "GcroDr": GcroDr,
+        "SStepGmres": SStepGmres,
         "IO": IO,
         "IOFormat": IOFormat,
         "supersonic_inflow": supersonic_inflow,
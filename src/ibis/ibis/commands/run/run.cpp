@@ -5,11 +5,17 @@
 #include <ibis_version.h>
 #include <solvers/solver.h>
 #include <spdlog/spdlog.h>
+#include <util/comm.h>
+#include <util/numa.h>
+#include <util/profile.h>
 
 #include <Kokkos_Core.hpp>
 #include <cstdlib>
+#include <filesystem>
 #include <fstream>
+#include <map>
 #include <nlohmann/json.hpp>
+#include <sstream>
 
 using json = nlohmann::json;
 
@@ -33,7 +39,55 @@ void print_config_info(json config) {
         std::string(config.at("convective_flux").at("flux_calculator").at("type")));
 }
 
+// Which cpu and NUMA node each host thread runs on. The threads are pinned
+// by the OpenMP runtime (e.g. OMP_PROC_BIND=spread OMP_PLACES=threads), so
+// this shows whether the memory placed by first touch stays local.
+void print_thread_placement() {
+    std::vector<Ibis::ThreadPlacement> placement = Ibis::host_thread_placement();
+    std::map<int, size_t> threads_per_node;
+    for (const Ibis::ThreadPlacement& thread : placement) {
+        spdlog::debug("host thread {}: cpu {}, NUMA node {}", thread.thread, thread.cpu,
+                      thread.numa_node);
+        threads_per_node[thread.numa_node]++;
+    }
+    std::string summary;
+    for (const auto& [node, threads] : threads_per_node) {
+        if (!summary.empty()) summary += ", ";
+        if (node < 0) {
+            summary += std::to_string(threads) + " on an unknown NUMA node";
+        } else {
+            summary +=
+                std::to_string(threads) + " on NUMA node " + std::to_string(node);
+        }
+    }
+    spdlog::info("{} host threads: {}", placement.size(), summary);
+}
+
+// Print the time spent in each phase of the run, and write it to
+// log/profile.json. Only the first process reports its timings.
+void write_profile() {
+    if (!Ibis::is_root_rank()) return;
+
+    spdlog::info("profile:");
+    std::istringstream summary(Ibis::profile_summary());
+    std::string line;
+    while (std::getline(summary, line)) {
+        spdlog::info("  {}", line);
+    }
+
+    std::filesystem::create_directories("log");
+    std::ofstream profile_file("log/profile.json");
+    profile_file << Ibis::profile_json().dump(4);
+}
+
 int run(int argc, char* argv[]) {
+    Ibis::initialise_comm(argc, argv);
+
+    // only the first process reports progress
+    if (!Ibis::is_root_rank()) {
+        spdlog::set_level(spdlog::level::warn);
+    }
+
     json directories = read_directories();
     json config = read_config(directories);
 
@@ -43,17 +97,25 @@ int run(int argc, char* argv[]) {
     std::string grid_dir = directories.at("grid_dir");
     std::string flow_dir = directories.at("flow_dir");
     Kokkos::initialize(argc, argv);
+    print_thread_placement();
+    Ibis::reset_profile();
     int result;
 
     {
         // we need to make the solver (and thus allocate all the kokkos memory)
         // inside a block, so that the solver (and thus all kokkos managed
         // memory) is removed before Kokkos::finalise is called
-        std::unique_ptr<Solver> solver = make_solver(config, grid_dir, flow_dir);
+        std::unique_ptr<Solver> solver;
+        {
+            Ibis::ProfileRegion region("make_solver");
+            solver = make_solver(config, grid_dir, flow_dir);
+        }
         result = solver->solve();
     }
+    write_profile();
 
     Kokkos::finalize();
+    Ibis::finalise_comm();
 
     if (result != 0) {
         spdlog::error("run failed");
@@ -24,3 +24,14 @@ json read_config(json& directories) {
     f.close();
     return config;
 }
+
+json read_defaults(const std::string& file_name) {
+    std::ifstream f(Ibis::RES_DIR + "/defaults/" + file_name);
+    if (!f) {
+        spdlog::error("Unable to open default settings {}", file_name);
+        throw std::runtime_error("Unable to open default settings");
+    }
+    json defaults = json::parse(f);
+    f.close();
+    return defaults;
+}
@@ -2,10 +2,15 @@
 #define IBIS_CONFIG_H
 
 #include <nlohmann/json.hpp>
+#include <string>
 
 using json = nlohmann::json;
 
 json read_directories();
 json read_config(json& directories);
 
+// read one of the files of default settings installed with ibis
+// (e.g. "convective_flux.json")
+json read_defaults(const std::string& file_name);
+
 #endif
@@ -7,6 +7,7 @@
 
 #define DOCTEST_CONFIG_IMPLEMENT
 #include <doctest/doctest.h>
+#include <ibis/commands/bench/bench.h>
 #include <ibis/commands/clean/clean.h>
 #include <ibis/commands/post_commands/plot.h>
 #include <ibis/commands/post_commands/plot_residuals.h>
@@ -19,6 +20,7 @@
 #include <spdlog/sinks/basic_file_sink.h>
 #include <spdlog/sinks/stdout_color_sinks.h>
 #include <spdlog/spdlog.h>
+#include <util/profile.h>
 
 #include <CLI/CLI.hpp>
 
@@ -32,6 +34,54 @@ int cli(int argc, char* argv[]) {
     CLI::App* clean_command = ibis.add_subcommand("clean", "clean the simulation");
     CLI::App* prep_command = ibis.add_subcommand("prep", "prepare the simulation");
     CLI::App* run_command = ibis.add_subcommand("run", "run the simulation");
+    bool profile_fence = false;
+    run_command->add_flag("--profile-fence", profile_fence,
+                          "Fence the device at the end of each profiled region, so "
+                          "kernels are timed in the region that launched them");
+
+    CLI::App* bench_command =
+        ibis.add_subcommand("bench", "benchmark the solver on a synthetic grid");
+    // pass any options for kokkos (e.g. --kokkos-num-threads) through
+    bench_command->allow_extras();
+    BenchOptions bench_options;
+    bench_command
+        ->add_option("--size", bench_options.size,
+                     "Cells in each direction, e.g. 128,128 or 64,64,64")
+        ->delimiter(',')
+        ->expected(2, 3)
+        ->capture_default_str();
+    bench_command
+        ->add_option("--flux", bench_options.flux_calculator, "Flux calculator")
+        ->capture_default_str();
+    bench_command
+        ->add_option("--order", bench_options.reconstruction_order,
+                     "Reconstruction order")
+        ->check(CLI::Range(1, 2))
+        ->capture_default_str();
+    bench_command->add_flag("--viscous", bench_options.viscous,
+                            "Include the viscous fluxes");
+    bench_command->add_flag("--fused", bench_options.fused,
+                            "Compute the convective fluxes with the fused kernel");
+    bench_command->add_flag("--dual", bench_options.dual,
+                            "Use dual numbers (exact Jacobian-vector products)");
+    bench_command
+        ->add_option("--evaluations", bench_options.evaluations,
+                     "Residual evaluations to time")
+        ->check(CLI::PositiveNumber)
+        ->capture_default_str();
+    bench_command
+        ->add_option("--steps", bench_options.steps,
+                     "Linear solves and JFNK steps to time")
+        ->check(CLI::PositiveNumber)
+        ->capture_default_str();
+    bench_command
+        ->add_option("--threads", bench_options.threads,
+                     "Host thread counts to measure the scaling over, e.g. 1,2,4,8")
+        ->delimiter(',');
+    bench_command->add_flag("--profile-overhead", bench_options.profile_overhead,
+                            "Also measure the overhead of the profiler");
+    bench_command->add_option("--output", bench_options.output,
+                              "Write the results to this json file");
 
     CLI::App* post_command = ibis.add_subcommand("post", "post-process the simulation");
     post_command->require_subcommand(1);
@@ -68,7 +118,10 @@ int cli(int argc, char* argv[]) {
     } else if (ibis.got_subcommand(prep_command)) {
         return prep(argc, argv);
     } else if (ibis.got_subcommand(run_command)) {
+        Ibis::set_profile_fence(profile_fence);
         return run(argc, argv);
+    } else if (ibis.got_subcommand(bench_command)) {
+        return bench(bench_options, argc, argv);
     } else if (ibis.got_subcommand("post")) {
         if (post_command->got_subcommand(plot_command)) {
             return plot(format, extra_vars, argc, argv);
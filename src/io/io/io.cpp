@@ -5,6 +5,7 @@
 #include <io/native.h>
 #include <io/vtk.h>
 #include <spdlog/spdlog.h>
+#include <util/profile.h>
 
 #include <algorithm>
 #include <filesystem>
@@ -107,6 +108,8 @@ template <typename T>
 int FVIO<T>::write(const FlowStates<T>& fs, FiniteVolume<T>& fv, const GridBlock<T>& grid,
                    const IdealGas<T>& gas_model, const TransportProperties<T>& trans_prop,
                    Ibis::real time) {
+    Ibis::ProfileRegion region("FVIO::write");
+
     // get a copy of the flow states on the CPU
     auto fs_host = fs.host_mirror();
     fs_host.deep_copy(fs);
@@ -132,6 +135,7 @@ template <typename T>
 int FVIO<T>::read(FlowStates<T>& fs, GridBlock<T>& grid, const IdealGas<T>& gas_model,
                   const TransportProperties<T>& trans_prop, json& config, json& meta_data,
                   int time_idx) {
+    Ibis::ProfileRegion region("FVIO::read");
     // auto grid_host = grid.host_mirror();
     auto fs_host = fs.host_mirror();
     std::string time_index = pad_time_index(time_idx, 4);
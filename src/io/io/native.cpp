@@ -31,7 +31,8 @@ int NativeTextOutput<T>::write(const typename FlowStates<T>::mirror_type& fs,
         return 1;
     }
     temp << std::fixed << std::setprecision(16);
-    for (size_t cell_i = 0; cell_i < grid.num_cells(); cell_i++) {
+    for (size_t file_i = 0; file_i < grid.num_cells(); file_i++) {
+        size_t cell_i = grid.cell_id_from_file(file_i);
         temp << Ibis::real_part(fs.gas.temp(cell_i)) << std::endl;
     }
     temp.close();
@@ -42,7 +43,8 @@ int NativeTextOutput<T>::write(const typename FlowStates<T>::mirror_type& fs,
         return 1;
     }
     pressure << std::fixed << std::setprecision(16);
-    for (size_t cell_i = 0; cell_i < grid.num_cells(); cell_i++) {
+    for (size_t file_i = 0; file_i < grid.num_cells(); file_i++) {
+        size_t cell_i = grid.cell_id_from_file(file_i);
         pressure << Ibis::real_part(fs.gas.pressure(cell_i)) << std::endl;
     }
     pressure.close();
@@ -53,7 +55,8 @@ int NativeTextOutput<T>::write(const typename FlowStates<T>::mirror_type& fs,
         return 1;
     }
     vx << std::fixed << std::setprecision(16);
-    for (size_t cell_i = 0; cell_i < grid.num_cells(); cell_i++) {
+    for (size_t file_i = 0; file_i < grid.num_cells(); file_i++) {
+        size_t cell_i = grid.cell_id_from_file(file_i);
         vx << Ibis::real_part(fs.vel.x(cell_i)) << std::endl;
     }
     vx.close();
@@ -64,7 +67,8 @@ int NativeTextOutput<T>::write(const typename FlowStates<T>::mirror_type& fs,
         return 1;
     }
     vy << std::fixed << std::setprecision(16);
-    for (size_t cell_i = 0; cell_i < grid.num_cells(); cell_i++) {
+    for (size_t file_i = 0; file_i < grid.num_cells(); file_i++) {
+        size_t cell_i = grid.cell_id_from_file(file_i);
         vy << Ibis::real_part(fs.vel.y(cell_i)) << std::endl;
     }
     vy.close();
@@ -76,7 +80,8 @@ int NativeTextOutput<T>::write(const typename FlowStates<T>::mirror_type& fs,
             return 1;
         }
         vz << std::fixed << std::setprecision(16);
-        for (size_t cell_i = 0; cell_i < grid.num_cells(); cell_i++) {
+        for (size_t file_i = 0; file_i < grid.num_cells(); file_i++) {
+            size_t cell_i = grid.cell_id_from_file(file_i);
             vz << Ibis::real_part(fs.vel.z(cell_i)) << std::endl;
         }
         vz.close();
@@ -110,7 +115,7 @@ int NativeTextInput<T>::read(typename FlowStates<T>::mirror_type& fs, GridBlock<
     }
     size_t cell_i = 0;
     while (getline(temp, line)) {
-        Ibis::real_part(fs.gas.temp(cell_i)) = stod(line);
+        Ibis::real_part(fs.gas.temp(grid.cell_id_from_file(cell_i))) = stod(line);
         cell_i++;
     }
     if (cell_i != num_cells) {
@@ -127,7 +132,7 @@ int NativeTextInput<T>::read(typename FlowStates<T>::mirror_type& fs, GridBlock<
     }
     cell_i = 0;
     while (getline(pressure, line)) {
-        Ibis::real_part(fs.gas.pressure(cell_i)) = stod(line);
+        Ibis::real_part(fs.gas.pressure(grid.cell_id_from_file(cell_i))) = stod(line);
         cell_i++;
     }
     pressure.close();
@@ -139,7 +144,7 @@ int NativeTextInput<T>::read(typename FlowStates<T>::mirror_type& fs, GridBlock<
     }
     cell_i = 0;
     while (getline(vx, line)) {
-        Ibis::real_part(fs.vel.x(cell_i)) = stod(line);
+        Ibis::real_part(fs.vel.x(grid.cell_id_from_file(cell_i))) = stod(line);
         cell_i++;
     }
     vx.close();
@@ -151,7 +156,7 @@ int NativeTextInput<T>::read(typename FlowStates<T>::mirror_type& fs, GridBlock<
     }
     cell_i = 0;
     while (getline(vy, line)) {
-        Ibis::real_part(fs.vel.y(cell_i)) = stod(line);
+        Ibis::real_part(fs.vel.y(grid.cell_id_from_file(cell_i))) = stod(line);
         cell_i++;
     }
     vy.close();
@@ -165,7 +170,7 @@ int NativeTextInput<T>::read(typename FlowStates<T>::mirror_type& fs, GridBlock<
 
         cell_i = 0;
         while (getline(vz, line)) {
-            Ibis::real_part(fs.vel.z(cell_i)) = stod(line);
+            Ibis::real_part(fs.vel.z(grid.cell_id_from_file(cell_i))) = stod(line);
             cell_i++;
         }
         vz.close();
@@ -208,7 +213,8 @@ int NativeBinaryOutput<T>::write(const typename FlowStates<T>::mirror_type& fs,
         spdlog::error("failed to open {}", dir + "/T");
         return 1;
     }
-    for (size_t cell_i = 0; cell_i < grid.num_cells(); cell_i++) {
+    for (size_t file_i = 0; file_i < grid.num_cells(); file_i++) {
+        size_t cell_i = grid.cell_id_from_file(file_i);
         write_binary<Ibis::real>(temp, Ibis::real_part(fs.gas.temp(cell_i)));
     }
     temp.close();
@@ -218,7 +224,8 @@ int NativeBinaryOutput<T>::write(const typename FlowStates<T>::mirror_type& fs,
         spdlog::error("failed to open {}", dir + "/p");
         return 1;
     }
-    for (size_t cell_i = 0; cell_i < grid.num_cells(); cell_i++) {
+    for (size_t file_i = 0; file_i < grid.num_cells(); file_i++) {
+        size_t cell_i = grid.cell_id_from_file(file_i);
         write_binary<Ibis::real>(pressure, Ibis::real_part(fs.gas.pressure(cell_i)));
     }
     pressure.close();
@@ -228,7 +235,8 @@ int NativeBinaryOutput<T>::write(const typename FlowStates<T>::mirror_type& fs,
         spdlog::error("failed to open {}", dir + "/vx");
         return 1;
     }
-    for (size_t cell_i = 0; cell_i < grid.num_cells(); cell_i++) {
+    for (size_t file_i = 0; file_i < grid.num_cells(); file_i++) {
+        size_t cell_i = grid.cell_id_from_file(file_i);
         write_binary<Ibis::real>(vx, Ibis::real_part(fs.vel.x(cell_i)));
     }
     vx.close();
@@ -238,7 +246,8 @@ int NativeBinaryOutput<T>::write(const typename FlowStates<T>::mirror_type& fs,
         spdlog::error("failed to open {}", dir + "/vy");
         return 1;
     }
-    for (size_t cell_i = 0; cell_i < grid.num_cells(); cell_i++) {
+    for (size_t file_i = 0; file_i < grid.num_cells(); file_i++) {
+        size_t cell_i = grid.cell_id_from_file(file_i);
         write_binary<Ibis::real>(vy, Ibis::real_part(fs.vel.y(cell_i)));
     }
     vy.close();
@@ -249,7 +258,8 @@ int NativeBinaryOutput<T>::write(const typename FlowStates<T>::mirror_type& fs,
             spdlog::error("failed to open {}", dir + "/vz");
             return 1;
         }
-        for (size_t cell_i = 0; cell_i < grid.num_cells(); cell_i++) {
+        for (size_t file_i = 0; file_i < grid.num_cells(); file_i++) {
+            size_t cell_i = grid.cell_id_from_file(file_i);
             write_binary<Ibis::real>(vz, Ibis::real_part(fs.vel.z(cell_i)));
         }
         vz.close();
@@ -282,7 +292,8 @@ int NativeBinaryInput<T>::read(typename FlowStates<T>::mirror_type& fs,
         spdlog::error("Unable to load {}", dir + "/T");
         return 1;
     }
-    for (size_t cell_i = 0; cell_i < num_cells; cell_i++) {
+    for (size_t file_i = 0; file_i < num_cells; file_i++) {
+        size_t cell_i = grid.cell_id_from_file(file_i);
         read_binary<Ibis::real>(temp, Ibis::real_part(fs.gas.temp(cell_i)));
     }
 
@@ -291,7 +302,8 @@ int NativeBinaryInput<T>::read(typename FlowStates<T>::mirror_type& fs,
         spdlog::error("Unable to load {}", dir + "/p");
         return 1;
     }
-    for (size_t cell_i = 0; cell_i < num_cells; cell_i++) {
+    for (size_t file_i = 0; file_i < num_cells; file_i++) {
+        size_t cell_i = grid.cell_id_from_file(file_i);
         read_binary<Ibis::real>(pressure, Ibis::real_part(fs.gas.pressure(cell_i)));
     }
     pressure.close();
@@ -301,7 +313,8 @@ int NativeBinaryInput<T>::read(typename FlowStates<T>::mirror_type& fs,
         spdlog::error("Unable to load {}", dir + "/vx");
         return 1;
     }
-    for (size_t cell_i = 0; cell_i < num_cells; cell_i++) {
+    for (size_t file_i = 0; file_i < num_cells; file_i++) {
+        size_t cell_i = grid.cell_id_from_file(file_i);
         read_binary<Ibis::real>(vx, Ibis::real_part(fs.vel.x(cell_i)));
     }
     vx.close();
@@ -311,7 +324,8 @@ int NativeBinaryInput<T>::read(typename FlowStates<T>::mirror_type& fs,
         spdlog::error("Unable to load {}", dir + "/vy");
         return 1;
     }
-    for (size_t cell_i = 0; cell_i < num_cells; cell_i++) {
+    for (size_t file_i = 0; file_i < num_cells; file_i++) {
+        size_t cell_i = grid.cell_id_from_file(file_i);
         read_binary<Ibis::real>(vy, Ibis::real_part(fs.vel.y(cell_i)));
     }
     vy.close();
@@ -323,7 +337,8 @@ int NativeBinaryInput<T>::read(typename FlowStates<T>::mirror_type& fs,
             return 1;
         }
 
-        for (size_t cell_i = 0; cell_i < num_cells; cell_i++) {
+        for (size_t file_i = 0; file_i < num_cells; file_i++) {
+            size_t cell_i = grid.cell_id_from_file(file_i);
             read_binary<Ibis::real>(vz, Ibis::real_part(fs.vel.z(cell_i)));
         }
         vz.close();
@@ -0,0 +1,160 @@
+#include <doctest/doctest.h>
+#include <linear_algebra/block_sparse_matrix.h>
+#include <spdlog/spdlog.h>
+
+#include <algorithm>
+
+namespace Ibis {
+
+BlockSparseMatrix::BlockSparseMatrix(const std::vector<std::vector<size_t>>& pattern,
+                                     const size_t block_size) {
+    if (block_size > max_block_size) {
+        spdlog::error("Block size {} exceeds the maximum of {}", block_size,
+                      max_block_size);
+        throw std::runtime_error("Block size too large");
+    }
+    block_size_ = block_size;
+
+    // sort the columns in each row, so the lower and upper
+    // triangular parts of each row are contiguous
+    std::vector<std::vector<size_t>> sorted_pattern = pattern;
+    size_t num_rows = pattern.size();
+    for (auto& row : sorted_pattern) {
+        std::sort(row.begin(), row.end());
+    }
+    columns_ = RaggedArray<size_t, ArrayLayout, MemSpace>(sorted_pattern);
+    row_offsets_ = columns_.offsets();
+
+    diagonal_ = IndexType("BlockSparseMatrix::diagonal", num_rows);
+    auto diagonal_host = Kokkos::create_mirror_view(diagonal_);
+    size_t offset = 0;
+    for (size_t row = 0; row < num_rows; row++) {
+        auto it = std::find(sorted_pattern[row].begin(), sorted_pattern[row].end(), row);
+        if (it == sorted_pattern[row].end()) {
+            spdlog::error("Block row {} has no diagonal block", row);
+            throw std::runtime_error("Block sparse matrix missing diagonal");
+        }
+        diagonal_host(row) = offset + (it - sorted_pattern[row].begin());
+        offset += sorted_pattern[row].size();
+    }
+    Kokkos::deep_copy(diagonal_, diagonal_host);
+
+    values_ = ValuesType("BlockSparseMatrix::values", offset, block_size, block_size);
+}
+
+void BlockSparseMatrix::multiply(Vector<real>& vec, Vector<real>& res) const {
+    auto columns = columns_;
+    auto row_offsets = row_offsets_;
+    auto values = values_;
+    size_t bs = block_size_;
+    Kokkos::parallel_for(
+        "BlockSparseMatrix::multiply", Kokkos::RangePolicy<ExecSpace>(0, num_block_rows()),
+        KOKKOS_LAMBDA(const size_t row) {
+            real sum[max_block_size];
+            for (size_t i = 0; i < bs; i++) {
+                sum[i] = 0.0;
+            }
+            auto row_cols = columns(row);
+            size_t first = row_offsets(row);
+            for (size_t entry = 0; entry < row_cols.size(); entry++) {
+                size_t col = row_cols(entry);
+                for (size_t i = 0; i < bs; i++) {
+                    for (size_t j = 0; j < bs; j++) {
+                        sum[i] += values(first + entry, i, j) * vec(col * bs + j);
+                    }
+                }
+            }
+            for (size_t i = 0; i < bs; i++) {
+                res(row * bs + i) = sum[i];
+            }
+        });
+}
+
+BlockSparseMatrix BlockSparseMatrix::clone() const {
+    BlockSparseMatrix other;
+    other.block_size_ = block_size_;
+    other.columns_ = columns_;
+    other.row_offsets_ = row_offsets_;
+    other.diagonal_ = diagonal_;
+    other.values_ = ValuesType("BlockSparseMatrix::values", values_.extent(0),
+                               block_size_, block_size_);
+    Kokkos::deep_copy(other.values_, values_);
+    return other;
+}
+
+}  // namespace Ibis
+
+TEST_CASE("Ibis::BlockSparseMatrix::multiply") {
+    // a block tri-diagonal matrix with 3 block rows and 2x2 blocks
+    std::vector<std::vector<size_t>> pattern{{1, 0}, {0, 1, 2}, {1, 2}};
+    Ibis::BlockSparseMatrix A(pattern, 2);
+    CHECK(A.num_block_rows() == 3);
+    CHECK(A.num_blocks() == 7);
+    CHECK(A.num_rows() == 6);
+
+    auto values = Kokkos::create_mirror_view(A.values());
+    for (size_t block = 0; block < A.num_blocks(); block++) {
+        values(block, 0, 0) = 1.0 + block;
+        values(block, 0, 1) = 2.0;
+        values(block, 1, 0) = -1.0;
+        values(block, 1, 1) = 0.5 * block;
+    }
+    Kokkos::deep_copy(A.values(), values);
+
+    auto diagonal = Kokkos::create_mirror_view(A.diagonal());
+    Kokkos::deep_copy(diagonal, A.diagonal());
+    CHECK(diagonal(0) == 0);
+    CHECK(diagonal(1) == 3);
+    CHECK(diagonal(2) == 6);
+
+    Ibis::Vector<Ibis::real> x("x", 6);
+    auto x_h = x.host_mirror();
+    for (size_t i = 0; i < 6; i++) {
+        x_h(i) = i + 1.0;
+    }
+    x.deep_copy_space(x_h);
+
+    Ibis::Vector<Ibis::real> y("y", 6);
+    A.multiply(x, y);
+    auto y_h = y.host_mirror();
+    y_h.deep_copy_space(y);
+
+    // the same product, computed densely
+    for (size_t row = 0; row < 3; row++) {
+        for (size_t i = 0; i < 2; i++) {
+            Ibis::real expected = 0.0;
+            for (size_t col : pattern[row]) {
+                // blocks are stored in sorted column order
+                size_t first_block[3] = {0, 2, 4};
+                size_t block = first_block[row] + col;
+                for (size_t j = 0; j < 2; j++) {
+                    expected += values(block, i, j) * x_h(col * 2 + j);
+                }
+            }
+            CHECK(y_h(row * 2 + i) == doctest::Approx(expected));
+        }
+    }
+}
+
+TEST_CASE("Ibis::invert_block") {
+    Kokkos::View<Ibis::real**, Kokkos::HostSpace> a("a", 3, 3);
+    Kokkos::View<Ibis::real**, Kokkos::HostSpace> a_inv("a_inv", 3, 3);
+    Kokkos::View<Ibis::real**, Kokkos::HostSpace> identity("identity", 3, 3);
+    a(0, 0) = 0.0;
+    a(0, 1) = 2.0;
+    a(0, 2) = 1.0;
+    a(1, 0) = 1.0;
+    a(1, 1) = 1.0;
+    a(1, 2) = 0.0;
+    a(2, 0) = 3.0;
+    a(2, 1) = 0.0;
+    a(2, 2) = 4.0;
+
+    Ibis::invert_block(a, a_inv, 3);
+    Ibis::block_multiply(a, a_inv, identity, 3);
+    for (size_t i = 0; i < 3; i++) {
+        for (size_t j = 0; j < 3; j++) {
+            CHECK(identity(i, j) == doctest::Approx((i == j) ? 1.0 : 0.0));
+        }
+    }
+}
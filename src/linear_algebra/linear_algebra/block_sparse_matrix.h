@@ -0,0 +1,160 @@
+#ifndef BLOCK_SPARSE_MATRIX_H
+#define BLOCK_SPARSE_MATRIX_H
+
+#include <linear_algebra/dense_linear_algebra.h>
+#include <util/numeric_types.h>
+#include <util/ragged_array.h>
+#include <util/types.h>
+
+#include <Kokkos_Core.hpp>
+#include <vector>
+
+namespace Ibis {
+
+// the largest block size supported by the dense block operations
+constexpr size_t max_block_size = 8;
+
+// A sparse matrix made up of dense square blocks, stored in
+// block compressed sparse row format. Block row i of the matrix
+// corresponds to entries i*block_size -> (i+1)*block_size of a vector.
+class BlockSparseMatrix {
+public:
+    using ExecSpace = DefaultExecSpace;
+    using MemSpace = DefaultMemSpace;
+    using ArrayLayout = DefaultArrayLayout;
+    using ValuesType = Kokkos::View<real***, ArrayLayout, MemSpace>;
+    using IndexType = Kokkos::View<size_t*, ArrayLayout, MemSpace>;
+
+    // marks a block which isn't in the sparsity pattern
+    static constexpr size_t invalid_index = ~size_t(0);
+
+public:
+    BlockSparseMatrix() {}
+
+    // build a matrix with the given sparsity pattern. pattern[i] are the
+    // block columns in block row i, which must include the diagonal.
+    BlockSparseMatrix(const std::vector<std::vector<size_t>>& pattern,
+                      const size_t block_size);
+
+    void set_to_zero() { Kokkos::deep_copy(values_, 0.0); }
+
+    // res = A * vec
+    void multiply(Vector<real>& vec, Vector<real>& res) const;
+
+    // the index into values of the block at (row, col),
+    // or invalid_index if the block isn't stored
+    KOKKOS_INLINE_FUNCTION
+    size_t block_index(const size_t row, const size_t col) const {
+        auto row_cols = columns_(row);
+        for (size_t i = 0; i < row_cols.size(); i++) {
+            if (row_cols(i) == col) return row_offsets_(row) + i;
+        }
+        return invalid_index;
+    }
+
+    KOKKOS_INLINE_FUNCTION
+    size_t num_block_rows() const { return diagonal_.extent(0); }
+
+    KOKKOS_INLINE_FUNCTION
+    size_t num_blocks() const { return values_.extent(0); }
+
+    KOKKOS_INLINE_FUNCTION
+    size_t block_size() const { return block_size_; }
+
+    KOKKOS_INLINE_FUNCTION
+    size_t num_rows() const { return num_block_rows() * block_size_; }
+
+    KOKKOS_INLINE_FUNCTION
+    const RaggedArray<size_t, ArrayLayout, MemSpace>& columns() const {
+        return columns_;
+    }
+
+    // index into values of the first block in each row
+    KOKKOS_INLINE_FUNCTION
+    const IndexType& row_offsets() const { return row_offsets_; }
+
+    // index into values of the diagonal block of each row
+    KOKKOS_INLINE_FUNCTION
+    const IndexType& diagonal() const { return diagonal_; }
+
+    KOKKOS_INLINE_FUNCTION
+    const ValuesType& values() const { return values_; }
+
+    // a copy of the matrix, with the same sparsity pattern,
+    // but its own storage for the values
+    BlockSparseMatrix clone() const;
+
+private:
+    size_t block_size_;
+    RaggedArray<size_t, ArrayLayout, MemSpace> columns_;
+    IndexType row_offsets_;
+    IndexType diagonal_;
+    ValuesType values_;
+};
+
+// c = a * b for n x n blocks
+template <class A, class B, class C>
+KOKKOS_INLINE_FUNCTION void block_multiply(const A& a, const B& b, const C& c,
+                                           const size_t n) {
+    for (size_t i = 0; i < n; i++) {
+        for (size_t j = 0; j < n; j++) {
+            real sum = 0.0;
+            for (size_t k = 0; k < n; k++) {
+                sum += a(i, k) * b(k, j);
+            }
+            c(i, j) = sum;
+        }
+    }
+}
+
+// Invert the n x n block a, writing the result to a_inv.
+// This uses Gauss-Jordan elimination with partial pivoting.
+template <class A, class AInv>
+KOKKOS_INLINE_FUNCTION void invert_block(const A& a, const AInv& a_inv, const size_t n) {
+    real work[max_block_size][max_block_size];
+    for (size_t i = 0; i < n; i++) {
+        for (size_t j = 0; j < n; j++) {
+            work[i][j] = a(i, j);
+            a_inv(i, j) = (i == j) ? 1.0 : 0.0;
+        }
+    }
+
+    for (size_t col = 0; col < n; col++) {
+        // find the pivot
+        size_t pivot = col;
+        for (size_t row = col + 1; row < n; row++) {
+            if (Ibis::abs(work[row][col]) > Ibis::abs(work[pivot][col])) {
+                pivot = row;
+            }
+        }
+        if (pivot != col) {
+            for (size_t j = 0; j < n; j++) {
+                real tmp = work[col][j];
+                work[col][j] = work[pivot][j];
+                work[pivot][j] = tmp;
+                tmp = a_inv(col, j);
+                a_inv(col, j) = a_inv(pivot, j);
+                a_inv(pivot, j) = tmp;
+            }
+        }
+
+        // eliminate this column from the other rows
+        real inv_pivot = 1.0 / work[col][col];
+        for (size_t j = 0; j < n; j++) {
+            work[col][j] *= inv_pivot;
+            a_inv(col, j) *= inv_pivot;
+        }
+        for (size_t row = 0; row < n; row++) {
+            if (row == col) continue;
+            real factor = work[row][col];
+            for (size_t j = 0; j < n; j++) {
+                work[row][j] -= factor * work[col][j];
+                a_inv(row, j) -= factor * a_inv(col, j);
+            }
+        }
+    }
+}
+
+}  // namespace Ibis
+
+#endif
@@ -195,6 +195,30 @@ TEST_CASE("Ibis::dot") {
     CHECK(dot == 20.0);
 }
 
+TEST_CASE("Ibis::dot mixed precision") {
+    Ibis::Vector<Ibis::real> a("a", 3);
+    auto a_h = a.host_mirror();
+    a_h(0) = 1.0;
+    a_h(1) = 2.0;
+    a_h(2) = 3.0;
+    a.deep_copy_space(a_h);
+
+    // b is converted to single precision, and the dot
+    // product is accumulated in double precision
+    Ibis::Vector<Ibis::real> b("b", 3);
+    auto b_h = b.host_mirror();
+    b_h(0) = 2.0;
+    b_h(1) = 3.0;
+    b_h(2) = 4.0;
+    b.deep_copy_space(b_h);
+    Ibis::Vector<float> b_single("b_single", 3);
+    Ibis::convert(b, b_single);
+
+    Ibis::real dot = Ibis::dot(a, b_single);
+
+    CHECK(dot == 20.0);
+}
+
 TEST_CASE("Ibis::Matrix::column") {
     Ibis::Matrix<Ibis::real> A("A", 3, 5);
     auto A_h = A.host_mirror();
@@ -350,3 +374,140 @@ TEST_CASE("Ibis::Matrix::columns") {
     CHECK(columns.n_cols() == 2);
     // CHECK(columns(0, 0) == 1.0);
 }
+
+TEST_CASE("Ibis::multi_dot") {
+    Ibis::Matrix<Ibis::real> V("V", 3, 4);
+    auto V_h = V.host_mirror();
+    V_h(0, 0) = 1.0;
+    V_h(0, 1) = 2.0;
+    V_h(0, 2) = 3.0;
+    V_h(0, 3) = 4.0;
+    V_h(1, 0) = 5.0;
+    V_h(1, 1) = 6.0;
+    V_h(1, 2) = 7.0;
+    V_h(1, 3) = 8.0;
+    V_h(2, 0) = 9.0;
+    V_h(2, 1) = 10.0;
+    V_h(2, 2) = 11.0;
+    V_h(2, 3) = 12.0;
+    V.deep_copy_space(V_h);
+
+    Ibis::Vector<Ibis::real> w("w", 3);
+    auto w_h = w.host_mirror();
+    w_h(0) = 1.0;
+    w_h(1) = -1.0;
+    w_h(2) = 2.0;
+    w.deep_copy_space(w_h);
+
+    Ibis::real dots[3];
+    Ibis::multi_dot(V.columns(0, 3), w, dots);
+    CHECK(dots[0] == 14.0);
+    CHECK(dots[1] == 16.0);
+    CHECK(dots[2] == 18.0);
+}
+
+TEST_CASE("Ibis::multi_axpy") {
+    Ibis::Matrix<Ibis::real> V("V", 3, 4);
+    auto V_h = V.host_mirror();
+    V_h(0, 0) = 1.0;
+    V_h(0, 1) = 2.0;
+    V_h(0, 2) = 3.0;
+    V_h(0, 3) = 4.0;
+    V_h(1, 0) = 5.0;
+    V_h(1, 1) = 6.0;
+    V_h(1, 2) = 7.0;
+    V_h(1, 3) = 8.0;
+    V_h(2, 0) = 9.0;
+    V_h(2, 1) = 10.0;
+    V_h(2, 2) = 11.0;
+    V_h(2, 3) = 12.0;
+    V.deep_copy_space(V_h);
+
+    Ibis::Vector<Ibis::real> coeffs("coeffs", 4);
+    auto coeffs_h = coeffs.host_mirror();
+    coeffs_h(0) = 1.0;
+    coeffs_h(1) = 2.0;
+    coeffs_h(2) = -1.0;
+    coeffs_h(3) = 100.0;
+    coeffs.deep_copy_space(coeffs_h);
+
+    Ibis::Vector<Ibis::real> w("w", 3);
+    auto w_h = w.host_mirror();
+    w_h(0) = 1.0;
+    w_h(1) = -1.0;
+    w_h(2) = 2.0;
+    w.deep_copy_space(w_h);
+
+    // only the first three columns should contribute
+    Ibis::multi_axpy(w, V.columns(0, 3), coeffs, -1.0);
+    w_h.deep_copy_space(w);
+    CHECK(w_h(0) == -1.0);
+    CHECK(w_h(1) == -11.0);
+    CHECK(w_h(2) == -16.0);
+}
+
+TEST_CASE("Ibis::block_dot") {
+    Ibis::Matrix<Ibis::real> V("V", 3, 2);
+    auto V_h = V.host_mirror();
+    V_h(0, 0) = 1.0;
+    V_h(0, 1) = 2.0;
+    V_h(1, 0) = 3.0;
+    V_h(1, 1) = 4.0;
+    V_h(2, 0) = 5.0;
+    V_h(2, 1) = 6.0;
+    V.deep_copy_space(V_h);
+
+    Ibis::Matrix<Ibis::real> W("W", 3, 3);
+    auto W_h = W.host_mirror();
+    W_h(0, 0) = 1.0;
+    W_h(0, 1) = 0.0;
+    W_h(0, 2) = -1.0;
+    W_h(1, 0) = 1.0;
+    W_h(1, 1) = 2.0;
+    W_h(1, 2) = 0.0;
+    W_h(2, 0) = 1.0;
+    W_h(2, 1) = 1.0;
+    W_h(2, 2) = 1.0;
+    W.deep_copy_space(W_h);
+
+    Ibis::real dots[6];
+    Ibis::block_dot(V, W, dots);
+    CHECK(dots[0] == 9.0);
+    CHECK(dots[1] == 11.0);
+    CHECK(dots[2] == 4.0);
+    CHECK(dots[3] == 12.0);
+    CHECK(dots[4] == 14.0);
+    CHECK(dots[5] == 4.0);
+}
+
+TEST_CASE("Ibis::block_axpy") {
+    Ibis::Matrix<Ibis::real> V("V", 3, 2);
+    auto V_h = V.host_mirror();
+    V_h(0, 0) = 1.0;
+    V_h(0, 1) = 2.0;
+    V_h(1, 0) = 3.0;
+    V_h(1, 1) = 4.0;
+    V_h(2, 0) = 5.0;
+    V_h(2, 1) = 6.0;
+    V.deep_copy_space(V_h);
+
+    Ibis::Matrix<Ibis::real> coeffs("coeffs", 2, 2);
+    auto coeffs_h = coeffs.host_mirror();
+    coeffs_h(0, 0) = 1.0;
+    coeffs_h(0, 1) = -1.0;
+    coeffs_h(1, 0) = 0.5;
+    coeffs_h(1, 1) = 2.0;
+    coeffs.deep_copy_space(coeffs_h);
+
+    Ibis::Matrix<Ibis::real> W("W", 3, 2);
+    W.set_to_zero();
+    Ibis::block_axpy(W, V, coeffs, 2.0);
+    auto W_h = W.host_mirror();
+    W_h.deep_copy_space(W);
+    CHECK(W_h(0, 0) == 4.0);
+    CHECK(W_h(0, 1) == 6.0);
+    CHECK(W_h(1, 0) == 10.0);
+    CHECK(W_h(1, 1) == 10.0);
+    CHECK(W_h(2, 0) == 16.0);
+    CHECK(W_h(2, 1) == 14.0);
+}
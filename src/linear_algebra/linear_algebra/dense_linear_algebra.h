@@ -1,6 +1,7 @@
 #ifndef DENSE_LINEAR_ALGEBRA_H
 #define DENSE_LINEAR_ALGEBRA_H
 
+#include <util/numa.h>
 #include <util/numeric_types.h>
 #include <util/types.h>
 
@@ -19,7 +20,7 @@ public:
     Vector() {}
 
     Vector(std::string name, size_t n_values) {
-        data_ = Array1D<T, Layout, MemSpace>(name, n_values);
+        data_ = first_touch_view<Array1D<T, Layout, MemSpace>>(name, n_values);
     }
 
     Vector(Array1D<T, Layout, MemSpace> data) : data_(data) {}
@@ -83,7 +84,7 @@ public:
     Matrix() {}
 
     Matrix(std::string name, const size_t n, const size_t m) {
-        data_ = Array2D<T, Layout, MemSpace>(name, n, m);
+        data_ = first_touch_view<Array2D<T, Layout, MemSpace>>(name, n, m);
     }
 
     Matrix(Array2D<T, Layout, MemSpace> data) : data_(data) {}
@@ -215,14 +216,28 @@ void scale(const Vector<T, ExecSpace, Layout1, MemSpace>& vec,
         KOKKOS_LAMBDA(const size_t i) { result(i) = vec(i) * factor; });
 }
 
-template <typename T, class ExecSpace, class Layout1, class Layout2, class MemSpace>
+// vec1 += scale * vec2. vec2 may be stored with a different
+// (e.g. lower) precision, and is promoted to the type of vec1
+template <typename T, typename S, class ExecSpace, class Layout1, class Layout2,
+          class MemSpace>
 void add_scaled_vector(Vector<T, ExecSpace, Layout1, MemSpace>& vec1,
-                       const Vector<T, ExecSpace, Layout2, MemSpace>& vec2, T scale) {
+                       const Vector<S, ExecSpace, Layout2, MemSpace>& vec2, T scale) {
     assert(vec1.size() == vec2.size());
     Kokkos::parallel_for(
         "Ibis::Vector::subtract_scated_vector",
         Kokkos::RangePolicy<ExecSpace>(0, vec1.size()),
-        KOKKOS_LAMBDA(const size_t i) { vec1(i) += vec2(i) * scale; });
+        KOKKOS_LAMBDA(const size_t i) { vec1(i) += static_cast<T>(vec2(i)) * scale; });
+}
+
+// Copy src into dest, converting between the two number types
+template <typename T, typename S, class ExecSpace, class Layout1, class Layout2,
+          class MemSpace>
+void convert(const Vector<S, ExecSpace, Layout1, MemSpace>& src,
+             Vector<T, ExecSpace, Layout2, MemSpace>& dest) {
+    assert(src.size() == dest.size());
+    Kokkos::parallel_for(
+        "Ibis::Vector::convert", Kokkos::RangePolicy<ExecSpace>(0, src.size()),
+        KOKKOS_LAMBDA(const size_t i) { dest(i) = static_cast<T>(src(i)); });
 }
 
 // template <typename T, class ExecSpace, class Layout1, class Layout2, class MemSpace>
@@ -230,9 +245,11 @@ void add_scaled_vector(Vector<T, ExecSpace, Layout1, MemSpace>& vec1,
 //                       const Vector<T, ExecSpace, Layout2, MemSpace>& src) {
 // }
 
-template <typename T, class ExecSpace, class MatrixLayout, class VecLayout,
+// res = matrix * vec. The matrix may be stored with a different precision,
+// but the products are accumulated in the type of the vectors.
+template <typename T, typename S, class ExecSpace, class MatrixLayout, class VecLayout,
           class ResLayout, class MemSpace>
-void gemv(const Matrix<T, ExecSpace, MatrixLayout, MemSpace>& matrix,
+void gemv(const Matrix<S, ExecSpace, MatrixLayout, MemSpace>& matrix,
           const Vector<T, ExecSpace, VecLayout, MemSpace>& vec,
           Vector<T, ExecSpace, ResLayout, MemSpace>& res) {
     size_t n_rows = matrix.n_rows();
@@ -246,7 +263,7 @@ void gemv(const Matrix<T, ExecSpace, MatrixLayout, MemSpace>& matrix,
         KOKKOS_LAMBDA(const size_t row_i) {
             T dot = T(0.0);
             for (size_t col_i = 0; col_i < n_cols; col_i++) {
-                dot += matrix(row_i, col_i) * vec(col_i);
+                dot += static_cast<T>(matrix(row_i, col_i)) * vec(col_i);
             }
             res(row_i) = dot;
         });
@@ -296,18 +313,175 @@ void upper_triangular_solve(const Matrix<T, ExecSpace, MatrixLayout, MemSpace> A
     }
 }
 
-template <typename T, class ExecSpace, class Layout1, class Layout2, class MemSpace>
+// The dot product is accumulated in the type of vec1
+template <typename T, typename S, class ExecSpace, class Layout1, class Layout2,
+          class MemSpace>
 T dot(const Vector<T, ExecSpace, Layout1, MemSpace>& vec1,
-      const Vector<T, ExecSpace, Layout2, MemSpace>& vec2) {
+      const Vector<S, ExecSpace, Layout2, MemSpace>& vec2) {
     assert(vec1.size() == vec2.size());
     T dot_product;
     Kokkos::parallel_reduce(
         "Ibis::Vector::dot", Kokkos::RangePolicy<ExecSpace>(0, vec1.size()),
-        KOKKOS_LAMBDA(const size_t i, T& utd) { utd += vec1(i) * vec2(i); },
+        KOKKOS_LAMBDA(const size_t i, T& utd) {
+            utd += vec1(i) * static_cast<T>(vec2(i));
+        },
         Kokkos::Sum<T>(dot_product));
     return dot_product;
 }
 
+// Computes the dot product of a vector with each column of a matrix
+// in a single pass over the vector, using an array reduction. The
+// products are accumulated in the type of the vector.
+template <typename T, typename S, class ExecSpace, class MatrixLayout, class VecLayout,
+          class MemSpace>
+struct MultiDot {
+    using value_type = T[];
+    using size_type = size_t;
+
+    MultiDot(const Matrix<S, ExecSpace, MatrixLayout, MemSpace>& matrix,
+             const Vector<T, ExecSpace, VecLayout, MemSpace>& vec)
+        : value_count(matrix.n_cols()), matrix_(matrix), vec_(vec) {}
+
+    KOKKOS_INLINE_FUNCTION
+    void operator()(const size_t row, value_type sum) const {
+        T vec_row = vec_(row);
+        for (size_t col = 0; col < value_count; col++) {
+            sum[col] += static_cast<T>(matrix_(row, col)) * vec_row;
+        }
+    }
+
+    KOKKOS_INLINE_FUNCTION
+    void join(value_type dst, const value_type src) const {
+        for (size_t col = 0; col < value_count; col++) {
+            dst[col] += src[col];
+        }
+    }
+
+    KOKKOS_INLINE_FUNCTION
+    void init(value_type sum) const {
+        for (size_t col = 0; col < value_count; col++) {
+            sum[col] = T(0.0);
+        }
+    }
+
+    size_t value_count;
+    Matrix<S, ExecSpace, MatrixLayout, MemSpace> matrix_;
+    Vector<T, ExecSpace, VecLayout, MemSpace> vec_;
+};
+
+// Compute the dot product of vec with every column of matrix, storing the
+// results in the host accessible array result (of length matrix.n_cols())
+template <typename T, typename S, class ExecSpace, class MatrixLayout, class VecLayout,
+          class MemSpace>
+void multi_dot(const Matrix<S, ExecSpace, MatrixLayout, MemSpace>& matrix,
+               const Vector<T, ExecSpace, VecLayout, MemSpace>& vec, T* result) {
+    assert(matrix.n_rows() == vec.size());
+    MultiDot<T, S, ExecSpace, MatrixLayout, VecLayout, MemSpace> functor(matrix, vec);
+    Kokkos::parallel_reduce("Ibis::multi_dot",
+                            Kokkos::RangePolicy<ExecSpace>(0, matrix.n_rows()), functor,
+                            result);
+}
+
+// Computes the dot product of every column of lhs with every column of rhs
+// in a single pass over the rows, using an array reduction. The result for
+// columns i of lhs and j of rhs is stored at i * rhs.n_cols() + j.
+template <typename T, class ExecSpace, class LhsLayout, class RhsLayout, class MemSpace>
+struct BlockDot {
+    using value_type = T[];
+    using size_type = size_t;
+
+    BlockDot(const Matrix<T, ExecSpace, LhsLayout, MemSpace>& lhs,
+             const Matrix<T, ExecSpace, RhsLayout, MemSpace>& rhs)
+        : value_count(lhs.n_cols() * rhs.n_cols()), lhs_(lhs), rhs_(rhs) {}
+
+    KOKKOS_INLINE_FUNCTION
+    void operator()(const size_t row, value_type sum) const {
+        size_t n_lhs = lhs_.n_cols();
+        size_t n_rhs = rhs_.n_cols();
+        for (size_t i = 0; i < n_lhs; i++) {
+            T lhs_i = lhs_(row, i);
+            for (size_t j = 0; j < n_rhs; j++) {
+                sum[i * n_rhs + j] += lhs_i * rhs_(row, j);
+            }
+        }
+    }
+
+    KOKKOS_INLINE_FUNCTION
+    void join(value_type dst, const value_type src) const {
+        for (size_t i = 0; i < value_count; i++) {
+            dst[i] += src[i];
+        }
+    }
+
+    KOKKOS_INLINE_FUNCTION
+    void init(value_type sum) const {
+        for (size_t i = 0; i < value_count; i++) {
+            sum[i] = T(0.0);
+        }
+    }
+
+    size_t value_count;
+    Matrix<T, ExecSpace, LhsLayout, MemSpace> lhs_;
+    Matrix<T, ExecSpace, RhsLayout, MemSpace> rhs_;
+};
+
+// Compute lhs^T * rhs, storing the results in the host accessible array
+// result (of length lhs.n_cols() * rhs.n_cols(), row major)
+template <typename T, class ExecSpace, class LhsLayout, class RhsLayout, class MemSpace>
+void block_dot(const Matrix<T, ExecSpace, LhsLayout, MemSpace>& lhs,
+               const Matrix<T, ExecSpace, RhsLayout, MemSpace>& rhs, T* result) {
+    assert(lhs.n_rows() == rhs.n_rows());
+    BlockDot<T, ExecSpace, LhsLayout, RhsLayout, MemSpace> functor(lhs, rhs);
+    Kokkos::parallel_reduce("Ibis::block_dot",
+                            Kokkos::RangePolicy<ExecSpace>(0, lhs.n_rows()), functor,
+                            result);
+}
+
+// res += scale * matrix * coeffs, in a single pass over the rows of res
+template <typename T, class ExecSpace, class ResLayout, class MatrixLayout,
+          class CoeffLayout, class MemSpace>
+void block_axpy(Matrix<T, ExecSpace, ResLayout, MemSpace> res,
+                const Matrix<T, ExecSpace, MatrixLayout, MemSpace>& matrix,
+                const Matrix<T, ExecSpace, CoeffLayout, MemSpace>& coeffs, T scale) {
+    assert(matrix.n_rows() == res.n_rows());
+    assert(matrix.n_cols() <= coeffs.n_rows());
+    assert(res.n_cols() <= coeffs.n_cols());
+    size_t n_inner = matrix.n_cols();
+    size_t n_cols = res.n_cols();
+    Kokkos::parallel_for(
+        "Ibis::block_axpy", Kokkos::RangePolicy<ExecSpace>(0, res.n_rows()),
+        KOKKOS_LAMBDA(const size_t row) {
+            for (size_t col = 0; col < n_cols; col++) {
+                T sum = T(0.0);
+                for (size_t i = 0; i < n_inner; i++) {
+                    sum += matrix(row, i) * coeffs(i, col);
+                }
+                res(row, col) += scale * sum;
+            }
+        });
+}
+
+// vec += scale * matrix * coeffs, in a single pass over vec. This is the
+// same as calling add_scaled_vector for each column of matrix.
+template <typename T, typename S, class ExecSpace, class VecLayout, class MatrixLayout,
+          class CoeffLayout, class MemSpace>
+void multi_axpy(Vector<T, ExecSpace, VecLayout, MemSpace>& vec,
+                const Matrix<S, ExecSpace, MatrixLayout, MemSpace>& matrix,
+                const Vector<T, ExecSpace, CoeffLayout, MemSpace>& coeffs, T scale) {
+    assert(matrix.n_rows() == vec.size());
+    assert(matrix.n_cols() <= coeffs.size());
+    size_t n_cols = matrix.n_cols();
+    Kokkos::parallel_for(
+        "Ibis::multi_axpy", Kokkos::RangePolicy<ExecSpace>(0, vec.size()),
+        KOKKOS_LAMBDA(const size_t row) {
+            T sum = T(0.0);
+            for (size_t col = 0; col < n_cols; col++) {
+                sum += static_cast<T>(matrix(row, col)) * coeffs(col);
+            }
+            vec(row) += scale * sum;
+        });
+}
+
 }  // namespace Ibis
 
 #endif
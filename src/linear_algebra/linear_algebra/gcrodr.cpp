@@ -0,0 +1,452 @@
+#include <doctest/doctest.h>
+#include <linear_algebra/dense_linear_algebra.h>
+#include <linear_algebra/gcrodr.h>
+#include <linear_algebra/linear_system.h>
+#include <linear_algebra/test_linear_system.h>
+#include <spdlog/spdlog.h>
+#include <util/profile.h>
+
+#include <cmath>
+
+using HostExecSpace = Ibis::DefaultHostExecSpace;
+
+// the number of subspace iterations used to find the harmonic Ritz vectors
+constexpr size_t num_subspace_iters = 30;
+
+// Cholesky factorisation of the symmetric positive definite matrix stored in
+// the first n rows and columns of A. The lower triangle is overwritten with
+// the factor. Returns false if A isn't positive definite.
+bool cholesky_factorise_(Ibis::Matrix<Ibis::real, HostExecSpace> A, size_t n) {
+    for (size_t j = 0; j < n; j++) {
+        Ibis::real diag = A(j, j);
+        for (size_t l = 0; l < j; l++) {
+            diag -= A(j, l) * A(j, l);
+        }
+        if (diag <= 0.0) {
+            return false;
+        }
+        diag = Ibis::sqrt(diag);
+        A(j, j) = diag;
+        for (size_t i = j + 1; i < n; i++) {
+            Ibis::real sum = A(i, j);
+            for (size_t l = 0; l < j; l++) {
+                sum -= A(i, l) * A(j, l);
+            }
+            A(i, j) = sum / diag;
+        }
+    }
+    return true;
+}
+
+// solve L L^T Y = X in place for the first k columns of X,
+// where L is the Cholesky factor from cholesky_factorise_
+void cholesky_solve_(Ibis::Matrix<Ibis::real, HostExecSpace> L,
+                     Ibis::Matrix<Ibis::real, HostExecSpace> X, size_t n, size_t k) {
+    for (size_t col = 0; col < k; col++) {
+        for (size_t i = 0; i < n; i++) {
+            Ibis::real sum = X(i, col);
+            for (size_t l = 0; l < i; l++) {
+                sum -= L(i, l) * X(l, col);
+            }
+            X(i, col) = sum / L(i, i);
+        }
+        for (int i = n - 1; i >= 0; i--) {
+            Ibis::real sum = X(i, col);
+            for (size_t l = i + 1; l < n; l++) {
+                sum -= L(l, i) * X(l, col);
+            }
+            X(i, col) = sum / L(i, i);
+        }
+    }
+}
+
+// orthonormalise the first k columns (of length n) of X
+// using modified Gram-Schmidt
+void orthonormalise_columns_(Ibis::Matrix<Ibis::real, HostExecSpace> X, size_t n,
+                             size_t k) {
+    for (size_t col = 0; col < k; col++) {
+        for (size_t prev = 0; prev < col; prev++) {
+            Ibis::real dot = 0.0;
+            for (size_t i = 0; i < n; i++) {
+                dot += X(i, prev) * X(i, col);
+            }
+            for (size_t i = 0; i < n; i++) {
+                X(i, col) -= dot * X(i, prev);
+            }
+        }
+        Ibis::real norm = 0.0;
+        for (size_t i = 0; i < n; i++) {
+            norm += X(i, col) * X(i, col);
+        }
+        norm = Ibis::sqrt(norm);
+        if (norm > 0.0) {
+            for (size_t i = 0; i < n; i++) {
+                X(i, col) /= norm;
+            }
+        }
+    }
+}
+
+GcroDr::GcroDr(std::shared_ptr<LinearSystem> system, const size_t max_iters,
+               Ibis::real tol, const size_t num_recycle,
+               Orthogonalisation orthogonalisation) {
+    tol_ = tol;
+    orthogonalisation_ = orthogonalisation;
+    num_vars_ = system->num_vars();
+    max_iters_ = Kokkos::min(num_vars_, max_iters);
+    num_recycle_ = Kokkos::min(num_vars_, num_recycle);
+    size_t max_dim = max_iters_ + num_recycle_;
+
+    // least squares problem
+    H0_ = Ibis::Matrix<Ibis::real, HostExecSpace>("GcroDr::H0", max_iters_ + 1,
+                                                  max_iters_);
+    H_arnoldi_ = Ibis::Matrix<Ibis::real, HostExecSpace>("GcroDr::H_arnoldi",
+                                                         max_iters_ + 1, max_iters_);
+    B_ = Ibis::Matrix<Ibis::real, HostExecSpace>("GcroDr::B", num_recycle_, max_iters_);
+    g0_ = Ibis::Vector<Ibis::real, HostExecSpace>("GcroDr::g0", max_iters_ + 1);
+    cs_ = Ibis::Vector<Ibis::real, HostExecSpace>("GcroDr::cs", max_iters_);
+    sn_ = Ibis::Vector<Ibis::real, HostExecSpace>("GcroDr::sn", max_iters_);
+    h_host_ = Ibis::Vector<Ibis::real, HostExecSpace>("GcroDr::h_h", max_dim + 1);
+    h_ = Ibis::Vector<Ibis::real>("GcroDr::h_d", max_dim + 1);
+    ym_host_ = Ibis::Vector<Ibis::real, HostExecSpace>("GcroDr::ym_h", max_iters_ + 1);
+    ym_ = Ibis::Vector<Ibis::real>("GcroDr::ym_d", max_iters_ + 1);
+
+    // harmonic Ritz problem
+    G_ = Ibis::Matrix<Ibis::real, HostExecSpace>("GcroDr::G", max_dim + 1, max_dim);
+    X_ = Ibis::Matrix<Ibis::real, HostExecSpace>("GcroDr::X", max_dim + 1, max_dim);
+    GtG_ = Ibis::Matrix<Ibis::real, HostExecSpace>("GcroDr::GtG", max_dim, max_dim);
+    GtX_ = Ibis::Matrix<Ibis::real, HostExecSpace>("GcroDr::GtX", max_dim, max_dim);
+    P_host_ =
+        Ibis::Matrix<Ibis::real, HostExecSpace>("GcroDr::P_h", max_dim, num_recycle_);
+    P_tmp_ =
+        Ibis::Matrix<Ibis::real, HostExecSpace>("GcroDr::P_tmp", max_dim, num_recycle_);
+    P_ = Ibis::Matrix<Ibis::real>("GcroDr::P_d", max_dim, num_recycle_);
+
+    // Krylov subspace and memory for Arnoldi procedure
+    krylov_vectors_ =
+        Ibis::Matrix<Ibis::real>("GcroDr::krylov_vectors", num_vars_, max_iters_ + 1);
+    r0_ = Ibis::Vector<Ibis::real>("GcroDr::r0", num_vars_);
+    w_ = Ibis::Vector<Ibis::real>("GcroDr::w", num_vars_);
+    v_ = Ibis::Vector<Ibis::real>("GcroDr::v", num_vars_);
+
+    // recycled subspace
+    U_ = Ibis::Matrix<Ibis::real>("GcroDr::U", num_vars_, num_recycle_);
+    U_tmp_ = Ibis::Matrix<Ibis::real>("GcroDr::U_tmp", num_vars_, num_recycle_);
+    C_ = Ibis::Matrix<Ibis::real>("GcroDr::C", num_vars_, num_recycle_);
+
+    system_ = system;
+}
+
+GcroDr::GcroDr(std::shared_ptr<LinearSystem> system, json config)
+    : GcroDr(system, config.at("max_iters"), config.at("tol"),
+             config.at("recycle_vectors"),
+             string_to_orthogonalisation(config.at("orthogonalisation"))) {}
+
+size_t GcroDr::compute_recycled_images_() {
+    // The linear system may have changed since the recycled vectors were
+    // computed, so compute C = AU, and orthonormalise C, applying the same
+    // operations to U so that AU = C still holds. Any vectors which
+    // are (numerically) linearly dependent on the others are dropped.
+    size_t kept = 0;
+    for (size_t i = 0; i < num_recycled_; i++) {
+        auto ui = U_.column(i);
+        v_.deep_copy_layout(ui);
+        system_->matrix_vector_product(v_, w_);
+        Ibis::real initial_norm = Ibis::norm2(w_);
+        for (size_t l = 0; l < kept; l++) {
+            auto cl = C_.column(l);
+            Ibis::real r = Ibis::dot(w_, cl);
+            Ibis::add_scaled_vector(w_, cl, -r);
+            Ibis::add_scaled_vector(v_, U_.column(l), -r);
+        }
+        Ibis::real norm = Ibis::norm2(w_);
+        if (norm <= 1e-12 * initial_norm) {
+            continue;
+        }
+        Ibis::scale_in_place(w_, 1.0 / norm);
+        Ibis::scale_in_place(v_, 1.0 / norm);
+        C_.column(kept).deep_copy_layout(w_);
+        U_.column(kept).deep_copy_layout(v_);
+        kept++;
+    }
+    num_recycled_ = kept;
+    return kept;
+}
+
+void GcroDr::update_recycled_vectors_(size_t k, size_t m) {
+    size_t p = k + m;
+    size_t new_k = Kokkos::min(num_recycle_, p);
+    if (m == 0 || new_k == 0) {
+        return;
+    }
+
+    // The augmented Arnoldi relation is A [U V_m] = [C V_{m+1}] G, with
+    //     G = [I  B]
+    //         [0  H]
+    // The harmonic Ritz vectors are [U V_m] z, where G^T G z = theta G^T X z
+    // and X = [C V_{m+1}]^T [U V_m]. We want the vectors with the smallest
+    // theta, which are the dominant eigenvectors of (G^T G)^{-1} G^T X.
+    // These are found with subspace iteration.
+    for (size_t i = 0; i < p + 1; i++) {
+        for (size_t j = 0; j < p; j++) {
+            G_(i, j) = 0.0;
+            X_(i, j) = 0.0;
+        }
+    }
+    for (size_t i = 0; i < k; i++) {
+        G_(i, i) = 1.0;
+        for (size_t j = 0; j < m; j++) {
+            G_(i, k + j) = B_(i, j);
+        }
+    }
+    for (size_t i = 0; i < m + 1; i++) {
+        for (size_t j = 0; j < m; j++) {
+            G_(k + i, k + j) = H_arnoldi_(i, j);
+        }
+    }
+
+    auto V = krylov_vectors_.columns(0, m + 1);
+    for (size_t col = 0; col < k; col++) {
+        auto u = U_.column(col);
+        Ibis::multi_dot(C_.columns(0, k), u, h_host_.data().data());
+        for (size_t i = 0; i < k; i++) {
+            X_(i, col) = h_host_(i);
+        }
+        Ibis::multi_dot(V, u, h_host_.data().data());
+        for (size_t i = 0; i < m + 1; i++) {
+            X_(k + i, col) = h_host_(i);
+        }
+    }
+    for (size_t j = 0; j < m; j++) {
+        X_(k + j, k + j) = 1.0;
+    }
+
+    for (size_t a = 0; a < p; a++) {
+        for (size_t b = 0; b < p; b++) {
+            Ibis::real gtg = 0.0;
+            Ibis::real gtx = 0.0;
+            for (size_t i = 0; i < p + 1; i++) {
+                gtg += G_(i, a) * G_(i, b);
+                gtx += G_(i, a) * X_(i, b);
+            }
+            GtG_(a, b) = gtg;
+            GtX_(a, b) = gtx;
+        }
+    }
+    if (!cholesky_factorise_(GtG_, p)) {
+        // keep the previous recycled vectors
+        spdlog::warn("GcroDr: unable to update the recycled subspace");
+        return;
+    }
+
+    for (size_t i = 0; i < p; i++) {
+        for (size_t col = 0; col < new_k; col++) {
+            P_host_(i, col) = std::sin((i + 1.0) * (col + 1.0));
+        }
+    }
+    orthonormalise_columns_(P_host_, p, new_k);
+    for (size_t iter = 0; iter < num_subspace_iters; iter++) {
+        for (size_t i = 0; i < p; i++) {
+            for (size_t col = 0; col < new_k; col++) {
+                Ibis::real sum = 0.0;
+                for (size_t l = 0; l < p; l++) {
+                    sum += GtX_(i, l) * P_host_(l, col);
+                }
+                P_tmp_(i, col) = sum;
+            }
+        }
+        cholesky_solve_(GtG_, P_tmp_, p, new_k);
+        orthonormalise_columns_(P_tmp_, p, new_k);
+        for (size_t i = 0; i < p; i++) {
+            for (size_t col = 0; col < new_k; col++) {
+                P_host_(i, col) = P_tmp_(i, col);
+            }
+        }
+    }
+    P_.deep_copy_space(P_host_);
+
+    // the new recycled vectors are [U V_m] P
+    auto U = U_;
+    auto U_new = U_tmp_;
+    auto P = P_;
+    auto krylov_vectors = krylov_vectors_;
+    Kokkos::parallel_for(
+        "GcroDr::update_recycled_vectors", num_vars_, KOKKOS_LAMBDA(const size_t row) {
+            for (size_t col = 0; col < new_k; col++) {
+                Ibis::real sum = 0.0;
+                for (size_t i = 0; i < k; i++) {
+                    sum += U(row, i) * P(i, col);
+                }
+                for (size_t i = 0; i < m; i++) {
+                    sum += krylov_vectors(row, i) * P(k + i, col);
+                }
+                U_new(row, col) = sum;
+            }
+        });
+    std::swap(U_, U_tmp_);
+    num_recycled_ = new_k;
+}
+
+LinearSolveResult GcroDr::solve(Ibis::Vector<Ibis::real>& x0) {
+    Ibis::ProfileRegion solve_region("GcroDr::solve");
+
+    // zero out memory
+    H0_.set_to_zero();
+    H_arnoldi_.set_to_zero();
+    B_.set_to_zero();
+    g0_.zero();
+
+    // initialise the intial residuals
+    {
+        Ibis::ProfileRegion region("GcroDr::matrix_vector_product");
+        compute_r0_(system_, x0, r0_, w_);
+    }
+    Ibis::real beta0 = Ibis::norm2(r0_);
+    if (beta0 < min_initial_residual) {
+        // the initial guess already solves the system
+        return LinearSolveResult{true, 0, tol_, beta0};
+    }
+
+    // remove the part of the residual in the recycled subspace
+    size_t k;
+    {
+        Ibis::ProfileRegion region("GcroDr::recycled_projection");
+        k = compute_recycled_images_();
+        if (k > 0) {
+            auto C = C_.columns(0, k);
+            Ibis::multi_dot(C, r0_, h_host_.data().data());
+            h_.deep_copy_space(h_host_);
+            Ibis::multi_axpy(x0, U_.columns(0, k), h_, 1.0);
+            Ibis::multi_axpy(r0_, C, h_, -1.0);
+        }
+    }
+
+    Ibis::real beta = Ibis::norm2(r0_);
+    LinearSolveResult result{false, 0, tol_, beta / beta0};
+    if (beta < tol_ * beta0) {
+        result.success = true;
+        return result;
+    }
+    g0_(0) = beta;
+    Ibis::scale(r0_, v_, 1.0 / beta);
+    krylov_vectors_.column(0).deep_copy_layout(v_);
+
+    for (size_t j = 0; j < max_iters_; j++) {
+        // build the next krylov vector, orthogonal to the images of
+        // the recycled vectors and the previous krylov vectors
+        {
+            Ibis::ProfileRegion region("GcroDr::matrix_vector_product");
+            system_->matrix_vector_product(v_, w_);
+        }
+        {
+            Ibis::ProfileRegion region("GcroDr::orthogonalisation");
+            if (k > 0) {
+                auto C = C_.columns(0, k);
+                Ibis::multi_dot(C, w_, h_host_.data().data());
+                h_.deep_copy_space(h_host_);
+                Ibis::multi_axpy(w_, C, h_, -1.0);
+                for (size_t i = 0; i < k; i++) {
+                    B_(i, j) = h_host_(i);
+                }
+            }
+            orthogonalise_(krylov_vectors_, w_, H0_, h_host_, h_, orthogonalisation_,
+                           j);
+            H0_(j + 1, j) = Ibis::norm2(w_);
+            if (H0_(j + 1, j) > 0.0) {
+                Ibis::scale(w_, v_, 1.0 / H0_(j + 1, j));
+            } else {
+                v_.zero();
+            }
+            krylov_vectors_.column(j + 1).deep_copy_layout(v_);
+        }
+
+        // keep the un-rotated Hessenberg for computing the harmonic Ritz vectors
+        {
+            Ibis::ProfileRegion region("GcroDr::least_squares");
+            for (size_t i = 0; i < j + 2; i++) {
+                H_arnoldi_(i, j) = H0_(i, j);
+            }
+            apply_rotations_to_hessenberg_(H0_, cs_, sn_, g0_, j);
+        }
+
+        // check convergence
+        Ibis::real residual = Ibis::abs(g0_(j + 1));
+        result.residual = residual / beta0;
+        result.n_iters = j + 1;
+        if (residual < tol_ * beta0) {
+            result.success = true;
+            break;
+        }
+    }
+
+    // return the guess, even if we didn't converge
+    size_t m = result.n_iters;
+    auto H = H0_.sub_matrix(0, m, 0, m);
+    auto g = g0_.sub_vector(0, m);
+    auto ym_host = ym_host_.sub_vector(0, m);
+    {
+        Ibis::ProfileRegion region("GcroDr::least_squares");
+        Ibis::upper_triangular_solve(H, ym_host, g);
+        ym_.deep_copy_space(ym_host_);
+    }
+    {
+        Ibis::ProfileRegion region("GcroDr::update");
+        Ibis::multi_axpy(x0, krylov_vectors_.columns(0, m), ym_, 1.0);
+        if (k > 0) {
+            // the recycled vectors contribute -U B y
+            for (size_t i = 0; i < k; i++) {
+                Ibis::real sum = 0.0;
+                for (size_t j = 0; j < m; j++) {
+                    sum += B_(i, j) * ym_host_(j);
+                }
+                h_host_(i) = sum;
+            }
+            h_.deep_copy_space(h_host_);
+            Ibis::multi_axpy(x0, U_.columns(0, k), h_, -1.0);
+        }
+    }
+
+    // and choose the vectors to recycle for the next solve
+    {
+        Ibis::ProfileRegion region("GcroDr::update_recycled_vectors");
+        update_recycled_vectors_(k, m);
+    }
+    Ibis::profile_count("gcrodr iterations", result.n_iters);
+
+    return result;
+}
+
+TEST_CASE("GCRO-DR") {
+    auto matrix = tridiagonal_test_matrix(5, -1.0, 2.0, -0.5);
+    std::vector<Ibis::real> rhs = test_rhs(matrix, {1.0, 0.0, -1.0, 1.5, 0.5});
+    std::shared_ptr<LinearSystem> sys{new TestLinearSystem(matrix, rhs)};
+
+    GcroDr solver{sys, 5, 1e-10, 2};
+    Ibis::Vector<Ibis::real> x{"x", 5};
+    LinearSolveResult first_result = solver.solve(x);
+
+    auto x_h = x.host_mirror();
+    x_h.deep_copy_space(x);
+
+    CHECK(first_result.success == true);
+    CHECK(solver.num_recycled_vectors() == 2);
+    CHECK(x_h(0) == doctest::Approx(1.0));
+    CHECK(x_h(1) == doctest::Approx(0.0));
+    CHECK(x_h(2) == doctest::Approx(-1.0));
+    CHECK(x_h(3) == doctest::Approx(1.5));
+    CHECK(x_h(4) == doctest::Approx(0.5));
+
+    // the second solve should use the recycled vectors to
+    // converge in fewer iterations
+    x.zero();
+    LinearSolveResult second_result = solver.solve(x);
+    x_h.deep_copy_space(x);
+
+    CHECK(second_result.success == true);
+    CHECK(second_result.n_iters < first_result.n_iters);
+    CHECK(x_h(0) == doctest::Approx(1.0));
+    CHECK(x_h(1) == doctest::Approx(0.0));
+    CHECK(x_h(2) == doctest::Approx(-1.0));
+    CHECK(x_h(3) == doctest::Approx(1.5));
+    CHECK(x_h(4) == doctest::Approx(0.5));
+}
@@ -0,0 +1,94 @@
+#ifndef GCRODR_H
+#define GCRODR_H
+
+#include <linear_algebra/dense_linear_algebra.h>
+#include <linear_algebra/gmres.h>
+#include <linear_algebra/linear_system.h>
+#include <util/numeric_types.h>
+#include <util/types.h>
+
+#include <Kokkos_Core.hpp>
+#include <nlohmann/json.hpp>
+
+using json = nlohmann::json;
+
+// GMRES with deflated restarting and Krylov subspace recycling (GCRO-DR).
+// At the end of each solve, the harmonic Ritz vectors with the smallest
+// harmonic Ritz values are kept, and used to augment the Krylov subspace
+// on the next call to solve. The linear system may change between calls
+// to solve, so the images of the recycled vectors are recomputed at the
+// start of each solve.
+class GcroDr : public IterativeLinearSolver {
+public:
+    using HostExecSpace = Ibis::DefaultHostExecSpace;
+
+public:
+    GcroDr() {}
+
+    ~GcroDr() {}
+
+    GcroDr(std::shared_ptr<LinearSystem> system, const size_t max_iters, Ibis::real tol,
+           const size_t num_recycle,
+           Orthogonalisation orthogonalisation = Orthogonalisation::MGS);
+
+    GcroDr(std::shared_ptr<LinearSystem> system, json config);
+
+    LinearSolveResult solve(Ibis::Vector<Ibis::real>& x0);
+
+    Ibis::real tol() const { return tol_; }
+
+    void set_tol(Ibis::real tol) { tol_ = tol; }
+
+    size_t num_recycled_vectors() const { return num_recycled_; }
+
+private:
+    // configuration
+    size_t max_iters_;
+    size_t num_vars_;
+    size_t num_recycle_;
+    Ibis::real tol_;
+    Orthogonalisation orthogonalisation_;
+    std::shared_ptr<LinearSystem> system_;
+
+    // the number of recycled vectors currently stored
+    size_t num_recycled_ = 0;
+
+    size_t compute_recycled_images_();
+
+public:  // this has to be public to access from inside kernels
+    void update_recycled_vectors_(size_t k, size_t m);
+
+    // memory
+    Ibis::Matrix<Ibis::real> krylov_vectors_;
+    Ibis::Vector<Ibis::real> v_;
+    Ibis::Vector<Ibis::real> r0_;
+    Ibis::Vector<Ibis::real> w_;
+
+    // the recycled vectors (U), and their images (C = AU)
+    Ibis::Matrix<Ibis::real> U_;
+    Ibis::Matrix<Ibis::real> U_tmp_;
+    Ibis::Matrix<Ibis::real> C_;
+
+    // least squares problem
+    Ibis::Matrix<Ibis::real, HostExecSpace> H0_;
+    Ibis::Matrix<Ibis::real, HostExecSpace> H_arnoldi_;
+    Ibis::Matrix<Ibis::real, HostExecSpace> B_;
+    Ibis::Vector<Ibis::real, HostExecSpace> g0_;
+    Ibis::Vector<Ibis::real, HostExecSpace> cs_;
+    Ibis::Vector<Ibis::real, HostExecSpace> sn_;
+    Ibis::Vector<Ibis::real, HostExecSpace> h_host_;
+    Ibis::Vector<Ibis::real> h_;
+    Ibis::Vector<Ibis::real, HostExecSpace> ym_host_;
+    Ibis::Vector<Ibis::real> ym_;
+
+    // harmonic Ritz problem
+    Ibis::Matrix<Ibis::real, HostExecSpace> G_;
+    Ibis::Matrix<Ibis::real, HostExecSpace> X_;
+    Ibis::Matrix<Ibis::real, HostExecSpace> GtG_;
+    Ibis::Matrix<Ibis::real, HostExecSpace> GtX_;
+    Ibis::Matrix<Ibis::real, HostExecSpace> P_host_;
+    Ibis::Matrix<Ibis::real, HostExecSpace> P_tmp_;
+    Ibis::Matrix<Ibis::real> P_;
+};
+
+#endif
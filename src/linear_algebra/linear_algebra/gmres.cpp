@@ -1,8 +1,14 @@
 #include <doctest/doctest.h>
 #include <linear_algebra/dense_linear_algebra.h>
+#include <linear_algebra/gcrodr.h>
 #include <linear_algebra/gmres.h>
 #include <linear_algebra/linear_system.h>
+#include <linear_algebra/sstep_gmres.h>
+#include <linear_algebra/test_linear_system.h>
 #include <spdlog/spdlog.h>
+#include <util/profile.h>
+
+#include <type_traits>
 
 #include "util/types.h"
 
@@ -19,58 +25,112 @@ void compute_r0_(std::shared_ptr<LinearSystem> system, Ibis::Vector<Ibis::real>&
         KOKKOS_LAMBDA(const size_t i) { r0(i) = rhs(i) - w(i); });
 }
 
-void apply_rotations_to_hessenberg_(Ibis::Matrix<Ibis::real, HostExecSpace> H0,
-                                    Ibis::Matrix<Ibis::real, HostExecSpace> H1,
-                                    Ibis::Matrix<Ibis::real, HostExecSpace> Q0,
-                                    Ibis::Matrix<Ibis::real, HostExecSpace> Q1,
-                                    Ibis::Matrix<Ibis::real, HostExecSpace> Omega,
-                                    Ibis::Vector<Ibis::real, HostExecSpace> g0,
-                                    Ibis::Vector<Ibis::real, HostExecSpace> g1,
-                                    Ibis::Vector<Ibis::real, HostExecSpace> hr,
-                                    size_t j) {
-    // progressively rotate the Hessenberg into the QR factorisation using
-    // plane rotations, on the cpu
-    if (j != 0) {
-        // apply previous rotations to the new column of the Hessenberg
-        auto Q_sub = Q0.sub_matrix(0, j + 1, 0, j + 1);
-        auto h_col_j = H0.sub_matrix(0, j + 1, 0, j + 1).column(j);
-        auto h_rotated = hr.sub_vector(0, j + 1);
-        Ibis::gemv(Q_sub, h_col_j, h_rotated);
-        h_col_j.deep_copy_layout(h_rotated);
+Orthogonalisation string_to_orthogonalisation(std::string orthogonalisation) {
+    if (orthogonalisation == "mgs") {
+        return Orthogonalisation::MGS;
+    } else if (orthogonalisation == "cgs") {
+        return Orthogonalisation::CGS;
+    } else if (orthogonalisation == "cgs2") {
+        return Orthogonalisation::CGS2;
+    } else {
+        spdlog::error("Unknown orthogonalisation {}", orthogonalisation);
+        throw std::runtime_error("Unknown orthogonalisation");
     }
+}
 
-    // build the rotation matrix for this step
-    Omega.set_to_identity();
-    Ibis::real denom = Ibis::sqrt(H0(j, j) * H0(j, j) + H0(j + 1, j) * H0(j + 1, j));
-    Ibis::real si = H0(j + 1, j) / denom;
-    Ibis::real ci = H0(j, j) / denom;
-    Omega(j, j) = ci;
-    Omega(j, j + 1) = si;
-    Omega(j + 1, j) = -si;
-    Omega(j + 1, j + 1) = ci;
+KrylovPrecision string_to_krylov_precision(std::string precision) {
+    if (precision == "double") {
+        return KrylovPrecision::Double;
+    } else if (precision == "single") {
+        return KrylovPrecision::Single;
+    } else {
+        spdlog::error("Unknown krylov precision {}", precision);
+        throw std::runtime_error("Unknown krylov precision");
+    }
+}
 
-    // rotate the hessenberg matrix and the right hand side
-    auto H_old = H0.sub_matrix(0, j + 2, 0, j + 2);
-    auto H_new = H1.sub_matrix(0, j + 2, 0, j + 2);
-    auto Omega_sub = Omega.sub_matrix(0, j + 2, 0, j + 2);
+// one pass of classical Gram-Schmidt, orthogonalising w against the
+// first j+1 krylov vectors and adding the projections to column j of H
+template <typename S>
+void classical_gram_schmidt_pass_(Ibis::Matrix<S> krylov_vectors,
+                                  Ibis::Vector<Ibis::real> w,
+                                  Ibis::Matrix<Ibis::real, HostExecSpace> H,
+                                  Ibis::Vector<Ibis::real, HostExecSpace> h_host,
+                                  Ibis::Vector<Ibis::real> h, size_t j) {
+    auto V = krylov_vectors.columns(0, j + 1);
+    Ibis::multi_dot(V, w, h_host.data().data());
+    h.deep_copy_space(h_host);
+    Ibis::multi_axpy(w, V, h, -1.0);
+    for (size_t i = 0; i < j + 1; i++) {
+        H(i, j) += h_host(i);
+    }
+}
 
-    auto g = g0.sub_vector(0, j + 2);
-    auto g_new = g1.sub_vector(0, j + 2);
-    Ibis::gemm(Omega_sub, H_old, H_new);
-    Ibis::gemv(Omega_sub, g, g_new);
+template <typename S>
+void orthogonalise_(Ibis::Matrix<S> krylov_vectors, Ibis::Vector<Ibis::real> w,
+                    Ibis::Matrix<Ibis::real, HostExecSpace> H,
+                    Ibis::Vector<Ibis::real, HostExecSpace> h_host,
+                    Ibis::Vector<Ibis::real> h, Orthogonalisation orthogonalisation,
+                    size_t j) {
+    // orthogonalise w against the first j+1 krylov vectors, storing
+    // the projections in column j of the Hessenberg matrix
+    if (orthogonalisation == Orthogonalisation::MGS) {
+        for (size_t i = 0; i < j + 1; i++) {
+            auto vi = krylov_vectors.column(i);
+            H(i, j) = Ibis::dot(w, vi);
+            Ibis::add_scaled_vector(w, vi, -H(i, j));
+        }
+        return;
+    }
 
-    // and update the global rotation matrix
-    auto Q_new = Q1.sub_matrix(0, j + 2, 0, j + 2);
-    auto Q_old = Q0.sub_matrix(0, j + 2, 0, j + 2);
-    if (j == 0) {
-        Q_new.deep_copy(Omega_sub);
-    } else {
-        Ibis::gemm(Omega_sub, Q_old, Q_new);
+    // classical Gram-Schmidt computes all the projections in one
+    // sweep over w, and removes them in another sweep. The second
+    // pass recovers the orthogonality that classical Gram-Schmidt loses.
+    size_t n_passes = (orthogonalisation == Orthogonalisation::CGS2) ? 2 : 1;
+    for (size_t i = 0; i < j + 1; i++) {
+        H(i, j) = 0.0;
+    }
+    for (size_t pass = 0; pass < n_passes; pass++) {
+        classical_gram_schmidt_pass_(krylov_vectors, w, H, h_host, h, j);
     }
+}
 
-    g.deep_copy_layout(g_new);
-    Q_old.deep_copy(Q_new);
-    H_old.deep_copy(H_new);
+template void orthogonalise_(Ibis::Matrix<Ibis::real>, Ibis::Vector<Ibis::real>,
+                             Ibis::Matrix<Ibis::real, HostExecSpace>,
+                             Ibis::Vector<Ibis::real, HostExecSpace>,
+                             Ibis::Vector<Ibis::real>, Orthogonalisation, size_t);
+template void orthogonalise_(Ibis::Matrix<float>, Ibis::Vector<Ibis::real>,
+                             Ibis::Matrix<Ibis::real, HostExecSpace>,
+                             Ibis::Vector<Ibis::real, HostExecSpace>,
+                             Ibis::Vector<Ibis::real>, Orthogonalisation, size_t);
+
+void apply_rotations_to_hessenberg_(Ibis::Matrix<Ibis::real, HostExecSpace> H,
+                                    Ibis::Vector<Ibis::real, HostExecSpace> cs,
+                                    Ibis::Vector<Ibis::real, HostExecSpace> sn,
+                                    Ibis::Vector<Ibis::real, HostExecSpace> g,
+                                    size_t j) {
+    // progressively rotate the Hessenberg into the QR factorisation using
+    // plane rotations, on the cpu. Only the cosine and sine of each rotation
+    // are kept, so each step costs O(j) instead of forming the rotation matrix.
+
+    // apply the previous rotations to the new column of the Hessenberg
+    for (size_t i = 0; i < j; i++) {
+        Ibis::real h_i = H(i, j);
+        Ibis::real h_ip1 = H(i + 1, j);
+        H(i, j) = cs(i) * h_i + sn(i) * h_ip1;
+        H(i + 1, j) = -sn(i) * h_i + cs(i) * h_ip1;
+    }
+
+    // build the rotation which eliminates the sub-diagonal entry of this column
+    Ibis::real denom = Ibis::sqrt(H(j, j) * H(j, j) + H(j + 1, j) * H(j + 1, j));
+    cs(j) = H(j, j) / denom;
+    sn(j) = H(j + 1, j) / denom;
+    H(j, j) = denom;
+    H(j + 1, j) = 0.0;
+
+    // and rotate the right hand side
+    g(j + 1) = -sn(j) * g(j);
+    g(j) = cs(j) * g(j);
 }
 
 LinearSolveResult::LinearSolveResult(bool success_, size_t n_iters_, Ibis::real tol_,
@@ -80,32 +140,33 @@ LinearSolveResult::LinearSolveResult(bool success_, size_t n_iters_, Ibis::real
 LinearSolveResult::LinearSolveResult() : LinearSolveResult(false, 0, -1.0, -1.0) {}
 
 Gmres::Gmres(std::shared_ptr<LinearSystem> system, const size_t max_iters,
-             Ibis::real tol) {
+             Ibis::real tol, Orthogonalisation orthogonalisation,
+             KrylovPrecision precision) {
     tol_ = tol;
+    orthogonalisation_ = orthogonalisation;
+    precision_ = precision;
     num_vars_ = system->num_vars();
     max_iters_ = Kokkos::min(num_vars_, max_iters);
 
     // least squares problem
     H0_ =
         Ibis::Matrix<Ibis::real, HostExecSpace>("Gmres::H0", max_iters_ + 1, max_iters_);
-    H1_ =
-        Ibis::Matrix<Ibis::real, HostExecSpace>("Gmres::H1", max_iters_ + 1, max_iters_);
-    Q0_ = Ibis::Matrix<Ibis::real, HostExecSpace>("Gmres::Q0", max_iters_ + 1,
-                                                  max_iters_ + 1);
-    Q1_ = Ibis::Matrix<Ibis::real, HostExecSpace>("Gmres::Q1", max_iters_ + 1,
-                                                  max_iters_ + 1);
-    Omega_ = Ibis::Matrix<Ibis::real, HostExecSpace>("Gmres::Gamma", max_iters_ + 1,
-                                                     max_iters_ + 1);
     g0_ = Ibis::Vector<Ibis::real, HostExecSpace>("Gmres::g0", max_iters_ + 1);
-    g1_ = Ibis::Vector<Ibis::real, HostExecSpace>("Gmres::g1", max_iters_ + 1);
-    h_rotated_ =
-        Ibis::Vector<Ibis::real, HostExecSpace>("Gmres::h_rotated", max_iters_ + 1);
+    cs_ = Ibis::Vector<Ibis::real, HostExecSpace>("Gmres::cs", max_iters_);
+    sn_ = Ibis::Vector<Ibis::real, HostExecSpace>("Gmres::sn", max_iters_);
+    h_host_ = Ibis::Vector<Ibis::real, HostExecSpace>("Gmres::h_h", max_iters_ + 1);
+    h_ = Ibis::Vector<Ibis::real>("Gmres::h_d", max_iters_ + 1);
     ym_host_ = Ibis::Vector<Ibis::real, HostExecSpace>("Gmres::ym_h", max_iters_ + 1);
     ym_ = Ibis::Vector<Ibis::real>("Gmres::ym_d", max_iters_ + 1);
 
     // Krylov subspace and memory for Arnoldi procedure
-    krylov_vectors_ =
-        Ibis::Matrix<Ibis::real>("Gmres::krylov_vectors", num_vars_, max_iters_ + 1);
+    if (precision_ == KrylovPrecision::Single) {
+        krylov_vectors_single_ =
+            Ibis::Matrix<float>("Gmres::krylov_vectors", num_vars_, max_iters_ + 1);
+    } else {
+        krylov_vectors_ =
+            Ibis::Matrix<Ibis::real>("Gmres::krylov_vectors", num_vars_, max_iters_ + 1);
+    }
     r0_ = Ibis::Vector<Ibis::real>("Gmres::r0", num_vars_);
     w_ = Ibis::Vector<Ibis::real>("Gmres::w", num_vars_);
     v_ = Ibis::Vector<Ibis::real>("Gmres::v", num_vars_);
@@ -114,47 +175,90 @@ Gmres::Gmres(std::shared_ptr<LinearSystem> system, const size_t max_iters,
 }
 
 Gmres::Gmres(std::shared_ptr<LinearSystem> system, json config)
-    : Gmres(system, config.at("max_iters"), config.at("tol")) {}
+    : Gmres(system, config.at("max_iters"), config.at("tol"),
+            string_to_orthogonalisation(config.at("orthogonalisation")),
+            string_to_krylov_precision(config.at("krylov_precision"))) {}
 
 LinearSolveResult Gmres::solve(Ibis::Vector<Ibis::real>& x0) {
-    // zero out (or set to identity matrix) memory
-    Q0_.set_to_identity();
-    Q1_.set_to_identity();
-    Omega_.set_to_identity();
+    Ibis::ProfileRegion region("Gmres::solve");
+    if (precision_ == KrylovPrecision::Single) {
+        return solve_(x0, krylov_vectors_single_);
+    }
+    return solve_(x0, krylov_vectors_);
+}
+
+// Store v as column j of the krylov basis. When the basis has a lower
+// precision than v, v is rounded to the precision of the basis, so the
+// matrix-vector products are computed with the vectors actually stored.
+template <typename S>
+void store_krylov_vector_(Ibis::Matrix<S> krylov_vectors, Ibis::Vector<Ibis::real> v,
+                          size_t j) {
+    auto column = krylov_vectors.column(j);
+    if constexpr (std::is_same<S, Ibis::real>::value) {
+        column.deep_copy_layout(v);
+    } else {
+        Ibis::convert(v, column);
+        Ibis::convert(column, v);
+    }
+}
+
+// If orthogonalising a new vector against a single precision basis shrinks
+// it by more than this factor, most of its significant digits have been
+// cancelled, so it is orthogonalised a second time ("twice is enough")
+constexpr Ibis::real reorthogonalisation_threshold = 0.7071067811865476;
+
+template <typename S>
+LinearSolveResult Gmres::solve_(Ibis::Vector<Ibis::real>& x0,
+                                Ibis::Matrix<S> krylov_vectors) {
+    constexpr bool reduced_precision = !std::is_same<S, Ibis::real>::value;
+
+    // zero out memory
     H0_.set_to_zero();
-    H1_.set_to_zero();
     g0_.zero();
-    g1_.zero();
 
     // initialise the intial residuals and first krylov vector
-    compute_r0_(system_, x0, r0_, w_);
+    {
+        Ibis::ProfileRegion region("Gmres::matrix_vector_product");
+        compute_r0_(system_, x0, r0_, w_);
+    }
     Ibis::real beta = Ibis::norm2(r0_);
-    if (beta < tol_) {
-        // the initial guess is within the tolerance
+    if (beta < min_initial_residual) {
+        // the initial guess already solves the system
         return LinearSolveResult{true, 0, tol_, beta};
     }
     g0_(0) = beta;
     Ibis::scale(r0_, v_, 1.0 / beta);
-    krylov_vectors_.column(0).deep_copy_layout(v_);
+    store_krylov_vector_(krylov_vectors, v_, 0);
 
     LinearSolveResult result{false, 0, tol_, beta};
     for (size_t j = 0; j < max_iters_; j++) {
         // build the next krylov vector and entries in the Hessenberg matrix
-        system_->matrix_vector_product(v_, w_);
-        for (size_t i = 0; i < j + 1; i++) {
-            auto vi = krylov_vectors_.column(i);
-            H0_(i, j) = Ibis::dot(w_, vi);
-            Ibis::add_scaled_vector(w_, vi, -H0_(i, j));
+        {
+            Ibis::ProfileRegion region("Gmres::matrix_vector_product");
+            system_->matrix_vector_product(v_, w_);
+        }
+        {
+            Ibis::ProfileRegion region("Gmres::orthogonalisation");
+            Ibis::real w_norm_before = reduced_precision ? Ibis::norm2(w_) : 0.0;
+            orthogonalise_(krylov_vectors, w_, H0_, h_host_, h_, orthogonalisation_, j);
+            Ibis::real w_norm = Ibis::norm2(w_);
+            if (reduced_precision &&
+                w_norm < reorthogonalisation_threshold * w_norm_before) {
+                classical_gram_schmidt_pass_(krylov_vectors, w_, H0_, h_host_, h_, j);
+                w_norm = Ibis::norm2(w_);
+            }
+            H0_(j + 1, j) = w_norm;
+            Ibis::scale(w_, v_, 1.0 / H0_(j + 1, j));
+            store_krylov_vector_(krylov_vectors, v_, j + 1);
         }
-        H0_(j + 1, j) = Ibis::norm2(w_);
-        Ibis::scale(w_, v_, 1.0 / H0_(j + 1, j));
-        krylov_vectors_.column(j + 1).deep_copy_layout(v_);
 
         // progressively rotate the Hessenberg into upper-triangular form
         // so we can calculate the residual of this step, and later solve
         // the least squares problem
-        apply_rotations_to_hessenberg_(H0_, H1_, Q0_, Q1_, Omega_, g0_, g1_, h_rotated_,
-                                       j);
+        {
+            Ibis::ProfileRegion region("Gmres::least_squares");
+            apply_rotations_to_hessenberg_(H0_, cs_, sn_, g0_, j);
+        }
 
         // check convergence
         Ibis::real residual = Ibis::abs(g0_(j + 1));
@@ -169,40 +273,81 @@ LinearSolveResult Gmres::solve(Ibis::Vector<Ibis::real>& x0) {
     // return the guess, even if we didn't converge
     size_t n_vectors = result.n_iters;
     auto H = H0_.sub_matrix(0, n_vectors, 0, n_vectors);
-    auto V = krylov_vectors_.columns(0, n_vectors);
+    auto V = krylov_vectors.columns(0, n_vectors);
     auto g = g0_.sub_vector(0, n_vectors);
     auto ym_host = ym_host_.sub_vector(0, n_vectors);
     auto ym = ym_.sub_vector(0, n_vectors);
-    Ibis::upper_triangular_solve(H, ym_host, g);
-    ym.deep_copy_space(ym_host);
+    {
+        Ibis::ProfileRegion region("Gmres::least_squares");
+        Ibis::upper_triangular_solve(H, ym_host, g);
+        ym.deep_copy_space(ym_host);
+    }
+    Ibis::ProfileRegion region("Gmres::update");
     Ibis::gemv(V, ym, w_);
     Ibis::add_scaled_vector(x0, w_, 1.0);
 
     return result;
 }
 
+GmresPreconditioner::GmresPreconditioner(
+    std::shared_ptr<LinearSystem> precondition_system, const size_t max_iters,
+    Ibis::real tol, Orthogonalisation orthogonalisation)
+    : precondition_system_(precondition_system),
+      gmres_(precondition_system, max_iters, tol, orthogonalisation) {}
+
+void GmresPreconditioner::apply(Ibis::Vector<Ibis::real>& v,
+                                Ibis::Vector<Ibis::real>& z) {
+    precondition_system_->set_rhs(v);
+    z.zero();
+    gmres_.solve(z);
+}
+
+std::unique_ptr<Preconditioner> make_preconditioner(
+    std::shared_ptr<LinearSystem> precondition_system, json config) {
+    std::string preconditioner_type = config.at("preconditioner");
+    if (preconditioner_type == "gmres") {
+        return std::unique_ptr<Preconditioner>(new GmresPreconditioner(
+            precondition_system, config.at("max_preconditioner_iters"),
+            config.at("preconditioner_tolerance"),
+            string_to_orthogonalisation(config.at("orthogonalisation"))));
+    } else if (preconditioner_type == "block_jacobi") {
+        return std::unique_ptr<Preconditioner>(new BlockJacobi(precondition_system));
+    } else if (preconditioner_type == "ilu0") {
+        return std::unique_ptr<Preconditioner>(new Ilu0(precondition_system));
+    } else if (preconditioner_type == "lusgs") {
+        return precondition_system->lusgs_preconditioner();
+    } else {
+        spdlog::error("Unknown preconditioner {}", preconditioner_type);
+        throw std::runtime_error("Unknown preconditioner");
+    }
+}
+
 FGmres::FGmres(std::shared_ptr<LinearSystem> system, const size_t max_iters,
                Ibis::real tol, std::shared_ptr<LinearSystem> precondition_system,
-               const size_t max_precondition_iters, Ibis::real precondition_tol) {
+               const size_t max_precondition_iters, Ibis::real precondition_tol,
+               Orthogonalisation orthogonalisation)
+    : FGmres(system, max_iters, tol,
+             std::unique_ptr<Preconditioner>(
+                 new GmresPreconditioner(precondition_system, max_precondition_iters,
+                                         precondition_tol, orthogonalisation)),
+             orthogonalisation) {}
+
+FGmres::FGmres(std::shared_ptr<LinearSystem> system, const size_t max_iters,
+               Ibis::real tol, std::unique_ptr<Preconditioner> preconditioner,
+               Orthogonalisation orthogonalisation) {
     tol_ = tol;
+    orthogonalisation_ = orthogonalisation;
     num_vars_ = system->num_vars();
     max_iters_ = Kokkos::min(num_vars_, max_iters);
 
     // least squares problem
     H0_ =
         Ibis::Matrix<Ibis::real, HostExecSpace>("FGmres::H0", max_iters_ + 1, max_iters_);
-    H1_ =
-        Ibis::Matrix<Ibis::real, HostExecSpace>("FGmres::H1", max_iters_ + 1, max_iters_);
-    Q0_ = Ibis::Matrix<Ibis::real, HostExecSpace>("FGmres::Q0", max_iters_ + 1,
-                                                  max_iters_ + 1);
-    Q1_ = Ibis::Matrix<Ibis::real, HostExecSpace>("FGmres::Q1", max_iters_ + 1,
-                                                  max_iters_ + 1);
-    Omega_ = Ibis::Matrix<Ibis::real, HostExecSpace>("FGmres::Gamma", max_iters_ + 1,
-                                                     max_iters_ + 1);
     g0_ = Ibis::Vector<Ibis::real, HostExecSpace>("FGmres::g0", max_iters_ + 1);
-    g1_ = Ibis::Vector<Ibis::real, HostExecSpace>("FGmres::g1", max_iters_ + 1);
-    h_rotated_ =
-        Ibis::Vector<Ibis::real, HostExecSpace>("FGmres::h_rotated", max_iters_ + 1);
+    cs_ = Ibis::Vector<Ibis::real, HostExecSpace>("FGmres::cs", max_iters_);
+    sn_ = Ibis::Vector<Ibis::real, HostExecSpace>("FGmres::sn", max_iters_);
+    h_host_ = Ibis::Vector<Ibis::real, HostExecSpace>("FGmres::h_h", max_iters_ + 1);
+    h_ = Ibis::Vector<Ibis::real>("FGmres::h_d", max_iters_ + 1);
     ym_host_ = Ibis::Vector<Ibis::real, HostExecSpace>("FGmres::ym_h", max_iters_ + 1);
     ym_ = Ibis::Vector<Ibis::real>("FGmres::ym_d", max_iters_ + 1);
 
@@ -219,63 +364,72 @@ FGmres::FGmres(std::shared_ptr<LinearSystem> system, const size_t max_iters,
     // The linear system of equations
     system_ = system;
 
-    // The preconditioner system of equations, and gmres to solve it
-    precondition_system_ = precondition_system;
-    preconditioner_ =
-        Gmres(precondition_system, max_precondition_iters, precondition_tol);
+    // The preconditioner
+    preconditioner_ = std::move(preconditioner);
 }
 
 FGmres::FGmres(std::shared_ptr<LinearSystem> system,
                std::shared_ptr<LinearSystem> preconditioner, json config)
-    : FGmres(system, config.at("max_iters"), config.at("tolerance"), preconditioner,
-             config.at("max_preconditioner_iters"),
-             config.at("preconditioner_tolerance")) {}
+    : FGmres(system, config.at("max_iters"), config.at("tolerance"),
+             make_preconditioner(preconditioner, config),
+             string_to_orthogonalisation(config.at("orthogonalisation"))) {}
 
 LinearSolveResult FGmres::solve(Ibis::Vector<Ibis::real>& x) {
-    // zero out (or set to identity matrix) memory
-    Q0_.set_to_identity();
-    Q1_.set_to_identity();
-    Omega_.set_to_identity();
+    Ibis::ProfileRegion solve_region("FGmres::solve");
+
+    // zero out memory
     H0_.set_to_zero();
-    H1_.set_to_zero();
     g0_.zero();
-    g1_.zero();
 
     // initialise the intial residuals and first krylov vector
-    compute_r0_(system_, x, r0_, w_);
+    {
+        Ibis::ProfileRegion region("FGmres::matrix_vector_product");
+        compute_r0_(system_, x, r0_, w_);
+    }
     Ibis::real beta = Ibis::norm2(r0_);
-    if (beta < tol_) {
-        // the initial guess is within the tolerance
+    if (beta < min_initial_residual) {
+        // the initial guess already solves the system
         return LinearSolveResult{true, 0, tol_, beta};
     }
     g0_(0) = beta;
     Ibis::scale(r0_, v_, 1.0 / beta);
     krylov_vectors_.column(0).deep_copy_layout(v_);
 
+    // bring the preconditioner up to date with the linear system
+    {
+        Ibis::ProfileRegion region("FGmres::update_preconditioner");
+        preconditioner_->update();
+    }
+
     LinearSolveResult result{false, 0, tol_, beta};
     for (size_t j = 0; j < max_iters_; j++) {
-        // solve the precondition system
-        precondition_system_->set_rhs(v_);
-        z_.zero();
-        preconditioner_.solve(z_);
-        preconditioned_krylov_vectors_.column(j).deep_copy_layout(z_);
+        // apply the preconditioner
+        {
+            Ibis::ProfileRegion region("FGmres::apply_preconditioner");
+            preconditioner_->apply(v_, z_);
+            preconditioned_krylov_vectors_.column(j).deep_copy_layout(z_);
+        }
 
         // build the next krylov vector and entries in the Hessenberg matrix
-        system_->matrix_vector_product(z_, w_);
-        for (size_t i = 0; i < j + 1; i++) {
-            auto vi = krylov_vectors_.column(i);
-            H0_(i, j) = Ibis::dot(w_, vi);
-            Ibis::add_scaled_vector(w_, vi, -H0_(i, j));
+        {
+            Ibis::ProfileRegion region("FGmres::matrix_vector_product");
+            system_->matrix_vector_product(z_, w_);
+        }
+        {
+            Ibis::ProfileRegion region("FGmres::orthogonalisation");
+            orthogonalise_(krylov_vectors_, w_, H0_, h_host_, h_, orthogonalisation_, j);
+            H0_(j + 1, j) = Ibis::norm2(w_);
+            Ibis::scale(w_, v_, 1.0 / H0_(j + 1, j));
+            krylov_vectors_.column(j + 1).deep_copy_layout(v_);
         }
-        H0_(j + 1, j) = Ibis::norm2(w_);
-        Ibis::scale(w_, v_, 1.0 / H0_(j + 1, j));
-        krylov_vectors_.column(j + 1).deep_copy_layout(v_);
 
         // progressively rotate the Hessenberg into upper-triangular form
         // so we can calculate the residual of this step, and later solve
         // the least squares problem
-        apply_rotations_to_hessenberg_(H0_, H1_, Q0_, Q1_, Omega_, g0_, g1_, h_rotated_,
-                                       j);
+        {
+            Ibis::ProfileRegion region("FGmres::least_squares");
+            apply_rotations_to_hessenberg_(H0_, cs_, sn_, g0_, j);
+        }
 
         // check convergence
         Ibis::real residual = Ibis::abs(g0_(j + 1));
@@ -294,10 +448,17 @@ LinearSolveResult FGmres::solve(Ibis::Vector<Ibis::real>& x) {
     auto g = g0_.sub_vector(0, n_vectors);
     auto ym_host = ym_host_.sub_vector(0, n_vectors);
     auto ym = ym_.sub_vector(0, n_vectors);
-    Ibis::upper_triangular_solve(H, ym_host, g);
-    ym.deep_copy_space(ym_host);
-    Ibis::gemv(Z, ym, w_);
-    Ibis::add_scaled_vector(x, w_, 1.0);
+    {
+        Ibis::ProfileRegion region("FGmres::least_squares");
+        Ibis::upper_triangular_solve(H, ym_host, g);
+        ym.deep_copy_space(ym_host);
+    }
+    {
+        Ibis::ProfileRegion region("FGmres::update");
+        Ibis::gemv(Z, ym, w_);
+        Ibis::add_scaled_vector(x, w_, 1.0);
+    }
+    Ibis::profile_count("fgmres iterations", result.n_iters);
 
     return result;
 }
@@ -311,79 +472,137 @@ std::unique_ptr<IterativeLinearSolver> make_linear_solver(
     } else if (solver_type == "fgmres") {
         return std::unique_ptr<IterativeLinearSolver>(
             new FGmres(system, preconditioner, config));
+    } else if (solver_type == "gcrodr") {
+        return std::unique_ptr<IterativeLinearSolver>(new GcroDr(system, config));
+    } else if (solver_type == "sstep_gmres") {
+        return std::unique_ptr<IterativeLinearSolver>(new SStepGmres(system, config));
     } else {
         spdlog::error("Unknown linear solver {}", solver_type);
         throw new std::runtime_error("Unknown linear solver");
     }
 }
 
-TEST_CASE("GMRES") {
-    class TestLinearSystem : public LinearSystem {
-    public:
-        using ExecSpace = Kokkos::DefaultExecutionSpace;
-
-        TestLinearSystem() {
-            matrix_ = Ibis::Matrix<Ibis::real, ExecSpace>("A", 5, 5);
-            auto matrix_h = matrix_.host_mirror();
-            matrix_h(0, 0) = 2.0;
-            matrix_h(0, 1) = -0.5;
-            matrix_h(1, 0) = -1.0;
-            matrix_h(1, 1) = 2.0;
-            matrix_h(1, 2) = -0.5;
-            matrix_h(2, 1) = -1.0;
-            matrix_h(2, 2) = 2.0;
-            matrix_h(2, 3) = -0.5;
-            matrix_h(3, 2) = -1.0;
-            matrix_h(3, 3) = 2.0;
-            matrix_h(3, 4) = -0.5;
-            matrix_h(4, 3) = -1.0;
-            matrix_h(4, 4) = 2.0;
-            matrix_.deep_copy_space(matrix_h);
-
-            rhs_ = Ibis::Vector<Ibis::real, ExecSpace>("rhs", 5);
-            auto rhs_h = rhs_.host_mirror();
-            rhs_h(0) = 2.0;
-            rhs_h(1) = -0.5;
-            rhs_h(2) = -2.75;
-            rhs_h(3) = 3.75;
-            rhs_h(4) = -0.5;
-            rhs_.deep_copy_space(rhs_h);
-        }
-
-        ~TestLinearSystem() {}
+#ifndef DOCTEST_CONFIG_DISABLE
+namespace {
+
+// the original dense rotation update, kept as a reference for testing the
+// incremental Givens rotations. It is only compiled along with the tests.
+void dense_rotations_reference_(Ibis::Matrix<Ibis::real, HostExecSpace> H0,
+                                Ibis::Matrix<Ibis::real, HostExecSpace> H1,
+                                Ibis::Matrix<Ibis::real, HostExecSpace> Q0,
+                                Ibis::Matrix<Ibis::real, HostExecSpace> Q1,
+                                Ibis::Matrix<Ibis::real, HostExecSpace> Omega,
+                                Ibis::Vector<Ibis::real, HostExecSpace> g0,
+                                Ibis::Vector<Ibis::real, HostExecSpace> g1,
+                                Ibis::Vector<Ibis::real, HostExecSpace> hr, size_t j) {
+    if (j != 0) {
+        auto Q_sub = Q0.sub_matrix(0, j + 1, 0, j + 1);
+        auto h_col_j = H0.sub_matrix(0, j + 1, 0, j + 1).column(j);
+        auto h_rotated = hr.sub_vector(0, j + 1);
+        Ibis::gemv(Q_sub, h_col_j, h_rotated);
+        h_col_j.deep_copy_layout(h_rotated);
+    }
 
-        void eval_rhs() {}
+    Omega.set_to_identity();
+    Ibis::real denom = Ibis::sqrt(H0(j, j) * H0(j, j) + H0(j + 1, j) * H0(j + 1, j));
+    Ibis::real si = H0(j + 1, j) / denom;
+    Ibis::real ci = H0(j, j) / denom;
+    Omega(j, j) = ci;
+    Omega(j, j + 1) = si;
+    Omega(j + 1, j) = -si;
+    Omega(j + 1, j + 1) = ci;
 
-        void set_rhs(Ibis::Vector<Ibis::real>& rhs) { rhs_ = rhs; }
+    auto H_old = H0.sub_matrix(0, j + 2, 0, j + 2);
+    auto H_new = H1.sub_matrix(0, j + 2, 0, j + 2);
+    auto Omega_sub = Omega.sub_matrix(0, j + 2, 0, j + 2);
 
-        void matrix_vector_product(Ibis::Vector<Ibis::real>& vec,
-                                   Ibis::Vector<Ibis::real>& res) {
-            Ibis::gemv(matrix_, vec, res);
-        }
+    auto g = g0.sub_vector(0, j + 2);
+    auto g_new = g1.sub_vector(0, j + 2);
+    Ibis::gemm(Omega_sub, H_old, H_new);
+    Ibis::gemv(Omega_sub, g, g_new);
 
-        std::unique_ptr<LinearSystem> preconditioner() {
-            throw new std::runtime_error("");
-        }
+    auto Q_new = Q1.sub_matrix(0, j + 2, 0, j + 2);
+    auto Q_old = Q0.sub_matrix(0, j + 2, 0, j + 2);
+    if (j == 0) {
+        Q_new.deep_copy(Omega_sub);
+    } else {
+        Ibis::gemm(Omega_sub, Q_old, Q_new);
+    }
 
-        KOKKOS_INLINE_FUNCTION
-        Ibis::real& rhs(const size_t i) const { return rhs_(i); }
+    g.deep_copy_layout(g_new);
+    Q_old.deep_copy(Q_new);
+    H_old.deep_copy(H_new);
+}
 
-        KOKKOS_INLINE_FUNCTION
-        Ibis::real& rhs(const size_t i, const size_t j) const {
-            (void)j;
-            return rhs_(i);
+}  // namespace
+
+// with doctest disabled, test cases are still compiled (as uninstantiated
+// templates), so this one is left out along with the reference it uses
+TEST_CASE("Givens rotations") {
+    const size_t m = 5;
+
+    // an arbitrary upper Hessenberg matrix
+    Ibis::real hessenberg[m + 1][m] = {{4.0, -1.0, 0.5, 2.0, -0.3},
+                                       {1.5, 3.0, -2.0, 0.7, 1.1},
+                                       {0.0, 0.8, 2.5, -1.2, 0.4},
+                                       {0.0, 0.0, 1.3, 1.9, -0.6},
+                                       {0.0, 0.0, 0.0, 0.9, 3.3},
+                                       {0.0, 0.0, 0.0, 0.0, 0.2}};
+
+    Ibis::Matrix<Ibis::real, HostExecSpace> H("H", m + 1, m + 1);
+    Ibis::Vector<Ibis::real, HostExecSpace> cs("cs", m);
+    Ibis::Vector<Ibis::real, HostExecSpace> sn("sn", m);
+    Ibis::Vector<Ibis::real, HostExecSpace> g("g", m + 1);
+
+    Ibis::Matrix<Ibis::real, HostExecSpace> H_ref("H_ref", m + 1, m + 1);
+    Ibis::Matrix<Ibis::real, HostExecSpace> H1("H1", m + 1, m + 1);
+    Ibis::Matrix<Ibis::real, HostExecSpace> Q0("Q0", m + 1, m + 1);
+    Ibis::Matrix<Ibis::real, HostExecSpace> Q1("Q1", m + 1, m + 1);
+    Ibis::Matrix<Ibis::real, HostExecSpace> Omega("Omega", m + 1, m + 1);
+    Ibis::Vector<Ibis::real, HostExecSpace> g_ref("g_ref", m + 1);
+    Ibis::Vector<Ibis::real, HostExecSpace> g1("g1", m + 1);
+    Ibis::Vector<Ibis::real, HostExecSpace> hr("hr", m + 1);
+
+    H.set_to_zero();
+    H_ref.set_to_zero();
+    H1.set_to_zero();
+    Q0.set_to_identity();
+    Q1.set_to_identity();
+    g.zero();
+    g_ref.zero();
+    g1.zero();
+    g(0) = 2.0;
+    g_ref(0) = 2.0;
+
+    for (size_t j = 0; j < m; j++) {
+        // the Arnoldi process fills in one column of the Hessenberg at a time
+        for (size_t i = 0; i < j + 2; i++) {
+            H(i, j) = hessenberg[i][j];
+            H_ref(i, j) = hessenberg[i][j];
         }
+        apply_rotations_to_hessenberg_(H, cs, sn, g, j);
+        dense_rotations_reference_(H_ref, H1, Q0, Q1, Omega, g_ref, g1, hr, j);
 
-        Ibis::Vector<Ibis::real>& rhs() { return rhs_; }
-
-        size_t num_vars() const { return 5; }
+        // the residual history should be the same
+        CHECK(Ibis::abs(g(j + 1)) == doctest::Approx(Ibis::abs(g_ref(j + 1))));
+        for (size_t i = 0; i < j + 1; i++) {
+            CHECK(g(i) == doctest::Approx(g_ref(i)));
+        }
+    }
 
-    private:
-        Ibis::Matrix<Ibis::real, ExecSpace> matrix_;
-        Ibis::Vector<Ibis::real, ExecSpace> rhs_;
-    };
+    // and so should the upper triangular factor
+    for (size_t j = 0; j < m; j++) {
+        for (size_t i = 0; i < j + 1; i++) {
+            CHECK(H(i, j) == doctest::Approx(H_ref(i, j)));
+        }
+    }
+}
+#endif
 
-    std::shared_ptr<LinearSystem> sys{new TestLinearSystem()};
+TEST_CASE("GMRES") {
+    auto matrix = tridiagonal_test_matrix(5, -1.0, 2.0, -0.5);
+    std::vector<Ibis::real> rhs = test_rhs(matrix, {1.0, 0.0, -1.0, 1.5, 0.5});
+    std::shared_ptr<LinearSystem> sys{new TestLinearSystem(matrix, rhs)};
 
     Gmres solver{sys, 5, 1e-14};
     Ibis::Vector<Ibis::real> x{"x", 5};
@@ -398,91 +617,51 @@ TEST_CASE("GMRES") {
     CHECK(x_h(2) == doctest::Approx(-1.0));
     CHECK(x_h(3) == doctest::Approx(1.5));
     CHECK(x_h(4) == doctest::Approx(0.5));
-}
-
-TEST_CASE("FGMRES") {
-    class TestLinearSystem : public LinearSystem {
-    public:
-        using ExecSpace = Kokkos::DefaultExecutionSpace;
-
-        TestLinearSystem(Ibis::Matrix<Ibis::real> matrix) {
-            matrix_ = matrix;
-            rhs_ = Ibis::Vector<Ibis::real>("rhs", 5);
-            auto rhs_h = rhs_.host_mirror();
-            rhs_h(0) = 2.0;
-            rhs_h(1) = 0.0;
-            rhs_h(2) = -3.5;
-            rhs_h(3) = 3.5;
-            rhs_h(4) = -0.5;
-            rhs_.deep_copy_space(rhs_h);
-        }
-
-        ~TestLinearSystem() {}
-
-        void eval_rhs() {}
-
-        void set_rhs(Ibis::Vector<Ibis::real>& rhs) {
-            // rhs_.deep_copy_space(rhs);
-            rhs_ = rhs;
-        }
-
-        void matrix_vector_product(Ibis::Vector<Ibis::real>& vec,
-                                   Ibis::Vector<Ibis::real>& res) {
-            Ibis::gemv(matrix_, vec, res);
-        }
-
-        std::unique_ptr<LinearSystem> preconditioner() {
-            throw new std::runtime_error("");
-        }
 
-        KOKKOS_INLINE_FUNCTION
-        Ibis::real& rhs(const size_t i) const { return rhs_(i); }
+    // the classical Gram-Schmidt variants should give the same answer
+    for (Orthogonalisation orthogonalisation :
+         {Orthogonalisation::CGS, Orthogonalisation::CGS2}) {
+        Gmres cgs_solver{sys, 5, 1e-14, orthogonalisation};
+        Ibis::Vector<Ibis::real> x_cgs{"x_cgs", 5};
+        LinearSolveResult cgs_result = cgs_solver.solve(x_cgs);
+
+        auto x_cgs_h = x_cgs.host_mirror();
+        x_cgs_h.deep_copy_space(x_cgs);
+
+        CHECK(cgs_result.success == true);
+        CHECK(cgs_result.n_iters == result.n_iters);
+        CHECK(x_cgs_h(0) == doctest::Approx(1.0));
+        CHECK(x_cgs_h(1) == doctest::Approx(0.0));
+        CHECK(x_cgs_h(2) == doctest::Approx(-1.0));
+        CHECK(x_cgs_h(3) == doctest::Approx(1.5));
+        CHECK(x_cgs_h(4) == doctest::Approx(0.5));
+    }
 
-        KOKKOS_INLINE_FUNCTION
-        Ibis::real& rhs(const size_t i, const size_t j) const {
-            (void)j;
-            return rhs_(i);
-        }
+    // storing the krylov basis in single precision limits the accuracy
+    // of the solution to roughly single precision
+    Gmres mixed_solver{sys, 5, 1e-6, Orthogonalisation::MGS, KrylovPrecision::Single};
+    Ibis::Vector<Ibis::real> x_mixed{"x_mixed", 5};
+    LinearSolveResult mixed_result = mixed_solver.solve(x_mixed);
+
+    auto x_mixed_h = x_mixed.host_mirror();
+    x_mixed_h.deep_copy_space(x_mixed);
+
+    CHECK(mixed_result.success == true);
+    CHECK(x_mixed_h(0) == doctest::Approx(1.0).epsilon(1e-5));
+    CHECK(x_mixed_h(1) == doctest::Approx(0.0).epsilon(1e-5));
+    CHECK(x_mixed_h(2) == doctest::Approx(-1.0).epsilon(1e-5));
+    CHECK(x_mixed_h(3) == doctest::Approx(1.5).epsilon(1e-5));
+    CHECK(x_mixed_h(4) == doctest::Approx(0.5).epsilon(1e-5));
+}
 
-        Ibis::Vector<Ibis::real>& rhs() { return rhs_; }
-
-        size_t num_vars() const { return 5; }
-
-    private:
-        Ibis::Matrix<Ibis::real, ExecSpace> matrix_;
-        Ibis::Vector<Ibis::real, ExecSpace> rhs_;
-    };
-
-    Ibis::Matrix<Ibis::real> matrix("A", 5, 5);
-    auto matrix_h = matrix.host_mirror();
-    matrix_h(0, 0) = 2.0;
-    matrix_h(0, 1) = -1.0;
-    matrix_h(1, 0) = -1.0;
-    matrix_h(1, 1) = 2.0;
-    matrix_h(1, 2) = -1.0;
-    matrix_h(2, 1) = -1.0;
-    matrix_h(2, 2) = 2.0;
-    matrix_h(2, 3) = -1.0;
-    matrix_h(3, 2) = -1.0;
-    matrix_h(3, 3) = 2.0;
-    matrix_h(3, 4) = -1.0;
-    matrix_h(4, 3) = -1.0;
-    matrix_h(4, 4) = 2.0;
-    matrix.deep_copy_space(matrix_h);
-
-    std::shared_ptr<LinearSystem> sys{new TestLinearSystem(matrix)};
+TEST_CASE("FGMRES") {
+    auto matrix = tridiagonal_test_matrix(5, -1.0, 2.0, -1.0);
+    std::vector<Ibis::real> rhs = test_rhs(matrix, {1.0, 0.0, -1.0, 1.5, 0.5});
+    std::shared_ptr<LinearSystem> sys{new TestLinearSystem(matrix, rhs)};
 
     // the preconditioner we'll use is just the diagonal terms
-    Ibis::Matrix<Ibis::real> precondition_matrix("P", 5, 5);
-    auto preconditioner_h = precondition_matrix.host_mirror();
-    preconditioner_h(0, 0) = 2.0;
-    preconditioner_h(1, 1) = 2.0;
-    preconditioner_h(2, 2) = 2.0;
-    preconditioner_h(3, 3) = 2.0;
-    preconditioner_h(4, 4) = 2.0;
-    precondition_matrix.deep_copy_space(preconditioner_h);
     std::shared_ptr<LinearSystem> preconditioner{
-        new TestLinearSystem(precondition_matrix)};
+        new TestLinearSystem(tridiagonal_test_matrix(5, 0.0, 2.0, 0.0), rhs)};
 
     FGmres solver{sys, 5, 1e-14, preconditioner, 2, 1e-1};
     Ibis::Vector<Ibis::real> x{"x", 5};
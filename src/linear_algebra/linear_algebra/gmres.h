@@ -4,6 +4,7 @@
 // #include <linear_algebra/linear_solver.h>
 #include <linear_algebra/dense_linear_algebra.h>
 #include <linear_algebra/linear_system.h>
+#include <linear_algebra/preconditioner.h>
 #include <util/numeric_types.h>
 #include <util/types.h>
 
@@ -22,12 +23,42 @@ struct LinearSolveResult {
     Ibis::real residual;
 };
 
+// The solvers' tolerances are relative to the initial residual, so they
+// only skip iterating when the initial residual is (numerically) zero.
+// Comparing the absolute residual against a loose relative tolerance
+// (e.g. an Eisenstat-Walker forcing term close to 1) would return
+// without improving the solution at all.
+constexpr Ibis::real min_initial_residual = 1e-300;
+
+// How the Arnoldi process orthogonalises each new Krylov vector
+// against the previous ones.
+//   MGS: modified Gram-Schmidt, one dot product and update per vector
+//   CGS: classical Gram-Schmidt, all the dot products and updates fused
+//   CGS2: classical Gram-Schmidt with a second (re-orthogonalisation) pass
+enum class Orthogonalisation { MGS, CGS, CGS2 };
+
+Orthogonalisation string_to_orthogonalisation(std::string orthogonalisation);
+
+// The number type used to store the Krylov basis. With single precision,
+// the basis takes half the memory and bandwidth, but dot products, the
+// Hessenberg matrix and the update of the solution are still computed in
+// double precision.
+enum class KrylovPrecision { Double, Single };
+
+KrylovPrecision string_to_krylov_precision(std::string precision);
+
 class IterativeLinearSolver {
 public:
     IterativeLinearSolver() {}
     virtual ~IterativeLinearSolver() {}
 
     virtual LinearSolveResult solve(Ibis::Vector<Ibis::real>& x) = 0;
+
+    // the tolerance on the residual, relative to the initial
+    // residual. This may be changed between solves.
+    virtual Ibis::real tol() const = 0;
+
+    virtual void set_tol(Ibis::real tol) = 0;
 };
 
 class Gmres : public IterativeLinearSolver {
@@ -43,22 +74,37 @@ public:
 
     ~Gmres() {}
 
-    Gmres(std::shared_ptr<LinearSystem> system, const size_t max_iters, Ibis::real tol);
+    Gmres(std::shared_ptr<LinearSystem> system, const size_t max_iters, Ibis::real tol,
+          Orthogonalisation orthogonalisation = Orthogonalisation::MGS,
+          KrylovPrecision precision = KrylovPrecision::Double);
 
     Gmres(std::shared_ptr<LinearSystem> system, json config);
 
     LinearSolveResult solve(Ibis::Vector<Ibis::real>& x0);
 
+    Ibis::real tol() const { return tol_; }
+
+    void set_tol(Ibis::real tol) { tol_ = tol; }
+
 private:
     // configuration
     size_t max_iters_;
     size_t num_vars_;
     Ibis::real tol_;
+    Orthogonalisation orthogonalisation_;
+    KrylovPrecision precision_;
     std::shared_ptr<LinearSystem> system_;
 
+    // the solve, with the Krylov basis stored in krylov_vectors
+    template <typename S>
+    LinearSolveResult solve_(Ibis::Vector<Ibis::real>& x0,
+                             Ibis::Matrix<S> krylov_vectors);
+
 public:  // this has to be public to access from inside kernels
-    // memory
+    // memory. Only one of the Krylov bases is allocated,
+    // depending on the precision
     Ibis::Matrix<Ibis::real> krylov_vectors_;
+    Ibis::Matrix<float> krylov_vectors_single_;
     Ibis::Vector<Ibis::real> v_;
     // Ibis::Vector<Ibis::real> z_;
     Ibis::Vector<Ibis::real> r0_;
@@ -66,17 +112,34 @@ public:  // this has to be public to access from inside kernels
 
     // least squares problem
     Ibis::Matrix<Ibis::real, HostExecSpace> H0_;
-    Ibis::Matrix<Ibis::real, HostExecSpace> H1_;
-    Ibis::Matrix<Ibis::real, HostExecSpace> Q0_;
-    Ibis::Matrix<Ibis::real, HostExecSpace> Q1_;
-    Ibis::Matrix<Ibis::real, HostExecSpace> Omega_;
     Ibis::Vector<Ibis::real, HostExecSpace> g0_;
-    Ibis::Vector<Ibis::real, HostExecSpace> g1_;
+    Ibis::Vector<Ibis::real, HostExecSpace> cs_;
+    Ibis::Vector<Ibis::real, HostExecSpace> sn_;
+    Ibis::Vector<Ibis::real, HostExecSpace> h_host_;
+    Ibis::Vector<Ibis::real> h_;
     Ibis::Vector<Ibis::real, HostExecSpace> ym_host_;
     Ibis::Vector<Ibis::real> ym_;
-    Ibis::Vector<Ibis::real, HostExecSpace> h_rotated_;
 };
 
+// Preconditions by approximately solving the precondition system with GMRES
+class GmresPreconditioner : public Preconditioner {
+public:
+    GmresPreconditioner(std::shared_ptr<LinearSystem> precondition_system,
+                        const size_t max_iters, Ibis::real tol,
+                        Orthogonalisation orthogonalisation = Orthogonalisation::MGS);
+
+    ~GmresPreconditioner() {}
+
+    void apply(Ibis::Vector<Ibis::real>& v, Ibis::Vector<Ibis::real>& z);
+
+private:
+    std::shared_ptr<LinearSystem> precondition_system_;
+    Gmres gmres_;
+};
+
+std::unique_ptr<Preconditioner> make_preconditioner(
+    std::shared_ptr<LinearSystem> precondition_system, json config);
+
 class FGmres : public IterativeLinearSolver {
 public:
     using HostExecSpace = Ibis::DefaultHostExecSpace;
@@ -88,24 +151,33 @@ public:
 
     FGmres(std::shared_ptr<LinearSystem> system, const size_t max_iters, Ibis::real tol,
            std::shared_ptr<LinearSystem> precondition_system,
-           const size_t max_precondition_iters, Ibis::real inner_tol);
+           const size_t max_precondition_iters, Ibis::real inner_tol,
+           Orthogonalisation orthogonalisation = Orthogonalisation::MGS);
+
+    FGmres(std::shared_ptr<LinearSystem> system, const size_t max_iters, Ibis::real tol,
+           std::unique_ptr<Preconditioner> preconditioner,
+           Orthogonalisation orthogonalisation = Orthogonalisation::MGS);
 
     FGmres(std::shared_ptr<LinearSystem> system,
            std::shared_ptr<LinearSystem> preconditioner, json config);
 
     LinearSolveResult solve(Ibis::Vector<Ibis::real>& x);
 
+    Ibis::real tol() const { return tol_; }
+
+    void set_tol(Ibis::real tol) { tol_ = tol; }
+
 private:
     // configuration
     size_t max_iters_;
     size_t num_vars_;
     Ibis::real tol_;
+    Orthogonalisation orthogonalisation_;
 
     std::shared_ptr<LinearSystem> system_;
-    std::shared_ptr<LinearSystem> precondition_system_;
 
-    // the inner gmres
-    Gmres preconditioner_;
+    // approximately inverts the linear system
+    std::unique_ptr<Preconditioner> preconditioner_;
 
 public:  // this has to be public to access from inside kernels
     // memory
@@ -118,17 +190,32 @@ public:  // this has to be public to access from inside kernels
 
     // least squares problem
     Ibis::Matrix<Ibis::real, HostExecSpace> H0_;
-    Ibis::Matrix<Ibis::real, HostExecSpace> H1_;
-    Ibis::Matrix<Ibis::real, HostExecSpace> Q0_;
-    Ibis::Matrix<Ibis::real, HostExecSpace> Q1_;
-    Ibis::Matrix<Ibis::real, HostExecSpace> Omega_;
     Ibis::Vector<Ibis::real, HostExecSpace> g0_;
-    Ibis::Vector<Ibis::real, HostExecSpace> g1_;
+    Ibis::Vector<Ibis::real, HostExecSpace> cs_;
+    Ibis::Vector<Ibis::real, HostExecSpace> sn_;
+    Ibis::Vector<Ibis::real, HostExecSpace> h_host_;
+    Ibis::Vector<Ibis::real> h_;
     Ibis::Vector<Ibis::real, HostExecSpace> ym_host_;
     Ibis::Vector<Ibis::real> ym_;
-    Ibis::Vector<Ibis::real, HostExecSpace> h_rotated_;
 };
 
+// building blocks shared by the GMRES family of solvers
+void compute_r0_(std::shared_ptr<LinearSystem> system, Ibis::Vector<Ibis::real>& x0,
+                 Ibis::Vector<Ibis::real> r0, Ibis::Vector<Ibis::real> w);
+
+template <typename S>
+void orthogonalise_(Ibis::Matrix<S> krylov_vectors, Ibis::Vector<Ibis::real> w,
+                    Ibis::Matrix<Ibis::real, Ibis::DefaultHostExecSpace> H,
+                    Ibis::Vector<Ibis::real, Ibis::DefaultHostExecSpace> h_host,
+                    Ibis::Vector<Ibis::real> h, Orthogonalisation orthogonalisation,
+                    size_t j);
+
+void apply_rotations_to_hessenberg_(
+    Ibis::Matrix<Ibis::real, Ibis::DefaultHostExecSpace> H,
+    Ibis::Vector<Ibis::real, Ibis::DefaultHostExecSpace> cs,
+    Ibis::Vector<Ibis::real, Ibis::DefaultHostExecSpace> sn,
+    Ibis::Vector<Ibis::real, Ibis::DefaultHostExecSpace> g, size_t j);
+
 std::unique_ptr<IterativeLinearSolver> make_linear_solver(
     std::shared_ptr<LinearSystem> sysmtem, std::shared_ptr<LinearSystem> preconditioner,
     json config);
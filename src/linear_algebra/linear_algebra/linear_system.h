@@ -1,10 +1,14 @@
 #ifndef LINEAR_SYSTEM_H
 #define LINEAR_SYSTEM_H
 
+#include <linear_algebra/block_sparse_matrix.h>
 #include <linear_algebra/dense_linear_algebra.h>
 #include <simulation/simulation.h>
+#include <spdlog/spdlog.h>
 #include <util/numeric_types.h>
 
+class Preconditioner;
+
 class LinearSystem {
 public:
     LinearSystem(){};
@@ -29,6 +33,24 @@ public:
     virtual Ibis::Vector<Ibis::real>& rhs() = 0;
 
     virtual size_t num_vars() const = 0;
+
+    // Some linear systems can assemble their matrix explicitly, which is
+    // required by the assembled preconditioners. allocate_matrix builds a
+    // matrix with the right sparsity pattern, and assemble fills it in.
+    virtual Ibis::BlockSparseMatrix allocate_matrix() {
+        spdlog::error("This linear system can't be assembled");
+        throw std::runtime_error("Linear system can't be assembled");
+    }
+
+    virtual void assemble(Ibis::BlockSparseMatrix& matrix) {
+        (void)matrix;
+        spdlog::error("This linear system can't be assembled");
+        throw std::runtime_error("Linear system can't be assembled");
+    }
+
+    // Some linear systems can build a matrix-free LU-SGS preconditioner
+    // from knowledge of the underlying physics
+    virtual std::unique_ptr<Preconditioner> lusgs_preconditioner();
 };
 
 #endif
@@ -0,0 +1,397 @@
+#include <doctest/doctest.h>
+#include <linear_algebra/preconditioner.h>
+#include <spdlog/spdlog.h>
+
+#include <algorithm>
+
+using ExecSpace = Ibis::BlockSparseMatrix::ExecSpace;
+
+std::unique_ptr<Preconditioner> LinearSystem::lusgs_preconditioner() {
+    spdlog::error("This linear system doesn't provide an LU-SGS preconditioner");
+    throw std::runtime_error("LU-SGS preconditioner not available");
+}
+
+BlockJacobi::BlockJacobi(std::shared_ptr<LinearSystem> system) {
+    system_ = system;
+    matrix_ = system_->allocate_matrix();
+    size_t bs = matrix_.block_size();
+    inverse_diagonal_ = Ibis::BlockSparseMatrix::ValuesType(
+        "BlockJacobi::inverse_diagonal", matrix_.num_block_rows(), bs, bs);
+}
+
+void BlockJacobi::update() {
+    system_->assemble(matrix_);
+    factorise();
+}
+
+void BlockJacobi::factorise() {
+    auto values = matrix_.values();
+    auto diagonal = matrix_.diagonal();
+    auto inverse_diagonal = inverse_diagonal_;
+    size_t bs = matrix_.block_size();
+    Kokkos::parallel_for(
+        "BlockJacobi::factorise",
+        Kokkos::RangePolicy<ExecSpace>(0, matrix_.num_block_rows()),
+        KOKKOS_LAMBDA(const size_t row) {
+            auto diag_block = Kokkos::subview(values, diagonal(row), Kokkos::ALL,
+                                              Kokkos::ALL);
+            auto inv_block =
+                Kokkos::subview(inverse_diagonal, row, Kokkos::ALL, Kokkos::ALL);
+            Ibis::invert_block(diag_block, inv_block, bs);
+        });
+}
+
+void BlockJacobi::apply(Ibis::Vector<Ibis::real>& v, Ibis::Vector<Ibis::real>& z) {
+    auto inverse_diagonal = inverse_diagonal_;
+    size_t bs = matrix_.block_size();
+    Kokkos::parallel_for(
+        "BlockJacobi::apply", Kokkos::RangePolicy<ExecSpace>(0, matrix_.num_block_rows()),
+        KOKKOS_LAMBDA(const size_t row) {
+            for (size_t i = 0; i < bs; i++) {
+                Ibis::real sum = 0.0;
+                for (size_t j = 0; j < bs; j++) {
+                    sum += inverse_diagonal(row, i, j) * v(row * bs + j);
+                }
+                z(row * bs + i) = sum;
+            }
+        });
+}
+
+Ilu0::Ilu0(std::shared_ptr<LinearSystem> system) {
+    system_ = system;
+    matrix_ = system_->allocate_matrix();
+    size_t bs = matrix_.block_size();
+    inverse_diagonal_ = Ibis::BlockSparseMatrix::ValuesType(
+        "Ilu0::inverse_diagonal", matrix_.num_block_rows(), bs, bs);
+    compute_levels_();
+}
+
+void Ilu0::update() {
+    system_->assemble(matrix_);
+    factorise();
+}
+
+// group the rows into levels, given the level of each row
+void group_rows_by_level(const std::vector<size_t>& row_levels,
+                          Ibis::BlockSparseMatrix::IndexType& level_rows,
+                          std::vector<size_t>& level_offsets) {
+    size_t num_levels = 0;
+    for (size_t level : row_levels) {
+        num_levels = std::max(num_levels, level + 1);
+    }
+
+    level_offsets.assign(num_levels + 1, 0);
+    for (size_t level : row_levels) {
+        level_offsets[level + 1]++;
+    }
+    for (size_t level = 0; level < num_levels; level++) {
+        level_offsets[level + 1] += level_offsets[level];
+    }
+
+    level_rows =
+        Ibis::BlockSparseMatrix::IndexType("Ilu0::level_rows", row_levels.size());
+    auto level_rows_host = Kokkos::create_mirror_view(level_rows);
+    std::vector<size_t> next = level_offsets;
+    for (size_t row = 0; row < row_levels.size(); row++) {
+        level_rows_host(next[row_levels[row]]++) = row;
+    }
+    Kokkos::deep_copy(level_rows, level_rows_host);
+}
+
+void Ilu0::compute_levels_() {
+    // A row of the lower triangular solve (and the factorisation) depends
+    // on the rows in its lower triangular part. Similarly for the upper
+    // triangular solve, in reverse.
+    auto device_columns = matrix_.columns();
+    auto columns = device_columns.host_mirror_and_copy();
+    size_t num_rows = matrix_.num_block_rows();
+
+    std::vector<size_t> lower_levels(num_rows, 0);
+    for (size_t row = 0; row < num_rows; row++) {
+        auto row_cols = columns(row);
+        for (size_t i = 0; i < row_cols.size(); i++) {
+            size_t col = row_cols(i);
+            if (col < row) {
+                lower_levels[row] = std::max(lower_levels[row], lower_levels[col] + 1);
+            }
+        }
+    }
+
+    std::vector<size_t> upper_levels(num_rows, 0);
+    for (size_t row = num_rows; row-- > 0;) {
+        auto row_cols = columns(row);
+        for (size_t i = 0; i < row_cols.size(); i++) {
+            size_t col = row_cols(i);
+            if (col > row) {
+                upper_levels[row] = std::max(upper_levels[row], upper_levels[col] + 1);
+            }
+        }
+    }
+
+    group_rows_by_level(lower_levels, lower_level_rows_, lower_level_offsets_);
+    group_rows_by_level(upper_levels, upper_level_rows_, upper_level_offsets_);
+}
+
+void Ilu0::factorise() {
+    auto matrix = matrix_;
+    auto values = matrix_.values();
+    auto columns = matrix_.columns();
+    auto row_offsets = matrix_.row_offsets();
+    auto diagonal = matrix_.diagonal();
+    auto inverse_diagonal = inverse_diagonal_;
+    auto level_rows = lower_level_rows_;
+    size_t bs = matrix_.block_size();
+
+    for (size_t level = 0; level < num_lower_levels(); level++) {
+        Kokkos::parallel_for(
+            "Ilu0::factorise",
+            Kokkos::RangePolicy<ExecSpace>(lower_level_offsets_[level],
+                                           lower_level_offsets_[level + 1]),
+            KOKKOS_LAMBDA(const size_t level_i) {
+                size_t row = level_rows(level_i);
+                auto row_cols = columns(row);
+                size_t first = row_offsets(row);
+                size_t last = first + row_cols.size();
+                Ibis::real l_ik[Ibis::max_block_size][Ibis::max_block_size];
+
+                // the lower blocks are stored before the diagonal
+                for (size_t ik = first; ik < diagonal(row); ik++) {
+                    size_t k = row_cols(ik - first);
+
+                    // L_ik = A_ik U_kk^{-1}
+                    for (size_t i = 0; i < bs; i++) {
+                        for (size_t j = 0; j < bs; j++) {
+                            Ibis::real sum = 0.0;
+                            for (size_t l = 0; l < bs; l++) {
+                                sum += values(ik, i, l) * inverse_diagonal(k, l, j);
+                            }
+                            l_ik[i][j] = sum;
+                        }
+                    }
+                    for (size_t i = 0; i < bs; i++) {
+                        for (size_t j = 0; j < bs; j++) {
+                            values(ik, i, j) = l_ik[i][j];
+                        }
+                    }
+
+                    // A_ij -= L_ik U_kj, for the blocks in the pattern of both rows
+                    for (size_t ij = ik + 1; ij < last; ij++) {
+                        size_t j = row_cols(ij - first);
+                        size_t kj = matrix.block_index(k, j);
+                        if (kj == Ibis::BlockSparseMatrix::invalid_index) continue;
+                        for (size_t a = 0; a < bs; a++) {
+                            for (size_t b = 0; b < bs; b++) {
+                                Ibis::real sum = 0.0;
+                                for (size_t l = 0; l < bs; l++) {
+                                    sum += l_ik[a][l] * values(kj, l, b);
+                                }
+                                values(ij, a, b) -= sum;
+                            }
+                        }
+                    }
+                }
+
+                auto diag_block = Kokkos::subview(values, diagonal(row), Kokkos::ALL,
+                                                  Kokkos::ALL);
+                auto inv_block =
+                    Kokkos::subview(inverse_diagonal, row, Kokkos::ALL, Kokkos::ALL);
+                Ibis::invert_block(diag_block, inv_block, bs);
+            });
+    }
+}
+
+void Ilu0::apply(Ibis::Vector<Ibis::real>& v, Ibis::Vector<Ibis::real>& z) {
+    auto values = matrix_.values();
+    auto columns = matrix_.columns();
+    auto row_offsets = matrix_.row_offsets();
+    auto diagonal = matrix_.diagonal();
+    auto inverse_diagonal = inverse_diagonal_;
+    size_t bs = matrix_.block_size();
+
+    // forward substitution: L y = v
+    auto lower_level_rows = lower_level_rows_;
+    for (size_t level = 0; level < num_lower_levels(); level++) {
+        Kokkos::parallel_for(
+            "Ilu0::forward_substitution",
+            Kokkos::RangePolicy<ExecSpace>(lower_level_offsets_[level],
+                                           lower_level_offsets_[level + 1]),
+            KOKKOS_LAMBDA(const size_t level_i) {
+                size_t row = lower_level_rows(level_i);
+                auto row_cols = columns(row);
+                size_t first = row_offsets(row);
+                Ibis::real sum[Ibis::max_block_size];
+                for (size_t i = 0; i < bs; i++) {
+                    sum[i] = v(row * bs + i);
+                }
+                for (size_t ik = first; ik < diagonal(row); ik++) {
+                    size_t k = row_cols(ik - first);
+                    for (size_t i = 0; i < bs; i++) {
+                        for (size_t j = 0; j < bs; j++) {
+                            sum[i] -= values(ik, i, j) * z(k * bs + j);
+                        }
+                    }
+                }
+                for (size_t i = 0; i < bs; i++) {
+                    z(row * bs + i) = sum[i];
+                }
+            });
+    }
+
+    // backward substitution: U z = y
+    auto upper_level_rows = upper_level_rows_;
+    for (size_t level = 0; level < num_upper_levels(); level++) {
+        Kokkos::parallel_for(
+            "Ilu0::backward_substitution",
+            Kokkos::RangePolicy<ExecSpace>(upper_level_offsets_[level],
+                                           upper_level_offsets_[level + 1]),
+            KOKKOS_LAMBDA(const size_t level_i) {
+                size_t row = upper_level_rows(level_i);
+                auto row_cols = columns(row);
+                size_t first = row_offsets(row);
+                size_t last = first + row_cols.size();
+                Ibis::real sum[Ibis::max_block_size];
+                for (size_t i = 0; i < bs; i++) {
+                    sum[i] = z(row * bs + i);
+                }
+                for (size_t ij = diagonal(row) + 1; ij < last; ij++) {
+                    size_t j = row_cols(ij - first);
+                    for (size_t a = 0; a < bs; a++) {
+                        for (size_t b = 0; b < bs; b++) {
+                            sum[a] -= values(ij, a, b) * z(j * bs + b);
+                        }
+                    }
+                }
+                for (size_t a = 0; a < bs; a++) {
+                    Ibis::real z_a = 0.0;
+                    for (size_t b = 0; b < bs; b++) {
+                        z_a += inverse_diagonal(row, a, b) * sum[b];
+                    }
+                    z(row * bs + a) = z_a;
+                }
+            });
+    }
+}
+
+// A small block tri-diagonal system with 2x2 blocks, which can be assembled
+class TestBlockSystem : public LinearSystem {
+public:
+    TestBlockSystem() {
+        rhs_ = Ibis::Vector<Ibis::real>("rhs", 8);
+        pattern_ = {{0, 1}, {0, 1, 2}, {1, 2, 3}, {2, 3}};
+    }
+
+    ~TestBlockSystem() {}
+
+    void eval_rhs() {}
+
+    void set_rhs(Ibis::Vector<Ibis::real>& rhs) { rhs_ = rhs; }
+
+    void matrix_vector_product(Ibis::Vector<Ibis::real>& vec,
+                               Ibis::Vector<Ibis::real>& res) {
+        Ibis::BlockSparseMatrix matrix = allocate_matrix();
+        assemble(matrix);
+        matrix.multiply(vec, res);
+    }
+
+    std::unique_ptr<LinearSystem> preconditioner() { throw new std::runtime_error(""); }
+
+    KOKKOS_INLINE_FUNCTION
+    Ibis::real& rhs(const size_t i) const { return rhs_(i); }
+
+    KOKKOS_INLINE_FUNCTION
+    Ibis::real& rhs(const size_t i, const size_t j) const {
+        (void)j;
+        return rhs_(i);
+    }
+
+    Ibis::Vector<Ibis::real>& rhs() { return rhs_; }
+
+    size_t num_vars() const { return 8; }
+
+    Ibis::BlockSparseMatrix allocate_matrix() {
+        return Ibis::BlockSparseMatrix(pattern_, 2);
+    }
+
+    void assemble(Ibis::BlockSparseMatrix& matrix) {
+        auto values = Kokkos::create_mirror_view(matrix.values());
+        size_t block = 0;
+        for (size_t row = 0; row < pattern_.size(); row++) {
+            for (size_t col : pattern_[row]) {
+                if (row == col) {
+                    values(block, 0, 0) = 4.0 + row;
+                    values(block, 0, 1) = 1.0;
+                    values(block, 1, 0) = -1.0;
+                    values(block, 1, 1) = 3.0;
+                } else {
+                    values(block, 0, 0) = -1.0;
+                    values(block, 0, 1) = 0.5 * col;
+                    values(block, 1, 0) = 0.25;
+                    values(block, 1, 1) = -1.0;
+                }
+                block++;
+            }
+        }
+        Kokkos::deep_copy(matrix.values(), values);
+    }
+
+private:
+    Ibis::Vector<Ibis::real> rhs_;
+    std::vector<std::vector<size_t>> pattern_;
+};
+
+Ibis::Vector<Ibis::real> test_preconditioner_vector() {
+    Ibis::Vector<Ibis::real> v("v", 8);
+    auto v_h = v.host_mirror();
+    for (size_t i = 0; i < 8; i++) {
+        v_h(i) = 1.0 + 0.5 * i - 0.1 * i * i;
+    }
+    v.deep_copy_space(v_h);
+    return v;
+}
+
+TEST_CASE("Ilu0") {
+    std::shared_ptr<LinearSystem> system{new TestBlockSystem()};
+    Ilu0 ilu(system);
+    ilu.update();
+
+    // a chain of blocks has a dependency between every row
+    CHECK(ilu.num_lower_levels() == 4);
+    CHECK(ilu.num_upper_levels() == 4);
+
+    // block tri-diagonal matrices have no fill in, so ILU(0) is exact
+    auto v = test_preconditioner_vector();
+    Ibis::Vector<Ibis::real> z("z", 8);
+    Ibis::Vector<Ibis::real> Az("Az", 8);
+    ilu.apply(v, z);
+    system->matrix_vector_product(z, Az);
+
+    auto v_h = v.host_mirror();
+    v_h.deep_copy_space(v);
+    auto Az_h = Az.host_mirror();
+    Az_h.deep_copy_space(Az);
+    for (size_t i = 0; i < 8; i++) {
+        CHECK(Az_h(i) == doctest::Approx(v_h(i)));
+    }
+}
+
+TEST_CASE("BlockJacobi") {
+    std::shared_ptr<LinearSystem> system{new TestBlockSystem()};
+    BlockJacobi block_jacobi(system);
+    block_jacobi.update();
+
+    auto v = test_preconditioner_vector();
+    Ibis::Vector<Ibis::real> z("z", 8);
+    block_jacobi.apply(v, z);
+
+    // the diagonal blocks applied to z should give back v
+    auto v_h = v.host_mirror();
+    v_h.deep_copy_space(v);
+    auto z_h = z.host_mirror();
+    z_h.deep_copy_space(z);
+    for (size_t row = 0; row < 4; row++) {
+        Ibis::real z0 = z_h(2 * row);
+        Ibis::real z1 = z_h(2 * row + 1);
+        CHECK((4.0 + row) * z0 + z1 == doctest::Approx(v_h(2 * row)));
+        CHECK(-z0 + 3.0 * z1 == doctest::Approx(v_h(2 * row + 1)));
+    }
+}
@@ -0,0 +1,93 @@
+#ifndef PRECONDITIONER_H
+#define PRECONDITIONER_H
+
+#include <linear_algebra/block_sparse_matrix.h>
+#include <linear_algebra/dense_linear_algebra.h>
+#include <linear_algebra/linear_system.h>
+#include <util/numeric_types.h>
+#include <util/types.h>
+
+#include <Kokkos_Core.hpp>
+#include <memory>
+#include <vector>
+
+// Approximately solves P z = v, where P approximates a linear system
+class Preconditioner {
+public:
+    Preconditioner() {}
+
+    virtual ~Preconditioner() {}
+
+    // prepare the preconditioner for the current state of the linear
+    // system. This is called at the start of each outer linear solve.
+    virtual void update() {}
+
+    virtual void apply(Ibis::Vector<Ibis::real>& v, Ibis::Vector<Ibis::real>& z) = 0;
+};
+
+// Inverts the diagonal blocks of the assembled matrix
+class BlockJacobi : public Preconditioner {
+public:
+    BlockJacobi() {}
+
+    BlockJacobi(std::shared_ptr<LinearSystem> system);
+
+    ~BlockJacobi() {}
+
+    void update();
+
+    void apply(Ibis::Vector<Ibis::real>& v, Ibis::Vector<Ibis::real>& z);
+
+    // compute the inverse of the diagonal blocks of matrix_
+    void factorise();
+
+    Ibis::BlockSparseMatrix& matrix() { return matrix_; }
+
+private:
+    std::shared_ptr<LinearSystem> system_;
+    Ibis::BlockSparseMatrix matrix_;
+    Ibis::BlockSparseMatrix::ValuesType inverse_diagonal_;
+};
+
+// Incomplete block LU factorisation of the assembled matrix, with no fill in.
+// The factorisation and triangular solves are parallelised by level
+// scheduling: the rows in each level only depend on rows in earlier levels.
+class Ilu0 : public Preconditioner {
+public:
+    Ilu0() {}
+
+    Ilu0(std::shared_ptr<LinearSystem> system);
+
+    ~Ilu0() {}
+
+    void update();
+
+    void apply(Ibis::Vector<Ibis::real>& v, Ibis::Vector<Ibis::real>& z);
+
+    // factorise matrix_ in place
+    void factorise();
+
+    Ibis::BlockSparseMatrix& matrix() { return matrix_; }
+
+    size_t num_lower_levels() const { return lower_level_offsets_.size() - 1; }
+
+    size_t num_upper_levels() const { return upper_level_offsets_.size() - 1; }
+
+private:
+    std::shared_ptr<LinearSystem> system_;
+
+    // after factorising, the strictly lower blocks hold L (which has
+    // identity diagonal blocks) and the rest hold U
+    Ibis::BlockSparseMatrix matrix_;
+    Ibis::BlockSparseMatrix::ValuesType inverse_diagonal_;
+
+    // the rows in each level of the lower and upper triangular parts
+    Ibis::BlockSparseMatrix::IndexType lower_level_rows_;
+    Ibis::BlockSparseMatrix::IndexType upper_level_rows_;
+    std::vector<size_t> lower_level_offsets_;
+    std::vector<size_t> upper_level_offsets_;
+
+    void compute_levels_();
+};
+
+#endif
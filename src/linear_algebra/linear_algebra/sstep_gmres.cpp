@@ -0,0 +1,822 @@
+#include <doctest/doctest.h>
+#include <linear_algebra/dense_linear_algebra.h>
+#include <linear_algebra/linear_system.h>
+#include <linear_algebra/sstep_gmres.h>
+#include <linear_algebra/test_linear_system.h>
+#include <spdlog/spdlog.h>
+#include <util/profile.h>
+
+#include <cmath>
+#include <limits>
+
+using HostExecSpace = Ibis::DefaultHostExecSpace;
+
+// If the component of a new basis vector orthogonal to the existing basis
+// is smaller than this (relative to the vector), the basis has lost rank
+constexpr Ibis::real sstep_rank_tolerance = 1e-10;
+
+// The R factors of the TSQR blocks are stacked and factorised serially on
+// the host, so the number of blocks is capped to keep that step small on
+// devices with a lot of concurrency
+constexpr size_t max_tsqr_blocks = 64;
+
+// the maximum number of QR iterations per eigenvalue
+constexpr int max_eigenvalue_iters = 30;
+
+// Householder QR factorisation of rows [first, last) of the first n_cols
+// columns of A, in place. R is left in the upper triangle of the first
+// n_cols rows, and the Householder vectors below it, with an implicit
+// unit first entry. The scale factor of each reflector is stored in tau,
+// starting at tau_offset. This works on the host and device.
+template <class MatrixType, class TauType>
+KOKKOS_INLINE_FUNCTION void householder_qr_(const MatrixType& A, const TauType& tau,
+                                            size_t first, size_t last, size_t n_cols,
+                                            size_t tau_offset) {
+    for (size_t c = 0; c < n_cols; c++) {
+        size_t pivot = first + c;
+        Ibis::real alpha = A(pivot, c);
+        Ibis::real sigma = 0.0;
+        for (size_t r = pivot + 1; r < last; r++) {
+            sigma += A(r, c) * A(r, c);
+        }
+        if (sigma == 0.0) {
+            tau(tau_offset + c) = 0.0;
+            continue;
+        }
+
+        Ibis::real norm = Kokkos::sqrt(alpha * alpha + sigma);
+        Ibis::real beta = (alpha > 0.0) ? -norm : norm;
+        Ibis::real scale = 1.0 / (alpha - beta);
+        for (size_t r = pivot + 1; r < last; r++) {
+            A(r, c) *= scale;
+        }
+        Ibis::real t = (beta - alpha) / beta;
+        tau(tau_offset + c) = t;
+        A(pivot, c) = beta;
+
+        // apply the reflector to the remaining columns
+        for (size_t k = c + 1; k < n_cols; k++) {
+            Ibis::real w = A(pivot, k);
+            for (size_t r = pivot + 1; r < last; r++) {
+                w += A(r, c) * A(r, k);
+            }
+            w *= t;
+            A(pivot, k) -= w;
+            for (size_t r = pivot + 1; r < last; r++) {
+                A(r, k) -= w * A(r, c);
+            }
+        }
+    }
+}
+
+// Apply the Householder reflectors computed by householder_qr_ to the
+// first n_cols columns of rows [first, last) of W, in reverse order. If
+// W starts as the first n_cols columns of the identity, this forms the
+// orthonormal factor explicitly.
+template <class ReflectorType, class TauType, class MatrixType>
+KOKKOS_INLINE_FUNCTION void householder_apply_(const ReflectorType& A, const TauType& tau,
+                                               const MatrixType& W, size_t first,
+                                               size_t last, size_t n_cols,
+                                               size_t tau_offset) {
+    for (size_t c = n_cols; c-- > 0;) {
+        size_t pivot = first + c;
+        Ibis::real t = tau(tau_offset + c);
+        if (t == 0.0) continue;
+        for (size_t k = 0; k < n_cols; k++) {
+            Ibis::real w = W(pivot, k);
+            for (size_t r = pivot + 1; r < last; r++) {
+                w += A(r, c) * W(r, k);
+            }
+            w *= t;
+            W(pivot, k) -= w;
+            for (size_t r = pivot + 1; r < last; r++) {
+                W(r, k) -= w * A(r, c);
+            }
+        }
+    }
+}
+
+bool hessenberg_eigenvalues_(Ibis::Matrix<Ibis::real, HostExecSpace> H, size_t n,
+                             std::vector<Ibis::real>& re, std::vector<Ibis::real>& im) {
+    re.assign(n, 0.0);
+    im.assign(n, 0.0);
+
+    // a norm of H, used to decide when sub-diagonal entries are negligible
+    Ibis::real anorm = 0.0;
+    for (size_t i = 0; i < n; i++) {
+        for (size_t j = (i > 0) ? i - 1 : 0; j < n; j++) {
+            anorm += Ibis::abs(H(i, j));
+        }
+    }
+
+    // the shifted QR algorithm, with Francis double shifts, deflating one
+    // (real) or two (real or complex pair) eigenvalues at a time from the
+    // bottom of the matrix
+    int nn = static_cast<int>(n) - 1;
+    Ibis::real t = 0.0;
+    while (nn >= 0) {
+        int its = 0;
+        int l;
+        do {
+            // look for a single small sub-diagonal element
+            for (l = nn; l >= 1; l--) {
+                Ibis::real s = Ibis::abs(H(l - 1, l - 1)) + Ibis::abs(H(l, l));
+                if (s == 0.0) s = anorm;
+                if (Ibis::abs(H(l, l - 1)) + s == s) {
+                    H(l, l - 1) = 0.0;
+                    break;
+                }
+            }
+            Ibis::real x = H(nn, nn);
+            if (l == nn) {
+                // one root found
+                re[nn] = x + t;
+                im[nn] = 0.0;
+                nn--;
+                continue;
+            }
+
+            Ibis::real y = H(nn - 1, nn - 1);
+            Ibis::real w = H(nn, nn - 1) * H(nn - 1, nn);
+            if (l == nn - 1) {
+                // two roots found
+                Ibis::real p = 0.5 * (y - x);
+                Ibis::real q = p * p + w;
+                Ibis::real z = Ibis::sqrt(Ibis::abs(q));
+                x += t;
+                if (q >= 0.0) {
+                    z = p + std::copysign(z, p);
+                    re[nn - 1] = x + z;
+                    re[nn] = (z != 0.0) ? x - w / z : x + z;
+                    im[nn - 1] = 0.0;
+                    im[nn] = 0.0;
+                } else {
+                    re[nn - 1] = x + p;
+                    re[nn] = x + p;
+                    im[nn - 1] = -z;
+                    im[nn] = z;
+                }
+                nn -= 2;
+                continue;
+            }
+
+            // no roots found yet, so do another iteration
+            if (its == max_eigenvalue_iters) return false;
+            if (its == 10 || its == 20) {
+                // exceptional shift
+                t += x;
+                for (int i = 0; i <= nn; i++) {
+                    H(i, i) -= x;
+                }
+                Ibis::real s = Ibis::abs(H(nn, nn - 1)) + Ibis::abs(H(nn - 1, nn - 2));
+                x = 0.75 * s;
+                y = x;
+                w = -0.4375 * s * s;
+            }
+            its++;
+
+            // look for two consecutive small sub-diagonal elements
+            int m;
+            Ibis::real p = 0.0, q = 0.0, r = 0.0, z;
+            for (m = nn - 2; m >= l; m--) {
+                z = H(m, m);
+                r = x - z;
+                Ibis::real s = y - z;
+                p = (r * s - w) / H(m + 1, m) + H(m, m + 1);
+                q = H(m + 1, m + 1) - z - r - s;
+                r = H(m + 2, m + 1);
+                s = Ibis::abs(p) + Ibis::abs(q) + Ibis::abs(r);
+                p /= s;
+                q /= s;
+                r /= s;
+                if (m == l) break;
+                Ibis::real u = Ibis::abs(H(m, m - 1)) * (Ibis::abs(q) + Ibis::abs(r));
+                Ibis::real v = Ibis::abs(p) * (Ibis::abs(H(m - 1, m - 1)) + Ibis::abs(z) +
+                                               Ibis::abs(H(m + 1, m + 1)));
+                if (u + v == v) break;
+            }
+            for (int i = m + 2; i <= nn; i++) {
+                H(i, i - 2) = 0.0;
+                if (i != m + 2) H(i, i - 3) = 0.0;
+            }
+
+            // double QR step on rows l to nn and columns m to nn
+            for (int k = m; k <= nn - 1; k++) {
+                if (k != m) {
+                    p = H(k, k - 1);
+                    q = H(k + 1, k - 1);
+                    r = (k != nn - 1) ? H(k + 2, k - 1) : 0.0;
+                    x = Ibis::abs(p) + Ibis::abs(q) + Ibis::abs(r);
+                    if (x != 0.0) {
+                        p /= x;
+                        q /= x;
+                        r /= x;
+                    }
+                }
+                Ibis::real s = std::copysign(Ibis::sqrt(p * p + q * q + r * r), p);
+                if (s == 0.0) continue;
+                if (k == m) {
+                    if (l != m) H(k, k - 1) = -H(k, k - 1);
+                } else {
+                    H(k, k - 1) = -s * x;
+                }
+                p += s;
+                x = p / s;
+                y = q / s;
+                z = r / s;
+                q /= p;
+                r /= p;
+                for (int j = k; j <= nn; j++) {
+                    p = H(k, j) + q * H(k + 1, j);
+                    if (k != nn - 1) {
+                        p += r * H(k + 2, j);
+                        H(k + 2, j) -= p * z;
+                    }
+                    H(k + 1, j) -= p * y;
+                    H(k, j) -= p * x;
+                }
+                int i_max = (nn < k + 3) ? nn : k + 3;
+                for (int i = l; i <= i_max; i++) {
+                    p = x * H(i, k) + y * H(i, k + 1);
+                    if (k != nn - 1) {
+                        p += z * H(i, k + 2);
+                        H(i, k + 2) -= p * r;
+                    }
+                    H(i, k + 1) -= p * q;
+                    H(i, k) -= p;
+                }
+            }
+        } while (l < nn - 1);
+    }
+    return true;
+}
+
+SStepGmres::SStepGmres(std::shared_ptr<LinearSystem> system, const size_t max_iters,
+                       Ibis::real tol, const size_t s_step) {
+    tol_ = tol;
+    num_vars_ = system->num_vars();
+    max_iters_ = Kokkos::min(num_vars_, max_iters);
+    s_step_ = Kokkos::max(size_t(1), Kokkos::min(s_step, max_iters_));
+
+    // each TSQR block needs at least s_step rows
+    size_t concurrency = Kokkos::DefaultExecutionSpace().concurrency();
+    n_tsqr_blocks_ = Kokkos::min(Kokkos::min(concurrency, max_tsqr_blocks),
+                                 num_vars_ / s_step_);
+    n_tsqr_blocks_ = Kokkos::max(size_t(1), n_tsqr_blocks_);
+
+    // least squares problem
+    H0_ = Ibis::Matrix<Ibis::real, HostExecSpace>("SStepGmres::H0", max_iters_ + 1,
+                                                  max_iters_);
+    H_arnoldi_ = Ibis::Matrix<Ibis::real, HostExecSpace>("SStepGmres::H_arnoldi",
+                                                         max_iters_ + 1, max_iters_);
+    g0_ = Ibis::Vector<Ibis::real, HostExecSpace>("SStepGmres::g0", max_iters_ + 1);
+    cs_ = Ibis::Vector<Ibis::real, HostExecSpace>("SStepGmres::cs", max_iters_);
+    sn_ = Ibis::Vector<Ibis::real, HostExecSpace>("SStepGmres::sn", max_iters_);
+    h_host_ = Ibis::Vector<Ibis::real, HostExecSpace>("SStepGmres::h_h", max_iters_ + 1);
+    h_ = Ibis::Vector<Ibis::real>("SStepGmres::h_d", max_iters_ + 1);
+    ym_host_ =
+        Ibis::Vector<Ibis::real, HostExecSpace>("SStepGmres::ym_h", max_iters_ + 1);
+    ym_ = Ibis::Vector<Ibis::real>("SStepGmres::ym_d", max_iters_ + 1);
+
+    // block orthogonalisation
+    dots_host_ = Ibis::Vector<Ibis::real, HostExecSpace>("SStepGmres::dots",
+                                                         (max_iters_ + 1) * s_step_);
+    C_ = Ibis::Matrix<Ibis::real>("SStepGmres::C", max_iters_ + 1, s_step_);
+    C_host_ = C_.host_mirror();
+    C_total_ = Ibis::Matrix<Ibis::real, HostExecSpace>("SStepGmres::C_total",
+                                                       max_iters_ + 1, s_step_);
+    tau_ = Ibis::Vector<Ibis::real>("SStepGmres::tau", n_tsqr_blocks_ * s_step_);
+    R_stack_ = Ibis::Matrix<Ibis::real>("SStepGmres::R_stack", n_tsqr_blocks_ * s_step_,
+                                        s_step_);
+    R_stack_host_ = R_stack_.host_mirror();
+    Q_stack_host_ = R_stack_.host_mirror();
+    tau_host_ = Ibis::Vector<Ibis::real, HostExecSpace>("SStepGmres::tau_h", s_step_);
+    R_host_ = Ibis::Matrix<Ibis::real, HostExecSpace>("SStepGmres::R", s_step_, s_step_);
+    R_full_ = Ibis::Matrix<Ibis::real, HostExecSpace>("SStepGmres::R_full",
+                                                      max_iters_ + 1, s_step_ + 1);
+    H_new_ = Ibis::Matrix<Ibis::real, HostExecSpace>("SStepGmres::H_new", max_iters_ + 1,
+                                                     s_step_);
+
+    // Krylov subspace and the Newton basis
+    krylov_vectors_ =
+        Ibis::Matrix<Ibis::real>("SStepGmres::krylov_vectors", num_vars_, max_iters_ + 1);
+    newton_vectors_ =
+        Ibis::Matrix<Ibis::real>("SStepGmres::newton_vectors", num_vars_, s_step_ + 1);
+    r0_ = Ibis::Vector<Ibis::real>("SStepGmres::r0", num_vars_);
+    w_ = Ibis::Vector<Ibis::real>("SStepGmres::w", num_vars_);
+    v_ = Ibis::Vector<Ibis::real>("SStepGmres::v", num_vars_);
+
+    system_ = system;
+}
+
+SStepGmres::SStepGmres(std::shared_ptr<LinearSystem> system, json config)
+    : SStepGmres(system, config.at("max_iters"), config.at("tol"), config.at("s_step")) {}
+
+void SStepGmres::compute_shifts_(size_t n_ritz) {
+    // the Ritz values are the eigenvalues of the square part
+    // of the Hessenberg matrix from the first Arnoldi steps
+    Ibis::Matrix<Ibis::real, HostExecSpace> H("SStepGmres::H_ritz", n_ritz, n_ritz);
+    for (size_t i = 0; i < n_ritz; i++) {
+        for (size_t j = 0; j < n_ritz; j++) {
+            H(i, j) = H_arnoldi_(i, j);
+        }
+    }
+    std::vector<Ibis::real> ritz_re;
+    std::vector<Ibis::real> ritz_im;
+    shifts_re_.assign(s_step_, 0.0);
+    shifts_im2_.assign(s_step_, 0.0);
+    if (!hessenberg_eigenvalues_(H, n_ritz, ritz_re, ritz_im)) {
+        // fall back to the monomial basis
+        spdlog::debug("SStepGmres: Ritz values didn't converge, using monomial basis");
+        return;
+    }
+
+    // Leja ordering: start with the largest Ritz value, then repeatedly
+    // pick the one which maximises the product of the distances to those
+    // already chosen. The conjugate of a complex value is taken with it.
+    std::vector<bool> used(n_ritz, false);
+    std::vector<Ibis::real> chosen_re;
+    std::vector<Ibis::real> chosen_im;
+    size_t n_shifts = 0;
+    while (n_shifts < s_step_) {
+        int best = -1;
+        Ibis::real best_score = -std::numeric_limits<Ibis::real>::infinity();
+        for (size_t i = 0; i < n_ritz; i++) {
+            // only consider one of each complex conjugate pair
+            if (used[i] || ritz_im[i] < 0.0) continue;
+            Ibis::real score = 0.0;
+            if (chosen_re.empty()) {
+                score = Ibis::sqrt(ritz_re[i] * ritz_re[i] + ritz_im[i] * ritz_im[i]);
+            } else {
+                for (size_t k = 0; k < chosen_re.size(); k++) {
+                    Ibis::real d_re = ritz_re[i] - chosen_re[k];
+                    Ibis::real d_im = ritz_im[i] - chosen_im[k];
+                    score += std::log(Ibis::sqrt(d_re * d_re + d_im * d_im));
+                }
+            }
+            if (best < 0 || score > best_score) {
+                best = static_cast<int>(i);
+                best_score = score;
+            }
+        }
+        if (best < 0) break;
+
+        used[best] = true;
+        Ibis::real re = ritz_re[best];
+        Ibis::real im = ritz_im[best];
+        chosen_re.push_back(re);
+        chosen_im.push_back(im);
+        shifts_re_[n_shifts] = re;
+        n_shifts++;
+        if (im > 0.0) {
+            chosen_re.push_back(re);
+            chosen_im.push_back(-im);
+            // if there isn't room for the conjugate, only the
+            // real part of the pair is used
+            if (n_shifts < s_step_) {
+                shifts_re_[n_shifts] = re;
+                shifts_im2_[n_shifts] = im * im;
+                n_shifts++;
+            }
+        }
+    }
+}
+
+void SStepGmres::tsqr_(StridedMatrix Y, StridedMatrix Q, size_t n_cols) {
+    size_t n_rows = Y.n_rows();
+    size_t n_blocks = n_tsqr_blocks_;
+    size_t n_stack = n_blocks * n_cols;
+    auto tau = tau_;
+    auto R_stack = R_stack_;
+
+    // factorise each block of rows independently
+    Kokkos::parallel_for(
+        "SStepGmres::tsqr::local_qr", n_blocks, KOKKOS_LAMBDA(const size_t block) {
+            size_t first = block * n_rows / n_blocks;
+            size_t last = (block + 1) * n_rows / n_blocks;
+            householder_qr_(Y, tau, first, last, n_cols, block * n_cols);
+            for (size_t r = 0; r < n_cols; r++) {
+                for (size_t c = 0; c < n_cols; c++) {
+                    R_stack(block * n_cols + r, c) = (c >= r) ? Y(first + r, c) : 0.0;
+                }
+            }
+        });
+
+    // factorise the stacked R factors on the host, and
+    // form the orthonormal factor of the stack
+    R_stack_host_.deep_copy_space(R_stack_);
+    householder_qr_(R_stack_host_, tau_host_, 0, n_stack, n_cols, 0);
+    for (size_t r = 0; r < n_cols; r++) {
+        for (size_t c = 0; c < n_cols; c++) {
+            R_host_(r, c) = (c >= r) ? R_stack_host_(r, c) : 0.0;
+        }
+    }
+    for (size_t r = 0; r < n_stack; r++) {
+        for (size_t c = 0; c < n_cols; c++) {
+            Q_stack_host_(r, c) = (r == c) ? 1.0 : 0.0;
+        }
+    }
+    householder_apply_(R_stack_host_, tau_host_, Q_stack_host_, 0, n_stack, n_cols, 0);
+    R_stack_.deep_copy_space(Q_stack_host_);
+
+    // each block of Q is its reflectors applied to its part of the
+    // orthonormal factor of the stack
+    Kokkos::parallel_for(
+        "SStepGmres::tsqr::form_q", n_blocks, KOKKOS_LAMBDA(const size_t block) {
+            size_t first = block * n_rows / n_blocks;
+            size_t last = (block + 1) * n_rows / n_blocks;
+            for (size_t r = first; r < last; r++) {
+                size_t stack_row = block * n_cols + r - first;
+                for (size_t c = 0; c < n_cols; c++) {
+                    Q(r, c) = (r - first < n_cols) ? R_stack(stack_row, c) : 0.0;
+                }
+            }
+            householder_apply_(Y, tau, Q, first, last, n_cols, block * n_cols);
+        });
+}
+
+size_t SStepGmres::extend_basis_(size_t j, size_t n_new, bool& invariant) {
+    // generate the Newton basis, starting from the last krylov vector
+    auto P = newton_vectors_;
+    auto p0 = P.column(0);
+    auto q_j = krylov_vectors_.column(j);
+    p0.deep_copy_layout(q_j);
+
+    // each column is the product with the one before it, so the products
+    // are done one at a time. Only the reductions are saved, not the
+    // residual evaluations.
+    for (size_t i = 0; i < n_new; i++) {
+        auto p_i = P.column(i);
+        v_.deep_copy_layout(p_i);
+        system_->matrix_vector_product(v_, w_);
+        auto p_next = P.column(i + 1);
+        p_next.deep_copy_layout(w_);
+        Ibis::real shift = shifts_re_[i];
+        Ibis::real shift_im2 = shifts_im2_[i];
+        Kokkos::parallel_for(
+            "SStepGmres::newton_shift", num_vars_, KOKKOS_LAMBDA(const size_t row) {
+                P(row, i + 1) -= shift * P(row, i);
+                if (shift_im2 != 0.0) {
+                    P(row, i + 1) += shift_im2 * P(row, i - 1);
+                }
+            });
+    }
+
+    // block classical Gram-Schmidt against the existing basis, twice
+    auto Y = P.columns(1, n_new + 1);
+    auto Q_old = krylov_vectors_.columns(0, j + 1);
+    for (size_t r = 0; r <= j; r++) {
+        for (size_t c = 0; c < n_new; c++) {
+            C_total_(r, c) = 0.0;
+        }
+    }
+    for (size_t pass = 0; pass < 2; pass++) {
+        Ibis::block_dot(Q_old, Y, dots_host_.data().data());
+        for (size_t r = 0; r <= j; r++) {
+            for (size_t c = 0; c < n_new; c++) {
+                C_host_(r, c) = dots_host_(r * n_new + c);
+                C_total_(r, c) += C_host_(r, c);
+            }
+        }
+        C_.deep_copy_space(C_host_);
+        Ibis::block_axpy(Y, Q_old, C_, -1.0);
+    }
+
+    // orthonormalise the new vectors amongst themselves
+    tsqr_(Y, krylov_vectors_.columns(j + 1, j + 1 + n_new), n_new);
+
+    // A new vector with (almost) no component orthogonal to the previous
+    // vectors means the Krylov subspace is invariant. Its column of the
+    // Hessenberg matrix is still valid, but with a zero sub-diagonal,
+    // and no more vectors can be added after it.
+    size_t n_added = n_new;
+    invariant = false;
+    for (size_t c = 0; c < n_new; c++) {
+        Ibis::real norm2 = 0.0;
+        for (size_t r = 0; r <= j; r++) {
+            norm2 += C_total_(r, c) * C_total_(r, c);
+        }
+        for (size_t r = 0; r <= c; r++) {
+            norm2 += R_host_(r, c) * R_host_(r, c);
+        }
+        if (Ibis::abs(R_host_(c, c)) <= sstep_rank_tolerance * Ibis::sqrt(norm2)) {
+            R_host_(c, c) = 0.0;
+            n_added = c + 1;
+            invariant = true;
+            break;
+        }
+    }
+
+    // The Newton vectors in the orthonormal basis, P = Q R_full.
+    // The first Newton vector is the last krylov vector.
+    size_t m = n_added;
+    for (size_t r = 0; r <= j + m; r++) {
+        for (size_t c = 0; c <= m; c++) {
+            Ibis::real value = 0.0;
+            if (c == 0) {
+                value = (r == j) ? 1.0 : 0.0;
+            } else if (r <= j) {
+                value = C_total_(r, c - 1);
+            } else {
+                value = R_host_(r - j - 1, c - 1);
+            }
+            R_full_(r, c) = value;
+        }
+    }
+
+    // The Newton basis satisfies A P_{0:m-1} = P_{0:m} B, where B has
+    // the shifts on the diagonal, ones on the sub-diagonal, and -im^2
+    // above the second of each complex pair. With the existing Arnoldi
+    // relation for the first j columns, the new columns of the
+    // Hessenberg matrix are
+    //    H_new = (R_full B - H_{:,0:j-1} R_full_{0:j-1,0:m-1}) T^{-1},
+    // where T = R_full_{j:j+m-1,0:m-1} is upper triangular.
+    for (size_t r = 0; r <= j + m; r++) {
+        for (size_t c = 0; c < m; c++) {
+            Ibis::real value = shifts_re_[c] * R_full_(r, c) + R_full_(r, c + 1);
+            if (c > 0) {
+                value -= shifts_im2_[c] * R_full_(r, c - 1);
+            }
+            for (size_t k = 0; k < j; k++) {
+                value -= H_arnoldi_(r, k) * R_full_(k, c);
+            }
+            H_new_(r, c) = value;
+        }
+    }
+    for (size_t c = 0; c < m; c++) {
+        for (size_t k = 0; k < c; k++) {
+            Ibis::real T_kc = R_full_(j + k, c);
+            for (size_t r = 0; r <= j + m; r++) {
+                H_new_(r, c) -= H_new_(r, k) * T_kc;
+            }
+        }
+        Ibis::real T_cc = R_full_(j + c, c);
+        for (size_t r = 0; r <= j + m; r++) {
+            H_new_(r, c) /= T_cc;
+            H_arnoldi_(r, j + c) = H_new_(r, c);
+            H0_(r, j + c) = H_new_(r, c);
+        }
+    }
+    return n_added;
+}
+
+LinearSolveResult SStepGmres::solve(Ibis::Vector<Ibis::real>& x0) {
+    Ibis::ProfileRegion solve_region("SStepGmres::solve");
+
+    // zero out memory
+    H0_.set_to_zero();
+    H_arnoldi_.set_to_zero();
+    g0_.zero();
+
+    // initialise the intial residuals and first krylov vector
+    {
+        Ibis::ProfileRegion region("SStepGmres::matrix_vector_product");
+        compute_r0_(system_, x0, r0_, w_);
+    }
+    Ibis::real beta = Ibis::norm2(r0_);
+    if (beta < min_initial_residual) {
+        // the initial guess already solves the system
+        return LinearSolveResult{true, 0, tol_, beta};
+    }
+    g0_(0) = beta;
+    Ibis::scale(r0_, v_, 1.0 / beta);
+    auto v0 = krylov_vectors_.column(0);
+    v0.deep_copy_layout(v_);
+
+    // The first s steps are standard Arnoldi steps, which
+    // provide the Ritz values for the shifts of the Newton basis
+    LinearSolveResult result{false, 0, tol_, beta};
+    size_t j = 0;
+    size_t n_ritz = s_step_;
+    for (; j < n_ritz; j++) {
+        {
+            Ibis::ProfileRegion region("SStepGmres::matrix_vector_product");
+            system_->matrix_vector_product(v_, w_);
+        }
+        {
+            Ibis::ProfileRegion region("SStepGmres::orthogonalisation");
+            orthogonalise_(krylov_vectors_, w_, H0_, h_host_, h_,
+                           Orthogonalisation::CGS2, j);
+            H0_(j + 1, j) = Ibis::norm2(w_);
+            for (size_t i = 0; i <= j + 1; i++) {
+                H_arnoldi_(i, j) = H0_(i, j);
+            }
+            Ibis::scale(w_, v_, 1.0 / H0_(j + 1, j));
+            auto v_j = krylov_vectors_.column(j + 1);
+            v_j.deep_copy_layout(v_);
+        }
+
+        {
+            Ibis::ProfileRegion region("SStepGmres::least_squares");
+            apply_rotations_to_hessenberg_(H0_, cs_, sn_, g0_, j);
+        }
+        Ibis::real residual = Ibis::abs(g0_(j + 1));
+        result.residual = residual / beta;
+        result.n_iters = j + 1;
+        if (residual < tol_ * beta) {
+            result.success = true;
+            break;
+        }
+    }
+
+    // the remaining iterations are done s at a time
+    if (!result.success && j < max_iters_) {
+        compute_shifts_(n_ritz);
+    }
+    while (!result.success && j < max_iters_) {
+        size_t n_new = Kokkos::min(s_step_, max_iters_ - j);
+        size_t n_added;
+        bool invariant;
+        {
+            Ibis::ProfileRegion region("SStepGmres::extend_basis");
+            n_added = extend_basis_(j, n_new, invariant);
+        }
+        Ibis::ProfileRegion region("SStepGmres::least_squares");
+        for (size_t c = 0; c < n_added; c++, j++) {
+            apply_rotations_to_hessenberg_(H0_, cs_, sn_, g0_, j);
+            Ibis::real residual = Ibis::abs(g0_(j + 1));
+            result.residual = residual / beta;
+            result.n_iters = j + 1;
+            if (residual < tol_ * beta) {
+                result.success = true;
+                break;
+            }
+        }
+        if (invariant) {
+            // the Krylov subspace can't be extended any further
+            spdlog::debug("SStepGmres: breakdown after {} iterations", j);
+            break;
+        }
+    }
+
+    // return the guess, even if we didn't converge
+    size_t n_vectors = result.n_iters;
+    auto H = H0_.sub_matrix(0, n_vectors, 0, n_vectors);
+    auto V = krylov_vectors_.columns(0, n_vectors);
+    auto g = g0_.sub_vector(0, n_vectors);
+    auto ym_host = ym_host_.sub_vector(0, n_vectors);
+    auto ym = ym_.sub_vector(0, n_vectors);
+    {
+        Ibis::ProfileRegion region("SStepGmres::least_squares");
+        Ibis::upper_triangular_solve(H, ym_host, g);
+        ym.deep_copy_space(ym_host);
+    }
+    {
+        Ibis::ProfileRegion region("SStepGmres::update");
+        Ibis::gemv(V, ym, w_);
+        Ibis::add_scaled_vector(x0, w_, 1.0);
+    }
+    Ibis::profile_count("sstep_gmres iterations", result.n_iters);
+
+    return result;
+}
+
+TEST_CASE("hessenberg_eigenvalues") {
+    Ibis::Matrix<Ibis::real, HostExecSpace> H("H", 3, 3);
+    H(0, 0) = 1.0;
+    H(0, 1) = -2.0;
+    H(0, 2) = 0.5;
+    H(1, 0) = 2.0;
+    H(1, 1) = 1.0;
+    H(1, 2) = 0.25;
+    H(2, 2) = 3.0;
+
+    std::vector<Ibis::real> re;
+    std::vector<Ibis::real> im;
+    CHECK(hessenberg_eigenvalues_(H, 3, re, im));
+
+    // the eigenvalues are 3 and 1 +/- 2i, in no particular order
+    size_t n_real = 0;
+    for (size_t i = 0; i < 3; i++) {
+        if (im[i] == 0.0) {
+            n_real++;
+            CHECK(re[i] == doctest::Approx(3.0));
+        } else {
+            CHECK(re[i] == doctest::Approx(1.0));
+            CHECK(Ibis::abs(im[i]) == doctest::Approx(2.0));
+        }
+    }
+    CHECK(n_real == 1);
+}
+
+#ifndef DOCTEST_CONFIG_DISABLE
+namespace {
+
+std::vector<Ibis::real> test_solution_(size_t n) {
+    std::vector<Ibis::real> x_true(n);
+    for (size_t i = 0; i < n; i++) {
+        x_true[i] = 1.0 + 0.1 * i;
+    }
+    return x_true;
+}
+
+void check_solution_(Ibis::Vector<Ibis::real>& x, const std::vector<Ibis::real>& x_true) {
+    auto x_h = x.host_mirror();
+    x_h.deep_copy_space(x);
+    for (size_t i = 0; i < x_true.size(); i++) {
+        CHECK(x_h(i) == doctest::Approx(x_true[i]));
+    }
+}
+
+}  // namespace
+
+TEST_CASE("s-step GMRES") {
+    // a non-symmetric tri-diagonal matrix
+    constexpr size_t n = 20;
+    auto matrix = tridiagonal_test_matrix(n, -1.0, 2.0, -0.5);
+    std::vector<Ibis::real> x_true = test_solution_(n);
+    std::vector<Ibis::real> rhs = test_rhs(matrix, x_true);
+    std::shared_ptr<LinearSystem> sys{new TestLinearSystem(matrix, rhs)};
+
+    SStepGmres solver{sys, n, 1e-10, 4};
+    Ibis::Vector<Ibis::real> x{"x", n};
+    LinearSolveResult result = solver.solve(x);
+
+    CHECK(result.success == true);
+    CHECK(solver.s_step() == 4);
+    check_solution_(x, x_true);
+}
+
+TEST_CASE("s-step GMRES with complex shifts") {
+    // 2x2 blocks [a, b; -b, a], with eigenvalues a +/- ib, so the
+    // Ritz values from the first two Arnoldi steps are a complex pair
+    constexpr size_t n = 20;
+    std::vector<std::vector<Ibis::real>> matrix(n, std::vector<Ibis::real>(n, 0.0));
+    for (size_t k = 0; k < n / 2; k++) {
+        Ibis::real a = 2.0 + 0.1 * k;
+        Ibis::real b = 1.0 + 0.05 * k;
+        matrix[2 * k][2 * k] = a;
+        matrix[2 * k][2 * k + 1] = b;
+        matrix[2 * k + 1][2 * k] = -b;
+        matrix[2 * k + 1][2 * k + 1] = a;
+    }
+    std::vector<Ibis::real> x_true = test_solution_(n);
+    std::vector<Ibis::real> rhs = test_rhs(matrix, x_true);
+    std::shared_ptr<LinearSystem> sys{new TestLinearSystem(matrix, rhs)};
+
+    SStepGmres solver{sys, n, 1e-10, 2};
+    Ibis::Vector<Ibis::real> x{"x", n};
+    LinearSolveResult result = solver.solve(x);
+
+    CHECK(result.success == true);
+    CHECK(result.n_iters > solver.s_step());
+    CHECK(solver.num_complex_shifts() == 2);
+    check_solution_(x, x_true);
+}
+
+TEST_CASE("s-step GMRES breakdown") {
+    // Four distinct eigenvalues, so the Krylov subspace is invariant after
+    // four vectors. With s = 2, the fourth vector is the last of the first
+    // Newton block. With no tolerance to stop at, the solve has to notice
+    // the breakdown, and still return the exact solution.
+    constexpr size_t n = 12;
+    std::vector<std::vector<Ibis::real>> matrix(n, std::vector<Ibis::real>(n, 0.0));
+    for (size_t i = 0; i < n; i++) {
+        matrix[i][i] = 1.0 + i % 4;
+    }
+    std::vector<Ibis::real> x_true = test_solution_(n);
+    std::vector<Ibis::real> rhs = test_rhs(matrix, x_true);
+    std::shared_ptr<LinearSystem> sys{new TestLinearSystem(matrix, rhs)};
+
+    SStepGmres solver{sys, n, 0.0, 2};
+    Ibis::Vector<Ibis::real> x{"x", n};
+    LinearSolveResult result = solver.solve(x);
+
+    CHECK(result.success == false);
+    CHECK(result.n_iters == 4);
+    check_solution_(x, x_true);
+}
+
+TEST_CASE("restarted s-step GMRES") {
+    // the tri-diagonal matrix again, with too few iterations per solve to
+    // converge, so each solve restarts from the last one's solution
+    constexpr size_t n = 20;
+    auto matrix = tridiagonal_test_matrix(n, -1.0, 2.0, -0.5);
+    std::vector<Ibis::real> x_true = test_solution_(n);
+    std::vector<Ibis::real> rhs = test_rhs(matrix, x_true);
+    std::shared_ptr<LinearSystem> sys{new TestLinearSystem(matrix, rhs)};
+
+    SStepGmres solver{sys, 6, 1e-10, 2};
+    Ibis::Vector<Ibis::real> x{"x", n};
+    LinearSolveResult result = solver.solve(x);
+    CHECK(result.success == false);
+    CHECK(result.n_iters == 6);
+
+    // Each solve's residual is relative to the residual it started from,
+    // so their product is the residual relative to the first one. The
+    // symmetric part of the matrix is positive definite, so every
+    // restart makes progress.
+    Ibis::real total_residual = result.residual;
+    size_t n_restarts = 0;
+    while (total_residual > 1e-10 && n_restarts < 100) {
+        result = solver.solve(x);
+        CHECK(result.residual < 1.0);
+        total_residual *= result.residual;
+        n_restarts++;
+    }
+
+    CHECK(total_residual <= 1e-10);
+    CHECK(n_restarts > 1);
+    check_solution_(x, x_true);
+}
+#endif
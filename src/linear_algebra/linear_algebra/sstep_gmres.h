@@ -0,0 +1,148 @@
+#ifndef SSTEP_GMRES_H
+#define SSTEP_GMRES_H
+
+#include <linear_algebra/dense_linear_algebra.h>
+#include <linear_algebra/gmres.h>
+#include <linear_algebra/linear_system.h>
+#include <util/numeric_types.h>
+#include <util/types.h>
+
+#include <Kokkos_Core.hpp>
+#include <nlohmann/json.hpp>
+#include <vector>
+
+using json = nlohmann::json;
+
+// Communication avoiding (s-step) GMRES. Instead of orthogonalising each
+// Krylov vector as it is generated, s vectors are generated with s matrix
+// vector products using a Newton basis,
+//     p_{i+1} = (A - theta_i I) p_i,
+// and then orthogonalised as a block: once against the existing basis
+// with block classical Gram-Schmidt (applied twice), and then amongst
+// themselves with a tall-skinny QR factorisation (TSQR). This needs a
+// fixed number of global reductions per s iterations, instead of O(s^2)
+// for modified Gram-Schmidt. The Hessenberg matrix is recovered from the
+// change of basis and the R factors.
+//
+// The shifts theta_i are the Ritz values from s standard Arnoldi steps at
+// the start of each solve, in Leja order. Complex conjugate pairs are
+// applied together, so everything stays in real arithmetic.
+//
+// Each vector of the Newton basis depends on the one before, so the
+// matrix vector products are still one at a time.
+class SStepGmres : public IterativeLinearSolver {
+public:
+    using HostExecSpace = Ibis::DefaultHostExecSpace;
+
+    // a block of columns of a larger matrix
+    using StridedMatrix =
+        Ibis::Matrix<Ibis::real, Ibis::DefaultExecSpace, Kokkos::LayoutStride>;
+
+public:
+    SStepGmres() {}
+
+    ~SStepGmres() {}
+
+    SStepGmres(std::shared_ptr<LinearSystem> system, const size_t max_iters,
+               Ibis::real tol, const size_t s_step);
+
+    SStepGmres(std::shared_ptr<LinearSystem> system, json config);
+
+    LinearSolveResult solve(Ibis::Vector<Ibis::real>& x0);
+
+    Ibis::real tol() const { return tol_; }
+
+    void set_tol(Ibis::real tol) { tol_ = tol; }
+
+    size_t s_step() const { return s_step_; }
+
+    // the number of shifts of the Newton basis which are part of a
+    // complex conjugate pair, from the last solve which needed them
+    size_t num_complex_shifts() const {
+        size_t n_complex = 0;
+        for (Ibis::real im2 : shifts_im2_) {
+            if (im2 != 0.0) n_complex += 2;
+        }
+        return n_complex;
+    }
+
+private:
+    // configuration
+    size_t max_iters_;
+    size_t num_vars_;
+    size_t s_step_;
+    Ibis::real tol_;
+    std::shared_ptr<LinearSystem> system_;
+
+    // the number of TSQR blocks the rows are split into
+    size_t n_tsqr_blocks_;
+
+    // the shifts of the Newton basis. For a complex conjugate pair
+    // re +/- i im, both shifts have real part re, and im^2 is stored
+    // with the second of the pair.
+    std::vector<Ibis::real> shifts_re_;
+    std::vector<Ibis::real> shifts_im2_;
+
+    void compute_shifts_(size_t n_ritz);
+
+public:  // these are public to appease NVCC
+    // generate, orthogonalise and add up to n_new vectors to the basis,
+    // after the last vector, j. Returns the number actually added, which
+    // may be fewer if the Krylov subspace becomes invariant. invariant is
+    // set if it does, even if that happens with the last of the n_new.
+    size_t extend_basis_(size_t j, size_t n_new, bool& invariant);
+
+    // Tall-skinny QR factorisation of the first n_cols columns of Y,
+    // storing the orthonormal factor in Q and the triangular factor
+    // in R_host_
+    void tsqr_(StridedMatrix Y, StridedMatrix Q, size_t n_cols);
+
+public:  // this has to be public to access from inside kernels
+    // memory
+    Ibis::Matrix<Ibis::real> krylov_vectors_;
+    Ibis::Matrix<Ibis::real> newton_vectors_;
+    Ibis::Vector<Ibis::real> v_;
+    Ibis::Vector<Ibis::real> r0_;
+    Ibis::Vector<Ibis::real> w_;
+
+    // block Gram-Schmidt coefficients
+    Ibis::Vector<Ibis::real, HostExecSpace> dots_host_;
+    Ibis::Matrix<Ibis::real> C_;
+    Ibis::Matrix<Ibis::real, HostExecSpace, Ibis::DefaultArrayLayout> C_host_;
+    Ibis::Matrix<Ibis::real, HostExecSpace> C_total_;
+
+    // TSQR. The R factors of each block are stacked in R_stack_, which
+    // is then overwritten by the orthonormal factor of the stack
+    Ibis::Vector<Ibis::real> tau_;
+    Ibis::Matrix<Ibis::real> R_stack_;
+    Ibis::Matrix<Ibis::real, HostExecSpace, Ibis::DefaultArrayLayout> R_stack_host_;
+    Ibis::Matrix<Ibis::real, HostExecSpace, Ibis::DefaultArrayLayout> Q_stack_host_;
+    Ibis::Vector<Ibis::real, HostExecSpace> tau_host_;
+    Ibis::Matrix<Ibis::real, HostExecSpace> R_host_;
+
+    // the new vectors expressed in the orthonormal basis, and
+    // the new columns of the Hessenberg matrix
+    Ibis::Matrix<Ibis::real, HostExecSpace> R_full_;
+    Ibis::Matrix<Ibis::real, HostExecSpace> H_new_;
+
+    // least squares problem. H_arnoldi_ is the Hessenberg matrix, and
+    // H0_ is progressively rotated into upper triangular form
+    Ibis::Matrix<Ibis::real, HostExecSpace> H0_;
+    Ibis::Matrix<Ibis::real, HostExecSpace> H_arnoldi_;
+    Ibis::Vector<Ibis::real, HostExecSpace> g0_;
+    Ibis::Vector<Ibis::real, HostExecSpace> cs_;
+    Ibis::Vector<Ibis::real, HostExecSpace> sn_;
+    Ibis::Vector<Ibis::real, HostExecSpace> h_host_;
+    Ibis::Vector<Ibis::real> h_;
+    Ibis::Vector<Ibis::real, HostExecSpace> ym_host_;
+    Ibis::Vector<Ibis::real> ym_;
+};
+
+// The eigenvalues of the upper Hessenberg matrix H (n x n), computed with
+// the shifted QR algorithm. H is overwritten. Returns false if the
+// iterations didn't converge.
+bool hessenberg_eigenvalues_(Ibis::Matrix<Ibis::real, Ibis::DefaultHostExecSpace> H,
+                             size_t n, std::vector<Ibis::real>& re,
+                             std::vector<Ibis::real>& im);
+
+#endif
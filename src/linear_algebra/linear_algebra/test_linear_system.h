@@ -0,0 +1,95 @@
+#ifndef TEST_LINEAR_SYSTEM_H
+#define TEST_LINEAR_SYSTEM_H
+
+#include <linear_algebra/dense_linear_algebra.h>
+#include <linear_algebra/linear_system.h>
+
+#include <memory>
+#include <stdexcept>
+#include <vector>
+
+// A small dense linear system, for testing the linear solvers.
+// The matrix is given by rows.
+class TestLinearSystem : public LinearSystem {
+public:
+    using ExecSpace = Kokkos::DefaultExecutionSpace;
+
+    TestLinearSystem(const std::vector<std::vector<Ibis::real>>& matrix,
+                     const std::vector<Ibis::real>& rhs) {
+        n_ = rhs.size();
+        matrix_ = Ibis::Matrix<Ibis::real, ExecSpace>("A", n_, n_);
+        auto matrix_h = matrix_.host_mirror();
+        for (size_t i = 0; i < n_; i++) {
+            for (size_t j = 0; j < n_; j++) {
+                matrix_h(i, j) = matrix[i][j];
+            }
+        }
+        matrix_.deep_copy_space(matrix_h);
+
+        rhs_ = Ibis::Vector<Ibis::real, ExecSpace>("rhs", n_);
+        auto rhs_h = rhs_.host_mirror();
+        for (size_t i = 0; i < n_; i++) {
+            rhs_h(i) = rhs[i];
+        }
+        rhs_.deep_copy_space(rhs_h);
+    }
+
+    ~TestLinearSystem() {}
+
+    void eval_rhs() {}
+
+    void set_rhs(Ibis::Vector<Ibis::real>& rhs) { rhs_ = rhs; }
+
+    void matrix_vector_product(Ibis::Vector<Ibis::real>& vec,
+                               Ibis::Vector<Ibis::real>& res) {
+        Ibis::gemv(matrix_, vec, res);
+    }
+
+    std::unique_ptr<LinearSystem> preconditioner() { throw new std::runtime_error(""); }
+
+    KOKKOS_INLINE_FUNCTION
+    Ibis::real& rhs(const size_t i) const { return rhs_(i); }
+
+    KOKKOS_INLINE_FUNCTION
+    Ibis::real& rhs(const size_t i, const size_t j) const {
+        (void)j;
+        return rhs_(i);
+    }
+
+    Ibis::Vector<Ibis::real>& rhs() { return rhs_; }
+
+    size_t num_vars() const { return n_; }
+
+private:
+    size_t n_;
+    Ibis::Matrix<Ibis::real, ExecSpace> matrix_;
+    Ibis::Vector<Ibis::real, ExecSpace> rhs_;
+};
+
+// An n x n tri-diagonal matrix, with the same values on each diagonal
+inline std::vector<std::vector<Ibis::real>> tridiagonal_test_matrix(size_t n,
+                                                                    Ibis::real lower,
+                                                                    Ibis::real diagonal,
+                                                                    Ibis::real upper) {
+    std::vector<std::vector<Ibis::real>> matrix(n, std::vector<Ibis::real>(n, 0.0));
+    for (size_t i = 0; i < n; i++) {
+        matrix[i][i] = diagonal;
+        if (i > 0) matrix[i][i - 1] = lower;
+        if (i < n - 1) matrix[i][i + 1] = upper;
+    }
+    return matrix;
+}
+
+// The right hand side for which x is the solution
+inline std::vector<Ibis::real> test_rhs(
+    const std::vector<std::vector<Ibis::real>>& matrix, const std::vector<Ibis::real>& x) {
+    std::vector<Ibis::real> rhs(x.size(), 0.0);
+    for (size_t i = 0; i < x.size(); i++) {
+        for (size_t j = 0; j < x.size(); j++) {
+            rhs[i] += matrix[i][j] * x[j];
+        }
+    }
+    return rhs;
+}
+
+#endif
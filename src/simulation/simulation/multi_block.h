@@ -0,0 +1,142 @@
+#ifndef MULTI_BLOCK_H
+#define MULTI_BLOCK_H
+
+#include <finite_volume/conserved_quantities.h>
+#include <gas/flow_state.h>
+#include <grid/grid.h>
+#include <simulation/simulation.h>
+#include <util/field.h>
+#include <util/numeric_types.h>
+
+#include <Kokkos_Core.hpp>
+#include <nlohmann/json.hpp>
+#include <vector>
+
+using json = nlohmann::json;
+
+// A grid split into several blocks (see grid/partition.h), each with its
+// own Sim. The ghost cells on the faces between blocks are filled from the
+// flow in the neighbouring block by exchange_halos. For second order
+// reconstruction and viscous fluxes, compute_dudt also gives those ghost
+// cells the gradients (and limiters) of the cells they stand in for, part
+// way through evaluating the residuals, so the residuals of each block
+// are the same as those of the whole grid.
+//
+// When running on several processes, the blocks are shared out between
+// them, with each process holding a contiguous range of blocks, and the
+// halos between processes are passed through Ibis::exchange. Only the
+// first process holds the flow of the whole grid, which scatter and
+// gather pass to and from the other processes. Every process still
+// needs the whole grid to build its blocks from.
+//
+// With a single block the Sim is built directly on the whole grid, so the
+// flow of the block is the flow of the whole grid, and scatter and gather
+// have nothing to do.
+template <typename T>
+class MultiBlock {
+public:
+    MultiBlock() {}
+
+    // split grid into config["grid"]["num_blocks"] blocks (or one block
+    // per process, if there are more processes than that)
+    MultiBlock(GridBlock<T> grid, json config);
+
+    // the number of blocks on this process
+    size_t num_blocks() const { return sims_.size(); }
+
+    Sim<T>& sim(size_t block_i) { return sims_[block_i]; }
+
+    const Sim<T>& sim(size_t block_i) const { return sims_[block_i]; }
+
+    // copy the flow next to the faces between blocks into the ghost cells
+    // on the other side of the faces
+    void exchange_halos(const std::vector<FlowStates<T>>& block_flows) const;
+
+    // the time derivatives of the conserved quantities of every block
+    // (of a static grid), including the exchange of the halos
+    void compute_dudt(std::vector<FlowStates<T>>& block_flows,
+                      std::vector<ConservedQuantities<T>>& dudts);
+
+    // copy the flow of the whole grid to the flow of each block, and back
+    void scatter(const FlowStates<T>& flow,
+                 const std::vector<FlowStates<T>>& block_flows) const;
+    void gather(const std::vector<FlowStates<T>>& block_flows,
+                const FlowStates<T>& flow) const;
+
+    // the stable time step of the whole grid
+    Ibis::real estimate_dt(const std::vector<FlowStates<T>>& block_flows);
+
+    // the number of bad cells in the whole grid
+    size_t count_bad_cells(const std::vector<FlowStates<T>>& block_flows);
+
+    // the L2 norms over the whole grid
+    ConservedQuantitiesNorm<T> L2_norms(const std::vector<ConservedQuantities<T>>& cqs);
+
+private:
+    using buffer_type = Kokkos::View<T**>;
+
+    std::vector<Sim<T>> sims_;
+
+    // whether the ghost cells between blocks need gradients
+    // for the reconstruction, or the viscous fluxes
+    bool reconstruction_gradients_ = false;
+    bool viscous_gradients_ = false;
+
+    // The ghost cells of one block filled from one of its neighbours on
+    // the same process, and the cells in the neighbour they are filled from
+    struct Halo {
+        size_t block;
+        size_t source_block;
+        Field<size_t> ghost_cells;
+        Field<size_t> source_cells;
+    };
+    std::vector<Halo> halos_;
+
+    // The cells of one block which are sent to (or received from) another
+    // process, and where they go in the message
+    struct HaloSegment {
+        size_t block;
+        Field<size_t> cells;
+        size_t offset;
+    };
+
+    // The messages to and from another process, with a row for each cell
+    struct HaloBuffers {
+        buffer_type send;
+        buffer_type recv;
+    };
+
+    // The halos passed to and from another process. The segments are in
+    // the same order on both processes. The gradients (and limiters) have
+    // their own buffers, since there are more of them than flow values.
+    struct HaloNeighbour {
+        size_t rank;
+        std::vector<HaloSegment> send;
+        std::vector<HaloSegment> recv;
+        HaloBuffers flow_buffers;
+        HaloBuffers gradient_buffers;
+    };
+    std::vector<HaloNeighbour> neighbours_;
+
+    // Pass the values packed by pack into the buffers of each neighbouring
+    // process to them, and unpack what they send back
+    template <class Pack, class Unpack>
+    void exchange_neighbours(HaloBuffers HaloNeighbour::*halo_buffers, Pack pack,
+                             Unpack unpack) const;
+
+    // copy the gradients (and limiters) to the ghost cells between blocks,
+    // either those used by the reconstruction or those used by the
+    // viscous fluxes
+    void exchange_gradients(bool viscous) const;
+
+    // the cell in each block of each cell of the block's grid file
+    std::vector<Field<size_t>> block_cells_;
+
+    // The cell in the whole grid of each cell of the grid file of every
+    // block, and the process each block belongs to. Only the first
+    // process keeps global_cells_.
+    std::vector<Field<size_t>> global_cells_;
+    std::vector<size_t> block_ranks_;
+};
+
+#endif
@@ -13,3 +13,4 @@ Sim<T>::Sim(GridBlock<T> grid_, json config) : grid(grid_) {
 
 template struct Sim<Ibis::real>;
 template struct Sim<Ibis::dual>;
+template struct Sim<Ibis::dual4>;
@@ -0,0 +1,17 @@
+#define DOCTEST_CONFIG_IMPLEMENT
+
+#include <doctest/doctest.h>
+#include <util/comm.h>
+
+#include <Kokkos_Core.hpp>
+
+int main(int argc, char* argv[]) {
+    doctest::Context ctx;
+    ctx.applyCommandLine(argc, argv);
+    Ibis::initialise_comm(argc, argv);
+    Kokkos::initialize(argc, argv);
+    int res = ctx.run();
+    Kokkos::finalize();
+    Ibis::finalise_comm();
+    return res;
+}
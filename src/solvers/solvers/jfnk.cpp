@@ -1,14 +1,59 @@
+#include <doctest/doctest.h>
 #include <finite_volume/conserved_quantities.h>
 #include <finite_volume/primative_conserved_conversion.h>
 #include <solvers/jfnk.h>
+#include <spdlog/spdlog.h>
+#include <util/profile.h>
+
+#include <vector>
 
 #include "linear_algebra/gmres.h"
 
-Jfnk::Jfnk(std::shared_ptr<PseudoTransientLinearSystem> system,
-           std::unique_ptr<CflSchedule>&& cfl,
-           std::shared_ptr<ConservedQuantities<Ibis::dual>> residuals, json config) {
+// constants for Eisenstat and Walker's choice 2
+constexpr Ibis::real forcing_term_gamma = 0.9;
+constexpr Ibis::real forcing_term_alpha = 2.0;
+
+// if the forcing term from the previous step was larger than this, it
+// limits how fast the forcing term can decrease
+constexpr Ibis::real forcing_term_safeguard = 0.1;
+
+ForcingTerm string_to_forcing_term(std::string forcing_term) {
+    if (forcing_term == "constant") {
+        return ForcingTerm::Constant;
+    } else if (forcing_term == "eisenstat_walker") {
+        return ForcingTerm::EisenstatWalker;
+    } else {
+        spdlog::error("Unknown forcing term {}", forcing_term);
+        throw std::runtime_error("Unknown forcing term");
+    }
+}
+
+Ibis::real eisenstat_walker_forcing_term(Ibis::real residual_ratio,
+                                         Ibis::real previous_forcing_term,
+                                         Ibis::real min_forcing_term,
+                                         Ibis::real max_forcing_term) {
+    Ibis::real eta =
+        forcing_term_gamma * Kokkos::pow(residual_ratio, forcing_term_alpha);
+
+    // don't let the forcing term drop too quickly, unless
+    // it was already small
+    Ibis::real eta_limit =
+        forcing_term_gamma * Kokkos::pow(previous_forcing_term, forcing_term_alpha);
+    if (eta_limit > forcing_term_safeguard) {
+        eta = Kokkos::max(eta, eta_limit);
+    }
+
+    eta = Kokkos::max(eta, min_forcing_term);
+    return Kokkos::min(eta, max_forcing_term);
+}
+
+template <typename T>
+Jfnk<T>::Jfnk(std::shared_ptr<PseudoTransientLinearSystem> system,
+              std::unique_ptr<CflSchedule>&& cfl,
+              std::shared_ptr<ConservedQuantities<T>> residuals, json config) {
     max_steps_ = config.at("max_steps");
     tolerance_ = config.at("tolerance");
+    warm_start_ = config.at("warm_start");
 
     system_ = system;
     std::shared_ptr<LinearSystem> preconditioner = system_->preconditioner();
@@ -16,53 +61,94 @@ Jfnk::Jfnk(std::shared_ptr<PseudoTransientLinearSystem> system,
         std::dynamic_pointer_cast<PseudoTransientLinearSystem>(preconditioner);
     gmres_ = make_linear_solver(system, preconditioner_, config.at("linear_solver"));
 
+    forcing_term_ = string_to_forcing_term(config.at("forcing_term"));
+    max_forcing_term_ = config.at("max_forcing_term");
+    initial_forcing_term_ = gmres_->tol();
+
     cfl_ = std::move(cfl);
     residual_based_cfl_ = cfl_->residual_based();
     dU_ = Ibis::Vector<Ibis::real>{"dU", system_->num_vars()};
     residuals_ = residuals;
 }
 
-int Jfnk::initialise() {
+template <typename T>
+int Jfnk<T>::initialise() {
     system_->eval_rhs();
     residual_norms_ = residuals_->L2_norms();
     initial_residual_norms_ = residual_norms_;
+    previous_residual_norm_ = -1.0;
     return 0;
 }
 
-void Jfnk::set_pseudo_time_step_size(Ibis::real dt_star) {
+template <typename T>
+Ibis::real Jfnk<T>::forcing_term(Ibis::real residual_norm) const {
+    if (forcing_term_ == ForcingTerm::Constant) {
+        return gmres_->tol();
+    }
+
+    // on the first step there's no convergence rate to go off
+    if (previous_residual_norm_ <= 0.0) {
+        return initial_forcing_term_;
+    }
+
+    // there's no point solving the linear system much more accurately
+    // than is needed to reach the non-linear tolerance
+    Ibis::real relative_residual = Ibis::real_part(relative_residual_norms().global());
+    Ibis::real min_forcing_term = 0.5 * tolerance_ / relative_residual;
+    return eisenstat_walker_forcing_term(residual_norm / previous_residual_norm_,
+                                         gmres_->tol(), min_forcing_term,
+                                         max_forcing_term_);
+}
+
+template <typename T>
+void Jfnk<T>::set_pseudo_time_step_size(Ibis::real dt_star) {
     system_->set_pseudo_time_step(dt_star);
     if (preconditioner_) {
         preconditioner_->set_pseudo_time_step(dt_star);
     }
 }
 
-LinearSolveResult Jfnk::step(std::shared_ptr<Sim<Ibis::dual>>& sim,
-                             ConservedQuantities<Ibis::dual>& cq,
-                             FlowStates<Ibis::dual>& fs, size_t step) {
-    // dU is the change in the solution for the step,
-    // our initial guess for it is zero
-    dU_.zero();
+template <typename T>
+LinearSolveResult Jfnk<T>::step(std::shared_ptr<Sim<T>>& sim, ConservedQuantities<T>& cq,
+                                FlowStates<T>& fs, size_t step) {
+    Ibis::ProfileRegion region("Jfnk::step");
+
+    // dU is the change in the solution for the step. Our initial
+    // guess for it is either zero, or the change from the previous step
+    if (!warm_start_) {
+        dU_.zero();
+    }
 
     // set the time step
     stable_dt_ = sim->fv.estimate_dt(fs, sim->grid, sim->gas_model, sim->trans_prop);
     Ibis::real cfl = calculate_cfl(step);
     set_pseudo_time_step_size(cfl * stable_dt_);
 
+    // choose how accurately to solve the linear system
+    Ibis::real residual_norm = Ibis::real_part(residual_norms_.global());
+    gmres_->set_tol(forcing_term(residual_norm));
+    previous_residual_norm_ = residual_norm;
+    spdlog::debug("Jfnk: step {} linear tolerance {:.2e}", step, gmres_->tol());
+
     // solve the linear system of equations
     last_gmres_result_ = gmres_->solve(dU_);
+    Ibis::profile_count("gmres iterations", last_gmres_result_.n_iters);
 
     // apply the update and calculate the new residuals
     // so we can check non-linear convergence.
     // These residuals get re-used for the next step if we haven't converged.
-    apply_update_(sim, cq, fs);
+    {
+        Ibis::ProfileRegion update_region("Jfnk::apply_update");
+        apply_update_(sim, cq, fs);
+    }
     system_->eval_rhs();
     residual_norms_ = residuals_->L2_norms();
     return last_gmres_result_;
 }
 
-void Jfnk::apply_update_(std::shared_ptr<Sim<Ibis::dual>>& sim,
-                         ConservedQuantities<Ibis::dual>& cq,
-                         FlowStates<Ibis::dual>& fs) {
+template <typename T>
+void Jfnk<T>::apply_update_(std::shared_ptr<Sim<T>>& sim, ConservedQuantities<T>& cq,
+                            FlowStates<T>& fs) {
     auto dU = dU_;
     size_t n_cells = sim->grid.num_cells();
     size_t n_cons = cq.n_conserved();
@@ -70,8 +156,9 @@ void Jfnk::apply_update_(std::shared_ptr<Sim<Ibis::dual>>& sim,
         "Jfnk::apply_update", n_cells, KOKKOS_LAMBDA(const size_t cell_i) {
             const size_t vector_idx = cell_i * n_cons;
             for (size_t cons_i = 0; cons_i < n_cons; cons_i++) {
-                cq(cell_i, cons_i).real() += dU(vector_idx + cons_i);
-                cq(cell_i, cons_i).dual() = 0.0;
+                // this also clears any derivative information
+                Ibis::real cq_i = Ibis::real_part(cq(cell_i, cons_i));
+                cq(cell_i, cons_i) = T(cq_i + dU(vector_idx + cons_i));
             }
         });
     if (sim->grid.moving()) {
@@ -82,8 +169,8 @@ void Jfnk::apply_update_(std::shared_ptr<Sim<Ibis::dual>>& sim,
             "Jfnk::apply_update::grid", n_vertices, KOKKOS_LAMBDA(const size_t vertex_i) {
                 const size_t vector_idx = n_cells * n_cons + vertex_i * dim;
                 for (int dim_i = 0; dim_i < dim; dim_i++) {
-                    vertex_pos(vertex_i, dim_i).real() += dU(vector_idx + dim_i);
-                    vertex_pos(vertex_i, dim_i).dual() = 0.0;
+                    Ibis::real pos_i = Ibis::real_part(vertex_pos(vertex_i, dim_i));
+                    vertex_pos(vertex_i, dim_i) = T(pos_i + dU(vector_idx + dim_i));
                 }
             });
         sim->grid.compute_geometric_data();
@@ -91,3 +178,38 @@ void Jfnk::apply_update_(std::shared_ptr<Sim<Ibis::dual>>& sim,
 
     conserved_to_primatives(cq, fs, sim->gas_model);
 }
+
+template class Jfnk<Ibis::dual>;
+template class Jfnk<Ibis::real>;
+
+TEST_CASE("Eisenstat-Walker forcing term") {
+    // a steadily converging sequence of residual norms, starting from a
+    // forcing term of 0.1. The forcing term follows 0.9 * ratio^2, since
+    // the previous forcing term is always small enough to skip the safeguard.
+    std::vector<Ibis::real> residual_norms{1.0, 0.5, 0.05, 5e-4};
+    std::vector<Ibis::real> expected{0.225, 0.009, 9e-5};
+    Ibis::real eta = 0.1;
+    for (size_t step = 1; step < residual_norms.size(); step++) {
+        CAPTURE(step);
+        Ibis::real ratio = residual_norms[step] / residual_norms[step - 1];
+        eta = eisenstat_walker_forcing_term(ratio, eta, 1e-10, 0.9);
+        CHECK(eta == doctest::Approx(expected[step - 1]));
+    }
+
+    // safeguard: after a large forcing term, 0.9 * 0.9^2 = 0.729 is more
+    // than 0.1, so the forcing term can't drop to 0.9 * 0.1^2 = 0.009
+    CHECK(eisenstat_walker_forcing_term(0.1, 0.9, 1e-10, 0.95) ==
+          doctest::Approx(0.729));
+
+    // but after a smaller one, 0.9 * 0.3^2 = 0.081 is less than 0.1,
+    // so the safeguard isn't applied
+    CHECK(eisenstat_walker_forcing_term(0.1, 0.3, 1e-10, 0.95) ==
+          doctest::Approx(0.009));
+
+    // a growing residual gives 0.9 * 1.2^2 = 1.296, clamped to the maximum
+    CHECK(eisenstat_walker_forcing_term(1.2, 0.1, 1e-10, 0.9) == doctest::Approx(0.9));
+
+    // and the forcing term is never below the minimum
+    CHECK(eisenstat_walker_forcing_term(0.01, 0.01, 1e-3, 0.9) ==
+          doctest::Approx(1e-3));
+}
@@ -16,21 +16,42 @@
 
 using json = nlohmann::json;
 
+// How the tolerance of each linear solve (the forcing term) is chosen
+//   Constant: the tolerance of the linear solver, for every step
+//   EisenstatWalker: choice 2 of Eisenstat and Walker (1996), which solves
+//       loosely while the non-linear residual is dropping slowly, and
+//       tightens the tolerance as the non-linear iterations converge
+enum class ForcingTerm { Constant, EisenstatWalker };
+
+ForcingTerm string_to_forcing_term(std::string forcing_term);
+
+// Choice 2 of Eisenstat and Walker for the next forcing term, given the
+// ratio of the current non-linear residual norm to the previous one, and
+// the previous forcing term. The result is limited to between
+// min_forcing_term and max_forcing_term.
+Ibis::real eisenstat_walker_forcing_term(Ibis::real residual_ratio,
+                                         Ibis::real previous_forcing_term,
+                                         Ibis::real min_forcing_term,
+                                         Ibis::real max_forcing_term);
+
+// T is the number type of the simulation. With dual numbers, the
+// linearisation computes exact Jacobian-vector products; with real
+// numbers it approximates them with finite differences.
+template <typename T>
 class Jfnk {
 public:
     Jfnk() {}
 
     Jfnk(std::shared_ptr<PseudoTransientLinearSystem> system,
          std::unique_ptr<CflSchedule>&&,
-         std::shared_ptr<ConservedQuantities<Ibis::dual>> resiudals, json config);
+         std::shared_ptr<ConservedQuantities<T>> resiudals, json config);
 
     int initialise();
 
-    LinearSolveResult step(std::shared_ptr<Sim<Ibis::dual>>& sim,
-                           ConservedQuantities<Ibis::dual>& cq,
-                           FlowStates<Ibis::dual>& fs, size_t step);
+    LinearSolveResult step(std::shared_ptr<Sim<T>>& sim, ConservedQuantities<T>& cq,
+                           FlowStates<T>& fs, size_t step);
 
-    void solve(std::shared_ptr<Sim<Ibis::dual>>& sim);
+    void solve(std::shared_ptr<Sim<T>>& sim);
 
     size_t max_steps() const { return max_steps_; }
 
@@ -46,9 +67,9 @@ public:
         return cfl;
     }
 
-    ConservedQuantitiesNorm<Ibis::dual> residual_norms() const { return residual_norms_; }
+    ConservedQuantitiesNorm<T> residual_norms() const { return residual_norms_; }
 
-    ConservedQuantitiesNorm<Ibis::dual> relative_residual_norms() const {
+    ConservedQuantitiesNorm<T> relative_residual_norms() const {
         return residual_norms_ / initial_residual_norms_;
     }
 
@@ -56,6 +77,10 @@ public:
 
     const LinearSolveResult& last_gmres_result() const { return last_gmres_result_; }
 
+    // the tolerance for the next linear solve, given
+    // the current global non-linear residual norm
+    Ibis::real forcing_term(Ibis::real residual_norm) const;
+
 private:
     std::shared_ptr<PseudoTransientLinearSystem> system_;
     std::shared_ptr<PseudoTransientLinearSystem> preconditioner_;
@@ -65,19 +90,26 @@ private:
 
     size_t max_steps_;
     Ibis::real tolerance_;
+    bool warm_start_;
     Ibis::real stable_dt_;
 
-    std::shared_ptr<ConservedQuantities<Ibis::dual>> residuals_;
-    ConservedQuantitiesNorm<Ibis::dual> residual_norms_;
-    ConservedQuantitiesNorm<Ibis::dual> initial_residual_norms_;
+    std::shared_ptr<ConservedQuantities<T>> residuals_;
+    ConservedQuantitiesNorm<T> residual_norms_;
+    ConservedQuantitiesNorm<T> initial_residual_norms_;
     LinearSolveResult last_gmres_result_;
     bool residual_based_cfl_;
 
+    // forcing term
+    ForcingTerm forcing_term_;
+    Ibis::real initial_forcing_term_;
+    Ibis::real max_forcing_term_;
+    Ibis::real previous_residual_norm_;
+
     void set_pseudo_time_step_size(Ibis::real dt_star);
 
 public:  // this is public to appease NVCC
-    void apply_update_(std::shared_ptr<Sim<Ibis::dual>>& sim,
-                       ConservedQuantities<Ibis::dual>& cq, FlowStates<Ibis::dual>& fs);
+    void apply_update_(std::shared_ptr<Sim<T>>& sim, ConservedQuantities<T>& cq,
+                       FlowStates<T>& fs);
 };
 
 #endif
@@ -0,0 +1,552 @@
+#include <doctest/doctest.h>
+#include <finite_volume/primative_conserved_conversion.h>
+#include <grid/structured_grid.h>
+#include <solvers/lusgs.h>
+#include <solvers/steady_state.h>
+#include <spdlog/spdlog.h>
+#include <util/numa.h>
+
+#include <algorithm>
+#include <cmath>
+#include <memory>
+#include <vector>
+
+LuSgs::LuSgs(const SteadyStateLinearisation* system, std::shared_ptr<Sim<Ibis::dual>> sim,
+             std::shared_ptr<ConservedQuantities<Ibis::dual>> cq,
+             std::shared_ptr<FlowStates<Ibis::dual>> fs) {
+    if (sim->grid.moving()) {
+        spdlog::error("The LU-SGS preconditioner isn't supported for moving grids");
+        throw std::runtime_error("LU-SGS not supported for moving grids");
+    }
+
+    system_ = system;
+    sim_ = sim;
+    cq_ = cq;
+    fs_ = fs;
+    n_cells_ = sim_->grid.num_cells();
+    n_cons_ = cq_->n_conserved();
+    if (n_cons_ != sim_->grid.dim() + 2) {
+        spdlog::error("LU-SGS expects {} conserved quantities, not {}",
+                      sim_->grid.dim() + 2, n_cons_);
+        throw std::runtime_error("Unsupported conserved quantities for LU-SGS");
+    }
+
+    spectral_radius_ = Ibis::first_touch_view<Kokkos::View<Ibis::real*>>(
+        "LuSgs::spectral_radius", sim_->grid.num_interfaces());
+    diagonal_ =
+        Ibis::first_touch_view<Kokkos::View<Ibis::real*>>("LuSgs::diagonal", n_cells_);
+    compute_colouring_();
+}
+
+void LuSgs::compute_colouring_() {
+    // greedy colouring, so that no two neighbouring cells share a colour
+    size_t n_cells = n_cells_;
+    auto neighbours = sim_->grid.cells().neighbour_cells();
+    auto neighbours_host = neighbours.host_mirror_and_copy();
+    std::vector<size_t> colours(n_cells, 0);
+    std::vector<size_t> forbidden;
+    size_t n_colours = 0;
+    for (size_t cell_i = 0; cell_i < n_cells; cell_i++) {
+        forbidden.assign(n_colours + 1, n_cells);
+        auto cell_neighbours = neighbours_host(cell_i);
+        for (size_t i = 0; i < cell_neighbours.size(); i++) {
+            size_t neighbour = cell_neighbours(i);
+            if (neighbour < cell_i) forbidden[colours[neighbour]] = cell_i;
+        }
+        size_t colour = 0;
+        while (forbidden[colour] == cell_i) colour++;
+        colours[cell_i] = colour;
+        n_colours = std::max(n_colours, colour + 1);
+    }
+
+    // group the cells by colour
+    colour_offsets_.assign(n_colours + 1, 0);
+    for (size_t cell_i = 0; cell_i < n_cells; cell_i++) {
+        colour_offsets_[colours[cell_i] + 1]++;
+    }
+    for (size_t colour = 0; colour < n_colours; colour++) {
+        colour_offsets_[colour + 1] += colour_offsets_[colour];
+    }
+
+    colours_ = Kokkos::View<size_t*>("LuSgs::colours", n_cells);
+    colour_cells_ = Kokkos::View<size_t*>("LuSgs::colour_cells", n_cells);
+    auto colours_host = Kokkos::create_mirror_view(colours_);
+    auto colour_cells_host = Kokkos::create_mirror_view(colour_cells_);
+    std::vector<size_t> next = colour_offsets_;
+    for (size_t cell_i = 0; cell_i < n_cells; cell_i++) {
+        colours_host(cell_i) = colours[cell_i];
+        colour_cells_host(next[colours[cell_i]]++) = cell_i;
+    }
+    Kokkos::deep_copy(colours_, colours_host);
+    Kokkos::deep_copy(colour_cells_, colour_cells_host);
+    spdlog::debug("LU-SGS coloured {} cells with {} colours", n_cells, n_colours);
+}
+
+void LuSgs::update() {
+    auto interfaces = sim_->grid.interfaces();
+    auto cells = sim_->grid.cells();
+    auto cell_faces = cells.faces();
+    auto fs = *fs_;
+    auto gas_model = sim_->gas_model;
+    auto spectral_radius = spectral_radius_;
+    auto diagonal = diagonal_;
+
+    // the largest wave speed either side of each face
+    Kokkos::parallel_for(
+        "LuSgs::spectral_radius", sim_->grid.num_interfaces(),
+        KOKKOS_LAMBDA(const size_t face_i) {
+            Ibis::real nx = Ibis::real_part(interfaces.norm().x(face_i));
+            Ibis::real ny = Ibis::real_part(interfaces.norm().y(face_i));
+            Ibis::real nz = Ibis::real_part(interfaces.norm().z(face_i));
+            Ibis::real lambda = 0.0;
+            size_t sides[2] = {interfaces.left_cell(face_i),
+                               interfaces.right_cell(face_i)};
+            for (size_t side : sides) {
+                Ibis::real vn = Ibis::real_part(fs.vel.x(side)) * nx +
+                                Ibis::real_part(fs.vel.y(side)) * ny +
+                                Ibis::real_part(fs.vel.z(side)) * nz;
+                Ibis::real a = Ibis::real_part(gas_model.speed_of_sound(fs.gas, side));
+                lambda = Kokkos::max(lambda, Ibis::abs(vn) + a);
+            }
+            spectral_radius(face_i) = lambda;
+        });
+
+    // with the split Jacobians, the diagonal block is a multiple of the
+    // identity, since the flux Jacobians integrate to zero over a closed cell
+    Ibis::real dt_star = system_->pseudo_time_step();
+    Kokkos::parallel_for(
+        "LuSgs::diagonal", n_cells_, KOKKOS_LAMBDA(const size_t cell_i) {
+            auto face_ids = cell_faces.face_ids(cell_i);
+            Ibis::real sum = 0.0;
+            for (size_t i = 0; i < face_ids.size(); i++) {
+                size_t face_i = face_ids(i);
+                sum += spectral_radius(face_i) * Ibis::real_part(interfaces.area(face_i));
+            }
+            Ibis::real volume = Ibis::real_part(cells.volume(cell_i));
+            diagonal(cell_i) = 1.0 / dt_star + 0.5 * sum / volume;
+        });
+}
+
+template <int Dim>
+void LuSgs::sweep_(Ibis::Vector<Ibis::real>& v, Ibis::Vector<Ibis::real>& z,
+                   size_t colour, bool forward) {
+    constexpr size_t n_cons = Dim + 2;
+    auto interfaces = sim_->grid.interfaces();
+    auto cells = sim_->grid.cells();
+    auto cell_faces = cells.faces();
+    auto cq = *cq_;
+    auto spectral_radius = spectral_radius_;
+    auto diagonal = diagonal_;
+    auto colours = colours_;
+    auto colour_cells = colour_cells_;
+    size_t n_cells = n_cells_;
+    Ibis::real gamma = Ibis::real_part(sim_->gas_model.gamma());
+    Kokkos::parallel_for(
+        "LuSgs::sweep",
+        Kokkos::RangePolicy<>(colour_offsets_[colour], colour_offsets_[colour + 1]),
+        KOKKOS_LAMBDA(const size_t colour_i) {
+            size_t cell_i = colour_cells(colour_i);
+            auto face_ids = cell_faces.face_ids(cell_i);
+            auto outsigns = cell_faces.outsigns(cell_i);
+            Ibis::real volume = Ibis::real_part(cells.volume(cell_i));
+
+            // sum the off-diagonal blocks applied to the neighbours
+            // which have already been swept
+            Ibis::real sum[n_cons];
+            for (size_t cons_i = 0; cons_i < n_cons; cons_i++) {
+                sum[cons_i] = 0.0;
+            }
+            for (size_t i = 0; i < face_ids.size(); i++) {
+                size_t face_i = face_ids(i);
+                size_t left = interfaces.left_cell(face_i);
+                size_t neighbour =
+                    (left == cell_i) ? interfaces.right_cell(face_i) : left;
+                if (neighbour >= n_cells) continue;
+                size_t neighbour_colour = colours(neighbour);
+                if (forward && neighbour_colour > colour) continue;
+                if (!forward && neighbour_colour < colour) continue;
+
+                Ibis::real u[n_cons];
+                Ibis::real du[n_cons];
+                Ibis::real flux[n_cons];
+                for (size_t cons_i = 0; cons_i < n_cons; cons_i++) {
+                    u[cons_i] = Ibis::real_part(cq(neighbour, cons_i));
+                    du[cons_i] = z(neighbour * n_cons + cons_i);
+                }
+                Ibis::real sign = outsigns(i);
+                Ibis::real nx = sign * Ibis::real_part(interfaces.norm().x(face_i));
+                Ibis::real ny = sign * Ibis::real_part(interfaces.norm().y(face_i));
+                Ibis::real nz = sign * Ibis::real_part(interfaces.norm().z(face_i));
+                euler_flux_jacobian_product(u, du, nx, ny, nz, gamma, Dim, flux);
+
+                Ibis::real factor =
+                    0.5 * Ibis::real_part(interfaces.area(face_i)) / volume;
+                Ibis::real lambda = spectral_radius(face_i);
+                for (size_t cons_i = 0; cons_i < n_cons; cons_i++) {
+                    sum[cons_i] += factor * (flux[cons_i] - lambda * du[cons_i]);
+                }
+            }
+
+            Ibis::real inv_diagonal = 1.0 / diagonal(cell_i);
+            for (size_t cons_i = 0; cons_i < n_cons; cons_i++) {
+                size_t idx = cell_i * n_cons + cons_i;
+                if (forward) {
+                    z(idx) = (v(idx) - sum[cons_i]) * inv_diagonal;
+                } else {
+                    z(idx) -= sum[cons_i] * inv_diagonal;
+                }
+            }
+        });
+}
+
+void LuSgs::apply(Ibis::Vector<Ibis::real>& v, Ibis::Vector<Ibis::real>& z) {
+    Ibis::dispatch_dim(sim_->grid.dim(), [&](auto dim) {
+        constexpr int Dim = decltype(dim)::value;
+
+        // forward sweep: (D + L) y = v
+        for (size_t colour = 0; colour < num_colours(); colour++) {
+            sweep_<Dim>(v, z, colour, true);
+        }
+
+        // backward sweep: (D + U) z = D y
+        for (size_t colour = num_colours(); colour-- > 0;) {
+            sweep_<Dim>(v, z, colour, false);
+        }
+    });
+}
+
+#ifndef DOCTEST_CONFIG_DISABLE
+namespace {
+
+// a first order inviscid simulation of air on grid_io, whose boundaries
+// copy the flow next to them into the ghost cells
+json lusgs_config_(const GridIO& grid_io) {
+    json internal_copy{{"type", "internal_copy"}};
+    json boundaries;
+    for (const auto& [tag, faces] : grid_io.markers()) {
+        boundaries[tag] = {{"ghost_cells", true},
+                           {"pre_reconstruction", json::array({internal_copy})},
+                           {"post_convective_flux", json::array()},
+                           {"pre_viscous_grad", json::array()}};
+    }
+    json grid_config{{"boundaries", boundaries},
+                     {"motion", {{"enabled", false}}},
+                     {"renumber", "none"},
+                     {"cache", false},
+                     {"geometry_cache",
+                      {{"face_weights", true},
+                       {"signed_areas", true},
+                       {"inverse_volumes", true},
+                       {"centre_offsets", true}}}};
+    json convective_flux{{"flux_calculator", {{"type", "hanel"}}},
+                         {"reconstruction_order", 1},
+                         {"fused", false}};
+    json gas_model{{"R", 287.0}, {"Cv", 717.5}, {"Cp", 1004.5}, {"gamma", 1.4}};
+    json transport_properties{
+        {"viscosity",
+         {{"type", "sutherland"}, {"mu_0", 1.716e-5}, {"T_0", 273.0}, {"T_s", 110.4}}},
+        {"thermal_conductivity", {{"type", "constant_prandtl_number"}, {"Pr", 0.72}}}};
+    return json{{"grid", grid_config},
+                {"convective_flux", convective_flux},
+                {"viscous_flux", {{"enabled", false}, {"signal_factor", 1.0}}},
+                {"gas_model", gas_model},
+                {"transport_properties", transport_properties}};
+}
+
+// A smooth flow on a small structured grid, and the steady state system
+// linearised around it, as the steady state solver would set them up
+struct LuSgsTestCase {
+    std::shared_ptr<Sim<Ibis::dual>> sim;
+    std::shared_ptr<ConservedQuantities<Ibis::dual>> cq;
+    std::shared_ptr<FlowStates<Ibis::dual>> fs;
+    std::shared_ptr<SteadyStateLinearisation> system;
+};
+
+LuSgsTestCase lusgs_test_case_(size_t nz) {
+    GridIO grid_io = structured_grid(6, 5, nz);
+    json config = lusgs_config_(grid_io);
+    json grid_config = config.at("grid");
+    GridBlock<Ibis::dual> grid(grid_io, grid_config);
+
+    LuSgsTestCase test;
+    test.sim = std::make_shared<Sim<Ibis::dual>>(grid, config);
+    size_t n_total_cells = test.sim->grid.num_total_cells();
+    size_t dim = test.sim->grid.dim();
+    test.fs = std::make_shared<FlowStates<Ibis::dual>>(n_total_cells);
+    test.cq = std::make_shared<ConservedQuantities<Ibis::dual>>(n_total_cells, dim);
+    auto residuals =
+        std::make_shared<ConservedQuantities<Ibis::dual>>(n_total_cells, dim);
+
+    auto centroids = test.sim->grid.cells().centroids();
+    FlowStates<Ibis::dual> flow = *test.fs;
+    Kokkos::parallel_for(
+        "test::smooth_flow", test.sim->grid.num_cells(), KOKKOS_LAMBDA(const size_t i) {
+            Ibis::real wave = Kokkos::sin(6.0 * Ibis::real_part(centroids.x(i))) *
+                              Kokkos::cos(4.0 * Ibis::real_part(centroids.y(i))) *
+                              Kokkos::cos(3.0 * Ibis::real_part(centroids.z(i)));
+            flow.gas.rho(i) = 1.0 + 0.1 * wave;
+            flow.gas.temp(i) = 300.0 - 20.0 * wave;
+            flow.vel.x(i) = 200.0 + 50.0 * wave;
+            flow.vel.y(i) = 30.0 * wave;
+            flow.vel.z(i) = (nz > 0) ? -20.0 * wave : 0.0;
+        });
+    test.sim->gas_model.update_thermo_from_rhoT(flow.gas);
+    primatives_to_conserved(*test.cq, *test.fs, test.sim->gas_model);
+
+    test.system = std::make_shared<SteadyStateLinearisation>(test.sim, residuals, test.cq,
+                                                             test.fs, nullptr);
+    test.system->set_pseudo_time_step(1e-4);
+    test.system->eval_rhs();
+    return test;
+}
+
+// the real parts of the conserved quantities, on the host
+auto host_conserved_(const ConservedQuantities<Ibis::dual>& cq) {
+    Kokkos::View<Ibis::real**> values("test::conserved", cq.size(), cq.n_conserved());
+    Kokkos::parallel_for(
+        "test::copy_conserved", cq.size(), KOKKOS_LAMBDA(const size_t i) {
+            for (size_t j = 0; j < values.extent(1); j++) {
+                values(i, j) = Ibis::real_part(cq(i, j));
+            }
+        });
+    auto host_values = Kokkos::create_mirror_view(values);
+    Kokkos::deep_copy(host_values, values);
+    return host_values;
+}
+
+using Matrix_ = std::vector<std::vector<Ibis::real>>;
+
+// the Euler flux normal to n, at the conserved state u
+std::vector<Ibis::real> euler_flux_(const std::vector<Ibis::real>& u, Ibis::real nx,
+                                    Ibis::real ny, Ibis::real nz, Ibis::real gamma,
+                                    size_t dim) {
+    Ibis::real rho = u[0];
+    Ibis::real vx = u[1] / rho;
+    Ibis::real vy = u[2] / rho;
+    Ibis::real vz = (dim == 3) ? u[3] / rho : 0.0;
+    Ibis::real E = u[dim + 1];
+    Ibis::real p = (gamma - 1.0) * (E - 0.5 * rho * (vx * vx + vy * vy + vz * vz));
+    Ibis::real vn = vx * nx + vy * ny + vz * nz;
+
+    std::vector<Ibis::real> flux(dim + 2);
+    flux[0] = rho * vn;
+    flux[1] = rho * vx * vn + p * nx;
+    flux[2] = rho * vy * vn + p * ny;
+    if (dim == 3) {
+        flux[3] = rho * vz * vn + p * nz;
+    }
+    flux[dim + 1] = (E + p) * vn;
+    return flux;
+}
+
+// the Jacobian of the Euler flux, by central differences
+Matrix_ euler_flux_jacobian_(const std::vector<Ibis::real>& u, Ibis::real nx,
+                             Ibis::real ny, Ibis::real nz, Ibis::real gamma, size_t dim) {
+    size_t n = u.size();
+    Matrix_ jacobian(n, std::vector<Ibis::real>(n));
+    for (size_t j = 0; j < n; j++) {
+        Ibis::real h = 1e-5 * std::max(std::abs(u[j]), 1.0);
+        std::vector<Ibis::real> u_plus = u;
+        std::vector<Ibis::real> u_minus = u;
+        u_plus[j] += h;
+        u_minus[j] -= h;
+        std::vector<Ibis::real> flux_plus = euler_flux_(u_plus, nx, ny, nz, gamma, dim);
+        std::vector<Ibis::real> flux_minus = euler_flux_(u_minus, nx, ny, nz, gamma, dim);
+        for (size_t i = 0; i < n; i++) {
+            jacobian[i][j] = (flux_plus[i] - flux_minus[i]) / (2.0 * h);
+        }
+    }
+    return jacobian;
+}
+
+// solve a x = b by Gaussian elimination with partial pivoting
+std::vector<Ibis::real> dense_solve_(Matrix_ a, std::vector<Ibis::real> b) {
+    size_t n = b.size();
+    for (size_t k = 0; k < n; k++) {
+        size_t pivot = k;
+        for (size_t i = k + 1; i < n; i++) {
+            if (std::abs(a[i][k]) > std::abs(a[pivot][k])) pivot = i;
+        }
+        std::swap(a[k], a[pivot]);
+        std::swap(b[k], b[pivot]);
+        for (size_t i = k + 1; i < n; i++) {
+            Ibis::real factor = a[i][k] / a[k][k];
+            if (factor == 0.0) continue;
+            for (size_t j = k; j < n; j++) {
+                a[i][j] -= factor * a[k][j];
+            }
+            b[i] -= factor * b[k];
+        }
+    }
+    std::vector<Ibis::real> x(n);
+    for (size_t k = n; k-- > 0;) {
+        Ibis::real sum = b[k];
+        for (size_t j = k + 1; j < n; j++) {
+            sum -= a[k][j] * x[j];
+        }
+        x[k] = sum / a[k][k];
+    }
+    return x;
+}
+
+}  // namespace
+
+TEST_CASE("LU-SGS colouring") {
+    for (size_t nz : {0, 3}) {
+        CAPTURE(nz);
+        LuSgsTestCase test = lusgs_test_case_(nz);
+        LuSgs lusgs(test.system.get(), test.sim, test.cq, test.fs);
+        auto colours = Kokkos::create_mirror_view(lusgs.colours());
+        Kokkos::deep_copy(colours, lusgs.colours());
+
+        auto grid = test.sim->grid.host_mirror();
+        grid.deep_copy(test.sim->grid);
+        size_t n_cells = grid.num_cells();
+        auto interfaces = grid.interfaces();
+        for (size_t face_i = 0; face_i < grid.num_interfaces(); face_i++) {
+            size_t left = interfaces.left_cell(face_i);
+            size_t right = interfaces.right_cell(face_i);
+            if (left >= n_cells || right >= n_cells) continue;
+            CHECK(colours(left) != colours(right));
+        }
+        for (size_t cell_i = 0; cell_i < n_cells; cell_i++) {
+            CHECK(colours(cell_i) < lusgs.num_colours());
+        }
+    }
+}
+
+// LuSgs::apply should solve (D + L) D^{-1} (D + U) z = v, with L and U the
+// split flux Jacobians of the neighbours of lower and higher colour. This
+// assembles the dense matrix, with flux Jacobians from finite differences
+// of the Euler flux, and solves it directly.
+TEST_CASE("LU-SGS apply") {
+    for (size_t nz : {0, 3}) {
+        CAPTURE(nz);
+        LuSgsTestCase test = lusgs_test_case_(nz);
+        LuSgs lusgs(test.system.get(), test.sim, test.cq, test.fs);
+        lusgs.update();
+
+        size_t n_cells = test.sim->grid.num_cells();
+        size_t n_cons = test.cq->n_conserved();
+        size_t n_vars = n_cells * n_cons;
+        size_t dim = test.sim->grid.dim();
+        Ibis::Vector<Ibis::real> v("test::v", n_vars);
+        Ibis::Vector<Ibis::real> z("test::z", n_vars);
+        auto v_host = v.host_mirror();
+        for (size_t i = 0; i < n_vars; i++) {
+            v_host(i) = Kokkos::sin(0.37 * i);
+        }
+        v.deep_copy_space(v_host);
+        lusgs.apply(v, z);
+        auto z_host = z.host_mirror();
+        z_host.deep_copy_space(z);
+
+        auto colours = Kokkos::create_mirror_view(lusgs.colours());
+        Kokkos::deep_copy(colours, lusgs.colours());
+        auto grid = test.sim->grid.host_mirror();
+        grid.deep_copy(test.sim->grid);
+        auto fs = test.fs->host_mirror();
+        fs.deep_copy(*test.fs);
+        auto cq = host_conserved_(*test.cq);
+        auto interfaces = grid.interfaces();
+        auto cells = grid.cells();
+        Ibis::real gamma = 1.4;
+        Ibis::real R = 287.0;
+
+        // the largest wave speed either side of each face
+        std::vector<Ibis::real> lambda(grid.num_interfaces(), 0.0);
+        for (size_t face_i = 0; face_i < grid.num_interfaces(); face_i++) {
+            Ibis::real nx = Ibis::real_part(interfaces.norm().x(face_i));
+            Ibis::real ny = Ibis::real_part(interfaces.norm().y(face_i));
+            Ibis::real nz = Ibis::real_part(interfaces.norm().z(face_i));
+            size_t sides[2] = {interfaces.left_cell(face_i),
+                               interfaces.right_cell(face_i)};
+            for (size_t side : sides) {
+                Ibis::real vn = Ibis::real_part(fs.vel.x(side)) * nx +
+                                Ibis::real_part(fs.vel.y(side)) * ny +
+                                Ibis::real_part(fs.vel.z(side)) * nz;
+                Ibis::real a = std::sqrt(gamma * R * Ibis::real_part(fs.gas.temp(side)));
+                lambda[face_i] = std::max(lambda[face_i], std::abs(vn) + a);
+            }
+        }
+
+        // D + L and D + U, with the scalar diagonal of each cell in D
+        Ibis::real dt_star = test.system->pseudo_time_step();
+        std::vector<Ibis::real> diagonal(n_cells);
+        Matrix_ lower(n_vars, std::vector<Ibis::real>(n_vars, 0.0));
+        Matrix_ upper(n_vars, std::vector<Ibis::real>(n_vars, 0.0));
+        for (size_t cell_i = 0; cell_i < n_cells; cell_i++) {
+            auto face_ids = cells.faces().face_ids(cell_i);
+            auto outsigns = cells.faces().outsigns(cell_i);
+            Ibis::real volume = Ibis::real_part(cells.volume(cell_i));
+            Ibis::real sum = 0.0;
+            for (size_t i = 0; i < face_ids.size(); i++) {
+                size_t face_i = face_ids(i);
+                sum += lambda[face_i] * Ibis::real_part(interfaces.area(face_i));
+            }
+            diagonal[cell_i] = 1.0 / dt_star + 0.5 * sum / volume;
+            for (size_t cons_i = 0; cons_i < n_cons; cons_i++) {
+                size_t row = cell_i * n_cons + cons_i;
+                lower[row][row] = diagonal[cell_i];
+                upper[row][row] = diagonal[cell_i];
+            }
+
+            for (size_t i = 0; i < face_ids.size(); i++) {
+                size_t face_i = face_ids(i);
+                size_t left = interfaces.left_cell(face_i);
+                size_t neighbour =
+                    (left == cell_i) ? interfaces.right_cell(face_i) : left;
+                if (neighbour >= n_cells) continue;
+
+                std::vector<Ibis::real> u(n_cons);
+                for (size_t cons_i = 0; cons_i < n_cons; cons_i++) {
+                    u[cons_i] = cq(neighbour, cons_i);
+                }
+                Ibis::real sign = outsigns(i);
+                Matrix_ jacobian = euler_flux_jacobian_(
+                    u, sign * Ibis::real_part(interfaces.norm().x(face_i)),
+                    sign * Ibis::real_part(interfaces.norm().y(face_i)),
+                    sign * Ibis::real_part(interfaces.norm().z(face_i)), gamma, dim);
+                Ibis::real factor =
+                    0.5 * Ibis::real_part(interfaces.area(face_i)) / volume;
+                bool is_lower = colours(neighbour) < colours(cell_i);
+                Matrix_& triangle = is_lower ? lower : upper;
+                for (size_t row_i = 0; row_i < n_cons; row_i++) {
+                    for (size_t col_i = 0; col_i < n_cons; col_i++) {
+                        Ibis::real value = jacobian[row_i][col_i];
+                        if (row_i == col_i) value -= lambda[face_i];
+                        triangle[cell_i * n_cons + row_i][neighbour * n_cons + col_i] =
+                            factor * value;
+                    }
+                }
+            }
+        }
+
+        // (D + L) D^{-1} (D + U)
+        Matrix_ matrix(n_vars, std::vector<Ibis::real>(n_vars, 0.0));
+        for (size_t i = 0; i < n_vars; i++) {
+            for (size_t k = 0; k < n_vars; k++) {
+                if (lower[i][k] == 0.0) continue;
+                Ibis::real scale = lower[i][k] / diagonal[k / n_cons];
+                for (size_t j = 0; j < n_vars; j++) {
+                    matrix[i][j] += scale * upper[k][j];
+                }
+            }
+        }
+
+        std::vector<Ibis::real> rhs(n_vars);
+        for (size_t i = 0; i < n_vars; i++) {
+            rhs[i] = v_host(i);
+        }
+        std::vector<Ibis::real> z_ref = dense_solve_(matrix, rhs);
+
+        Ibis::real difference = 0.0;
+        Ibis::real norm = 0.0;
+        for (size_t i = 0; i < n_vars; i++) {
+            difference += (z_host(i) - z_ref[i]) * (z_host(i) - z_ref[i]);
+            norm += z_ref[i] * z_ref[i];
+        }
+        CHECK(std::sqrt(difference / norm) < 1e-8);
+    }
+}
+#endif
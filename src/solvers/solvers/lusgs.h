@@ -0,0 +1,103 @@
+#ifndef LUSGS_H
+#define LUSGS_H
+
+#include <finite_volume/conserved_quantities.h>
+#include <gas/flow_state.h>
+#include <linear_algebra/preconditioner.h>
+#include <simulation/simulation.h>
+#include <util/dimension.h>
+#include <util/numeric_types.h>
+
+#include <Kokkos_Core.hpp>
+#include <memory>
+#include <vector>
+
+class SteadyStateLinearisation;
+
+// Matrix-free LU-SGS preconditioner for the first order, inviscid
+// pseudo-transient linear system. The flux Jacobian at each face is
+// approximated by splitting it with the spectral radius,
+//     A^{+/-} = 0.5 * (A_n +/- lambda I),
+// so the diagonal blocks reduce to scalars and the off-diagonal blocks
+// are applied as Jacobian-vector products of the Euler flux, evaluated
+// with dual numbers. No blocks are stored. The forward and backward
+// sweeps are parallelised with a multicolour ordering of the cells.
+class LuSgs : public Preconditioner {
+public:
+    LuSgs(const SteadyStateLinearisation* system, std::shared_ptr<Sim<Ibis::dual>> sim,
+          std::shared_ptr<ConservedQuantities<Ibis::dual>> cq,
+          std::shared_ptr<FlowStates<Ibis::dual>> fs);
+
+    ~LuSgs() {}
+
+    // compute the spectral radii and diagonal at the current state
+    void update();
+
+    void apply(Ibis::Vector<Ibis::real>& v, Ibis::Vector<Ibis::real>& z);
+
+    size_t num_colours() const { return colour_offsets_.size() - 1; }
+
+    // the colour of each cell
+    Kokkos::View<size_t*> colours() const { return colours_; }
+
+private:
+    // the linear system this is preconditioning. This is only used
+    // to look up the pseudo time step, which changes between solves.
+    const SteadyStateLinearisation* system_;
+
+    // the point the system is linearised around
+    std::shared_ptr<Sim<Ibis::dual>> sim_;
+    std::shared_ptr<ConservedQuantities<Ibis::dual>> cq_;
+    std::shared_ptr<FlowStates<Ibis::dual>> fs_;
+
+    size_t n_cells_;
+    size_t n_cons_;
+
+    // spectral radius of the flux Jacobian at each face
+    Kokkos::View<Ibis::real*> spectral_radius_;
+
+    // the (scalar) diagonal of each cell
+    Kokkos::View<Ibis::real*> diagonal_;
+
+    // the colour of each cell, and the cells grouped by colour.
+    // No two neighbouring cells share a colour.
+    Kokkos::View<size_t*> colours_;
+    Kokkos::View<size_t*> colour_cells_;
+    std::vector<size_t> colour_offsets_;
+
+    void compute_colouring_();
+
+public:  // this is public to appease NVCC
+    // update z for the cells of one colour. The forward sweep solves
+    // (D + L) z = v, and the backward sweep overwrites z with the
+    // solution of (D + U) z = D z. There are Dim + 2 conserved quantities.
+    template <int Dim>
+    void sweep_(Ibis::Vector<Ibis::real>& v, Ibis::Vector<Ibis::real>& z, size_t colour,
+                bool forward);
+};
+
+// The derivative of the Euler flux normal to n, at the conserved state u,
+// in the direction du. This is the flux Jacobian applied to du.
+KOKKOS_INLINE_FUNCTION
+void euler_flux_jacobian_product(const Ibis::real* u, const Ibis::real* du,
+                                 const Ibis::real nx, const Ibis::real ny,
+                                 const Ibis::real nz, const Ibis::real gamma,
+                                 const size_t dim, Ibis::real* result) {
+    Ibis::dual rho{u[0], du[0]};
+    Ibis::dual vx = Ibis::dual{u[1], du[1]} / rho;
+    Ibis::dual vy = Ibis::dual{u[2], du[2]} / rho;
+    Ibis::dual vz = (dim == 3) ? Ibis::dual{u[3], du[3]} / rho : Ibis::dual{0.0};
+    Ibis::dual E{u[dim + 1], du[dim + 1]};
+    Ibis::dual p = (gamma - 1.0) * (E - 0.5 * rho * (vx * vx + vy * vy + vz * vz));
+    Ibis::dual vn = vx * nx + vy * ny + vz * nz;
+
+    result[0] = Ibis::dual_part(rho * vn);
+    result[1] = Ibis::dual_part(rho * vx * vn + p * nx);
+    result[2] = Ibis::dual_part(rho * vy * vn + p * ny);
+    if (dim == 3) {
+        result[3] = Ibis::dual_part(rho * vz * vn + p * nz);
+    }
+    result[dim + 1] = Ibis::dual_part((E + p) * vn);
+}
+
+#endif
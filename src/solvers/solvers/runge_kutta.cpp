@@ -8,10 +8,46 @@
 #include <solvers/runge_kutta.h>
 #include <solvers/solver.h>
 #include <spdlog/spdlog.h>
+#include <util/comm.h>
+#include <util/numa.h>
 #include <util/numeric_types.h>
+#include <util/profile.h>
 
+#include <algorithm>
 #include <limits>
 
+// Report which NUMA node the pages of the flow of each block are on, to
+// check that first touch has spread them over the nodes of the threads
+// which use them
+static void print_memory_placement(const std::vector<FlowStates<Ibis::real>>& flows) {
+    using memory_space = FlowStates<Ibis::real>::memory_space;
+    if constexpr (Kokkos::SpaceAccessibility<Kokkos::HostSpace,
+                                             memory_space>::accessible) {
+        for (size_t block_i = 0; block_i < flows.size(); block_i++) {
+            const auto& gas = flows[block_i].gas.data_;
+            const auto& vel = flows[block_i].vel.view_;
+            std::vector<size_t> gas_pages =
+                Ibis::numa_pages(gas.data(), gas.span() * sizeof(Ibis::real));
+            std::vector<size_t> vel_pages =
+                Ibis::numa_pages(vel.data(), vel.span() * sizeof(Ibis::real));
+            if (gas_pages.empty() && vel_pages.empty()) return;
+            gas_pages.resize(std::max(gas_pages.size(), vel_pages.size()), 0);
+            for (size_t node = 0; node < vel_pages.size(); node++) {
+                gas_pages[node] += vel_pages[node];
+            }
+            std::string summary;
+            for (size_t node = 0; node < gas_pages.size(); node++) {
+                if (!summary.empty()) summary += ", ";
+                summary += std::to_string(gas_pages[node]) + " on NUMA node " +
+                           std::to_string(node);
+            }
+            spdlog::info("block {} flow pages: {}", block_i, summary);
+        }
+    } else {
+        (void)flows;
+    }
+}
+
 // Implementation of Butcher tableau
 Ibis::real ButcherTableau::a(size_t i, size_t j) { return a_[i - 1][j]; }
 Ibis::real ButcherTableau::b(size_t i) { return b_[i]; }
@@ -41,26 +77,30 @@ RungeKutta::RungeKutta(json config, GridBlock<Ibis::real> grid, std::string grid
     trans_prop_ = TransportProperties<Ibis::real>(config.at("transport_properties"));
 
     // memory
-    grid_ = grid;
-    int number_cells = grid_.num_total_cells();
-    int dim = grid_.dim();
-    flow_ = FlowStates<Ibis::real>(number_cells);
-    conserved_quantities_ = ConservedQuantities<Ibis::real>(number_cells, dim);
-    k_ = std::vector<ConservedQuantities<Ibis::real>>(
-        tableau_.num_stages(), ConservedQuantities<Ibis::real>(number_cells, dim));
-    if (tableau_.num_stages() > 1) {
-        k_tmp_ = ConservedQuantities<Ibis::real>(number_cells, dim);
-        flow_tmp_ = FlowStates<Ibis::real>(number_cells);
+    blocks_ = MultiBlock<Ibis::real>(grid, config);
+    size_t num_blocks = blocks_.num_blocks();
+    int dim = grid.dim();
+    for (size_t block_i = 0; block_i < num_blocks; block_i++) {
+        size_t number_cells = blocks_.sim(block_i).grid.num_total_cells();
+        flows_.push_back(FlowStates<Ibis::real>(number_cells));
+        conserved_quantities_.push_back(
+            ConservedQuantities<Ibis::real>(number_cells, dim));
+        k_.push_back(std::vector<ConservedQuantities<Ibis::real>>(
+            tableau_.num_stages(), ConservedQuantities<Ibis::real>(number_cells, dim)));
+        if (tableau_.num_stages() > 1) {
+            k_tmp_.push_back(ConservedQuantities<Ibis::real>(number_cells, dim));
+            flow_tmp_.push_back(FlowStates<Ibis::real>(number_cells));
+        }
     }
-    fv_ = FiniteVolume<Ibis::real>(grid_, config);
+    print_memory_placement(flows_);
 
-    // grid motion
-    moving_grid_ = grid_.moving();
+    // grid motion (only a single block can move)
+    moving_grid_ = grid.moving();
     if (moving_grid_) {
         json grid_config = config.at("grid");
         json grid_motion_config = grid_config.at("motion");
         auto grid_driver = build_grid_motion_driver<Ibis::real>(grid, grid_motion_config);
-        grid_.set_motion_driver(grid_driver);
+        blocks_.sim(0).grid.set_motion_driver(grid_driver);
         vertex_vel_ = std::vector<Vector3s<Ibis::real>>(
             tableau_.num_stages(), Vector3s<Ibis::real>(grid.num_vertices()));
 
@@ -69,6 +109,18 @@ RungeKutta::RungeKutta(json config, GridBlock<Ibis::real> grid, std::string grid
         }
     }
 
+    // the flow of the whole grid, which only the first process reads and
+    // writes. With one block this is the same memory as the flow of the block.
+    if (Ibis::comm_size() == 1 && num_blocks == 1) {
+        grid_ = blocks_.sim(0).grid;
+        fv_ = blocks_.sim(0).fv;
+        flow_ = flows_[0];
+    } else if (Ibis::is_root_rank()) {
+        grid_ = grid;
+        fv_ = FiniteVolume<Ibis::real>(grid_, config);
+        flow_ = FlowStates<Ibis::real>(grid_.num_total_cells());
+    }
+
     // progress
     time_since_last_plot_ = 0.0;
     t_ = 0.0;
@@ -83,16 +135,24 @@ int RungeKutta::initialise() {
     // read the grid and initial flow
     json meta_data;
     json grid_config = config_.at("grid");
-    int ic_result =
-        io_.read(flow_, grid_, gas_model_, trans_prop_, grid_config, meta_data, 0);
-    int conversion_result =
-        primatives_to_conserved(conserved_quantities_, flow_, gas_model_);
+    int ic_result = 0;
+    if (Ibis::is_root_rank()) {
+        ic_result =
+            io_.read(flow_, grid_, gas_model_, trans_prop_, grid_config, meta_data, 0);
+    }
+    ic_result = Ibis::all_reduce_sum(size_t(ic_result != 0));
+    blocks_.scatter(flow_, flows_);
+    int conversion_result = 0;
+    for (size_t block_i = 0; block_i < blocks_.num_blocks(); block_i++) {
+        conversion_result += primatives_to_conserved(conserved_quantities_[block_i],
+                                                     flows_[block_i], gas_model_);
+    }
     dt_ = (dt_init_ > 0) ? dt_init_ : std::numeric_limits<Ibis::real>::max();
 
     // compute the initial residuals, and begin the residuals file
-    function_eval_(flow_, conserved_quantities_, 0);
+    function_eval_(flows_, conserved_quantities_, 0);
     if (residuals_every_n_steps_ > 0 || residual_frequency_ > 0) {
-        {
+        if (Ibis::is_root_rank()) {
             std::ofstream residual_file("log/residuals.dat", std::ios_base::out);
             residual_file << "time step wall_clock global mass momentum_x momentum_y "
                              "momentum_z energy\n";
@@ -110,7 +170,7 @@ void RungeKutta::estimate_dt() {
     //   1. The stable timestep
     //   2. 1.5 x the previous time step
     //   3. The time till the next plot needs to be written
-    stable_dt_ = fv_.estimate_dt(flow_, grid_, gas_model_, trans_prop_);
+    stable_dt_ = blocks_.estimate_dt(flows_);
     Ibis::real dt_startup = Ibis::min(cfl_->eval(t_) * stable_dt_, 1.5 * dt_);
     dt_ = Ibis::min(dt_startup, max_time_ - t_);
     if (plot_frequency_ > 0.0 && time_since_last_plot_ < plot_frequency_) {
@@ -118,18 +178,27 @@ void RungeKutta::estimate_dt() {
     }
 }
 
-void RungeKutta::function_eval_(FlowStates<Ibis::real> fs,
-                                ConservedQuantities<Ibis::real>& cq, size_t index) {
-    if (grid_.moving()) {
-        fv_.compute_dudt(fs, vertex_vel_[index], cq, grid_, k_[index], gas_model_,
-                         trans_prop_);
-    } else {
-        fv_.compute_dudt(fs, grid_, k_[index], gas_model_, trans_prop_);
+void RungeKutta::function_eval_(std::vector<FlowStates<Ibis::real>>& fs,
+                                std::vector<ConservedQuantities<Ibis::real>>& cq,
+                                size_t index) {
+    if (moving_grid_) {
+        // a moving grid is never split into blocks
+        Sim<Ibis::real>& sim = blocks_.sim(0);
+        sim.fv.compute_dudt(fs[0], vertex_vel_[index], cq[0], sim.grid, k_[0][index],
+                            sim.gas_model, sim.trans_prop);
+        return;
+    }
+
+    std::vector<ConservedQuantities<Ibis::real>> dudts;
+    for (size_t block_i = 0; block_i < blocks_.num_blocks(); block_i++) {
+        dudts.push_back(k_[block_i][index]);
     }
+    blocks_.compute_dudt(fs, dudts);
 }
 
 int RungeKutta::take_step(size_t step) {
     (void)step;
+    Ibis::ProfileRegion region("RungeKutta::take_step");
 
     // if (moving_grid_ && tableau_.num_stages() > 1) {
     // we need to save the initial grid vertex positions
@@ -140,7 +209,7 @@ int RungeKutta::take_step(size_t step) {
     // values used to estimate the stable time step. It also serves
     // as the first stage of all the runge-kutta schemes
     // fv_.compute_dudt(flow_, grid_, k_[0], gas_model_, trans_prop_);
-    function_eval_(flow_, conserved_quantities_, 0);
+    function_eval_(flows_, conserved_quantities_, 0);
 
     // estimate the stable time step we can take. After this call,
     // dt_ will be set to the stable time step.
@@ -152,8 +221,10 @@ int RungeKutta::take_step(size_t step) {
         // The first evaluation for each row of the tabluea includes the initial state
         // so we treat it separately. Even if the coefficient for this stage is zero,
         // we do this step to make sure k_tmp_ is set correctly.
-        apply_time_derivative(conserved_quantities_, k_tmp_, k_[0],
-                              tableau_.a(i, 0) * dt_);
+        for (size_t block_i = 0; block_i < blocks_.num_blocks(); block_i++) {
+            apply_time_derivative(conserved_quantities_[block_i], k_tmp_[block_i],
+                                  k_[block_i][0], tableau_.a(i, 0) * dt_);
+        }
         if (moving_grid_) {
             add_scaled_vector(init_vertex_pos_, vertex_vel_[0], tableau_.a(i, 0) * dt_,
                               grid_.vertices().positions());
@@ -166,7 +237,10 @@ int RungeKutta::take_step(size_t step) {
             if (tableau_.a(i, j) < 1e-14) continue;
 
             // accumulate the intermediate state for the next function evaluation
-            k_tmp_.apply_time_derivative(k_[j], tableau_.a(i, j) * dt_);
+            for (size_t block_i = 0; block_i < blocks_.num_blocks(); block_i++) {
+                k_tmp_[block_i].apply_time_derivative(k_[block_i][j],
+                                                      tableau_.a(i, j) * dt_);
+            }
             if (moving_grid_) {
                 add_scaled_vector(grid_.vertices().positions(), vertex_vel_[i],
                                   tableau_.a(i, j) * dt_);
@@ -174,7 +248,9 @@ int RungeKutta::take_step(size_t step) {
         }
 
         // The function evaluation
-        conserved_to_primatives(k_tmp_, flow_tmp_, gas_model_);
+        for (size_t block_i = 0; block_i < blocks_.num_blocks(); block_i++) {
+            conserved_to_primatives(k_tmp_[block_i], flow_tmp_[block_i], gas_model_);
+        }
         if (moving_grid_) {
             grid_.compute_geometric_data();
         }
@@ -182,15 +258,22 @@ int RungeKutta::take_step(size_t step) {
     }
 
     // Update the solution
+    Ibis::ProfileRegion update_region("RungeKutta::update");
     for (size_t i = 0; i < tableau_.num_stages(); i++) {
-        conserved_quantities_.apply_time_derivative(k_[i], tableau_.b(i) * dt_);
+        for (size_t block_i = 0; block_i < blocks_.num_blocks(); block_i++) {
+            conserved_quantities_[block_i].apply_time_derivative(k_[block_i][i],
+                                                                 tableau_.b(i) * dt_);
+        }
 
         if (moving_grid_) {
             add_scaled_vector(init_vertex_pos_, vertex_vel_[i], tableau_.b(i) * dt_);
         }
     }
 
-    conserved_to_primatives(conserved_quantities_, flow_, gas_model_);
+    for (size_t block_i = 0; block_i < blocks_.num_blocks(); block_i++) {
+        conserved_to_primatives(conserved_quantities_[block_i], flows_[block_i],
+                                gas_model_);
+    }
     if (moving_grid_) {
         grid_.set_vertex_positions(init_vertex_pos_);
     }
@@ -220,9 +303,10 @@ bool RungeKutta::residuals_this_step(unsigned int step) {
 bool RungeKutta::write_residuals(unsigned int step, Ibis::real wc) {
     spdlog::debug("Writing residuals at step {}", step);
     ConservedQuantitiesNorm<Ibis::real> norms = L2_norms();
+    time_since_last_residual_ = 0;
+    if (!Ibis::is_root_rank()) return true;
     std::ofstream residual_file("log/residuals.dat", std::ios_base::app);
     norms.write_to_file(residual_file, wc, t_, step);
-    time_since_last_residual_ = 0;
     return true;
 }
 
@@ -236,8 +320,10 @@ bool RungeKutta::plot_this_step(unsigned int step) {
 }
 
 int RungeKutta::plot_solution(unsigned int step) {
-    int result = io_.write(flow_, fv_, grid_, gas_model_, trans_prop_, t_);
+    blocks_.gather(flows_, flow_);
     time_since_last_plot_ = 0.0;
+    if (!Ibis::is_root_rank()) return 0;
+    int result = io_.write(flow_, fv_, grid_, gas_model_, trans_prop_, t_);
     spdlog::info("  written flow solution: step {}, time {:.6e}", step, t_);
     return result;
 }
@@ -261,4 +347,10 @@ bool RungeKutta::stop_now(unsigned int step) {
     return false;
 }
 
-ConservedQuantitiesNorm<Ibis::real> RungeKutta::L2_norms() { return k_[0].L2_norms(); }
+ConservedQuantitiesNorm<Ibis::real> RungeKutta::L2_norms() {
+    std::vector<ConservedQuantities<Ibis::real>> dudt;
+    for (size_t block_i = 0; block_i < blocks_.num_blocks(); block_i++) {
+        dudt.push_back(k_[block_i][0]);
+    }
+    return blocks_.L2_norms(dudt);
+}
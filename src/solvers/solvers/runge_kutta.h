@@ -7,6 +7,7 @@
 #include <gas/transport_properties.h>
 #include <grid/grid.h>
 #include <io/io.h>
+#include <simulation/multi_block.h>
 #include <solvers/cfl.h>
 #include <solvers/solver.h>
 #include <util/numeric_types.h>
@@ -85,26 +86,30 @@ private:
     std::string stop_reason(unsigned int step);
     bool stop_now(unsigned int step);
     size_t max_step() const { return max_step_; }
-    int count_bad_cells() { return fv_.count_bad_cells(flow_, grid_.num_cells()); }
+    int count_bad_cells() { return blocks_.count_bad_cells(flows_); }
 
     // this computes the L2 norms of the time derivates evaluated
-    // at the beginning of the previous step (essential whatever is in k_[0]).
-    // It should be called after taking a step, so the
+    // at the beginning of the previous step (essential whatever is in k_[0]),
+    // over all the blocks. It should be called after taking a step, so the
     ConservedQuantitiesNorm<Ibis::real> L2_norms();
 
     bool residuals_this_step(unsigned int step);
     bool write_residuals(unsigned int step, Ibis::real wc);
 
-    void function_eval_(FlowStates<Ibis::real> fs, ConservedQuantities<Ibis::real>& cq,
-                        size_t index);
+    // evaluate stage `index` of every block, after filling the ghost
+    // cells between the blocks
+    void function_eval_(std::vector<FlowStates<Ibis::real>>& fs,
+                        std::vector<ConservedQuantities<Ibis::real>>& cq, size_t index);
 
 private:
-    // memory
+    // memory. flow_ is the flow on the whole grid, which is read and
+    // written. Everything else is stored for each block.
     FlowStates<Ibis::real> flow_;
-    ConservedQuantities<Ibis::real> conserved_quantities_;
-    std::vector<ConservedQuantities<Ibis::real>> k_;
-    ConservedQuantities<Ibis::real> k_tmp_;
-    FlowStates<Ibis::real> flow_tmp_;
+    std::vector<FlowStates<Ibis::real>> flows_;
+    std::vector<ConservedQuantities<Ibis::real>> conserved_quantities_;
+    std::vector<std::vector<ConservedQuantities<Ibis::real>>> k_;
+    std::vector<ConservedQuantities<Ibis::real>> k_tmp_;
+    std::vector<FlowStates<Ibis::real>> flow_tmp_;
 
     // grid movement
     bool moving_grid_;
@@ -117,7 +122,9 @@ private:
     ButcherTableau tableau_;
 
 private:
-    // spatial discretisation
+    // spatial discretisation. The blocks do the work; grid_ and fv_
+    // are the whole grid, for reading and writing the flow.
+    MultiBlock<Ibis::real> blocks_;
     GridBlock<Ibis::real> grid_;
     FiniteVolume<Ibis::real> fv_;
 
@@ -2,6 +2,8 @@
 #include <solvers/solver.h>
 #include <spdlog/spdlog.h>
 #include <spdlog/stopwatch.h>
+#include <util/comm.h>
+#include <util/profile.h>
 
 #include <algorithm>
 #include <filesystem>
@@ -16,7 +18,11 @@ Solver::Solver(std::string grid_dir, std::string flow_dir)
     : grid_dir_(grid_dir), flow_dir_(flow_dir) {}
 
 int Solver::solve() {
-    int success = initialise();
+    int success;
+    {
+        Ibis::ProfileRegion region("Solver::initialise");
+        success = initialise();
+    }
     if (success != 0) {
         spdlog::error("Failed to initialise runge kutta solver");
         return success;
@@ -24,8 +30,10 @@ int Solver::solve() {
     spdlog::stopwatch sw;
     for (size_t step = 0; step < max_step(); step++) {
         int result = take_step(step);
+        Ibis::profile_step();
 
         if (residuals_this_step(step)) {
+            Ibis::ProfileRegion region("Solver::write_residuals");
             write_residuals(step, sw.elapsed().count());
         }
 
@@ -69,14 +77,48 @@ std::unique_ptr<Solver> make_solver(json config, std::string grid_dir,
     json solver_config = config.at("solver");
     json grid_config = config.at("grid");
     std::string solver_name = solver_config.at("name");
+    if (Ibis::comm_size() > 1) {
+        // The steady state solver works on a single block, and its linear
+        // solvers' dot products and norms aren't reduced over the processes
+        if (solver_name != "runge_kutta") {
+            spdlog::error("Only the runge_kutta solver can run on several processes");
+            throw std::runtime_error("Solver can't run on several processes");
+        }
+
+        // only the first process writes the grid cache, so the processes
+        // don't all write the same file at once
+        if (!Ibis::is_root_rank()) {
+            grid_config["cache"] = false;
+        }
+    }
     if (solver_name == "runge_kutta") {
+        // every process reads the whole grid, and MultiBlock keeps the
+        // blocks that belong to it
         GridBlock<Ibis::real> grid(grid_file, grid_config);
         return std::unique_ptr<Solver>(
             new RungeKutta(config, std::move(grid), grid_dir, flow_dir));
     } else if (solver_name == "steady_state") {
-        GridBlock<Ibis::dual> grid(grid_file, grid_config);
+        // the finite difference linearisations only need real numbers
+        Linearisation linearisation =
+            string_to_linearisation(solver_config.at("linearisation"));
+        if (linearisation == Linearisation::Dual && solver_config.at("batched_dual")) {
+            // both copies of the grid are built from the one read of the grid
+            // file, rather than reading and parsing it twice
+            GridIO grid_io(grid_file);
+            GridBlock<Ibis::dual> grid(grid_io, grid_config);
+            auto batch_grid =
+                std::make_shared<GridBlock<Ibis::dual4>>(grid_io, grid_config);
+            return std::unique_ptr<Solver>(new SteadyState<Ibis::dual>(
+                config, std::move(grid), grid_dir, flow_dir, batch_grid));
+        }
+        if (linearisation == Linearisation::Dual) {
+            GridBlock<Ibis::dual> grid(grid_file, grid_config);
+            return std::unique_ptr<Solver>(
+                new SteadyState<Ibis::dual>(config, std::move(grid), grid_dir, flow_dir));
+        }
+        GridBlock<Ibis::real> grid(grid_file, grid_config);
         return std::unique_ptr<Solver>(
-            new SteadyState(config, std::move(grid), grid_dir, flow_dir));
+            new SteadyState<Ibis::real>(config, std::move(grid), grid_dir, flow_dir));
     } else {
         spdlog::error("Unknown solver {}", solver_name);
         throw new std::runtime_error("Unknown solver");
@@ -1,12 +1,23 @@
+#include <doctest/doctest.h>
 #include <finite_volume/conserved_quantities.h>
 #include <finite_volume/finite_volume.h>
 #include <finite_volume/primative_conserved_conversion.h>
 #include <gas/flow_state.h>
 #include <gas/transport_properties.h>
+#include <grid/structured_grid.h>
 #include <simulation/simulation.h>
 #include <solvers/cfl.h>
+#include <solvers/lusgs.h>
 #include <solvers/steady_state.h>
 #include <solvers/transient_linear_system.h>
+#include <spdlog/spdlog.h>
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <memory>
+#include <type_traits>
+#include <vector>
 
 #include "finite_volume/grid_motion_driver.h"
 
@@ -15,7 +26,8 @@ SteadyStateLinearisation::SteadyStateLinearisation(
     std::shared_ptr<ConservedQuantities<Ibis::dual>> residuals,
     std::shared_ptr<ConservedQuantities<Ibis::dual>> cq,
     std::shared_ptr<FlowStates<Ibis::dual>> fs,
-    std::shared_ptr<Vector3s<Ibis::dual>> vertex_vel, bool allow_reconstruction) {
+    std::shared_ptr<Vector3s<Ibis::dual>> vertex_vel, bool allow_reconstruction,
+    std::shared_ptr<Sim<Ibis::dual4>> batch_sim) {
     sim_ = sim;
     cq_ = cq;
     fs_ = fs;
@@ -42,11 +54,23 @@ SteadyStateLinearisation::SteadyStateLinearisation(
         vertex_pos_tmp_ = Vector3s<Ibis::dual>{"SteadyStateLinearisation::vertex_vel",
                                                sim_->grid.num_vertices()};
     }
+
+    batch_sim_ = batch_sim;
+    if (batch_sim_) {
+        if (sim_->grid.moving()) {
+            spdlog::error("Batched Jacobian assembly doesn't support moving grids");
+            throw std::runtime_error("Batched assembly not supported for moving grids");
+        }
+        batch_fs_tmp_ = FlowStates<Ibis::dual4>{n_total_cells_};
+        batch_cq_tmp_ = ConservedQuantities<Ibis::dual4>{n_total_cells_, dim};
+        batch_residuals_ = ConservedQuantities<Ibis::dual4>{n_total_cells_, dim};
+    }
 }
 
 std::unique_ptr<LinearSystem> SteadyStateLinearisation::preconditioner() {
     return std::unique_ptr<LinearSystem>(
-        new SteadyStateLinearisation(sim_, residuals_, cq_, fs_, vertex_vel_, false));
+        new SteadyStateLinearisation(sim_, residuals_, cq_, fs_, vertex_vel_, false,
+                                     batch_sim_));
 }
 
 void SteadyStateLinearisation::matrix_vector_product(Ibis::Vector<Ibis::real>& vec,
@@ -127,6 +151,174 @@ void SteadyStateLinearisation::matrix_vector_product(Ibis::Vector<Ibis::real>& v
     }
 }
 
+Ibis::BlockSparseMatrix SteadyStateLinearisation::allocate_matrix() {
+    if (sim_->grid.moving()) {
+        spdlog::error("Assembling the Jacobian isn't supported for moving grids");
+        throw std::runtime_error("Can't assemble Jacobian for moving grid");
+    }
+
+    // the sparsity pattern is each cell and its (valid) neighbours
+    size_t n_cells = n_cells_;
+    auto neighbours = sim_->grid.cells().neighbour_cells();
+    auto neighbours_host = neighbours.host_mirror_and_copy();
+    std::vector<std::vector<size_t>> pattern(n_cells);
+    for (size_t cell_i = 0; cell_i < n_cells; cell_i++) {
+        pattern[cell_i].push_back(cell_i);
+        auto cell_neighbours = neighbours_host(cell_i);
+        for (size_t i = 0; i < cell_neighbours.size(); i++) {
+            if (cell_neighbours(i) < n_cells) {
+                pattern[cell_i].push_back(cell_neighbours(i));
+            }
+        }
+    }
+
+    // greedy distance-2 colouring, so no two cells of the same
+    // colour contribute to the residual of the same cell
+    std::vector<size_t> colours(n_cells, 0);
+    std::vector<size_t> forbidden;
+    n_colours_ = 0;
+    for (size_t cell_i = 0; cell_i < n_cells; cell_i++) {
+        forbidden.assign(n_colours_ + 1, n_cells);
+        for (size_t neighbour : pattern[cell_i]) {
+            for (size_t other : pattern[neighbour]) {
+                if (other < cell_i) forbidden[colours[other]] = cell_i;
+            }
+        }
+        size_t colour = 0;
+        while (forbidden[colour] == cell_i) colour++;
+        colours[cell_i] = colour;
+        n_colours_ = std::max(n_colours_, colour + 1);
+    }
+
+    colours_ = Kokkos::View<size_t*>("SteadyStateLinearisation::colours", n_cells);
+    auto colours_host = Kokkos::create_mirror_view(colours_);
+    for (size_t cell_i = 0; cell_i < n_cells; cell_i++) {
+        colours_host(cell_i) = colours[cell_i];
+    }
+    Kokkos::deep_copy(colours_, colours_host);
+    spdlog::debug("Coloured {} cells with {} colours", n_cells, n_colours_);
+
+    return Ibis::BlockSparseMatrix(pattern, n_cons_);
+}
+
+void SteadyStateLinearisation::assemble(Ibis::BlockSparseMatrix& matrix) {
+    if (batch_sim_) {
+        assemble_batched_(matrix);
+        return;
+    }
+
+    size_t n_cons = n_cons_;
+    auto residuals = *residuals_;
+    Ibis::real dt_star = dt_star_;
+    auto cq_tmp = cq_tmp_;
+    auto cq = *cq_;
+    auto colours = colours_;
+    auto columns = matrix.columns();
+    auto row_offsets = matrix.row_offsets();
+    auto values = matrix.values();
+
+    for (size_t colour = 0; colour < n_colours_; colour++) {
+        for (size_t comp = 0; comp < n_cons; comp++) {
+            // perturb one conserved quantity in every cell of this colour
+            Kokkos::parallel_for(
+                "SteadyStateLinearisation::assemble::set_dual", n_cells_,
+                KOKKOS_LAMBDA(const size_t cell_i) {
+                    bool perturb = colours(cell_i) == colour;
+                    for (size_t cons_i = 0; cons_i < n_cons; cons_i++) {
+                        cq_tmp(cell_i, cons_i).real() = cq(cell_i, cons_i).real();
+                        cq_tmp(cell_i, cons_i).dual() =
+                            (perturb && cons_i == comp) ? 1.0 : 0.0;
+                    }
+                });
+
+            conserved_to_primatives(cq_tmp_, fs_tmp_, sim_->gas_model);
+            sim_->fv.compute_dudt(fs_tmp_, sim_->grid, residuals, sim_->gas_model,
+                                  sim_->trans_prop, allow_reconstruction_);
+
+            // the perturbation seen by each cell comes from the
+            // only cell of this colour in its stencil
+            Kokkos::parallel_for(
+                "SteadyStateLinearisation::assemble::set_blocks", n_cells_,
+                KOKKOS_LAMBDA(const size_t cell_i) {
+                    auto row_cols = columns(cell_i);
+                    size_t first = row_offsets(cell_i);
+                    for (size_t entry = 0; entry < row_cols.size(); entry++) {
+                        size_t col = row_cols(entry);
+                        if (colours(col) != colour) continue;
+                        for (size_t cons_i = 0; cons_i < n_cons; cons_i++) {
+                            Ibis::real diag =
+                                (col == cell_i && cons_i == comp) ? 1 / dt_star : 0.0;
+                            values(first + entry, cons_i, comp) =
+                                diag - Ibis::dual_part(residuals(cell_i, cons_i));
+                        }
+                    }
+                });
+        }
+    }
+}
+
+void SteadyStateLinearisation::assemble_batched_(Ibis::BlockSparseMatrix& matrix) {
+    size_t n_cons = n_cons_;
+    Ibis::real dt_star = dt_star_;
+    auto cq_tmp = batch_cq_tmp_;
+    auto residuals = batch_residuals_;
+    auto cq = *cq_;
+    auto colours = colours_;
+    auto columns = matrix.columns();
+    auto row_offsets = matrix.row_offsets();
+    auto values = matrix.values();
+
+    for (size_t colour = 0; colour < n_colours_; colour++) {
+        for (size_t first = 0; first < n_cons; first += Ibis::dual_lanes) {
+            // perturb up to dual_lanes conserved quantities in every
+            // cell of this colour, one in each lane
+            size_t n_lanes = std::min(Ibis::dual_lanes, n_cons - first);
+            Kokkos::parallel_for(
+                "SteadyStateLinearisation::assemble_batched::set_duals", n_cells_,
+                KOKKOS_LAMBDA(const size_t cell_i) {
+                    bool perturb = colours(cell_i) == colour;
+                    for (size_t cons_i = 0; cons_i < n_cons; cons_i++) {
+                        cq_tmp(cell_i, cons_i) = cq(cell_i, cons_i).real();
+                        for (size_t lane = 0; lane < n_lanes; lane++) {
+                            cq_tmp(cell_i, cons_i).dual(lane) =
+                                (perturb && cons_i == first + lane) ? 1.0 : 0.0;
+                        }
+                    }
+                });
+
+            conserved_to_primatives(batch_cq_tmp_, batch_fs_tmp_, batch_sim_->gas_model);
+            batch_sim_->fv.compute_dudt(batch_fs_tmp_, batch_sim_->grid, residuals,
+                                        batch_sim_->gas_model, batch_sim_->trans_prop,
+                                        allow_reconstruction_);
+
+            Kokkos::parallel_for(
+                "SteadyStateLinearisation::assemble_batched::set_blocks", n_cells_,
+                KOKKOS_LAMBDA(const size_t cell_i) {
+                    auto row_cols = columns(cell_i);
+                    size_t first_entry = row_offsets(cell_i);
+                    for (size_t entry = 0; entry < row_cols.size(); entry++) {
+                        size_t col = row_cols(entry);
+                        if (colours(col) != colour) continue;
+                        for (size_t lane = 0; lane < n_lanes; lane++) {
+                            size_t comp = first + lane;
+                            for (size_t cons_i = 0; cons_i < n_cons; cons_i++) {
+                                Ibis::real diag =
+                                    (col == cell_i && cons_i == comp) ? 1 / dt_star : 0.0;
+                                Ibis::real dudt =
+                                    Ibis::dual_part(residuals(cell_i, cons_i), lane);
+                                values(first_entry + entry, cons_i, comp) = diag - dudt;
+                            }
+                        }
+                    }
+                });
+        }
+    }
+}
+
+std::unique_ptr<Preconditioner> SteadyStateLinearisation::lusgs_preconditioner() {
+    return std::unique_ptr<Preconditioner>(new LuSgs(this, sim_, cq_, fs_));
+}
+
 void SteadyStateLinearisation::eval_rhs() {
     if (sim_->grid.moving()) {
         sim_->fv.compute_dudt(*fs_, *vertex_vel_, *cq_, sim_->grid, *residuals_,
@@ -173,41 +365,256 @@ void SteadyStateLinearisation::set_pseudo_time_step(Ibis::real dt_star) {
     dt_star_ = dt_star;
 }
 
-SteadyState::SteadyState(json config, GridBlock<Ibis::dual> grid, std::string grid_dir,
-                         std::string flow_dir)
+Linearisation string_to_linearisation(std::string linearisation) {
+    if (linearisation == "dual") {
+        return Linearisation::Dual;
+    } else if (linearisation == "forward_difference") {
+        return Linearisation::ForwardDifference;
+    } else if (linearisation == "central_difference") {
+        return Linearisation::CentralDifference;
+    } else {
+        spdlog::error("Unknown linearisation {}", linearisation);
+        throw std::runtime_error("Unknown linearisation");
+    }
+}
+
+SteadyStateFDLinearisation::SteadyStateFDLinearisation(
+    std::shared_ptr<Sim<Ibis::real>> sim,
+    std::shared_ptr<ConservedQuantities<Ibis::real>> residuals,
+    std::shared_ptr<ConservedQuantities<Ibis::real>> cq,
+    std::shared_ptr<FlowStates<Ibis::real>> fs, bool central_difference,
+    bool allow_reconstruction, std::shared_ptr<size_t> linearisation_point) {
+    sim_ = sim;
+    cq_ = cq;
+    fs_ = fs;
+    residuals_ = residuals;
+    allow_reconstruction_ = allow_reconstruction;
+    central_difference_ = central_difference;
+    size_t dim = sim_->grid.dim();
+
+    if (sim_->grid.moving()) {
+        spdlog::error("Finite difference linearisation doesn't support moving grids");
+        throw std::runtime_error("Finite difference linearisation with moving grid");
+    }
+
+    n_total_cells_ = sim_->grid.num_total_cells();
+    n_cells_ = sim_->grid.num_cells();
+    n_cons_ = cq_->n_conserved();
+    n_vars_ = n_cells_ * n_cons_;
+
+    rhs_ = Ibis::Vector<Ibis::real>{"SteadyStateFDLinearisation::rhs", n_vars_};
+    base_residuals_ =
+        Ibis::Vector<Ibis::real>{"SteadyStateFDLinearisation::base_residuals", n_vars_};
+    fs_tmp_ = FlowStates<Ibis::real>{n_total_cells_};
+    cq_tmp_ = ConservedQuantities<Ibis::real>{n_total_cells_, dim};
+    residuals_tmp_ = ConservedQuantities<Ibis::real>{n_total_cells_, dim};
+
+    // the perturbation which balances the truncation error
+    // of the finite difference and the round off error
+    Ibis::real machine_eps = std::numeric_limits<Ibis::real>::epsilon();
+    perturbation_scale_ =
+        central_difference_ ? std::cbrt(machine_eps) : std::sqrt(machine_eps);
+    base_norm_ = 0.0;
+
+    linearisation_point_ = linearisation_point;
+    if (!linearisation_point_) {
+        linearisation_point_ = std::make_shared<size_t>(0);
+    }
+}
+
+std::unique_ptr<LinearSystem> SteadyStateFDLinearisation::preconditioner() {
+    return std::unique_ptr<LinearSystem>(
+        new SteadyStateFDLinearisation(sim_, residuals_, cq_, fs_, central_difference_,
+                                       false, linearisation_point_));
+}
+
+void SteadyStateFDLinearisation::update_base_point_() {
+    sim_->fv.compute_dudt(*fs_, sim_->grid, residuals_tmp_, sim_->gas_model,
+                          sim_->trans_prop, allow_reconstruction_);
+
+    size_t n_cons = n_cons_;
+    auto base_residuals = base_residuals_;
+    auto residuals = residuals_tmp_;
+    Kokkos::parallel_for(
+        "SteadyStateFDLinearisation::update_base_point", n_cells_,
+        KOKKOS_LAMBDA(const size_t cell_i) {
+            const size_t vector_idx = cell_i * n_cons;
+            for (size_t cons_i = 0; cons_i < n_cons; cons_i++) {
+                base_residuals(vector_idx + cons_i) = residuals(cell_i, cons_i);
+            }
+        });
+    base_norm_ = cq_->L2_norms().global();
+    base_point_ = *linearisation_point_;
+}
+
+void SteadyStateFDLinearisation::perturbed_residuals_(Ibis::Vector<Ibis::real>& vec,
+                                                      Ibis::real eps) {
+    size_t n_cons = n_cons_;
+    auto cq_tmp = cq_tmp_;
+    auto cq = *cq_;
+    Kokkos::parallel_for(
+        "SteadyStateFDLinearisation::perturb", n_cells_,
+        KOKKOS_LAMBDA(const size_t cell_i) {
+            const size_t vector_idx = cell_i * n_cons;
+            for (size_t cons_i = 0; cons_i < n_cons; cons_i++) {
+                Ibis::real dU = eps * vec(vector_idx + cons_i);
+                cq_tmp(cell_i, cons_i) = cq(cell_i, cons_i) + dU;
+            }
+        });
+
+    conserved_to_primatives(cq_tmp_, fs_tmp_, sim_->gas_model);
+    sim_->fv.compute_dudt(fs_tmp_, sim_->grid, residuals_tmp_, sim_->gas_model,
+                          sim_->trans_prop, allow_reconstruction_);
+}
+
+void SteadyStateFDLinearisation::matrix_vector_product(
+    Ibis::Vector<Ibis::real>& vec, Ibis::Vector<Ibis::real>& result) {
+    // the preconditioner systems linearise about the same point as the
+    // main system, but evaluate their own residuals there
+    if (base_point_ != *linearisation_point_) {
+        update_base_point_();
+    }
+
+    Ibis::real vec_norm = Ibis::norm2(vec);
+    if (vec_norm == 0.0) {
+        result.zero();
+        return;
+    }
+    Ibis::real eps = perturbation(vec_norm);
+
+    size_t n_cons = n_cons_;
+    Ibis::real dt_star = dt_star_;
+    auto residuals = residuals_tmp_;
+    perturbed_residuals_(vec, eps);
+    if (central_difference_) {
+        // J v ~= (R(U + eps v) - R(U - eps v)) / (2 eps)
+        Kokkos::parallel_for(
+            "SteadyStateFDLinearisation::central_difference::plus", n_cells_,
+            KOKKOS_LAMBDA(const size_t cell_i) {
+                const size_t vector_idx = cell_i * n_cons;
+                for (size_t cons_i = 0; cons_i < n_cons; cons_i++) {
+                    result(vector_idx + cons_i) = 1 / dt_star * vec(vector_idx + cons_i) -
+                                                  residuals(cell_i, cons_i) / (2 * eps);
+                }
+            });
+        perturbed_residuals_(vec, -eps);
+        Kokkos::parallel_for(
+            "SteadyStateFDLinearisation::central_difference::minus", n_cells_,
+            KOKKOS_LAMBDA(const size_t cell_i) {
+                const size_t vector_idx = cell_i * n_cons;
+                for (size_t cons_i = 0; cons_i < n_cons; cons_i++) {
+                    result(vector_idx + cons_i) += residuals(cell_i, cons_i) / (2 * eps);
+                }
+            });
+    } else {
+        // J v ~= (R(U + eps v) - R(U)) / eps
+        auto base_residuals = base_residuals_;
+        Kokkos::parallel_for(
+            "SteadyStateFDLinearisation::forward_difference", n_cells_,
+            KOKKOS_LAMBDA(const size_t cell_i) {
+                const size_t vector_idx = cell_i * n_cons;
+                for (size_t cons_i = 0; cons_i < n_cons; cons_i++) {
+                    Ibis::real dR = residuals(cell_i, cons_i) -
+                                    base_residuals(vector_idx + cons_i);
+                    result(vector_idx + cons_i) =
+                        1 / dt_star * vec(vector_idx + cons_i) - dR / eps;
+                }
+            });
+    }
+}
+
+void SteadyStateFDLinearisation::eval_rhs() {
+    sim_->fv.compute_dudt(*fs_, sim_->grid, *residuals_, sim_->gas_model,
+                          sim_->trans_prop, allow_reconstruction_);
+
+    size_t n_cons = n_cons_;
+    auto rhs = rhs_;
+    auto base_residuals = base_residuals_;
+    auto residuals = *residuals_;
+    Kokkos::parallel_for(
+        "SteadyStateFDLinearisation::eval_rhs", n_cells_,
+        KOKKOS_LAMBDA(const size_t cell_i) {
+            const size_t vector_idx = cell_i * n_cons;
+            for (size_t cons_i = 0; cons_i < n_cons; cons_i++) {
+                rhs(vector_idx + cons_i) = residuals(cell_i, cons_i);
+                base_residuals(vector_idx + cons_i) = residuals(cell_i, cons_i);
+            }
+        });
+
+    // the state has (probably) changed, so this is a new linearisation point
+    base_norm_ = cq_->L2_norms().global();
+    (*linearisation_point_)++;
+    base_point_ = *linearisation_point_;
+}
+
+void SteadyStateFDLinearisation::set_rhs(Ibis::Vector<Ibis::real>& rhs) { rhs_ = rhs; }
+
+void SteadyStateFDLinearisation::set_pseudo_time_step(Ibis::real dt_star) {
+    dt_star_ = dt_star;
+}
+
+template <typename T>
+SteadyState<T>::SteadyState(json config, GridBlock<T> grid, std::string grid_dir,
+                            std::string flow_dir,
+                            std::shared_ptr<GridBlock<Ibis::dual4>> batch_grid)
     : Solver(grid_dir, flow_dir) {
     json solver_config = config.at("solver");
-    sim_ = std::shared_ptr<Sim<Ibis::dual>>{new Sim<Ibis::dual>(grid, config)};
+    sim_ = std::shared_ptr<Sim<T>>{new Sim<T>(grid, config)};
 
     size_t n_total_cells = sim_->grid.num_total_cells();
     // size_t n_cells = sim_->grid.num_cells();
     size_t dim = sim_->grid.dim();
 
-    fs_ = std::shared_ptr<FlowStates<Ibis::dual>>{
-        new FlowStates<Ibis::dual>(n_total_cells)};
+    fs_ = std::shared_ptr<FlowStates<T>>{
+        new FlowStates<T>(n_total_cells)};
 
-    cq_ = std::shared_ptr<ConservedQuantities<Ibis::dual>>{
-        new ConservedQuantities<Ibis::dual>(n_total_cells, dim)};
+    cq_ = std::shared_ptr<ConservedQuantities<T>>{
+        new ConservedQuantities<T>(n_total_cells, dim)};
 
-    residuals_ = std::shared_ptr<ConservedQuantities<Ibis::dual>>{
-        new ConservedQuantities<Ibis::dual>(n_total_cells, dim)};
+    residuals_ = std::shared_ptr<ConservedQuantities<T>>{
+        new ConservedQuantities<T>(n_total_cells, dim)};
 
     if (sim_->grid.moving()) {
         json grid_config = config.at("grid");
         json grid_motion_config = grid_config.at("motion");
         auto grid_driver =
-            build_grid_motion_driver<Ibis::dual>(sim_->grid, grid_motion_config);
+            build_grid_motion_driver<T>(sim_->grid, grid_motion_config);
         sim_->grid.set_motion_driver(grid_driver);
-        vertex_vel_ = std::shared_ptr<Vector3s<Ibis::dual>>(
-            new Vector3s<Ibis::dual>(grid.num_vertices()));
+        vertex_vel_ = std::shared_ptr<Vector3s<T>>(
+            new Vector3s<T>(grid.num_vertices()));
     }
 
     // set up the linear system and non-linear solver
     auto cfl = make_cfl_schedule(solver_config.at("cfl"));
-    std::unique_ptr<PseudoTransientLinearSystem> system =
-        std::unique_ptr<PseudoTransientLinearSystem>(
-            new SteadyStateLinearisation(sim_, residuals_, cq_, fs_, vertex_vel_));
-    jfnk_ = Jfnk(std::move(system), std::move(cfl), residuals_, solver_config);
+    Linearisation linearisation =
+        string_to_linearisation(solver_config.at("linearisation"));
+    std::unique_ptr<PseudoTransientLinearSystem> system;
+    if constexpr (std::is_same<T, Ibis::dual>::value) {
+        // the linearisation can compute several Jacobian-vector products per
+        // residual evaluation with a second copy of the simulation which uses
+        // multi-lane dual numbers, at the cost of the memory for another grid
+        if (solver_config.at("batched_dual")) {
+            if (!batch_grid) {
+                spdlog::error("batched_dual needs the grid with multi-lane dual numbers");
+                throw std::runtime_error("No grid for batched_dual");
+            }
+            batch_sim_ = std::shared_ptr<Sim<Ibis::dual4>>{
+                new Sim<Ibis::dual4>(std::move(*batch_grid), config)};
+        }
+        system = std::unique_ptr<PseudoTransientLinearSystem>(
+            new SteadyStateLinearisation(sim_, residuals_, cq_, fs_, vertex_vel_, true,
+                                         batch_sim_));
+    } else {
+        if (solver_config.at("batched_dual")) {
+            spdlog::error("batched_dual requires the dual linearisation");
+            throw std::runtime_error("batched_dual requires the dual linearisation");
+        }
+        bool central_difference = linearisation == Linearisation::CentralDifference;
+        system = std::unique_ptr<PseudoTransientLinearSystem>(
+            new SteadyStateFDLinearisation(sim_, residuals_, cq_, fs_,
+                                           central_difference));
+    }
+    jfnk_ = Jfnk<T>(std::move(system), std::move(cfl), residuals_, solver_config);
 
     // configuration
     print_frequency_ = solver_config.at("print_frequency");
@@ -215,12 +622,13 @@ SteadyState::SteadyState(json config, GridBlock<Ibis::dual> grid, std::string gr
     diagnostics_frequency_ = solver_config.at("diagnostics_frequency");
 
     // I/O
-    io_ = FVIO<Ibis::dual>(config, 1);
+    io_ = FVIO<T>(config, 1);
 
     config_ = config;
 }
 
-int SteadyState::initialise() {
+template <typename T>
+int SteadyState<T>::initialise() {
     // read grid and initial condition
     json meta_data{};
     json grid_config = config_.at("grid");
@@ -253,27 +661,33 @@ int SteadyState::initialise() {
     return ic_result + conversion_result + jfnk_init;
 }
 
-int SteadyState::finalise() { return 0; }
+template <typename T>
+int SteadyState<T>::finalise() { return 0; }
 
-int SteadyState::take_step(size_t step) {
+template <typename T>
+int SteadyState<T>::take_step(size_t step) {
     jfnk_.step(sim_, *cq_, *fs_, step);
     return 0;
 }
 
-bool SteadyState::print_this_step(unsigned int step) {
+template <typename T>
+bool SteadyState<T>::print_this_step(unsigned int step) {
     return (step != 0 && step % print_frequency_ == 0);
 }
 
-bool SteadyState::residuals_this_step(unsigned int step) {
+template <typename T>
+bool SteadyState<T>::residuals_this_step(unsigned int step) {
     return ((diagnostics_frequency_ > 0) && (step != 0) &&
             (step % diagnostics_frequency_ == 0));
 }
 
-bool SteadyState::plot_this_step(unsigned int step) {
+template <typename T>
+bool SteadyState<T>::plot_this_step(unsigned int step) {
     return (step != 0 && step % plot_frequency_ == 0);
 }
 
-int SteadyState::plot_solution(unsigned int step) {
+template <typename T>
+int SteadyState<T>::plot_solution(unsigned int step) {
     Ibis::real t = (Ibis::real)step;
     int result =
         io_.write(*fs_, sim_->fv, sim_->grid, sim_->gas_model, sim_->trans_prop, t);
@@ -281,21 +695,25 @@ int SteadyState::plot_solution(unsigned int step) {
     return result;
 }
 
-void SteadyState::print_progress(unsigned int step, Ibis::real wc) {
-    Ibis::real relative_global_residual = jfnk_.relative_residual_norms().global().real();
+template <typename T>
+void SteadyState<T>::print_progress(unsigned int step, Ibis::real wc) {
+    Ibis::real relative_global_residual =
+        Ibis::real_part(jfnk_.relative_residual_norms().global());
     Ibis::real cfl = jfnk_.calculate_cfl(step);
     spdlog::info(
         "  step: {:>8}, relative global residual {:.2e}, cfl = {:.1f}, wc = {:.1f}s",
         step, relative_global_residual, cfl, wc);
 }
 
-bool SteadyState::stop_now(unsigned int step) {
+template <typename T>
+bool SteadyState<T>::stop_now(unsigned int step) {
     if (step >= max_step() - 1) return true;
     if (jfnk_.relative_residual_norms().global() < jfnk_.target_residual()) return true;
     return false;
 }
 
-std::string SteadyState::stop_reason(unsigned int step) {
+template <typename T>
+std::string SteadyState<T>::stop_reason(unsigned int step) {
     if (step >= max_step() - 1) return "reached max_step";
     if (jfnk_.relative_residual_norms().global() < jfnk_.target_residual()) {
         return "reached target residual";
@@ -303,16 +721,17 @@ std::string SteadyState::stop_reason(unsigned int step) {
     return "Shouldn't reach here";
 }
 
-bool SteadyState::write_residuals(unsigned int step, Ibis::real wc) {
+template <typename T>
+bool SteadyState<T>::write_residuals(unsigned int step, Ibis::real wc) {
     spdlog::debug("Writing residuals at step {}", step);
 
     // the absolute residuals
-    ConservedQuantitiesNorm<Ibis::dual> abs_norms = jfnk_.residual_norms();
+    ConservedQuantitiesNorm<T> abs_norms = jfnk_.residual_norms();
     std::ofstream residual_file("log/absolute_residuals.dat", std::ios_base::app);
     abs_norms.write_to_file(residual_file, wc, (Ibis::real)step, step);
 
     // the relative residuals
-    ConservedQuantitiesNorm<Ibis::dual> rel_norms = jfnk_.relative_residual_norms();
+    ConservedQuantitiesNorm<T> rel_norms = jfnk_.relative_residual_norms();
     std::ofstream relative_residual_file("log/relative_residuals.dat",
                                          std::ios_base::app);
     rel_norms.write_to_file(relative_residual_file, wc, (Ibis::real)step, step);
@@ -324,3 +743,210 @@ bool SteadyState::write_residuals(unsigned int step, Ibis::real wc) {
                       << gmres_result.n_iters << std::endl;
     return true;
 }
+
+template class SteadyState<Ibis::dual>;
+template class SteadyState<Ibis::real>;
+
+#ifndef DOCTEST_CONFIG_DISABLE
+namespace {
+
+// a first order inviscid simulation of air on grid_io, whose boundaries
+// copy the flow next to them into the ghost cells
+json linearisation_config_(const GridIO& grid_io) {
+    json internal_copy{{"type", "internal_copy"}};
+    json boundaries;
+    for (const auto& [tag, faces] : grid_io.markers()) {
+        boundaries[tag] = {{"ghost_cells", true},
+                           {"pre_reconstruction", json::array({internal_copy})},
+                           {"post_convective_flux", json::array()},
+                           {"pre_viscous_grad", json::array()}};
+    }
+    json grid_config{{"boundaries", boundaries},
+                     {"motion", {{"enabled", false}}},
+                     {"renumber", "none"},
+                     {"cache", false},
+                     {"geometry_cache",
+                      {{"face_weights", true},
+                       {"signed_areas", true},
+                       {"inverse_volumes", true},
+                       {"centre_offsets", true}}}};
+    json convective_flux{{"flux_calculator", {{"type", "hanel"}}},
+                         {"reconstruction_order", 1},
+                         {"fused", false}};
+    json gas_model{{"R", 287.0}, {"Cv", 717.5}, {"Cp", 1004.5}, {"gamma", 1.4}};
+    json transport_properties{
+        {"viscosity",
+         {{"type", "sutherland"}, {"mu_0", 1.716e-5}, {"T_0", 273.0}, {"T_s", 110.4}}},
+        {"thermal_conductivity", {{"type", "constant_prandtl_number"}, {"Pr", 0.72}}}};
+    return json{{"grid", grid_config},
+                {"convective_flux", convective_flux},
+                {"viscous_flux", {{"enabled", false}, {"signal_factor", 1.0}}},
+                {"gas_model", gas_model},
+                {"transport_properties", transport_properties}};
+}
+
+// The product of the steady state Jacobian with a vector, for a smooth flow
+// on a small grid, using dual numbers (T = Ibis::dual) or finite differences
+// (T = Ibis::real). The pseudo time step is large enough that its
+// contribution to the product is negligible.
+template <typename T>
+std::vector<Ibis::real> jacobian_vector_product_(bool central_difference) {
+    GridIO grid_io = structured_grid(6, 5);
+    json config = linearisation_config_(grid_io);
+    json grid_config = config.at("grid");
+    GridBlock<T> grid(grid_io, grid_config);
+    auto sim = std::make_shared<Sim<T>>(grid, config);
+    size_t n_total_cells = sim->grid.num_total_cells();
+    size_t n_cells = sim->grid.num_cells();
+    auto fs = std::make_shared<FlowStates<T>>(n_total_cells);
+    auto cq = std::make_shared<ConservedQuantities<T>>(n_total_cells, sim->grid.dim());
+    auto residuals =
+        std::make_shared<ConservedQuantities<T>>(n_total_cells, sim->grid.dim());
+
+    auto centroids = sim->grid.cells().centroids();
+    FlowStates<T> flow = *fs;
+    Kokkos::parallel_for(
+        "test::smooth_flow", n_cells, KOKKOS_LAMBDA(const size_t i) {
+            Ibis::real x = Ibis::real_part(centroids.x(i));
+            Ibis::real y = Ibis::real_part(centroids.y(i));
+            Ibis::real wave = Kokkos::sin(6.0 * x) * Kokkos::cos(4.0 * y);
+            flow.gas.rho(i) = 1.0 + 0.1 * wave;
+            flow.gas.temp(i) = 300.0 - 20.0 * wave;
+            flow.vel.x(i) = 200.0 + 50.0 * wave;
+            flow.vel.y(i) = 30.0 * wave;
+            flow.vel.z(i) = 0.0;
+        });
+    sim->gas_model.update_thermo_from_rhoT(flow.gas);
+    primatives_to_conserved(*cq, *fs, sim->gas_model);
+
+    std::unique_ptr<PseudoTransientLinearSystem> system;
+    if constexpr (std::is_same<T, Ibis::dual>::value) {
+        system = std::make_unique<SteadyStateLinearisation>(sim, residuals, cq, fs,
+                                                            nullptr);
+    } else {
+        system = std::make_unique<SteadyStateFDLinearisation>(sim, residuals, cq, fs,
+                                                              central_difference);
+    }
+    system->set_pseudo_time_step(1e30);
+    system->eval_rhs();
+
+    // a vector scaled like the conserved quantities, as
+    // the updates in a Newton iteration would be
+    size_t n_cons = cq->n_conserved();
+    Ibis::Vector<Ibis::real> vec("test::vec", system->num_vars());
+    Ibis::Vector<Ibis::real> result("test::result", system->num_vars());
+    ConservedQuantities<T> U = *cq;
+    Kokkos::parallel_for(
+        "test::vec", n_cells, KOKKOS_LAMBDA(const size_t i) {
+            for (size_t j = 0; j < n_cons; j++) {
+                vec(i * n_cons + j) =
+                    Ibis::real_part(U(i, j)) * Kokkos::sin(0.37 * (i * n_cons + j));
+            }
+        });
+    system->matrix_vector_product(vec, result);
+
+    auto host_result = result.host_mirror();
+    host_result.deep_copy_space(result);
+    std::vector<Ibis::real> product(host_result.size());
+    for (size_t i = 0; i < product.size(); i++) {
+        product[i] = host_result(i);
+    }
+    return product;
+}
+
+Ibis::real relative_difference_(const std::vector<Ibis::real>& a,
+                                const std::vector<Ibis::real>& b) {
+    Ibis::real difference = 0.0;
+    Ibis::real norm = 0.0;
+    for (size_t i = 0; i < a.size(); i++) {
+        difference += (a[i] - b[i]) * (a[i] - b[i]);
+        norm += b[i] * b[i];
+    }
+    return Ibis::sqrt(difference / norm);
+}
+
+}  // namespace
+
+// The finite difference products should match the exact products from dual
+// numbers to about half the significant digits with forward differences,
+// and two thirds with central differences
+TEST_CASE("finite difference Jacobian-vector products") {
+    std::vector<Ibis::real> exact = jacobian_vector_product_<Ibis::dual>(false);
+    std::vector<Ibis::real> forward = jacobian_vector_product_<Ibis::real>(false);
+    std::vector<Ibis::real> central = jacobian_vector_product_<Ibis::real>(true);
+    REQUIRE(forward.size() == exact.size());
+    REQUIRE(central.size() == exact.size());
+
+    Ibis::real eps = std::numeric_limits<Ibis::real>::epsilon();
+    Ibis::real forward_error = relative_difference_(forward, exact);
+    Ibis::real central_error = relative_difference_(central, exact);
+    CHECK(forward_error < 1e3 * std::sqrt(eps));
+    CHECK(central_error < 1e3 * std::pow(eps, 2.0 / 3.0));
+    CHECK(central_error < forward_error);
+}
+
+// With the Eisenstat-Walker forcing term, the linear tolerance is loose (up
+// to 0.9) while the non-linear residual drops slowly. A small perturbation
+// of a thin, supersonic flow has an absolute residual well below that, so
+// this checks every linear solve still does some work and Newton converges.
+TEST_CASE("JFNK converges with the Eisenstat-Walker forcing term") {
+    GridIO grid_io = structured_grid(6, 5);
+    json config = linearisation_config_(grid_io);
+    json grid_config = config.at("grid");
+    GridBlock<Ibis::dual> grid(grid_io, grid_config);
+    auto sim = std::make_shared<Sim<Ibis::dual>>(grid, config);
+    size_t n_total_cells = sim->grid.num_total_cells();
+    size_t n_cells = sim->grid.num_cells();
+    auto fs = std::make_shared<FlowStates<Ibis::dual>>(n_total_cells);
+    auto cq =
+        std::make_shared<ConservedQuantities<Ibis::dual>>(n_total_cells, sim->grid.dim());
+    auto residuals =
+        std::make_shared<ConservedQuantities<Ibis::dual>>(n_total_cells, sim->grid.dim());
+
+    auto centroids = sim->grid.cells().centroids();
+    FlowStates<Ibis::dual> flow = *fs;
+    Kokkos::parallel_for(
+        "test::perturbed_flow", n_cells, KOKKOS_LAMBDA(const size_t i) {
+            Ibis::real x = Ibis::real_part(centroids.x(i));
+            Ibis::real y = Ibis::real_part(centroids.y(i));
+            Ibis::real wave = 1e-7 * Kokkos::sin(6.0 * x) * Kokkos::cos(4.0 * y);
+            flow.gas.rho(i) = 1e-5 * (1.0 + wave);
+            flow.gas.temp(i) = 300.0 * (1.0 - wave);
+            flow.vel.x(i) = 700.0 * (1.0 + wave);
+            flow.vel.y(i) = 30.0 * wave;
+            flow.vel.z(i) = 0.0;
+        });
+    sim->gas_model.update_thermo_from_rhoT(flow.gas);
+    primatives_to_conserved(*cq, *fs, sim->gas_model);
+
+    json linear_solver{{"type", "gmres"},
+                       {"max_iters", 50},
+                       {"tol", 0.5},
+                       {"orthogonalisation", "mgs"},
+                       {"krylov_precision", "double"}};
+    json cfl{{"type", "linear_interpolate"},
+             {"times", json::array({0.0, 20.0})},
+             {"cfls", json::array({10.0, 1e4})}};
+    json jfnk_config{{"max_steps", 60},
+                     {"tolerance", 1e-6},
+                     {"warm_start", false},
+                     {"linear_solver", linear_solver},
+                     {"forcing_term", "eisenstat_walker"},
+                     {"max_forcing_term", 0.9}};
+    std::shared_ptr<PseudoTransientLinearSystem> system{
+        new SteadyStateLinearisation(sim, residuals, cq, fs, nullptr)};
+    Jfnk<Ibis::dual> jfnk(system, make_cfl_schedule(cfl), residuals, jfnk_config);
+    jfnk.initialise();
+    REQUIRE(Ibis::real_part(jfnk.residual_norms().global()) < 0.5);
+
+    size_t step = 0;
+    while (Ibis::real_part(jfnk.relative_residual_norms().global()) >= 1e-6 &&
+           step < jfnk.max_steps()) {
+        CAPTURE(step);
+        LinearSolveResult result = jfnk.step(sim, *cq, *fs, step);
+        CHECK(result.n_iters > 0);
+        step++;
+    }
+    CHECK(Ibis::real_part(jfnk.relative_residual_norms().global()) < 1e-6);
+}
+#endif
@@ -21,7 +21,8 @@ public:
                              std::shared_ptr<ConservedQuantities<Ibis::dual>> cq,
                              std::shared_ptr<FlowStates<Ibis::dual>> fs,
                              std::shared_ptr<Vector3s<Ibis::dual>> vertex_vel,
-                             bool allow_reconstruction = true);
+                             bool allow_reconstruction = true,
+                             std::shared_ptr<Sim<Ibis::dual4>> batch_sim = nullptr);
 
     ~SteadyStateLinearisation() {}
 
@@ -47,10 +48,25 @@ public:
 
     size_t num_vars() const { return n_vars_; };
 
+    // Assemble the Jacobian of the system as a block sparse matrix, with
+    // one block per pair of neighbouring cells. The columns are computed
+    // with dual numbers, perturbing every cell of a colour at once, so
+    // only one residual evaluation per colour per conserved quantity is
+    // required (or one per Ibis::dual_lanes conserved quantities, if a
+    // simulation with multi-lane dual numbers is available). This is
+    // exact for first order inviscid residuals.
+    Ibis::BlockSparseMatrix allocate_matrix();
+
+    void assemble(Ibis::BlockSparseMatrix& matrix);
+
+    std::unique_ptr<Preconditioner> lusgs_preconditioner();
+
 public:
     // some specific methods
     void set_pseudo_time_step(Ibis::real dt_star);
 
+    Ibis::real pseudo_time_step() const { return dt_star_; }
+
 private:
     Ibis::real dt_star_;
     bool allow_reconstruction_;
@@ -76,14 +92,143 @@ private:
     ConservedQuantities<Ibis::dual> cq_tmp_;  // storage for perturbed cq
     Vector3s<Ibis::dual> vertex_pos_tmp_;     // storage for perturbed vertex pos
 
+    // the distance-2 colouring of the cells used to assemble the Jacobian
+    Kokkos::View<size_t*> colours_;
+    size_t n_colours_ = 0;
+
     // the simulation
     std::shared_ptr<Sim<Ibis::dual>> sim_;
+
+    // an optional copy of the simulation using multi-lane dual numbers,
+    // and the memory to evaluate the residuals with it
+    std::shared_ptr<Sim<Ibis::dual4>> batch_sim_;
+    FlowStates<Ibis::dual4> batch_fs_tmp_;
+    ConservedQuantities<Ibis::dual4> batch_cq_tmp_;
+    ConservedQuantities<Ibis::dual4> batch_residuals_;
+
+public:  // this is public to appease NVCC
+    void assemble_batched_(Ibis::BlockSparseMatrix& matrix);
+};
+
+// How the Jacobian-vector products of the steady state system are computed
+//   Dual: exactly, using a simulation with dual numbers
+//   ForwardDifference: with a one-sided finite difference of the residuals,
+//       using a simulation with real numbers
+//   CentralDifference: with a central finite difference of the residuals,
+//       which is more accurate, but needs two residual evaluations
+enum class Linearisation { Dual, ForwardDifference, CentralDifference };
+
+Linearisation string_to_linearisation(std::string linearisation);
+
+// Approximates the Jacobian-vector products of the steady state system with
+// a finite difference of the residuals,
+//     J v ~= (R(U + eps v) - R(U)) / eps,
+// with the residuals at the linearisation point, R(U), re-used from eval_rhs.
+// This uses a simulation with real numbers, which needs about half the memory
+// of the dual number linearisation. The perturbation is scaled with the size
+// of U and v, so the products are accurate to about half the significant
+// digits (two thirds with central differences).
+class SteadyStateFDLinearisation : public PseudoTransientLinearSystem {
+public:
+    SteadyStateFDLinearisation(std::shared_ptr<Sim<Ibis::real>> sim,
+                               std::shared_ptr<ConservedQuantities<Ibis::real>> residuals,
+                               std::shared_ptr<ConservedQuantities<Ibis::real>> cq,
+                               std::shared_ptr<FlowStates<Ibis::real>> fs,
+                               bool central_difference, bool allow_reconstruction = true,
+                               std::shared_ptr<size_t> linearisation_point = nullptr);
+
+    ~SteadyStateFDLinearisation() {}
+
+    // SystemLinearisation interface
+    void matrix_vector_product(Ibis::Vector<Ibis::real>& vec,
+                               Ibis::Vector<Ibis::real>& result);
+
+    std::unique_ptr<LinearSystem> preconditioner();
+
+    void eval_rhs();
+
+    void set_rhs(Ibis::Vector<Ibis::real>& rhs);
+
+    KOKKOS_INLINE_FUNCTION
+    Ibis::real& rhs(const size_t i) const { return rhs_(i); }
+
+    KOKKOS_INLINE_FUNCTION
+    Ibis::real& rhs(const size_t cell_i, const size_t cons_i) const {
+        return rhs_(cell_i * n_cons_ + cons_i);
+    }
+
+    Ibis::Vector<Ibis::real>& rhs() { return rhs_; }
+
+    size_t num_vars() const { return n_vars_; };
+
+    // the size of the perturbation for a product with a vector with norm vec_norm
+    Ibis::real perturbation(Ibis::real vec_norm) const {
+        return perturbation_scale_ * (1.0 + base_norm_) / vec_norm;
+    }
+
+public:
+    // some specific methods
+    void set_pseudo_time_step(Ibis::real dt_star);
+
+    Ibis::real pseudo_time_step() const { return dt_star_; }
+
+private:
+    Ibis::real dt_star_;
+    bool allow_reconstruction_;
+    bool central_difference_;
+    Ibis::real perturbation_scale_;
+
+    // memory
+    size_t n_cells_;        // excluding ghost cells
+    size_t n_total_cells_;  // including ghost cells
+    size_t n_cons_;
+    size_t n_vars_;
+
+    // the point to linearise the system of equations around
+    // these are not owned by the linearisation, so the memory
+    // isn't allocated by this class
+    std::shared_ptr<ConservedQuantities<Ibis::real>> cq_;
+    std::shared_ptr<FlowStates<Ibis::real>> fs_;
+    std::shared_ptr<ConservedQuantities<Ibis::real>> residuals_;
+
+    // memory owned by this class
+    Ibis::Vector<Ibis::real> rhs_;  // the rhs of the system of equations
+
+    // temporary storage for the perturbed state and its residuals
+    FlowStates<Ibis::real> fs_tmp_;
+    ConservedQuantities<Ibis::real> cq_tmp_;
+    ConservedQuantities<Ibis::real> residuals_tmp_;
+
+    // The residuals at the linearisation point, and the norm of the
+    // conserved quantities there. eval_rhs moves the linearisation point,
+    // and counts how many times it has, in a counter shared with the
+    // preconditioner systems. The preconditioner systems evaluate their own
+    // residuals (without reconstruction) when the count changes.
+    Ibis::Vector<Ibis::real> base_residuals_;
+    Ibis::real base_norm_;
+    std::shared_ptr<size_t> linearisation_point_;
+    size_t base_point_ = 0;
+
+    // the simulation
+    std::shared_ptr<Sim<Ibis::real>> sim_;
+
+public:  // these are public to appease NVCC
+    void update_base_point_();
+
+    // evaluate the residuals at U + eps vec into residuals_tmp_
+    void perturbed_residuals_(Ibis::Vector<Ibis::real>& vec, Ibis::real eps);
 };
 
+// T is the number type of the simulation, which depends on
+// how the Jacobian-vector products are computed
+template <typename T>
 class SteadyState : public Solver {
 public:
-    SteadyState(json config, GridBlock<Ibis::dual> grid, std::string grid_dir,
-                std::string flow_dir);
+    // batch_grid is the same grid with multi-lane dual numbers, which
+    // is only needed (and required) when batched_dual is enabled
+    SteadyState(json config, GridBlock<T> grid, std::string grid_dir,
+                std::string flow_dir,
+                std::shared_ptr<GridBlock<Ibis::dual4>> batch_grid = nullptr);
 
     ~SteadyState() {}
 
@@ -91,7 +236,7 @@ public:
 
 private:
     // The Jfnk solver
-    Jfnk jfnk_;
+    Jfnk<T> jfnk_;
 
     // configuration
     unsigned int print_frequency_;
@@ -104,7 +249,7 @@ private:
     // Ibis::real dt_star_;
 
     // input/output
-    FVIO<Ibis::dual> io_;
+    FVIO<T> io_;
 
     // implementation
     int initialise();
@@ -128,13 +273,17 @@ private:
 
 private:
     // memory
-    std::shared_ptr<ConservedQuantities<Ibis::dual>> cq_;
-    std::shared_ptr<ConservedQuantities<Ibis::dual>> residuals_;
-    std::shared_ptr<FlowStates<Ibis::dual>> fs_;
-    std::shared_ptr<Vector3s<Ibis::dual>> vertex_vel_;
+    std::shared_ptr<ConservedQuantities<T>> cq_;
+    std::shared_ptr<ConservedQuantities<T>> residuals_;
+    std::shared_ptr<FlowStates<T>> fs_;
+    std::shared_ptr<Vector3s<T>> vertex_vel_;
 
     // the core simulation
-    std::shared_ptr<Sim<Ibis::dual>> sim_;
+    std::shared_ptr<Sim<T>> sim_;
+
+    // the simulation with multi-lane dual numbers, if batched Jacobian
+    // assembly is enabled (dual numbers only)
+    std::shared_ptr<Sim<Ibis::dual4>> batch_sim_;
 };
 
 #endif
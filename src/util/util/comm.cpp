@@ -0,0 +1,158 @@
+#include <doctest/doctest.h>
+#include <util/comm.h>
+
+#ifdef Ibis_USE_MPI
+#include <mpi.h>
+#endif
+
+namespace Ibis {
+
+#ifdef Ibis_USE_MPI
+
+// Programs which never call initialise_comm (e.g. the unit tests of
+// other modules) behave as if they were a single process
+static bool comm_active() {
+    int initialised;
+    int finalised;
+    MPI_Initialized(&initialised);
+    MPI_Finalized(&finalised);
+    return initialised && !finalised;
+}
+
+void initialise_comm(int& argc, char**& argv) {
+    int initialised;
+    MPI_Initialized(&initialised);
+    if (!initialised) {
+        MPI_Init(&argc, &argv);
+    }
+}
+
+void finalise_comm() {
+    int finalised;
+    MPI_Finalized(&finalised);
+    if (!finalised) {
+        MPI_Finalize();
+    }
+}
+
+size_t comm_rank() {
+    if (!comm_active()) return 0;
+    int rank;
+    MPI_Comm_rank(MPI_COMM_WORLD, &rank);
+    return rank;
+}
+
+size_t comm_size() {
+    if (!comm_active()) return 1;
+    int size;
+    MPI_Comm_size(MPI_COMM_WORLD, &size);
+    return size;
+}
+
+Ibis::real all_reduce_min(Ibis::real value) {
+    if (!comm_active()) return value;
+    Ibis::real result;
+    MPI_Allreduce(&value, &result, 1, MPI_DOUBLE, MPI_MIN, MPI_COMM_WORLD);
+    return result;
+}
+
+Ibis::real all_reduce_sum(Ibis::real value) {
+    if (!comm_active()) return value;
+    Ibis::real result;
+    MPI_Allreduce(&value, &result, 1, MPI_DOUBLE, MPI_SUM, MPI_COMM_WORLD);
+    return result;
+}
+
+size_t all_reduce_sum(size_t value) {
+    if (!comm_active()) return value;
+    unsigned long long send = value;
+    unsigned long long result;
+    MPI_Allreduce(&send, &result, 1, MPI_UNSIGNED_LONG_LONG, MPI_SUM, MPI_COMM_WORLD);
+    return result;
+}
+
+void all_reduce_sum(std::vector<Ibis::real>& values) {
+    if (!comm_active()) return;
+    MPI_Allreduce(MPI_IN_PLACE, values.data(), values.size(), MPI_DOUBLE, MPI_SUM,
+                  MPI_COMM_WORLD);
+}
+
+void exchange(const std::vector<CommBuffer>& buffers) {
+    if (!comm_active()) return;
+
+    // post all the receives before any of the sends, so the messages
+    // never wait for a matching receive
+    std::vector<MPI_Request> requests;
+    requests.reserve(2 * buffers.size());
+    for (const CommBuffer& buffer : buffers) {
+        if (buffer.recv_size == 0) continue;
+        requests.emplace_back();
+        MPI_Irecv(buffer.recv, buffer.recv_size, MPI_DOUBLE, buffer.rank, 0,
+                  MPI_COMM_WORLD, &requests.back());
+    }
+    for (const CommBuffer& buffer : buffers) {
+        if (buffer.send_size == 0) continue;
+        requests.emplace_back();
+        MPI_Isend(buffer.send, buffer.send_size, MPI_DOUBLE, buffer.rank, 0,
+                  MPI_COMM_WORLD, &requests.back());
+    }
+    MPI_Waitall(requests.size(), requests.data(), MPI_STATUSES_IGNORE);
+}
+
+#else
+
+void initialise_comm(int& argc, char**& argv) {
+    (void)argc;
+    (void)argv;
+}
+
+void finalise_comm() {}
+
+size_t comm_rank() { return 0; }
+
+size_t comm_size() { return 1; }
+
+Ibis::real all_reduce_min(Ibis::real value) { return value; }
+
+Ibis::real all_reduce_sum(Ibis::real value) { return value; }
+
+size_t all_reduce_sum(size_t value) { return value; }
+
+void all_reduce_sum(std::vector<Ibis::real>& values) { (void)values; }
+
+void exchange(const std::vector<CommBuffer>& buffers) { (void)buffers; }
+
+#endif
+
+}  // namespace Ibis
+
+TEST_CASE("comm reductions") {
+    size_t num_ranks = Ibis::comm_size();
+    size_t rank = Ibis::comm_rank();
+    CHECK(rank < num_ranks);
+    CHECK(Ibis::all_reduce_min(Ibis::real(rank) + 1.0) == 1.0);
+    CHECK(Ibis::all_reduce_sum(Ibis::real(1.0)) == Ibis::real(num_ranks));
+    CHECK(Ibis::all_reduce_sum(size_t(2)) == 2 * num_ranks);
+
+    std::vector<Ibis::real> values{1.0, Ibis::real(rank)};
+    Ibis::all_reduce_sum(values);
+    CHECK(values[0] == Ibis::real(num_ranks));
+    CHECK(values[1] == Ibis::real(num_ranks * (num_ranks - 1) / 2));
+}
+
+TEST_CASE("comm exchange") {
+    // pass a value around a ring of processes
+    size_t num_ranks = Ibis::comm_size();
+    size_t rank = Ibis::comm_rank();
+    if (num_ranks == 1) return;
+    size_t next = (rank + 1) % num_ranks;
+    size_t previous = (rank + num_ranks - 1) % num_ranks;
+    Ibis::real send = Ibis::real(rank);
+    Ibis::real recv = -1.0;
+    if (num_ranks == 2) {
+        Ibis::exchange({{next, &send, 1, &recv, 1}});
+    } else {
+        Ibis::exchange({{next, &send, 1, nullptr, 0}, {previous, nullptr, 0, &recv, 1}});
+    }
+    CHECK(recv == Ibis::real(previous));
+}
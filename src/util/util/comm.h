@@ -0,0 +1,55 @@
+#ifndef COMM_H
+#define COMM_H
+
+#include <util/real.h>
+
+#include <cstddef>
+#include <vector>
+
+namespace Ibis {
+
+// Communication between the processes of a run. When ibis is built with
+// Ibis_USE_MPI these go through MPI_COMM_WORLD, otherwise there is only
+// ever one process and they do nothing.
+//
+// Only the explicit solver is distributed: its blocks are shared out
+// between the processes, but the first process still reads and writes the
+// flow of the whole grid, and the linear algebra (Ibis::dot, Ibis::norm2
+// and so on) only ever works on the vectors of one process.
+
+void initialise_comm(int& argc, char**& argv);
+
+void finalise_comm();
+
+size_t comm_rank();
+
+size_t comm_size();
+
+inline bool is_root_rank() { return comm_rank() == 0; }
+
+// The minimum or sum of value over all the processes
+Ibis::real all_reduce_min(Ibis::real value);
+Ibis::real all_reduce_sum(Ibis::real value);
+size_t all_reduce_sum(size_t value);
+
+// the element-wise sum of values over all the processes, in place
+void all_reduce_sum(std::vector<Ibis::real>& values);
+
+// The data passed to and from one other process by exchange. Either
+// side can be empty.
+struct CommBuffer {
+    size_t rank;
+    const Ibis::real* send;
+    size_t send_size;
+    Ibis::real* recv;
+    size_t recv_size;
+};
+
+// Send and receive all the buffers at once, returning when every
+// message has arrived. The other processes must post the matching
+// buffers, with the same sizes.
+void exchange(const std::vector<CommBuffer>& buffers);
+
+}  // namespace Ibis
+
+#endif
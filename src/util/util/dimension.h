@@ -0,0 +1,36 @@
+#ifndef DIMENSION_H
+#define DIMENSION_H
+
+#include <stdexcept>
+#include <string>
+#include <type_traits>
+
+namespace Ibis {
+
+// The number of spatial dimensions, as a compile time constant
+template <int N>
+using Dim = std::integral_constant<int, N>;
+
+// Call `function` with the number of spatial dimensions as a compile time
+// constant (Dim<2> or Dim<3>). This lets kernels be compiled separately
+// for two and three dimensions, instead of checking the number of
+// dimensions for every cell or face. It only changes the loops, not the
+// storage: flow states still hold three velocity components in 2D.
+template <class Function>
+void dispatch_dim(int dim, Function&& function) {
+    switch (dim) {
+        case 2:
+            function(Dim<2>());
+            break;
+        case 3:
+            function(Dim<3>());
+            break;
+        default:
+            throw std::runtime_error("Unsupported number of dimensions " +
+                                     std::to_string(dim));
+    }
+}
+
+}  // namespace Ibis
+
+#endif
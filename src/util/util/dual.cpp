@@ -219,3 +219,34 @@ TEST_CASE("Dual::abs(x^2)_2") {
     CHECK(y.real() == doctest::Approx(1.0));
     CHECK(y.dual() == doctest::Approx(2.0));
 }
+
+TEST_CASE("Dual::multiple_lanes") {
+    Ibis::Dual<Ibis::real, 3> x{3.0};
+    Ibis::Dual<Ibis::real, 3> y{2.0};
+    for (size_t i = 0; i < 3; i++) {
+        x.dual(i) = Ibis::real(i);
+        y.dual(i) = 1.0;
+    }
+    auto d = x * y / (x + y);
+
+    // d(xy/(x+y)) = (y^2 dx + x^2 dy) / (x+y)^2
+    CHECK(d.real() == doctest::Approx(1.2));
+    for (size_t i = 0; i < 3; i++) {
+        CHECK(d.dual(i) == doctest::Approx((4.0 * i + 9.0) / 25.0));
+    }
+}
+
+TEST_CASE("Dual::multiple_lanes_match_single_lane") {
+    Ibis::dual4 x{1.5};
+    for (size_t i = 0; i < Ibis::dual_lanes; i++) {
+        x.dual(i) = 0.5 * i - 1.0;
+    }
+    Ibis::dual4 d = Ibis::pow(Ibis::sqrt(x) * Ibis::sin(x), Ibis::dual4{2.0});
+
+    for (size_t i = 0; i < Ibis::dual_lanes; i++) {
+        Ibis::dual xi{1.5, 0.5 * i - 1.0};
+        Ibis::dual di = Ibis::pow(Ibis::sqrt(xi) * Ibis::sin(xi), Ibis::dual{2.0});
+        CHECK(d.real() == doctest::Approx(di.real()));
+        CHECK(Ibis::dual_part(d, i) == doctest::Approx(di.dual()));
+    }
+}
@@ -7,194 +7,273 @@
 
 namespace Ibis {
 
-template <typename T>
+// A dual number, with N independent derivative directions (lanes).
+// The operations on the dual parts are simple loops over the
+// lanes, which the compiler can vectorise.
+template <typename T, size_t N = 1>
 class Dual {
 public:
     // constructors
     KOKKOS_INLINE_FUNCTION
-    Dual(T real, T dual) : real_(real), dual_(dual) {}
+    Dual(T real, T dual) : real_(real) {
+        static_assert(N == 1, "Use Dual(real) and set the lanes with dual(i)");
+        dual_[0] = dual;
+    }
 
     KOKKOS_INLINE_FUNCTION
-    Dual(T real) : real_(real), dual_(T(0.0)) {}
+    Dual(T real) : real_(real) {
+        for (size_t i = 0; i < N; i++) {
+            dual_[i] = T(0.0);
+        }
+    }
 
     KOKKOS_INLINE_FUNCTION
-    Dual() : real_(T(0.0)), dual_(T(0.0)) {}
+    Dual() : Dual(T(0.0)) {}
 
     KOKKOS_INLINE_FUNCTION
-    Dual(Dual<T>& other) : real_(other.real_), dual_(other.dual_) {}
+    Dual(Dual<T, N>& other) : real_(other.real_) {
+        for (size_t i = 0; i < N; i++) {
+            dual_[i] = other.dual_[i];
+        }
+    }
 
     KOKKOS_INLINE_FUNCTION
-    Dual(const Dual<T>& other) : real_(other.real_), dual_(other.dual_) {}
+    Dual(const Dual<T, N>& other) : real_(other.real_) {
+        for (size_t i = 0; i < N; i++) {
+            dual_[i] = other.dual_[i];
+        }
+    }
 
     // assignment operators
     KOKKOS_INLINE_FUNCTION
-    Dual<T>& operator=(const T& real) {
+    Dual<T, N>& operator=(const T& real) {
         this->real_ = real;
-        this->dual_ = T(0.0);
+        for (size_t i = 0; i < N; i++) {
+            this->dual_[i] = T(0.0);
+        }
         return *this;
     }
 
     KOKKOS_INLINE_FUNCTION
-    Dual<T>& operator=(const Dual<T>& other) {
+    Dual<T, N>& operator=(const Dual<T, N>& other) {
         this->real_ = other.real_;
-        this->dual_ = other.dual_;
+        for (size_t i = 0; i < N; i++) {
+            this->dual_[i] = other.dual_[i];
+        }
         return *this;
     }
 
     // comparison operators
     KOKKOS_INLINE_FUNCTION
-    friend bool operator<(const Dual<T>& lhs, const Dual<T>& rhs) {
+    friend bool operator<(const Dual<T, N>& lhs, const Dual<T, N>& rhs) {
         return lhs.real_ < rhs.real_;
     }
 
     KOKKOS_INLINE_FUNCTION
-    friend bool operator>(const Dual<T>& lhs, const Dual<T>& rhs) {
+    friend bool operator>(const Dual<T, N>& lhs, const Dual<T, N>& rhs) {
         return lhs.real_ > rhs.real_;
     }
 
     KOKKOS_INLINE_FUNCTION
-    friend bool operator<=(const Dual<T>& lhs, const Dual<T>& rhs) {
+    friend bool operator<=(const Dual<T, N>& lhs, const Dual<T, N>& rhs) {
         return lhs.real_ <= rhs.real_;
     }
 
     KOKKOS_INLINE_FUNCTION
-    friend bool operator>=(const Dual<T>& lhs, const Dual<T>& rhs) {
+    friend bool operator>=(const Dual<T, N>& lhs, const Dual<T, N>& rhs) {
         return lhs.real_ >= rhs.real_;
     }
 
     KOKKOS_INLINE_FUNCTION
-    friend bool operator==(const Dual<T>& lhs, const Dual<T>& rhs) {
+    friend bool operator==(const Dual<T, N>& lhs, const Dual<T, N>& rhs) {
         return lhs.real_ == rhs.real_;
     }
 
     KOKKOS_INLINE_FUNCTION
-    friend bool operator!=(const Dual<T>& lhs, const Dual<T>& rhs) {
+    friend bool operator!=(const Dual<T, N>& lhs, const Dual<T, N>& rhs) {
         return lhs.real_ != rhs.real_;
     }
 
     // addition operators
     KOKKOS_INLINE_FUNCTION
-    friend Dual<T> operator+(const Dual<T>& lhs, const Dual<T>& rhs) {
-        return Dual<T>{lhs.real_ + rhs.real_, lhs.dual_ + rhs.dual_};
+    friend Dual<T, N> operator+(const Dual<T, N>& lhs, const Dual<T, N>& rhs) {
+        Dual<T, N> result{lhs.real_ + rhs.real_};
+        for (size_t i = 0; i < N; i++) {
+            result.dual_[i] = lhs.dual_[i] + rhs.dual_[i];
+        }
+        return result;
     }
 
     KOKKOS_INLINE_FUNCTION
-    friend Dual<T> operator+(const Dual<T>& lhs, const T& rhs) {
-        return Dual<T>{lhs.real_ + rhs, lhs.dual_};
+    friend Dual<T, N> operator+(const Dual<T, N>& lhs, const T& rhs) {
+        Dual<T, N> result{lhs};
+        result.real_ += rhs;
+        return result;
     }
 
     KOKKOS_INLINE_FUNCTION
-    friend Dual<T> operator+(const T& lhs, const Dual<T>& rhs) {
-        return Dual<T>{lhs + rhs.real_, rhs.dual_};
+    friend Dual<T, N> operator+(const T& lhs, const Dual<T, N>& rhs) {
+        Dual<T, N> result{rhs};
+        result.real_ += lhs;
+        return result;
     }
 
     KOKKOS_INLINE_FUNCTION
-    Dual<T>& operator+=(const Dual<T>& other) {
+    Dual<T, N>& operator+=(const Dual<T, N>& other) {
         this->real_ += other.real_;
-        this->dual_ += other.dual_;
+        for (size_t i = 0; i < N; i++) {
+            this->dual_[i] += other.dual_[i];
+        }
         return *this;
     }
 
     KOKKOS_INLINE_FUNCTION
-    Dual<T> operator+=(const T& re) {
+    Dual<T, N> operator+=(const T& re) {
         this->real_ += re;
         return *this;
     }
 
     // subtraction operators
     KOKKOS_INLINE_FUNCTION
-    friend Dual<T> operator-(const Dual<T>& lhs, const Dual<T>& rhs) {
-        return Dual<T>{lhs.real_ - rhs.real_, lhs.dual_ - rhs.dual_};
+    friend Dual<T, N> operator-(const Dual<T, N>& lhs, const Dual<T, N>& rhs) {
+        Dual<T, N> result{lhs.real_ - rhs.real_};
+        for (size_t i = 0; i < N; i++) {
+            result.dual_[i] = lhs.dual_[i] - rhs.dual_[i];
+        }
+        return result;
     }
 
     KOKKOS_INLINE_FUNCTION
-    friend Dual<T> operator-(const Dual<T>& lhs, const T& rhs) {
-        return Dual<T>{lhs.real_ - rhs, lhs.dual_};
+    friend Dual<T, N> operator-(const Dual<T, N>& lhs, const T& rhs) {
+        Dual<T, N> result{lhs};
+        result.real_ -= rhs;
+        return result;
     }
 
     KOKKOS_INLINE_FUNCTION
-    friend Dual<T> operator-(const T& lhs, const Dual<T>& rhs) {
-        return Dual<T>{lhs - rhs.real_, -rhs.dual_};
+    friend Dual<T, N> operator-(const T& lhs, const Dual<T, N>& rhs) {
+        Dual<T, N> result{lhs - rhs.real_};
+        for (size_t i = 0; i < N; i++) {
+            result.dual_[i] = -rhs.dual_[i];
+        }
+        return result;
     }
 
     KOKKOS_INLINE_FUNCTION
-    Dual<T>& operator-=(const Dual<T>& other) {
+    Dual<T, N>& operator-=(const Dual<T, N>& other) {
         this->real_ -= other.real_;
-        this->dual_ -= other.dual_;
+        for (size_t i = 0; i < N; i++) {
+            this->dual_[i] -= other.dual_[i];
+        }
         return *this;
     }
 
     KOKKOS_INLINE_FUNCTION
-    Dual<T>& operator-=(T re) {
+    Dual<T, N>& operator-=(T re) {
         this->real_ -= re;
         return *this;
     }
 
     // negation operator
     KOKKOS_INLINE_FUNCTION
-    Dual<T> operator-() const { return Dual<T>{-this->real_, -this->dual_}; }
+    Dual<T, N> operator-() const {
+        Dual<T, N> result{-this->real_};
+        for (size_t i = 0; i < N; i++) {
+            result.dual_[i] = -this->dual_[i];
+        }
+        return result;
+    }
 
     // multiplication operators
     KOKKOS_INLINE_FUNCTION
-    friend Dual<T> operator*(const Dual<T>& lhs, const Dual<T>& rhs) {
-        return Dual<T>{lhs.real_ * rhs.real_,
-                       lhs.real_ * rhs.dual_ + lhs.dual_ * rhs.real_};
+    friend Dual<T, N> operator*(const Dual<T, N>& lhs, const Dual<T, N>& rhs) {
+        Dual<T, N> result{lhs.real_ * rhs.real_};
+        for (size_t i = 0; i < N; i++) {
+            result.dual_[i] = lhs.real_ * rhs.dual_[i] + lhs.dual_[i] * rhs.real_;
+        }
+        return result;
     }
 
     KOKKOS_INLINE_FUNCTION
-    friend Dual<T> operator*(const Dual<T>& lhs, const T& rhs) {
-        return Dual<T>{lhs.real_ * rhs, lhs.dual_ * rhs};
+    friend Dual<T, N> operator*(const Dual<T, N>& lhs, const T& rhs) {
+        Dual<T, N> result{lhs.real_ * rhs};
+        for (size_t i = 0; i < N; i++) {
+            result.dual_[i] = lhs.dual_[i] * rhs;
+        }
+        return result;
     }
 
     KOKKOS_INLINE_FUNCTION
-    friend Dual<T> operator*(const T& lhs, const Dual<T>& rhs) {
-        return Dual<T>{rhs.real_ * lhs, rhs.dual_ * lhs};
+    friend Dual<T, N> operator*(const T& lhs, const Dual<T, N>& rhs) {
+        return rhs * lhs;
     }
 
     KOKKOS_INLINE_FUNCTION
-    Dual<T>& operator*=(const Dual<T>& other) {
-        this->dual_ = this->real_ * other.dual_ + this->dual_ * other.real_;
+    Dual<T, N>& operator*=(const Dual<T, N>& other) {
+        for (size_t i = 0; i < N; i++) {
+            this->dual_[i] = this->real_ * other.dual_[i] + this->dual_[i] * other.real_;
+        }
         this->real_ *= other.real_;
         return *this;
     }
 
     KOKKOS_INLINE_FUNCTION
-    Dual<T>& operator*=(T re) {
+    Dual<T, N>& operator*=(T re) {
         this->real_ *= re;
-        this->dual_ *= re;
+        for (size_t i = 0; i < N; i++) {
+            this->dual_[i] *= re;
+        }
         return *this;
     }
 
     // division operators
     KOKKOS_INLINE_FUNCTION
-    friend Dual<T> operator/(const Dual<T>& num, const Dual<T>& den) {
-        return Dual<T>{
-            num.real_ / den.real_,
-            (num.dual_ * den.real_ - num.real_ * den.dual_) / (den.real_ * den.real_)};
+    friend Dual<T, N> operator/(const Dual<T, N>& num, const Dual<T, N>& den) {
+        Dual<T, N> result{num.real_ / den.real_};
+        T den2 = den.real_ * den.real_;
+        for (size_t i = 0; i < N; i++) {
+            result.dual_[i] =
+                (num.dual_[i] * den.real_ - num.real_ * den.dual_[i]) / den2;
+        }
+        return result;
     }
 
     KOKKOS_INLINE_FUNCTION
-    friend Dual<T> operator/(const Dual<T>& num, const T& den) {
-        return Dual<T>{num.real_ / den, num.dual_ / den};
+    friend Dual<T, N> operator/(const Dual<T, N>& num, const T& den) {
+        Dual<T, N> result{num.real_ / den};
+        for (size_t i = 0; i < N; i++) {
+            result.dual_[i] = num.dual_[i] / den;
+        }
+        return result;
     }
 
     KOKKOS_INLINE_FUNCTION
-    friend Dual<T> operator/(const T& num, const Dual<T>& den) {
-        return Dual<T>{num / den.real_, -den.dual_ * num / (den.real_ * den.real_)};
+    friend Dual<T, N> operator/(const T& num, const Dual<T, N>& den) {
+        Dual<T, N> result{num / den.real_};
+        T den2 = den.real_ * den.real_;
+        for (size_t i = 0; i < N; i++) {
+            result.dual_[i] = -den.dual_[i] * num / den2;
+        }
+        return result;
     }
 
     KOKKOS_INLINE_FUNCTION
-    Dual<T>& operator/=(const Dual<T>& other) {
-        this->dual_ = (this->dual_ * other.real_ - this->real_ * other.dual_) /
-                      (other.real_ * other.real_);
+    Dual<T, N>& operator/=(const Dual<T, N>& other) {
+        T den2 = other.real_ * other.real_;
+        for (size_t i = 0; i < N; i++) {
+            this->dual_[i] =
+                (this->dual_[i] * other.real_ - this->real_ * other.dual_[i]) / den2;
+        }
         this->real_ /= other.real_;
         return *this;
     }
 
     KOKKOS_INLINE_FUNCTION
-    Dual<T>& operator/=(T re) {
+    Dual<T, N>& operator/=(T re) {
         this->real_ /= re;
-        this->dual_ /= re;
+        for (size_t i = 0; i < N; i++) {
+            this->dual_[i] /= re;
+        }
         return *this;
     }
 
@@ -203,133 +282,176 @@ public:
     T real() const { return this->real_; }
 
     KOKKOS_INLINE_FUNCTION
-    T dual() const { return this->dual_; }
+    T dual() const {
+        static_assert(N == 1, "Use dual(i) to access the lanes of a multi-lane dual");
+        return this->dual_[0];
+    }
+
+    KOKKOS_INLINE_FUNCTION
+    T dual(size_t i) const { return this->dual_[i]; }
 
     KOKKOS_INLINE_FUNCTION
     T& real() { return this->real_; }
 
     KOKKOS_INLINE_FUNCTION
-    T& dual() { return this->dual_; }
+    T& dual() {
+        static_assert(N == 1, "Use dual(i) to access the lanes of a multi-lane dual");
+        return this->dual_[0];
+    }
 
     KOKKOS_INLINE_FUNCTION
-    Dual<T> abs() const { return (real_ < T(0.0)) ? -(*this) : *this; }
+    T& dual(size_t i) { return this->dual_[i]; }
+
+    static constexpr size_t lanes() { return N; }
 
     KOKKOS_INLINE_FUNCTION
-    Dual<T> conjugate() const { return Dual<T>{this->real_, -this->dual_}; }
+    Dual<T, N> abs() const { return (real_ < T(0.0)) ? -(*this) : *this; }
+
+    KOKKOS_INLINE_FUNCTION
+    Dual<T, N> conjugate() const {
+        Dual<T, N> result{this->real_};
+        for (size_t i = 0; i < N; i++) {
+            result.dual_[i] = -this->dual_[i];
+        }
+        return result;
+    }
+
+    // apply the chain rule: the result has real part f, and
+    // dual parts df_dx times the dual parts of this number
+    KOKKOS_INLINE_FUNCTION
+    Dual<T, N> chain(T f, T df_dx) const {
+        Dual<T, N> result{f};
+        for (size_t i = 0; i < N; i++) {
+            result.dual_[i] = df_dx * this->dual_[i];
+        }
+        return result;
+    }
 
 private:
     T real_;
-    T dual_;
+    T dual_[N];
 };
 
 // stand alone math functions
-template <typename T>
-KOKKOS_INLINE_FUNCTION Dual<T> sqrt(const Dual<T>& d) {
+template <typename T, size_t N>
+KOKKOS_INLINE_FUNCTION Dual<T, N> sqrt(const Dual<T, N>& d) {
     T real = Kokkos::sqrt(d.real());
-    T dual = d.dual() / (T(2.0) * real);
-    return Dual<T>{real, dual};
+    return d.chain(real, T(1.0) / (T(2.0) * real));
 }
 
-template <typename T>
-KOKKOS_INLINE_FUNCTION Dual<T> abs(const Dual<T>& d) {
+template <typename T, size_t N>
+KOKKOS_INLINE_FUNCTION Dual<T, N> abs(const Dual<T, N>& d) {
     return d.abs();
 }
 
-template <typename T>
-KOKKOS_INLINE_FUNCTION Dual<T> pow(const Dual<T>& base, const Dual<T>& power) {
+template <typename T, size_t N>
+KOKKOS_INLINE_FUNCTION Dual<T, N> pow(const Dual<T, N>& base, const Dual<T, N>& power) {
     T real = Kokkos::pow(base.real(), power.real());
-    T dual =
-        base.dual() * power.real() * Kokkos::pow(base.real(), power.real() - T(1.0)) +
-        power.dual() * real * Kokkos::log(base.real());
-    return Dual<T>{real, dual};
+    T d_base = power.real() * Kokkos::pow(base.real(), power.real() - T(1.0));
+    T d_power = real * Kokkos::log(base.real());
+    Dual<T, N> result{real};
+    for (size_t i = 0; i < N; i++) {
+        result.dual(i) = base.dual(i) * d_base + power.dual(i) * d_power;
+    }
+    return result;
 }
 
-template <typename T>
-KOKKOS_INLINE_FUNCTION Dual<T> sin(const Dual<T>& d) {
-    T real = Kokkos::sin(d.real());
-    T dual = d.dual() * Kokkos::cos(d.real());
-    return Dual<T>{real, dual};
+template <typename T, size_t N>
+KOKKOS_INLINE_FUNCTION Dual<T, N> sin(const Dual<T, N>& d) {
+    return d.chain(Kokkos::sin(d.real()), Kokkos::cos(d.real()));
 }
 
-template <typename T>
-KOKKOS_INLINE_FUNCTION Dual<T> cos(const Dual<T>& d) {
-    T real = Kokkos::cos(d.real());
-    T dual = -d.dual() * Kokkos::sin(d.real());
-    return Dual<T>{real, dual};
+template <typename T, size_t N>
+KOKKOS_INLINE_FUNCTION Dual<T, N> cos(const Dual<T, N>& d) {
+    return d.chain(Kokkos::cos(d.real()), -Kokkos::sin(d.real()));
 }
 
-template <typename T>
-KOKKOS_INLINE_FUNCTION Dual<T> tanh(const Dual<T>& d) {
-    T real = Kokkos::tanh(d.real());
+template <typename T, size_t N>
+KOKKOS_INLINE_FUNCTION Dual<T, N> tanh(const Dual<T, N>& d) {
     T cosh_real = Kokkos::cosh(d.real());
-    T dual = d.dual() / (cosh_real * cosh_real);
-    return Dual<T>{real, dual};
+    return d.chain(Kokkos::tanh(d.real()), T(1.0) / (cosh_real * cosh_real));
 }
 
-template <typename T>
-KOKKOS_INLINE_FUNCTION Dual<T> max(const Dual<T>& d1, const Dual<T>& d2) {
+template <typename T, size_t N>
+KOKKOS_INLINE_FUNCTION Dual<T, N> max(const Dual<T, N>& d1, const Dual<T, N>& d2) {
     return d1.real() > d2.real() ? d1 : d2;
 }
 
-template <typename T>
-KOKKOS_INLINE_FUNCTION Dual<T> max(const T& d1, const Dual<T>& d2) {
-    return d1 > d2.real() ? d1 : d2;
+template <typename T, size_t N>
+KOKKOS_INLINE_FUNCTION Dual<T, N> max(const T& d1, const Dual<T, N>& d2) {
+    return d1 > d2.real() ? Dual<T, N>{d1} : d2;
 }
 
-template <typename T>
-KOKKOS_INLINE_FUNCTION Dual<T> max(const Dual<T>& d1, const T& d2) {
-    return d1.real() > d2 ? d1 : d2;
+template <typename T, size_t N>
+KOKKOS_INLINE_FUNCTION Dual<T, N> max(const Dual<T, N>& d1, const T& d2) {
+    return d1.real() > d2 ? d1 : Dual<T, N>{d2};
 }
 
-template <typename T>
-KOKKOS_INLINE_FUNCTION Dual<T> min(const Dual<T>& d1, const Dual<T>& d2) {
+template <typename T, size_t N>
+KOKKOS_INLINE_FUNCTION Dual<T, N> min(const Dual<T, N>& d1, const Dual<T, N>& d2) {
     return d1.real() < d2.real() ? d1 : d2;
 }
 
-template <typename T>
-KOKKOS_INLINE_FUNCTION Dual<T> min(const T& d1, const Dual<T>& d2) {
-    return d1 < d2.real() ? d1 : d2;
+template <typename T, size_t N>
+KOKKOS_INLINE_FUNCTION Dual<T, N> min(const T& d1, const Dual<T, N>& d2) {
+    return d1 < d2.real() ? Dual<T, N>{d1} : d2;
 }
 
-template <typename T>
-KOKKOS_INLINE_FUNCTION Dual<T> min(const Dual<T>& d1, const T& d2) {
-    return d1.real() < d2 ? d1 : d2;
+template <typename T, size_t N>
+KOKKOS_INLINE_FUNCTION Dual<T, N> min(const Dual<T, N>& d1, const T& d2) {
+    return d1.real() < d2 ? d1 : Dual<T, N>{d2};
 }
 
-template <typename T>
-KOKKOS_INLINE_FUNCTION Dual<T> floor(const Dual<T>& d) {
-    return Dual<T>{Kokkos::floor(d.real()), Kokkos::floor(d.dual())};
+template <typename T, size_t N>
+KOKKOS_INLINE_FUNCTION Dual<T, N> floor(const Dual<T, N>& d) {
+    Dual<T, N> result{Kokkos::floor(d.real())};
+    for (size_t i = 0; i < N; i++) {
+        result.dual(i) = Kokkos::floor(d.dual(i));
+    }
+    return result;
 }
 
-template <typename T>
-KOKKOS_INLINE_FUNCTION Dual<T> ceil(const Dual<T>& d) {
-    return Dual<T>{Kokkos::ceil(d.real()), Kokkos::ceil(d.dual())};
+template <typename T, size_t N>
+KOKKOS_INLINE_FUNCTION Dual<T, N> ceil(const Dual<T, N>& d) {
+    Dual<T, N> result{Kokkos::ceil(d.real())};
+    for (size_t i = 0; i < N; i++) {
+        result.dual(i) = Kokkos::ceil(d.dual(i));
+    }
+    return result;
 }
 
-template <typename T>
-KOKKOS_INLINE_FUNCTION Dual<T> copysign(const Dual<T>& mag, const Dual<T>& sign) {
+template <typename T, size_t N>
+KOKKOS_INLINE_FUNCTION Dual<T, N> copysign(const Dual<T, N>& mag,
+                                           const Dual<T, N>& sign) {
     T real = Kokkos::copysign(mag.real(), sign.real());
-    T dual = (real - mag.real()) < 1e-15 ? mag.dual() : -mag.dual();
-    return Dual<T>{real, dual};
+    return mag.chain(real, (real - mag.real()) < 1e-15 ? T(1.0) : T(-1.0));
 }
 
-template <typename T>
-KOKKOS_INLINE_FUNCTION bool isnan(const Dual<T>& d) {
-    return Kokkos::isnan(d.real()) || Kokkos::isnan(d.dual());
+template <typename T, size_t N>
+KOKKOS_INLINE_FUNCTION bool isnan(const Dual<T, N>& d) {
+    bool nan = Kokkos::isnan(d.real());
+    for (size_t i = 0; i < N; i++) {
+        nan = nan || Kokkos::isnan(d.dual(i));
+    }
+    return nan;
 }
 
-template <typename T>
-KOKKOS_INLINE_FUNCTION bool isinf(const Dual<T>& d) {
-    return Kokkos::isinf(d.real()) || Kokkos::isinf(d.dual());
+template <typename T, size_t N>
+KOKKOS_INLINE_FUNCTION bool isinf(const Dual<T, N>& d) {
+    bool inf = Kokkos::isinf(d.real());
+    for (size_t i = 0; i < N; i++) {
+        inf = inf || Kokkos::isinf(d.dual(i));
+    }
+    return inf;
 }
 
-template <typename T>
-KOKKOS_INLINE_FUNCTION T real_part(const Dual<T>& d) {
+template <typename T, size_t N>
+KOKKOS_INLINE_FUNCTION T real_part(const Dual<T, N>& d) {
     return d.real();
 }
 
-template <typename T>
-KOKKOS_INLINE_FUNCTION T& real_part(Dual<T>& d) {
+template <typename T, size_t N>
+KOKKOS_INLINE_FUNCTION T& real_part(Dual<T, N>& d) {
     return d.real();
 }
 
@@ -343,7 +465,22 @@ KOKKOS_INLINE_FUNCTION T& dual_part(Dual<T>& d) {
     return d.dual();
 }
 
+template <typename T, size_t N>
+KOKKOS_INLINE_FUNCTION T dual_part(const Dual<T, N>& d, size_t lane) {
+    return d.dual(lane);
+}
+
+template <typename T, size_t N>
+KOKKOS_INLINE_FUNCTION T& dual_part(Dual<T, N>& d, size_t lane) {
+    return d.dual(lane);
+}
+
 typedef Dual<real> dual;
+
+// the number of derivative directions carried by the multi-lane
+// dual numbers, used to batch Jacobian-vector products
+constexpr size_t dual_lanes = 4;
+typedef Dual<real, dual_lanes> dual4;
 }  // namespace Ibis
 
 #endif
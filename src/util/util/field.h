@@ -1,6 +1,8 @@
 #ifndef FIELD_H
 #define FIELD_H
 
+#include <util/numa.h>
+
 #include <Kokkos_Core.hpp>
 #include <vector>
 
@@ -19,10 +21,12 @@ public:
 public:
     Field() {}
 
-    Field(std::string description, size_t n) { view_ = view_type(description, n); }
+    Field(std::string description, size_t n) {
+        view_ = Ibis::first_touch_view<view_type>(description, n);
+    }
 
     Field(std::string description, std::vector<T> values) {
-        view_ = view_type(description, values.size());
+        view_ = Ibis::first_touch_view<view_type>(description, values.size());
         auto view_host = Kokkos::create_mirror_view(view_);
         for (size_t i = 0; i < values.size(); i++) {
             view_host(i) = values[i];
@@ -0,0 +1,77 @@
+#include <doctest/doctest.h>
+#include <util/mapped_file.h>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <stdexcept>
+
+namespace Ibis {
+
+MappedFile::MappedFile(const std::string& file_name) {
+    int fd = open(file_name.c_str(), O_RDONLY);
+    if (fd < 0) {
+        throw std::runtime_error("Unable to open " + file_name);
+    }
+
+    struct stat file_stat;
+    if (fstat(fd, &file_stat) != 0) {
+        close(fd);
+        throw std::runtime_error("Unable to read the size of " + file_name);
+    }
+    size_ = file_stat.st_size;
+
+    // an empty file can't be mapped, but there's nothing to read anyway
+    if (size_ > 0) {
+        void* data = mmap(nullptr, size_, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (data == MAP_FAILED) {
+            close(fd);
+            throw std::runtime_error("Unable to map " + file_name);
+        }
+        // the file is (usually) read from start to finish
+        madvise(data, size_, MADV_SEQUENTIAL);
+        data_ = static_cast<const char*>(data);
+    }
+
+    // the mapping stays valid after the file is closed
+    close(fd);
+}
+
+MappedFile::~MappedFile() {
+    if (data_ != nullptr) {
+        munmap(const_cast<char*>(data_), size_);
+    }
+}
+
+}  // namespace Ibis
+
+TEST_CASE("mapped file") {
+    std::string file_name =
+        (std::filesystem::temp_directory_path() / "ibis_mapped_file_test").string();
+    {
+        std::ofstream file(file_name);
+        file << "NDIME= 2\n";
+    }
+    {
+        Ibis::MappedFile mapped(file_name);
+        CHECK(mapped.size() == 9);
+        CHECK(std::string(mapped.data(), mapped.size()) == "NDIME= 2\n");
+    }
+    std::remove(file_name.c_str());
+}
+
+TEST_CASE("mapped file empty") {
+    std::string file_name =
+        (std::filesystem::temp_directory_path() / "ibis_mapped_file_empty").string();
+    { std::ofstream file(file_name); }
+    {
+        Ibis::MappedFile mapped(file_name);
+        CHECK(mapped.size() == 0);
+    }
+    std::remove(file_name.c_str());
+}
@@ -0,0 +1,32 @@
+#ifndef MAPPED_FILE_H
+#define MAPPED_FILE_H
+
+#include <cstddef>
+#include <string>
+
+namespace Ibis {
+
+// The contents of a file, mapped read only into memory. The operating
+// system pages the file in as it is read, so large files can be read
+// without first copying them into a buffer.
+class MappedFile {
+public:
+    MappedFile(const std::string& file_name);
+
+    ~MappedFile();
+
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    const char* data() const { return data_; }
+
+    size_t size() const { return size_; }
+
+private:
+    const char* data_ = nullptr;
+    size_t size_ = 0;
+};
+
+}  // namespace Ibis
+
+#endif
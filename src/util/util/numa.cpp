@@ -0,0 +1,137 @@
+#include <doctest/doctest.h>
+#include <sched.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#include <util/numa.h>
+
+#ifdef KOKKOS_ENABLE_OPENMP
+#include <omp.h>
+#endif
+
+#include <cstdint>
+#include <filesystem>
+
+namespace Ibis {
+
+std::vector<ThreadPlacement> host_thread_placement() {
+    size_t num_threads = Kokkos::DefaultHostExecutionSpace().concurrency();
+    std::vector<ThreadPlacement> placement(num_threads);
+    for (size_t thread_i = 0; thread_i < num_threads; thread_i++) {
+        placement[thread_i] = ThreadPlacement{thread_i, -1, -1};
+    }
+    Kokkos::parallel_for(
+        "Ibis::host_thread_placement",
+        Kokkos::RangePolicy<Kokkos::DefaultHostExecutionSpace>(0, num_threads),
+        [&](const size_t i) {
+#ifdef KOKKOS_ENABLE_OPENMP
+            // the schedule doesn't promise one iteration per thread, so
+            // each thread records itself. A thread which gets no
+            // iterations is left on an unknown cpu.
+            (void)i;
+            size_t thread_i = omp_get_thread_num();
+#else
+            // the other host execution spaces don't say which thread runs
+            // an iteration, so assume it's one iteration per thread
+            size_t thread_i = i;
+#endif
+            placement[thread_i].cpu = sched_getcpu();
+        });
+    for (ThreadPlacement& thread : placement) {
+        thread.numa_node = numa_node_of_cpu(thread.cpu);
+    }
+    return placement;
+}
+
+int numa_node_of_cpu(int cpu) {
+    if (cpu < 0) return -1;
+
+    // linux lists the node of each cpu as a directory called node<n>
+    std::filesystem::path cpu_dir =
+        "/sys/devices/system/cpu/cpu" + std::to_string(cpu);
+    std::error_code error;
+    for (const auto& entry : std::filesystem::directory_iterator(cpu_dir, error)) {
+        std::string name = entry.path().filename().string();
+        if (name.size() > 4 && name.compare(0, 4, "node") == 0 &&
+            name.find_first_not_of("0123456789", 4) == std::string::npos) {
+            return std::stoi(name.substr(4));
+        }
+    }
+    return -1;
+}
+
+std::vector<size_t> numa_pages(const void* data, size_t bytes) {
+#ifdef SYS_move_pages
+    if (data == nullptr || bytes == 0) return {};
+
+    size_t page_size = sysconf(_SC_PAGESIZE);
+    uintptr_t first_page = reinterpret_cast<uintptr_t>(data) / page_size * page_size;
+    uintptr_t end = reinterpret_cast<uintptr_t>(data) + bytes;
+    size_t num_pages = (end - first_page + page_size - 1) / page_size;
+    std::vector<void*> pages(num_pages);
+    for (size_t page_i = 0; page_i < num_pages; page_i++) {
+        pages[page_i] = reinterpret_cast<void*>(first_page + page_i * page_size);
+    }
+
+    // move_pages with no target nodes only reports where each page is
+    std::vector<int> status(num_pages);
+    if (syscall(SYS_move_pages, 0, num_pages, pages.data(), nullptr, status.data(), 0) !=
+        0) {
+        return {};
+    }
+
+    std::vector<size_t> node_pages;
+    for (int node : status) {
+        if (node < 0) continue;  // not touched yet
+        if (static_cast<size_t>(node) >= node_pages.size()) {
+            node_pages.resize(node + 1, 0);
+        }
+        node_pages[node]++;
+    }
+    return node_pages;
+#else
+    (void)data;
+    (void)bytes;
+    return {};
+#endif
+}
+
+}  // namespace Ibis
+
+TEST_CASE("first_touch_view") {
+    auto view = Ibis::first_touch_view<Kokkos::View<double**>>("test", 100, 3);
+    auto view_host = Kokkos::create_mirror_view(view);
+    Kokkos::deep_copy(view_host, view);
+    CHECK(view.extent(0) == 100);
+    CHECK(view.extent(1) == 3);
+    bool zero = true;
+    for (size_t i = 0; i < 100; i++) {
+        for (size_t j = 0; j < 3; j++) {
+            zero = zero && view_host(i, j) == 0.0;
+        }
+    }
+    CHECK(zero);
+}
+
+TEST_CASE("host_thread_placement") {
+    std::vector<Ibis::ThreadPlacement> placement = Ibis::host_thread_placement();
+    CHECK(placement.size() == size_t(Kokkos::DefaultHostExecutionSpace().concurrency()));
+    for (size_t thread_i = 0; thread_i < placement.size(); thread_i++) {
+        CHECK(placement[thread_i].thread == thread_i);
+        CHECK(placement[thread_i].numa_node >= -1);
+    }
+}
+
+TEST_CASE("numa_pages") {
+    std::vector<double> values(10000, 1.0);
+    std::vector<size_t> node_pages = Ibis::numa_pages(values.data(), values.size() * 8);
+
+    // the placement isn't available everywhere (e.g. in some containers)
+    if (node_pages.empty()) return;
+    size_t page_size = sysconf(_SC_PAGESIZE);
+    size_t total_pages = 0;
+    for (size_t pages : node_pages) {
+        total_pages += pages;
+    }
+    CHECK(total_pages >= values.size() * 8 / page_size);
+    CHECK(total_pages <= values.size() * 8 / page_size + 2);
+}
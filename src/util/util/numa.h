@@ -0,0 +1,72 @@
+#ifndef NUMA_H
+#define NUMA_H
+
+#include <Kokkos_Core.hpp>
+#include <cstddef>
+#include <string>
+#include <vector>
+
+namespace Ibis {
+
+// On a machine with several sockets (NUMA nodes), the operating system puts
+// each page of memory on the node of the thread which first writes to it.
+// Kokkos zeroes new views with a single memset, which puts every page on
+// one node, so threads on the other sockets pay for remote memory on every
+// access. Instead, views are allocated without initialisation and zeroed
+// in parallel over their first index, with the same RangePolicy as the
+// kernels, which loop over the cells or faces in the same way. Each page
+// then ends up on the node of the thread which will use it.
+//
+// For device memory spaces, this is just a parallel zero.
+template <class ViewType>
+void first_touch(const ViewType& view) {
+    using execution_space = typename ViewType::execution_space;
+    using value_type = typename ViewType::non_const_value_type;
+    static_assert(ViewType::rank == 1 || ViewType::rank == 2,
+                  "first_touch is only implemented for one and two dimensional views");
+    size_t n = view.extent(0);
+    size_t m = view.extent(1);
+    Kokkos::parallel_for(
+        "Ibis::first_touch", Kokkos::RangePolicy<execution_space>(0, n),
+        KOKKOS_LAMBDA(const size_t i) {
+            if constexpr (ViewType::rank == 1) {
+                (void)m;
+                view(i) = value_type(0);
+            } else {
+                for (size_t j = 0; j < m; j++) {
+                    view(i, j) = value_type(0);
+                }
+            }
+        });
+}
+
+// Allocate a view, zeroed with first_touch
+template <class ViewType, class... Extents>
+ViewType first_touch_view(const std::string& label, Extents... extents) {
+    ViewType view(Kokkos::view_alloc(Kokkos::WithoutInitializing, label), extents...);
+    first_touch(view);
+    return view;
+}
+
+// Where one thread of the host execution space is running
+struct ThreadPlacement {
+    size_t thread;
+    int cpu;
+    int numa_node;
+};
+
+// The cpu and NUMA node of each thread of the host execution space, or -1
+// if they can't be found
+std::vector<ThreadPlacement> host_thread_placement();
+
+// The NUMA node cpu belongs to, or -1 if it isn't known
+int numa_node_of_cpu(int cpu);
+
+// The number of pages of memory between data and data + bytes on each NUMA
+// node. Pages which haven't been touched yet aren't counted. If the
+// placement can't be found, this is empty.
+std::vector<size_t> numa_pages(const void* data, size_t bytes);
+
+}  // namespace Ibis
+
+#endif
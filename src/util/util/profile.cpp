@@ -0,0 +1,282 @@
+#include <doctest/doctest.h>
+#include <util/profile.h>
+
+#include <Kokkos_Core.hpp>
+#include <algorithm>
+#include <cstdio>
+#include <limits>
+#include <map>
+#include <vector>
+
+namespace Ibis {
+
+namespace {
+
+struct ProfileNode {
+    std::string name;
+    size_t parent;
+    std::vector<size_t> children;
+    double time = 0.0;
+    size_t calls = 0;
+};
+
+struct ProfileCounter {
+    size_t total = 0;
+    size_t this_step = 0;
+    size_t min_per_step = std::numeric_limits<size_t>::max();
+    size_t max_per_step = 0;
+};
+
+// The tree of regions, with the root (node 0) standing for the whole run
+struct Profiler {
+    Profiler() { reset(); }
+
+    void reset() {
+        nodes.clear();
+        nodes.push_back(ProfileNode{"total", 0, {}, 0.0, 1});
+        current = 0;
+        counters.clear();
+        steps = 0;
+        start = std::chrono::steady_clock::now();
+    }
+
+    void enter(const char* name) {
+        // regions usually have only a handful of children, so a linear
+        // search is quicker than anything cleverer
+        for (size_t child : nodes[current].children) {
+            if (nodes[child].name == name) {
+                current = child;
+                return;
+            }
+        }
+        size_t child = nodes.size();
+        nodes.push_back(ProfileNode{name, current, {}, 0.0, 0});
+        nodes[current].children.push_back(child);
+        current = child;
+    }
+
+    void exit(double time) {
+        ProfileNode& node = nodes[current];
+        node.time += time;
+        node.calls++;
+        current = node.parent;
+    }
+
+    double total_time() const {
+        std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+        return elapsed.count();
+    }
+
+    std::vector<ProfileNode> nodes;
+    size_t current;
+    std::map<std::string, ProfileCounter> counters;
+    size_t steps;
+    std::chrono::steady_clock::time_point start;
+    bool enabled = true;
+    bool fence = false;
+};
+
+Profiler& profiler() {
+    static Profiler profiler;
+    return profiler;
+}
+
+void summarise_node(const std::vector<ProfileNode>& nodes, size_t node_i,
+                    double parent_time, size_t depth, std::string& summary) {
+    const ProfileNode& node = nodes[node_i];
+    double percent = (parent_time > 0.0) ? 100.0 * node.time / parent_time : 100.0;
+    char line[256];
+    std::snprintf(line, sizeof(line), "%*s%-*s %10.4fs %6.1f%% %10zu calls\n",
+                  int(2 * depth), "", int(std::max(1, 40 - int(2 * depth))),
+                  node.name.c_str(), node.time, percent, node.calls);
+    summary += line;
+    for (size_t child : node.children) {
+        summarise_node(nodes, child, node.time, depth + 1, summary);
+    }
+}
+
+json node_json(const std::vector<ProfileNode>& nodes, size_t node_i) {
+    const ProfileNode& node = nodes[node_i];
+    json node_data;
+    node_data["name"] = node.name;
+    node_data["time"] = node.time;
+    node_data["calls"] = node.calls;
+    json children = json::array();
+    for (size_t child : node.children) {
+        children.push_back(node_json(nodes, child));
+    }
+    node_data["children"] = children;
+    return node_data;
+}
+
+}  // namespace
+
+ProfileRegion::ProfileRegion(const char* name) : enabled_(profiler().enabled) {
+    if (!enabled_) return;
+    Kokkos::Profiling::pushRegion(name);
+    profiler().enter(name);
+    start_ = std::chrono::steady_clock::now();
+}
+
+ProfileRegion::~ProfileRegion() {
+    if (!enabled_) return;
+    if (profiler().fence) {
+        Kokkos::fence("Ibis::ProfileRegion");
+    }
+    std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start_;
+    profiler().exit(elapsed.count());
+    Kokkos::Profiling::popRegion();
+}
+
+void set_profiling(bool enabled) { profiler().enabled = enabled; }
+
+void set_profile_fence(bool fence) { profiler().fence = fence; }
+
+void profile_count(const char* name, size_t count) {
+    Profiler& prof = profiler();
+    if (!prof.enabled) return;
+    auto [counter_it, inserted] = prof.counters.try_emplace(name);
+    ProfileCounter& counter = counter_it->second;
+    if (inserted && prof.steps > 0) {
+        // nothing was counted on the earlier steps
+        counter.min_per_step = 0;
+    }
+    counter.total += count;
+    counter.this_step += count;
+}
+
+void profile_step() {
+    Profiler& prof = profiler();
+    prof.steps++;
+    for (auto& [name, counter] : prof.counters) {
+        counter.min_per_step = std::min(counter.min_per_step, counter.this_step);
+        counter.max_per_step = std::max(counter.max_per_step, counter.this_step);
+        counter.this_step = 0;
+    }
+}
+
+void reset_profile() { profiler().reset(); }
+
+std::string profile_summary() {
+    Profiler& prof = profiler();
+    prof.nodes[0].time = prof.total_time();
+    std::string summary;
+    summarise_node(prof.nodes, 0, 0.0, 0, summary);
+    for (const auto& [name, counter] : prof.counters) {
+        char line[256];
+        if (prof.steps > 0) {
+            std::snprintf(line, sizeof(line),
+                          "%s: %zu (%.2f per step, min %zu, max %zu)\n", name.c_str(),
+                          counter.total, double(counter.total) / prof.steps,
+                          counter.min_per_step, counter.max_per_step);
+        } else {
+            std::snprintf(line, sizeof(line), "%s: %zu\n", name.c_str(), counter.total);
+        }
+        summary += line;
+    }
+    return summary;
+}
+
+json profile_json() {
+    Profiler& prof = profiler();
+    prof.nodes[0].time = prof.total_time();
+    json profile;
+    profile["regions"] = node_json(prof.nodes, 0);
+    profile["steps"] = prof.steps;
+    json counters = json::object();
+    for (const auto& [name, counter] : prof.counters) {
+        json counter_json;
+        counter_json["total"] = counter.total;
+        if (prof.steps > 0) {
+            counter_json["mean_per_step"] = double(counter.total) / prof.steps;
+            counter_json["min_per_step"] = counter.min_per_step;
+            counter_json["max_per_step"] = counter.max_per_step;
+        }
+        counters[name] = counter_json;
+    }
+    profile["counters"] = counters;
+    return profile;
+}
+
+}  // namespace Ibis
+
+TEST_CASE("profile regions") {
+    Ibis::reset_profile();
+    for (int step = 0; step < 3; step++) {
+        Ibis::ProfileRegion step_region("step");
+        {
+            Ibis::ProfileRegion inner("inner");
+        }
+        {
+            Ibis::ProfileRegion inner("inner");
+        }
+    }
+    {
+        Ibis::ProfileRegion other("other");
+    }
+
+    json profile = Ibis::profile_json();
+    json regions = profile.at("regions");
+    CHECK(regions.at("name") == "total");
+    CHECK(regions.at("children").size() == 2);
+
+    json step = regions.at("children")[0];
+    CHECK(step.at("name") == "step");
+    CHECK(step.at("calls") == 3);
+    CHECK(step.at("children").size() == 1);
+    CHECK(step.at("children")[0].at("name") == "inner");
+    CHECK(step.at("children")[0].at("calls") == 6);
+    double step_time = step.at("time");
+    double inner_time = step.at("children")[0].at("time");
+    CHECK(step_time >= inner_time);
+
+    json other = regions.at("children")[1];
+    CHECK(other.at("name") == "other");
+    CHECK(other.at("calls") == 1);
+    CHECK(other.at("children").size() == 0);
+}
+
+TEST_CASE("profile counters") {
+    Ibis::reset_profile();
+    Ibis::profile_count("iterations", 4);
+    Ibis::profile_step();
+    Ibis::profile_count("iterations", 2);
+    Ibis::profile_count("iterations", 4);
+    Ibis::profile_count("evaluations");
+    Ibis::profile_step();
+
+    json profile = Ibis::profile_json();
+    CHECK(profile.at("steps") == 2);
+    json iterations = profile.at("counters").at("iterations");
+    CHECK(iterations.at("total") == 10);
+    CHECK(iterations.at("mean_per_step").get<double>() == 5.0);
+    CHECK(iterations.at("min_per_step") == 4);
+    CHECK(iterations.at("max_per_step") == 6);
+
+    // evaluations weren't counted on the first step
+    json evaluations = profile.at("counters").at("evaluations");
+    CHECK(evaluations.at("total") == 1);
+    CHECK(evaluations.at("min_per_step") == 0);
+    CHECK(evaluations.at("max_per_step") == 1);
+    Ibis::reset_profile();
+}
+
+TEST_CASE("profiling disabled") {
+    Ibis::reset_profile();
+    Ibis::set_profiling(false);
+    {
+        Ibis::ProfileRegion region("step");
+        Ibis::profile_count("iterations", 4);
+    }
+    Ibis::set_profiling(true);
+    {
+        Ibis::ProfileRegion region("other");
+    }
+
+    json profile = Ibis::profile_json();
+    json regions = profile.at("regions");
+    CHECK(regions.at("children").size() == 1);
+    CHECK(regions.at("children")[0].at("name") == "other");
+    CHECK(profile.at("counters").size() == 0);
+    Ibis::reset_profile();
+}
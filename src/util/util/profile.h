@@ -0,0 +1,74 @@
+#ifndef PROFILE_H
+#define PROFILE_H
+
+#include <chrono>
+#include <cstddef>
+#include <nlohmann/json.hpp>
+#include <string>
+
+using json = nlohmann::json;
+
+namespace Ibis {
+
+// A lightweight profiler for the phases of a run. ProfileRegion times the
+// scope it lives in, and nested regions build up a tree, so the time of
+// each phase is broken down into the phases it calls. The same region
+// entered many times under the same parent (e.g. once per step) is
+// accumulated into one entry of the tree.
+//
+// Each region is also pushed as a Kokkos profiling region, so the phases
+// show up in Kokkos tools (e.g. the space time stack or nsys) when one is
+// loaded. Without a tool, that costs a single check.
+//
+// By default the regions don't synchronise, so on the GPU backends a
+// region's time only covers launching its kernels, and the kernels are
+// timed wherever the next synchronisation happens to be. With
+// set_profile_fence(true) the device is fenced at the end of each region,
+// so kernels are timed in the region which launched them, at the cost of
+// the fences (some of which are inside the GMRES iterations). `ibis bench
+// --profile-overhead` measures both costs.
+//
+// Regions should only be entered from the host thread that runs the
+// solver.
+class ProfileRegion {
+public:
+    explicit ProfileRegion(const char* name);
+
+    ~ProfileRegion();
+
+    ProfileRegion(const ProfileRegion&) = delete;
+    ProfileRegion& operator=(const ProfileRegion&) = delete;
+
+private:
+    std::chrono::steady_clock::time_point start_;
+    bool enabled_;
+};
+
+// Turn the regions and counters on or off (they're on by default). While
+// they're off, regions and counts cost a single check.
+void set_profiling(bool enabled);
+
+// Fence the device at the end of each region (off by default)
+void set_profile_fence(bool fence);
+
+// Add count to the counter called name (e.g. the number of GMRES
+// iterations). The counts are also broken down by step (see profile_step).
+void profile_count(const char* name, size_t count = 1);
+
+// Mark the end of a step, so the counts since the previous step are
+// recorded as the counts for this step
+void profile_step();
+
+// Forget all the timings and counts so far
+void reset_profile();
+
+// A human readable summary of the timings, one line per region indented
+// by its depth in the tree, followed by the counters
+std::string profile_summary();
+
+// The timings and counters as json, for log/profile.json
+json profile_json();
+
+}  // namespace Ibis
+
+#endif
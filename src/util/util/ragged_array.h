@@ -1,6 +1,8 @@
 #ifndef RAGGED_ARRAY_H
 #define RAGGED_ARRAY_H
 
+#include <util/numa.h>
+
 #include <Kokkos_Core.hpp>
 #include <string>
 #include <vector>
@@ -28,11 +30,28 @@ public:
     RaggedArray() {}
 
     RaggedArray(size_t num_values, size_t num_rows)
-        : data_("RaggedArray::data", num_values),
-          offsets_("RaggedArray::offsets", num_rows + 1) {}
+        : data_(first_touch_view<ArrayType>("RaggedArray::data", num_values)),
+          offsets_(first_touch_view<OffsetType>("RaggedArray::offsets", num_rows + 1)) {}
 
     RaggedArray(ArrayType data, OffsetType offsets) : data_(data), offsets_(offsets) {}
 
+    // from data which is already flat, with the values of row i being
+    // data[offsets[i]] to data[offsets[i+1]-1]
+    RaggedArray(const std::vector<DataType> &data, const std::vector<size_t> &offsets) {
+        data_ = first_touch_view<ArrayType>("RaggedArray::data", data.size());
+        offsets_ = first_touch_view<OffsetType>("RaggedArray::offsets", offsets.size());
+        auto data_host = Kokkos::create_mirror_view(data_);
+        auto offsets_host = Kokkos::create_mirror_view(offsets_);
+        for (size_t i = 0; i < data.size(); i++) {
+            data_host(i) = data[i];
+        }
+        for (size_t i = 0; i < offsets.size(); i++) {
+            offsets_host(i) = offsets[i];
+        }
+        Kokkos::deep_copy(data_, data_host);
+        Kokkos::deep_copy(offsets_, offsets_host);
+    }
+
     RaggedArray(std::vector<std::vector<DataType>> data) {
         // count the total number of entries
         size_t n = 0;
@@ -41,8 +60,8 @@ public:
         }
 
         // allocate memory
-        data_ = ArrayType("RaggedArray::data", n);
-        offsets_ = OffsetType("RaggedArray::offsets", data.size() + 1);
+        data_ = first_touch_view<ArrayType>("RaggedArray::data", n);
+        offsets_ = first_touch_view<OffsetType>("RaggedArray::offsets", data.size() + 1);
 
         // initialise memory (on the CPU)
         auto data_host = Kokkos::create_mirror_view(data_);
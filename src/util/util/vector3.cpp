@@ -49,6 +49,8 @@ template void add_scaled_vector<Ibis::real>(Vector3s<Ibis::real> &,
                                             const Vector3s<Ibis::real> &, Ibis::real);
 template void add_scaled_vector<Ibis::dual>(Vector3s<Ibis::dual> &,
                                             const Vector3s<Ibis::dual> &, Ibis::dual);
+template void add_scaled_vector<Ibis::dual4>(Vector3s<Ibis::dual4> &,
+                                             const Vector3s<Ibis::dual4> &, Ibis::dual4);
 
 template <typename T>
 void add_scaled_vector(const Vector3s<T> &a, const Vector3s<T> &b, T scale,
@@ -67,6 +69,9 @@ template void add_scaled_vector<Ibis::real>(const Vector3s<Ibis::real> &,
 template void add_scaled_vector<Ibis::dual>(const Vector3s<Ibis::dual> &,
                                             const Vector3s<Ibis::dual> &, Ibis::dual,
                                             Vector3s<Ibis::dual> &);
+template void add_scaled_vector<Ibis::dual4>(const Vector3s<Ibis::dual4> &,
+                                             const Vector3s<Ibis::dual4> &, Ibis::dual4,
+                                             Vector3s<Ibis::dual4> &);
 
 template <typename T>
 void subtract(const Vector3s<T> &a, const Vector3s<T> &b, Vector3s<T> &result) {
@@ -85,6 +90,9 @@ template void subtract<Ibis::real>(const Vector3s<Ibis::real> &a,
 template void subtract<Ibis::dual>(const Vector3s<Ibis::dual> &a,
                                    const Vector3s<Ibis::dual> &b,
                                    Vector3s<Ibis::dual> &result);
+template void subtract<Ibis::dual4>(const Vector3s<Ibis::dual4> &a,
+                                    const Vector3s<Ibis::dual4> &b,
+                                    Vector3s<Ibis::dual4> &result);
 
 template <typename T>
 void cross(const Vector3s<T> &a, const Vector3s<T> &b, Vector3s<T> &result) {
@@ -159,6 +167,10 @@ template void transform_to_local_frame<Ibis::dual>(Vector3s<Ibis::dual> &a,
                                                    const Vector3s<Ibis::dual> &norm,
                                                    const Vector3s<Ibis::dual> &tan1,
                                                    const Vector3s<Ibis::dual> tan2);
+template void transform_to_local_frame<Ibis::dual4>(Vector3s<Ibis::dual4> &a,
+                                                    const Vector3s<Ibis::dual4> &norm,
+                                                    const Vector3s<Ibis::dual4> &tan1,
+                                                    const Vector3s<Ibis::dual4> tan2);
 
 template <typename T>
 void transform_to_global_frame(Vector3s<T> &a, const Vector3s<T> &norm,
@@ -182,6 +194,10 @@ template void transform_to_global_frame<Ibis::dual>(Vector3s<Ibis::dual> &a,
                                                     const Vector3s<Ibis::dual> &norm,
                                                     const Vector3s<Ibis::dual> &tan1,
                                                     const Vector3s<Ibis::dual> &tan2);
+template void transform_to_global_frame<Ibis::dual4>(Vector3s<Ibis::dual4> &a,
+                                                     const Vector3s<Ibis::dual4> &norm,
+                                                     const Vector3s<Ibis::dual4> &tan1,
+                                                     const Vector3s<Ibis::dual4> &tan2);
 
 TEST_CASE("Vector Dot Product") {
     size_t n = 10;
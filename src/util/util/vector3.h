@@ -46,9 +46,11 @@ public:
 
     // ~Vector3s(){}
 
-    Vector3s(std::string description, size_t n) { view_ = view_type(description, n); }
+    Vector3s(std::string description, size_t n) {
+        view_ = Ibis::first_touch_view<view_type>(description, n);
+    }
 
-    Vector3s(size_t n) { view_ = view_type("Vector3s", n); }
+    Vector3s(size_t n) { view_ = Ibis::first_touch_view<view_type>("Vector3s", n); }
 
     Vector3s(view_type data) : view_(data) {}
 